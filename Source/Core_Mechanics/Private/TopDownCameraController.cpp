@@ -119,6 +119,16 @@ void ATopDownCameraController::Tick(float DeltaTime)
 	}
 }
 
+float ATopDownCameraController::GetVisibleGroundRadius() const
+{
+	// Half the ground width seen at the focus distance, stretched along the view direction by the tilt
+	const float AspectRatio = FMath::Max(1.0f, TopDownCamera->AspectRatio);
+	const float HalfWidth = CurrentZoomDistance * FMath::Tan(FMath::DegreesToRadians(TopDownCamera->FieldOfView * 0.5f));
+	const float Tilt = FMath::Max(FMath::Abs(FMath::Sin(FMath::DegreesToRadians(CameraBoom->GetRelativeRotation().Pitch))), 0.2f);
+	
+	return HalfWidth * FMath::Sqrt(1.0f + 1.0f / FMath::Square(AspectRatio * Tilt));
+}
+
 // Called to bind functionality to input
 void ATopDownCameraController::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 {
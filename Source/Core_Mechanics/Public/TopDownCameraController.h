@@ -153,6 +153,14 @@ public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	/** Point on the ground the camera looks at */
+	UFUNCTION(BlueprintCallable, Category = "Camera")
+	FVector GetViewFocus() const { return GetActorLocation(); }
+
+	/** Radius around the view focus that covers the visible ground, assuming a flat ground plane */
+	UFUNCTION(BlueprintCallable, Category = "Camera")
+	float GetVisibleGroundRadius() const;
+
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 };
\ No newline at end of file
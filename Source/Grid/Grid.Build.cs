@@ -19,6 +19,7 @@ public class Grid : ModuleRules
             {
                 "CoreUObject",
                 "Engine",
+                "NavigationSystem",
                 "Slate",
                 "SlateCore"
             }
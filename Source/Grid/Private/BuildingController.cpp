@@ -17,8 +17,18 @@ ABuildingController::ABuildingController()
     GridManager = nullptr;
     SelectedBuildingAsset = nullptr;
     bBuildingModeActive = false;
+    bStampModeActive = false;
     CurrentRotation = 0;
     CurrentFloorLevel = 0;
+    bShowPlacementHeatmap = false;
+    bPrefetchValidityMaps = true;
+    HeatmapBudgetMilliseconds = 1.0f;
+    bSnapToValidPlacement = false;
+    SnapSearchDistance = 3;
+    bBoxSelectAllFloors = false;
+    bBoxSelecting = false;
+    BoxSelectionStart = FIntPoint::ZeroValue;
+    BoxSelectionEnd = FIntPoint::ZeroValue;
     BuildingUIWidget = nullptr;
 }
 
@@ -62,14 +72,38 @@ void ABuildingController::Tick(float DeltaTime)
     // Only update placement preview if in building mode
     if (bBuildingModeActive && GridManager && SelectedBuildingAsset)
     {
-        // Get hit location under cursor
+        // Get placement location under cursor
+        FVector PlacementLocation;
+        if (GetPlacementLocation(PlacementLocation))
+        {
+            // Update placement preview
+            GridManager->UpdatePlacementPreview(SelectedBuildingAsset, PlacementLocation, CurrentRotation, CurrentFloorLevel);
+        }
+        
+        if (bPrefetchValidityMaps)
+        {
+            PrefetchValidityMaps();
+        }
+        
+        // Spread the heatmap over several frames so the preview stays within budget
+        if (bShowPlacementHeatmap)
+        {
+            GridManager->UpdatePlacementHeatmap(SelectedBuildingAsset, CurrentRotation, CurrentFloorLevel, HeatmapBudgetMilliseconds);
+        }
+    }
+    else if (bStampModeActive && GridManager)
+    {
+        // All rotations of the stamp are precompiled, so the preview only moves its masks
         FHitResult HitResult;
         if (GetHitUnderCursor(HitResult))
         {
-            // Update placement preview
-            GridManager->UpdatePlacementPreview(SelectedBuildingAsset, HitResult.Location, CurrentRotation, CurrentFloorLevel);
+            GridManager->UpdateStampPreview(HitResult.Location, CurrentRotation, CurrentFloorLevel);
         }
     }
+    else if (bBoxSelecting)
+    {
+        UpdateBoxSelection();
+    }
 }
 
 void ABuildingController::SetupInputComponent()
@@ -82,6 +116,11 @@ void ABuildingController::SetupInputComponent()
     InputComponent->BindAction("BuildingCancel", IE_Pressed, this, &ABuildingController::CancelPlacement);
     InputComponent->BindAction("FloorLevelUp", IE_Pressed, this, &ABuildingController::IncrementFloorLevel);
     InputComponent->BindAction("FloorLevelDown", IE_Pressed, this, &ABuildingController::DecrementFloorLevel);
+    
+    // Bind input actions for selection
+    InputComponent->BindAction("BuildingSelect", IE_Pressed, this, &ABuildingController::BeginBoxSelection);
+    InputComponent->BindAction("BuildingSelect", IE_Released, this, &ABuildingController::EndBoxSelection);
+    InputComponent->BindAction("BuildingDemolish", IE_Pressed, this, &ABuildingController::DemolishSelection);
 }
 
 bool ABuildingController::GetHitUnderCursor(FHitResult& OutHit)
@@ -114,10 +153,41 @@ bool ABuildingController::GetHitUnderCursor(FHitResult& OutHit)
     return GetWorld()->LineTraceSingleByChannel(OutHit, WorldLocation, TraceEnd, ECC_Visibility, TraceParams);
 }
 
+bool ABuildingController::GetPlacementLocation(FVector& OutLocation)
+{
+    FHitResult HitResult;
+    if (!GetHitUnderCursor(HitResult))
+    {
+        return false;
+    }
+
+    // The hovered origin is tried first, so snapping only moves blocked placements; without a valid origin nearby
+    // the hovered one is kept and shown as invalid
+    OutLocation = HitResult.Location;
+    if (bSnapToValidPlacement && GridManager && SelectedBuildingAsset)
+    {
+        GridManager->SnapPlacementLocation(SelectedBuildingAsset, HitResult.Location, CurrentRotation, CurrentFloorLevel, SnapSearchDistance, OutLocation);
+    }
+
+    return true;
+}
+
+void ABuildingController::PrefetchValidityMaps()
+{
+    // Cached maps are skipped, so after the first frame this only costs lookups until the grid changes
+    for (int32 RotationStep = 0; RotationStep < 4; RotationStep++)
+    {
+        GridManager->PrefetchValidityMap(SelectedBuildingAsset, (CurrentRotation + RotationStep) % 4, CurrentFloorLevel);
+    }
+    
+    GridManager->PrefetchValidityMap(SelectedBuildingAsset, CurrentRotation, CurrentFloorLevel + 1);
+    GridManager->PrefetchValidityMap(SelectedBuildingAsset, CurrentRotation, CurrentFloorLevel - 1);
+}
+
 void ABuildingController::RotateBuilding()
 {
     // Only rotate if in building mode
-    if (bBuildingModeActive)
+    if (bBuildingModeActive || bStampModeActive)
     {
         // Increment rotation and wrap around
         CurrentRotation = (CurrentRotation + 1) % 4;
@@ -129,12 +199,12 @@ void ABuildingController::ConfirmPlacement()
     // Only confirm if in building mode
     if (bBuildingModeActive && GridManager && SelectedBuildingAsset)
     {
-        // Get hit location under cursor
-        FHitResult HitResult;
-        if (GetHitUnderCursor(HitResult))
+        // Get placement location under cursor
+        FVector PlacementLocation;
+        if (GetPlacementLocation(PlacementLocation))
         {
             // Try to place the building
-            ABuildingObject* PlacedBuilding = GridManager->PlaceBuilding(SelectedBuildingAsset, HitResult.Location, CurrentRotation, CurrentFloorLevel);
+            ABuildingObject* PlacedBuilding = GridManager->PlaceBuilding(SelectedBuildingAsset, PlacementLocation, CurrentRotation, CurrentFloorLevel);
             
             // If building was placed successfully
             if (PlacedBuilding)
@@ -153,6 +223,18 @@ void ABuildingController::ConfirmPlacement()
             }
         }
     }
+    else if (bStampModeActive && GridManager)
+    {
+        FHitResult HitResult;
+        if (GetHitUnderCursor(HitResult))
+        {
+            // The stamp stays selected so the layout can be placed again
+            if (GridManager->PlaceStamp(HitResult.Location, CurrentRotation, CurrentFloorLevel).Num() == 0)
+            {
+                UE_LOG(LogTemp, Warning, TEXT("Cannot place stamp at this location"));
+            }
+        }
+    }
 }
 
 void ABuildingController::CancelPlacement()
@@ -187,6 +269,102 @@ void ABuildingController::DecrementFloorLevel()
     }
 }
 
+void ABuildingController::BeginBoxSelection()
+{
+    // Clicks place buildings while in building mode
+    if (bBuildingModeActive || bStampModeActive || !GridManager)
+    {
+        return;
+    }
+    
+    FIntPoint Cell;
+    if (GetCellUnderCursor(Cell))
+    {
+        bBoxSelecting = true;
+        BoxSelectionStart = Cell;
+        BoxSelectionEnd = Cell;
+        SelectBuildingsInBox(BoxSelectionStart, BoxSelectionEnd, CurrentFloorLevel, bBoxSelectAllFloors ? GridManager->GetMaxFloors() - 1 : CurrentFloorLevel);
+    }
+}
+
+void ABuildingController::EndBoxSelection()
+{
+    if (!bBoxSelecting)
+    {
+        return;
+    }
+    
+    UpdateBoxSelection();
+    bBoxSelecting = false;
+}
+
+void ABuildingController::UpdateBoxSelection()
+{
+    // The selection only changes when the cursor enters another cell
+    FIntPoint Cell;
+    if (!GridManager || !GetCellUnderCursor(Cell) || Cell == BoxSelectionEnd)
+    {
+        return;
+    }
+    
+    BoxSelectionEnd = Cell;
+    SelectBuildingsInBox(BoxSelectionStart, BoxSelectionEnd, CurrentFloorLevel, bBoxSelectAllFloors ? GridManager->GetMaxFloors() - 1 : CurrentFloorLevel);
+}
+
+bool ABuildingController::GetCellUnderCursor(FIntPoint& OutCell)
+{
+    FHitResult HitResult;
+    if (!GridManager || !GetHitUnderCursor(HitResult))
+    {
+        return false;
+    }
+    
+    int32 DetectedFloor;
+    OutCell = GridManager->WorldToGrid(HitResult.Location, DetectedFloor);
+    return true;
+}
+
+TArray<FBuildingHandle> ABuildingController::SelectBuildingsInBox(const FIntPoint& Min, const FIntPoint& Max, int32 MinFloor, int32 MaxFloor)
+{
+    SelectedBuildings.Reset();
+    
+    if (GridManager)
+    {
+        SelectedBuildings = GridManager->GetBuildingsInRect(Min, Max, MinFloor, MaxFloor);
+        GridManager->ShowBuildingSelection(SelectedBuildings);
+    }
+    
+    return SelectedBuildings;
+}
+
+void ABuildingController::DemolishSelection()
+{
+    DemolishSelectedBuildings();
+}
+
+int32 ABuildingController::DemolishSelectedBuildings()
+{
+    if (!GridManager || SelectedBuildings.Num() == 0)
+    {
+        return 0;
+    }
+    
+    const int32 NumRemoved = GridManager->RemoveBuildings(SelectedBuildings);
+    ClearSelection();
+    return NumRemoved;
+}
+
+void ABuildingController::ClearSelection()
+{
+    SelectedBuildings.Reset();
+    bBoxSelecting = false;
+    
+    if (GridManager)
+    {
+        GridManager->ShowBuildingSelection(SelectedBuildings);
+    }
+}
+
 void ABuildingController::EnterBuildingMode(UBuildingObjectAsset* BuildingAsset)
 {
     // Check if we have a valid asset and grid manager
@@ -197,6 +375,7 @@ void ABuildingController::EnterBuildingMode(UBuildingObjectAsset* BuildingAsset)
     
     // Set building mode active
     bBuildingModeActive = true;
+    bStampModeActive = false;
     
     // Store the selected asset
     SelectedBuildingAsset = BuildingAsset;
@@ -208,15 +387,58 @@ void ABuildingController::EnterBuildingMode(UBuildingObjectAsset* BuildingAsset)
     GridManager->SetGridVisualizationEnabled(true);
 }
 
+void ABuildingController::EnterStampMode(const FBuildingStamp& Stamp)
+{
+    if (Stamp.IsEmpty() || !GridManager)
+    {
+        return;
+    }
+    
+    // A stamp replaces any single building being placed
+    if (bBuildingModeActive)
+    {
+        ExitBuildingMode();
+    }
+    
+    bStampModeActive = true;
+    CurrentRotation = 0;
+    GridManager->SetActiveStamp(Stamp);
+    GridManager->SetGridVisualizationEnabled(true);
+}
+
+FPlacementScore ABuildingController::GetPreviewScore() const
+{
+    if (!bBuildingModeActive || !GridManager)
+    {
+        return FPlacementScore();
+    }
+    
+    return GridManager->GetPreviewScore();
+}
+
+void ABuildingController::SetPlacementHeatmapVisible(bool bVisible)
+{
+    bShowPlacementHeatmap = bVisible;
+    
+    // Hiding drops the heatmap, showing rebuilds it over the next frames
+    if (!bVisible && GridManager)
+    {
+        GridManager->ClearPlacementHeatmap();
+    }
+}
+
 void ABuildingController::ExitBuildingMode()
 {
     // Clear building mode state
     bBuildingModeActive = false;
+    bStampModeActive = false;
     SelectedBuildingAsset = nullptr;
     
     // Reset placement preview
     if (GridManager)
     {
+        GridManager->SetActiveStamp(FBuildingStamp());
+        GridManager->ClearPlacementHeatmap();
         GridManager->ResetCellVisualStates();
         GridManager->SetGridVisualizationEnabled(false);
     }
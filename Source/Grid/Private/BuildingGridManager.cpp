@@ -3,8 +3,12 @@
 #include "Engine/World.h"
 #include "Components/InstancedStaticMeshComponent.h"
 #include "Materials/MaterialInterface.h"
+#include "HAL/PlatformTime.h"
 #include "BuildingObjectAsset.h"
 #include "BuildingObject.h"
+#include "GridSystemHelpers.h"
+#include "GridNavModifierComponent.h"
+#include "NavAreas/NavArea_Null.h"
 
 // Sets default values
 ABuildingGridManager::ABuildingGridManager()
@@ -20,6 +24,12 @@ ABuildingGridManager::ABuildingGridManager()
     GridMeshComponent->SetupAttachment(RootComponent);
     GridMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
     GridMeshComponent->SetCastShadow(false);
+    
+    // One custom data float per cell instance carries the placement heatmap
+    GridMeshComponent->NumCustomDataFloats = 1;
+    
+    // Occupied cells cannot be walked unless another area is chosen
+    OccupiedNavArea = UNavArea_Null::StaticClass();
 }
 
 // Called when the game starts or when spawned
@@ -35,6 +45,9 @@ void ABuildingGridManager::BeginPlay()
 void ABuildingGridManager::Tick(float DeltaTime)
 {
     Super::Tick(DeltaTime);
+    
+    // Placements and removals of the frame reach navigation as a single batch
+    FlushNavModifiers();
 }
 
 void ABuildingGridManager::InitializeGrid(int32 SizeX, int32 SizeY, float CellSizeValue, int32 MaxFloorsValue)
@@ -47,50 +60,315 @@ void ABuildingGridManager::InitializeGrid(int32 SizeX, int32 SizeY, float CellSi
     
     // Initialize the grid data structure
     GridData.SetNum(MaxFloors);
+    OccupancyPlanes.SetNum(MaxFloors);
+    OccupancyPyramids.SetNum(MaxFloors);
+    RoomIndices.SetNum(MaxFloors);
+    EdgeGrids.SetNum(MaxFloors);
+    InfluenceFields.SetNum(MaxFloors);
+    DistanceFields.SetNum(MaxFloors);
+    DistanceFieldVersions.Init(MAX_uint32, MaxFloors);
+    ZoneLayers.SetNum(MaxFloors);
+    BuildingSlotPlanes.SetNum(MaxFloors);
+    ValidityMaps.Reset();
+    MarkGridChanged();
     
     // For each floor
     for (int32 Floor = 0; Floor < MaxFloors; Floor++)
     {
-        FGridFloor& CurrentFloor = GridData[Floor];
-        CurrentFloor.SetNumRows(GridSizeY);
-        
-        // For each row
-        for (int32 Y = 0; Y < GridSizeY; Y++)
+        InitializeFloor(Floor);
+    }
+    
+    // Sample the ground once, placement only reads the stored heights and slopes from here on
+    if (bSampleTerrain && GetWorld())
+    {
+        const FCollisionQueryParams Params = MakeTerrainQueryParams();
+        Terrain.Init(GridSizeX, GridSizeY, CellSize, [this, &Params](int32 X, int32 Y) { return TraceTerrainHeight(FIntPoint(X, Y), Params); });
+    }
+    else
+    {
+        Terrain.Reset();
+    }
+    
+    CreateNavModifiers();
+    
+    // Update the visual representation
+    UpdateAllCellVisuals();
+}
+
+bool ABuildingGridManager::ExpandGrid(const FIntPoint& AddMin, const FIntPoint& AddMax, int32 AddFloors)
+{
+    if (AddMin.X < 0 || AddMin.Y < 0 || AddMax.X < 0 || AddMax.Y < 0 || AddFloors < 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ExpandGrid: the grid can only grow"));
+        return false;
+    }
+    
+    if (GridData.Num() != MaxFloors || (AddMin == FIntPoint::ZeroValue && AddMax == FIntPoint::ZeroValue && AddFloors == 0))
+    {
+        return false;
+    }
+    
+    const int32 OldSizeX = GridSizeX;
+    const int32 OldSizeY = GridSizeY;
+    const int32 OldFloors = MaxFloors;
+    const int32 NewSizeX = OldSizeX + AddMin.X + AddMax.X;
+    const int32 NewSizeY = OldSizeY + AddMin.Y + AddMax.Y;
+    const FIntPoint Offset = AddMin;
+    
+    // Cached results are laid out for the old size
+    ClearPlacementHeatmap();
+    ValidityMaps.Reset();
+    
+    if (NewSizeX != OldSizeX || NewSizeY != OldSizeY)
+    {
+        // Influence kernels were clipped to the old bounds. Lift the ones reaching past a side that grows and
+        // stamp them again afterwards, so removing the building later subtracts exactly what was added.
+        TArray<ABuildingObject*> ClippedBuildings;
+        for (ABuildingObject* Building : BuildingSlots)
         {
-            FGridRow& CurrentRow = CurrentFloor.GetRow(Y);
-            CurrentRow.SetNumCells(GridSizeX);
+            const UBuildingObjectAsset* BuildingAsset = Building ? Building->GetBuildingAsset() : nullptr;
+            if (!BuildingAsset)
+            {
+                continue;
+            }
             
-            // For each column
-            for (int32 X = 0; X < GridSizeX; X++)
+            int32 Radius = 0;
+            for (const FBuildingInfluenceEmitter& Emitter : BuildingAsset->GetInfluenceEmitters())
             {
-                // Initialize cell data
-                FGridCellData& Cell = CurrentRow.GetCell(X);
-                Cell.GridPosition = FIntPoint(X, Y);
-                Cell.FloorLevel = Floor;
-                Cell.bIsOccupied = false;
-                Cell.bIsWalkable = true;
-                Cell.ObjectOrigin = FIntPoint(X, Y);
-                Cell.OccupyingObject = nullptr;
-                Cell.PathCost = 1.0f;
-                Cell.VisualState = EGridCellVisualState::Normal;
+                Radius = FMath::Max(Radius, Emitter.Radius);
+            }
+            
+            FIntPoint Origin;
+            int32 Floor, Rotation;
+            Building->GetGridProperties(Origin, Floor, Rotation);
+            const TArray<FIntPoint> Cells = BuildingAsset->GetFootprint().GetOccupiedCellPositions(Origin, Rotation);
+            
+            FGridFootprintMask Bounds;
+            Bounds.Build(Cells);
+            if ((AddMin.X > 0 && Bounds.Min.X - Radius < 0) || (AddMin.Y > 0 && Bounds.Min.Y - Radius < 0)
+                || (AddMax.X > 0 && Bounds.Min.X + Bounds.Width + Radius > OldSizeX)
+                || (AddMax.Y > 0 && Bounds.Min.Y + Bounds.Height + Radius > OldSizeY))
+            {
+                ApplyBuildingInfluence(BuildingAsset, Cells, Floor, -1.0f);
+                ClippedBuildings.Add(Building);
+            }
+        }
+        
+        // The per-floor arrays are dense and row-major, so every layer is copied once into the new layout
+        for (int32 Floor = 0; Floor < OldFloors; Floor++)
+        {
+            // Rows only move as a whole; cell data only changes where coordinates shift
+            TArray<FGridRow>& Rows = GridData[Floor].Rows;
+            Rows.InsertDefaulted(0, AddMin.Y);
+            Rows.AddDefaulted(AddMax.Y);
+            for (int32 Y = 0; Y < NewSizeY; Y++)
+            {
+                TArray<FGridCellData>& Cells = Rows[Y].Cells;
+                const bool bOldRow = Y >= Offset.Y && Y < Offset.Y + OldSizeY;
+                if (!bOldRow)
+                {
+                    Cells.SetNum(NewSizeX);
+                    for (int32 X = 0; X < NewSizeX; X++)
+                    {
+                        InitializeCell(Cells[X], FIntPoint(X, Y), Floor);
+                    }
+                    continue;
+                }
                 
-                // Ground floor automatically has utility connections for now
-                if (Floor == 0)
+                Cells.InsertDefaulted(0, AddMin.X);
+                Cells.AddDefaulted(AddMax.X);
+                for (int32 X = 0; X < NewSizeX; X++)
                 {
-                    Cell.bHasWaterConnection = true;
-                    Cell.bHasElectricalConnection = true;
+                    if (X < Offset.X || X >= Offset.X + OldSizeX)
+                    {
+                        InitializeCell(Cells[X], FIntPoint(X, Y), Floor);
+                    }
+                    else if (Offset != FIntPoint::ZeroValue)
+                    {
+                        Cells[X].GridPosition += Offset;
+                        Cells[X].ObjectOrigin += Offset;
+                    }
                 }
-                else
+            }
+            
+            OccupancyPlanes[Floor].Expand(NewSizeX, NewSizeY, Offset);
+            OccupancyPyramids[Floor].Build(OccupancyPlanes[Floor]);
+            EdgeGrids[Floor].Expand(NewSizeX, NewSizeY, Offset);
+            InfluenceFields[Floor].Expand(NewSizeX, NewSizeY, Offset);
+            ZoneLayers[Floor].Expand(NewSizeX, NewSizeY, Offset);
+            ExpandGridValues(BuildingSlotPlanes[Floor], OldSizeX, OldSizeY, NewSizeX, NewSizeY, Offset, static_cast<int32>(INDEX_NONE));
+            RoomIndices[Floor].Expand(Offset, OccupancyPlanes[Floor], EdgeGrids[Floor]);
+        }
+        
+        GridSizeX = NewSizeX;
+        GridSizeY = NewSizeY;
+        
+        // Keep the world in place: buildings and the entrance take the new coordinates, the grid actor moves back
+        if (Offset != FIntPoint::ZeroValue)
+        {
+            for (ABuildingObject* Building : BuildingSlots)
+            {
+                if (Building)
                 {
-                    Cell.bHasWaterConnection = false;
-                    Cell.bHasElectricalConnection = false;
+                    FIntPoint Origin;
+                    int32 Floor, Rotation;
+                    Building->GetGridProperties(Origin, Floor, Rotation);
+                    Building->SetGridProperties(Origin + Offset, Floor, Rotation);
                 }
             }
+            
+            EntranceCell += Offset;
+            SetActorLocation(GetActorLocation() - FVector(Offset.X * CellSize, Offset.Y * CellSize, 0.0f));
         }
+        
+        for (ABuildingObject* Building : ClippedBuildings)
+        {
+            FIntPoint Origin;
+            int32 Floor, Rotation;
+            Building->GetGridProperties(Origin, Floor, Rotation);
+            ApplyBuildingInfluence(Building->GetBuildingAsset(), Building->GetBuildingAsset()->GetFootprint().GetOccupiedCellPositions(Origin, Rotation), Floor, 1.0f);
+        }
+        
+        // Only the added cells are traced, the old samples move with their cells
+        if (Terrain.IsSampled())
+        {
+            const FCollisionQueryParams Params = MakeTerrainQueryParams();
+            Terrain.Expand(NewSizeX, NewSizeY, Offset, [this, &Params](int32 X, int32 Y) { return TraceTerrainHeight(FIntPoint(X, Y), Params); });
+        }
+        
+        // The chunk layout follows the grid size
+        ExpandNavModifiers(Offset, OldSizeX, OldSizeY);
     }
     
-    // Update the visual representation
-    UpdateAllCellVisuals();
+    // New floors start empty
+    MaxFloors = OldFloors + AddFloors;
+    GridData.SetNum(MaxFloors);
+    OccupancyPlanes.SetNum(MaxFloors);
+    OccupancyPyramids.SetNum(MaxFloors);
+    RoomIndices.SetNum(MaxFloors);
+    EdgeGrids.SetNum(MaxFloors);
+    InfluenceFields.SetNum(MaxFloors);
+    ZoneLayers.SetNum(MaxFloors);
+    BuildingSlotPlanes.SetNum(MaxFloors);
+    
+    // Added cells can shorten walks anywhere on a floor, so a distance field is rebuilt when its floor is next scored
+    DistanceFields.SetNum(MaxFloors);
+    DistanceFieldVersions.Init(MAX_uint32, MaxFloors);
+    for (int32 Floor = OldFloors; Floor < MaxFloors; Floor++)
+    {
+        InitializeFloor(Floor);
+    }
+    
+    MarkGridChanged();
+    RemapCellVisuals(OldSizeX, OldSizeY, Offset);
+    
+    for (int32 Floor = 0; Floor < OldFloors; Floor++)
+    {
+        NotifyRoomsChanged(Floor);
+    }
+    
+    UE_LOG(LogTemp, Log, TEXT("Grid expanded to %d x %d cells and %d floors"), GridSizeX, GridSizeY, MaxFloors);
+    OnGridExpanded.Broadcast(Offset);
+    return true;
+}
+
+void ABuildingGridManager::RemapCellVisuals(int32 OldSizeX, int32 OldSizeY, const FIntPoint& Offset)
+{
+    if (!bGridVisualizationEnabled || !GridMeshComponent || CellInstances.Num() != OldSizeX * OldSizeY)
+    {
+        CellInstances.Reset();
+        return;
+    }
+    
+    // Old instances keep their index and transform: they follow their cells through the lookup, and the mesh
+    // component is moved back to where it was before the grid actor shifted. Only added cells get instances.
+    ExpandGridValues(CellInstances, OldSizeX, OldSizeY, GridSizeX, GridSizeY, Offset, static_cast<int32>(INDEX_NONE));
+    if (Offset != FIntPoint::ZeroValue)
+    {
+        GridMeshComponent->SetWorldLocation(GridMeshComponent->GetComponentLocation() + FVector(Offset.X * CellSize, Offset.Y * CellSize, 0.0f));
+    }
+    
+    TArray<int32> AddedCells;
+    TArray<FTransform> AddedTransforms;
+    AddedCells.Reserve(CellInstances.Num() - OldSizeX * OldSizeY);
+    AddedTransforms.Reserve(CellInstances.Num() - OldSizeX * OldSizeY);
+    for (int32 CellIndex = 0; CellIndex < CellInstances.Num(); CellIndex++)
+    {
+        if (CellInstances[CellIndex] != INDEX_NONE)
+        {
+            continue;
+        }
+        
+        FTransform CellTransform;
+        CellTransform.SetLocation(GridToWorld(FIntPoint(CellIndex % GridSizeX, CellIndex / GridSizeX), ActiveFloorLevel) - FVector(0, 0, CellSize * 0.5f));
+        CellTransform.SetScale3D(FVector(CellSize / 100.0f));
+        AddedCells.Add(CellIndex);
+        AddedTransforms.Add(CellTransform);
+    }
+    
+    if (AddedTransforms.Num() > 0)
+    {
+        const TArray<int32> AddedInstances = GridMeshComponent->AddInstances(AddedTransforms, true, true);
+        for (int32 Index = 0; Index < AddedInstances.Num(); Index++)
+        {
+            CellInstances[AddedCells[Index]] = AddedInstances[Index];
+        }
+    }
+    GridMeshComponent->MarkRenderStateDirty();
+}
+
+void ABuildingGridManager::InitializeFloor(int32 Floor)
+{
+    FGridFloor& CurrentFloor = GridData[Floor];
+    CurrentFloor.SetNumRows(GridSizeY);
+    
+    // For each row
+    for (int32 Y = 0; Y < GridSizeY; Y++)
+    {
+        FGridRow& CurrentRow = CurrentFloor.GetRow(Y);
+        CurrentRow.SetNumCells(GridSizeX);
+        
+        // For each column
+        for (int32 X = 0; X < GridSizeX; X++)
+        {
+            InitializeCell(CurrentRow.GetCell(X), FIntPoint(X, Y), Floor);
+        }
+    }
+    
+    // Every cell starts free, so each floor begins as a single room
+    OccupancyPlanes[Floor].Init(GridSizeX, GridSizeY, false);
+    OccupancyPyramids[Floor].Build(OccupancyPlanes[Floor]);
+    EdgeGrids[Floor].Init(GridSizeX, GridSizeY);
+    InfluenceFields[Floor].Init(GridSizeX, GridSizeY);
+    ZoneLayers[Floor].Init(GridSizeX, GridSizeY);
+    BuildingSlotPlanes[Floor].Init(INDEX_NONE, GridSizeX * GridSizeY);
+    RoomIndices[Floor].Rebuild(OccupancyPlanes[Floor], EdgeGrids[Floor]);
+    RoomIndices[Floor].ResetChangedRooms();
+}
+
+void ABuildingGridManager::InitializeCell(FGridCellData& Cell, const FIntPoint& GridPosition, int32 Floor) const
+{
+    // Initialize cell data
+    Cell.GridPosition = GridPosition;
+    Cell.FloorLevel = Floor;
+    Cell.bIsOccupied = false;
+    Cell.bIsWalkable = true;
+    Cell.ObjectOrigin = GridPosition;
+    Cell.OccupyingObject = nullptr;
+    Cell.PathCost = 1.0f;
+    Cell.VisualState = EGridCellVisualState::Normal;
+    
+    // Ground floor automatically has utility connections for now
+    if (Floor == 0)
+    {
+        Cell.bHasWaterConnection = true;
+        Cell.bHasElectricalConnection = true;
+    }
+    else
+    {
+        Cell.bHasWaterConnection = false;
+        Cell.bHasElectricalConnection = false;
+    }
 }
 
 FGridCellData ABuildingGridManager::GetCellData(const FIntPoint& GridPosition, int32 FloorLevel) const
@@ -107,9 +385,6 @@ FGridCellData ABuildingGridManager::GetCellData(const FIntPoint& GridPosition, i
 
 FIntPoint ABuildingGridManager::WorldToGrid(const FVector& WorldPosition, int32& OutFloorLevel) const
 {
-    // Calculate floor level first
-    OutFloorLevel = FMath::Clamp(FMath::FloorToInt(WorldPosition.Z / FloorHeight), 0, MaxFloors - 1);
-    
     // Convert world XY to grid XY
     // Add half cell size to ensure proper rounding (center of cell)
     float GridX = (WorldPosition.X - GetActorLocation().X + (CellSize * 0.5f)) / CellSize;
@@ -119,6 +394,10 @@ FIntPoint ABuildingGridManager::WorldToGrid(const FVector& WorldPosition, int32&
     int32 X = FMath::Clamp(FMath::FloorToInt(GridX), 0, GridSizeX - 1);
     int32 Y = FMath::Clamp(FMath::FloorToInt(GridY), 0, GridSizeY - 1);
     
+    // Floors are stacked on the ground under the cell
+    const float Height = WorldPosition.Z - GetActorLocation().Z - GetFloorBaseHeight(X, Y, 0);
+    OutFloorLevel = FMath::Clamp(FMath::FloorToInt(Height / FloorHeight), 0, MaxFloors - 1);
+    
     return FIntPoint(X, Y);
 }
 
@@ -127,7 +406,7 @@ FVector ABuildingGridManager::GridToWorld(const FIntPoint& GridPosition, int32 F
     // Convert grid coordinates to world position
     float WorldX = GetActorLocation().X + (GridPosition.X * CellSize);
     float WorldY = GetActorLocation().Y + (GridPosition.Y * CellSize);
-    float WorldZ = GetActorLocation().Z + (FloorLevel * FloorHeight);
+    float WorldZ = GetActorLocation().Z + GetFloorBaseHeight(GridPosition.X, GridPosition.Y, FloorLevel);
     
     // Return the center of the cell
     return FVector(WorldX + (CellSize * 0.5f), WorldY + (CellSize * 0.5f), WorldZ);
@@ -144,378 +423,1965 @@ bool ABuildingGridManager::IsValidGridPosition(const FIntPoint& GridPosition, in
            GridPosition.Y < GridSizeY;
 }
 
-bool ABuildingGridManager::CanPlaceBuilding(UBuildingObjectAsset* BuildingAsset, const FVector& WorldLocation, int32 Rotation, int32 FloorLevel)
+int32 ABuildingGridManager::GetRoomIdAt(const FIntPoint& GridPosition, int32 FloorLevel) const
+{
+    if (!IsValidGridPosition(GridPosition, FloorLevel))
+    {
+        return INDEX_NONE;
+    }
+
+    return RoomIndices[FloorLevel].GetRoomId(GridPosition);
+}
+
+bool ABuildingGridManager::GetRoomInfo(int32 RoomId, int32 FloorLevel, FGridRoomInfo& OutInfo) const
+{
+    if (!RoomIndices.IsValidIndex(FloorLevel))
+    {
+        return false;
+    }
+
+    return RoomIndices[FloorLevel].GetRoomInfo(RoomId, OutInfo);
+}
+
+bool ABuildingGridManager::PlaceEdge(const FIntPoint& GridPosition, EGridDirection Side, EGridEdgeType EdgeType, int32 FloorLevel)
 {
     // Validate input parameters
-    if (!BuildingAsset)
+    if (EdgeType == EGridEdgeType::None || Side == EGridDirection::Any || !IsValidGridPosition(GridPosition, FloorLevel))
     {
         return false;
     }
     
-    // Convert world location to grid position
-    int32 DetectedFloor;
-    FIntPoint GridOrigin = WorldToGrid(WorldLocation, DetectedFloor);
+    FGridEdgeGrid& Edges = EdgeGrids[FloorLevel];
+    const EGridEdgeType PreviousType = Edges.GetEdge(GridPosition, Side);
+    if (PreviousType == EdgeType)
+    {
+        return false;
+    }
     
-    // Use detected floor if not specified
-    if (FloorLevel < 0)
+    Edges.SetEdge(GridPosition, Side, EdgeType);
+    MarkGridChanged();
+    
+    // Swapping one element for another keeps the rooms as they were
+    if (PreviousType == EGridEdgeType::None)
     {
-        FloorLevel = DetectedFloor;
+        RoomIndices[FloorLevel].OnEdgeClosed(GridPosition, Side, OccupancyPlanes[FloorLevel], Edges);
+        NotifyRoomsChanged(FloorLevel);
     }
     
-    // Check if the building footprint is available
-    const FBuildingFootprint& Footprint = BuildingAsset->GetFootprint();
-    if (!AreCellsAvailableForBuilding(Footprint, GridOrigin, Rotation, FloorLevel))
+    OnEdgeChanged.Broadcast(GridPosition, Side, FloorLevel, EdgeType);
+    return true;
+}
+
+bool ABuildingGridManager::RemoveEdge(const FIntPoint& GridPosition, EGridDirection Side, int32 FloorLevel)
+{
+    if (Side == EGridDirection::Any || !IsValidGridPosition(GridPosition, FloorLevel))
     {
         return false;
     }
     
-    // Check adjacency requirements
-    if (!CheckAdjacencyRequirements(BuildingAsset->GetAdjacencyRequirements(), GridOrigin, FloorLevel))
+    FGridEdgeGrid& Edges = EdgeGrids[FloorLevel];
+    if (Edges.GetEdge(GridPosition, Side) == EGridEdgeType::None)
     {
         return false;
     }
     
-    // All checks passed
+    Edges.SetEdge(GridPosition, Side, EGridEdgeType::None);
+    MarkGridChanged();
+    RoomIndices[FloorLevel].OnEdgeOpened(GridPosition, Side, OccupancyPlanes[FloorLevel], Edges);
+    NotifyRoomsChanged(FloorLevel);
+    
+    OnEdgeChanged.Broadcast(GridPosition, Side, FloorLevel, EGridEdgeType::None);
     return true;
 }
 
-ABuildingObject* ABuildingGridManager::PlaceBuilding(UBuildingObjectAsset* BuildingAsset, const FVector& WorldLocation, int32 Rotation, int32 FloorLevel)
+EGridEdgeType ABuildingGridManager::GetEdge(const FIntPoint& GridPosition, EGridDirection Side, int32 FloorLevel) const
 {
-    // First check if placement is possible
-    if (!CanPlaceBuilding(BuildingAsset, WorldLocation, Rotation, FloorLevel))
+    if (!IsValidGridPosition(GridPosition, FloorLevel))
     {
-        return nullptr;
+        return EGridEdgeType::None;
     }
     
-    // Convert world location to grid position
-    int32 DetectedFloor;
-    FIntPoint GridOrigin = WorldToGrid(WorldLocation, DetectedFloor);
+    return EdgeGrids[FloorLevel].GetEdge(GridPosition, Side);
+}
+
+bool ABuildingGridManager::IsMovementBlocked(const FIntPoint& GridPosition, EGridDirection Direction, int32 FloorLevel) const
+{
+    const FIntPoint Target = GridPosition + GridSystemHelpers::GetDirectionVector(Direction);
+    if (Direction == EGridDirection::Any || !IsValidGridPosition(GridPosition, FloorLevel) || !IsValidGridPosition(Target, FloorLevel))
+    {
+        return true;
+    }
     
-    // Use detected floor if not specified
-    if (FloorLevel < 0)
+    // Same planes the room index reads: occupancy of the target cell, then the edge in between
+    if (OccupancyPlanes[FloorLevel].Get(Target.X, Target.Y))
     {
-        FloorLevel = DetectedFloor;
+        return true;
     }
     
-    // Calculate world position for origin cell (center of cell)
-    FVector Origin = GridToWorld(GridOrigin, FloorLevel);
+    return EdgeGrids[FloorLevel].BlocksMovement(GridPosition, Direction);
+}
+
+float ABuildingGridManager::GetInfluenceAt(const FIntPoint& GridPosition, EGridInfluenceChannel Channel, int32 FloorLevel) const
+{
+    if (!IsValidGridPosition(GridPosition, FloorLevel) || Channel == EGridInfluenceChannel::Count)
+    {
+        return 0.0f;
+    }
     
-    // Spawn the building object
-    FActorSpawnParameters SpawnParams;
-    SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+    return InfluenceFields[FloorLevel].GetValue(Channel, GridPosition.X, GridPosition.Y);
+}
+
+float ABuildingGridManager::GetTerrainHeight(const FIntPoint& GridPosition) const
+{
+    return GetActorLocation().Z + Terrain.GetHeight(GridPosition.X, GridPosition.Y);
+}
+
+float ABuildingGridManager::GetTerrainSlope(const FIntPoint& GridPosition) const
+{
+    return Terrain.GetSlope(GridPosition.X, GridPosition.Y);
+}
+
+void ABuildingGridManager::PaintZoneRect(const FIntPoint& Min, const FIntPoint& Max, EGridZone Zone, int32 FloorLevel)
+{
+    if (FloorLevel < 0 || FloorLevel >= MaxFloors || Zone == EGridZone::Count)
+    {
+        return;
+    }
     
-    ABuildingObject* Building = GetWorld()->SpawnActor<ABuildingObject>(
-        BuildingAsset->GetBuildingClass(), 
-        Origin, 
-        FRotator(0.0f, Rotation * 90.0f, 0.0f), 
-        SpawnParams
-    );
+    // Corners may be given in any order
+    const FIntRect Rect(
+        FMath::Min(Min.X, Max.X), FMath::Min(Min.Y, Max.Y),
+        FMath::Max(Min.X, Max.X) + 1, FMath::Max(Min.Y, Max.Y) + 1);
     
-    if (Building)
+    ZoneLayers[FloorLevel].PaintRect(Rect, Zone);
+    MarkGridChanged();
+}
+
+void ABuildingGridManager::PaintZoneBrush(const FIntPoint& Center, int32 Radius, EGridZone Zone, int32 FloorLevel)
+{
+    if (FloorLevel < 0 || FloorLevel >= MaxFloors || Zone == EGridZone::Count)
     {
-        // Initialize the building with its asset
-        Building->InitializeFromAsset(BuildingAsset);
-        
-        // Set the building's grid properties
-        Building->SetGridProperties(GridOrigin, FloorLevel, Rotation);
-        
-        // Mark cells as occupied
-        MarkCellsAsOccupied(BuildingAsset->GetFootprint(), GridOrigin, Rotation, FloorLevel, Building);
-        
-        // Update visuals
-        UpdateAllCellVisuals();
+        return;
     }
     
-    return Building;
+    ZoneLayers[FloorLevel].PaintBrush(Center, Radius, Zone);
+    MarkGridChanged();
 }
 
-bool ABuildingGridManager::RemoveBuilding(const FIntPoint& GridPosition, int32 FloorLevel)
+EGridZone ABuildingGridManager::GetZoneAt(const FIntPoint& GridPosition, int32 FloorLevel) const
 {
-    // Check if position is valid
     if (!IsValidGridPosition(GridPosition, FloorLevel))
     {
-        return false;
+        return EGridZone::None;
     }
     
-    // Get the cell data
-    const FGridCellData& Cell = GridData[FloorLevel].GetRow(GridPosition.Y).GetCell(GridPosition.X);
+    return ZoneLayers[FloorLevel].GetZone(GridPosition.X, GridPosition.Y);
+}
+
+TArray<FIntPoint> ABuildingGridManager::GetZoneCells(EGridZone Zone, int32 FloorLevel) const
+{
+    TArray<FIntPoint> Cells;
+    if (FloorLevel < 0 || FloorLevel >= MaxFloors || Zone == EGridZone::Count)
+    {
+        return Cells;
+    }
     
-    // Check if cell is occupied
-    if (!Cell.bIsOccupied || !Cell.OccupyingObject)
+    const FGridZoneLayer& Layer = ZoneLayers[FloorLevel];
+    Cells.Reserve(Layer.CountCells(Zone));
+    
+    // Walk the runs instead of testing every cell
+    Layer.ForEachRun(Zone, [&Cells](int32 Y, int32 StartX, int32 Length)
     {
-        return false;
+        for (int32 X = StartX; X < StartX + Length; X++)
+        {
+            Cells.Add(FIntPoint(X, Y));
+        }
+    });
+    
+    return Cells;
+}
+
+int32 ABuildingGridManager::CountZoneCells(EGridZone Zone, int32 FloorLevel) const
+{
+    if (FloorLevel < 0 || FloorLevel >= MaxFloors || Zone == EGridZone::Count)
+    {
+        return 0;
     }
     
-    // Get the building object
-    ABuildingObject* Building = Cast<ABuildingObject>(Cell.OccupyingObject);
-    if (!Building)
+    return ZoneLayers[FloorLevel].CountCells(Zone);
+}
+
+bool ABuildingGridManager::CanPlaceBuilding(UBuildingObjectAsset* BuildingAsset, const FVector& WorldLocation, int32 Rotation, int32 FloorLevel)
+{
+    // Validate input parameters
+    if (!BuildingAsset)
     {
         return false;
     }
     
-    // Get the building's grid properties
-    FIntPoint BuildingOrigin;
-    int32 BuildingFloor;
-    int32 BuildingRotation;
-    Building->GetGridProperties(BuildingOrigin, BuildingFloor, BuildingRotation);
-    
+    // Convert world location to grid position
+    int32 DetectedFloor;
+    FIntPoint GridOrigin = WorldToGrid(WorldLocation, DetectedFloor);
+    
+    // Use detected floor if not specified
+    if (FloorLevel < 0)
+    {
+        FloorLevel = DetectedFloor;
+    }
+    
+    return CanPlaceBuildingAtCell(BuildingAsset, GridOrigin, Rotation, FloorLevel);
+}
+
+bool ABuildingGridManager::CanPlaceBuildingAtCell(const UBuildingObjectAsset* BuildingAsset, const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel)
+{
+    // A prefetched validity map answers bounds, occupancy, support and zoning with a single bit
+    if (const FGridBitPlane* ValidityMap = FindValidityMap(BuildingAsset, Rotation, FloorLevel))
+    {
+        if (!ValidityMap->IsValidCell(GridOrigin.X, GridOrigin.Y) || !ValidityMap->Get(GridOrigin.X, GridOrigin.Y))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        // Check if the building footprint is available
+        FGridFootprintMask Mask;
+        Mask.Build(BuildingAsset->GetFootprint().GetOccupiedCellPositions(GridOrigin, Rotation));
+        if (!IsFootprintMaskAvailable(Mask, FloorLevel))
+        {
+            return false;
+        }
+        
+        // Check zoning, every footprint cell must lie in an allowed zone
+        if (BuildingAsset->AllowedZones != 0 && !Mask.IsEmpty() && !ZoneLayers[FloorLevel].IsFootprintInZones(Mask, BuildingAsset->AllowedZones))
+        {
+            return false;
+        }
+        
+        // Check the ground under the footprint
+        if (!IsFootprintOnSuitableTerrain(BuildingAsset, Mask, FloorLevel))
+        {
+            return false;
+        }
+    }
+    
+    // Check adjacency requirements
+    if (!CheckAdjacencyRequirements(BuildingAsset->GetAdjacencyRequirements(), GridOrigin, FloorLevel))
+    {
+        return false;
+    }
+    
+    // All checks passed
+    return true;
+}
+
+FPlacementScore ABuildingGridManager::GetPlacementScore(UBuildingObjectAsset* BuildingAsset, const FVector& WorldLocation, int32 Rotation, int32 FloorLevel)
+{
+    if (!BuildingAsset)
+    {
+        return FPlacementScore();
+    }
+    
+    // Convert world location to grid position
+    int32 DetectedFloor;
+    FIntPoint GridOrigin = WorldToGrid(WorldLocation, DetectedFloor);
+    
+    // Use detected floor if not specified
+    if (FloorLevel < 0)
+    {
+        FloorLevel = DetectedFloor;
+    }
+    
+    return ComputePlacementScore(BuildingAsset, GridOrigin, Rotation, FloorLevel);
+}
+
+FPlacementScore ABuildingGridManager::ComputePlacementScore(const UBuildingObjectAsset* BuildingAsset, const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel)
+{
+    FPlacementScore Result;
+    if (!BuildingAsset || !InfluenceFields.IsValidIndex(FloorLevel))
+    {
+        return Result;
+    }
+    
+    Result.bIsValidPlacement = CanPlaceBuildingAtCell(BuildingAsset, GridOrigin, Rotation, FloorLevel);
+    
+    EnsureDistanceField(FloorLevel);
+    const FGridInfluenceField& Field = InfluenceFields[FloorLevel];
+    const FGridDistanceField& Distances = DistanceFields[FloorLevel];
+    
+    // Sample the precomputed fields under the footprint, nothing is recomputed here
+    int32 NumSamples = 0;
+    uint16 ClosestDistance = FGridDistanceField::Unreachable;
+    for (const FIntPoint& Cell : BuildingAsset->GetFootprint().GetOccupiedCellPositions(GridOrigin, Rotation))
+    {
+        if (!IsValidGridPosition(Cell, FloorLevel))
+        {
+            continue;
+        }
+        
+        Result.Tranquility += Field.GetValue(EGridInfluenceChannel::Tranquility, Cell.X, Cell.Y);
+        Result.Noise += Field.GetValue(EGridInfluenceChannel::Noise, Cell.X, Cell.Y);
+        Result.Appeal += Field.GetValue(EGridInfluenceChannel::Appeal, Cell.X, Cell.Y);
+        ClosestDistance = FMath::Min(ClosestDistance, Distances.GetDistance(Cell.X, Cell.Y));
+        NumSamples++;
+    }
+    
+    if (NumSamples > 0)
+    {
+        Result.Tranquility /= NumSamples;
+        Result.Noise /= NumSamples;
+        Result.Appeal /= NumSamples;
+    }
+    
+    Result.Score = Result.Tranquility * TranquilityScoreWeight
+        + Result.Appeal * AppealScoreWeight
+        - Result.Noise * NoiseScoreWeight;
+    
+    if (ClosestDistance != FGridDistanceField::Unreachable)
+    {
+        Result.WalkingDistance = ClosestDistance;
+        Result.Score -= ClosestDistance * WalkingDistanceScoreWeight;
+    }
+    
+    return Result;
+}
+
+void ABuildingGridManager::EnsureDistanceField(int32 FloorLevel)
+{
+    // Only the floor being scored is rebuilt, the others wait until they are needed
+    if (!DistanceFieldVersions.IsValidIndex(FloorLevel) || DistanceFieldVersions[FloorLevel] == GridVersion)
+    {
+        return;
+    }
+    
+    TArray<FIntPoint> Sources;
+    Sources.Add(EntranceCell);
+    DistanceFields[FloorLevel].Build(OccupancyPlanes[FloorLevel], EdgeGrids[FloorLevel], Sources);
+    
+    DistanceFieldVersions[FloorLevel] = GridVersion;
+}
+
+bool ABuildingGridManager::UpdatePlacementHeatmap(UBuildingObjectAsset* BuildingAsset, int32 Rotation, int32 FloorLevel, float BudgetMilliseconds)
+{
+    if (!BuildingAsset || FloorLevel < 0 || FloorLevel >= MaxFloors)
+    {
+        return false;
+    }
+    
+    // Restart whenever the inputs or the grid change
+    if (Heatmap.Asset.Get() != BuildingAsset || Heatmap.Rotation != Rotation || Heatmap.FloorLevel != FloorLevel || Heatmap.Version != GridVersion)
+    {
+        Heatmap.Asset = BuildingAsset;
+        Heatmap.Rotation = Rotation;
+        Heatmap.FloorLevel = FloorLevel;
+        Heatmap.Version = GridVersion;
+        Heatmap.NextCell = 0;
+        Heatmap.bApplied = false;
+        Heatmap.Scores.SetNumUninitialized(GridSizeX * GridSizeY);
+        Heatmap.Valid.Init(false, GridSizeX * GridSizeY);
+        
+        const TArray<FIntPoint> FootprintCells = BuildingAsset->GetFootprint().GetOccupiedCellPositions(FIntPoint::ZeroValue, Rotation);
+        Heatmap.Footprint.Build(FootprintCells);
+        Heatmap.bFootprintFillsBounds = FootprintCells.Num() == Heatmap.Footprint.Width * Heatmap.Footprint.Height;
+    }
+    
+    if (Heatmap.bApplied)
+    {
+        return true;
+    }
+    
+    // Rebuilding the floor's distance field counts against the budget like the scoring does
+    const double EndTime = FPlatformTime::Seconds() + BudgetMilliseconds * 0.001;
+    EnsureDistanceField(FloorLevel);
+    if (FPlatformTime::Seconds() > EndTime)
+    {
+        return false;
+    }
+    
+    // Score origins until the budget runs out, checking the clock every few cells
+    const int32 NumCells = GridSizeX * GridSizeY;
+    while (Heatmap.NextCell < NumCells)
+    {
+        const int32 CellIndex = Heatmap.NextCell++;
+        const FIntPoint GridOrigin(CellIndex % GridSizeX, CellIndex / GridSizeX);
+        
+        // Invalid origins are never shown, so blocked ones skip sampling the fields
+        if (IsFootprintCoarselyBlocked(Heatmap.Footprint, Heatmap.bFootprintFillsBounds, GridOrigin, FloorLevel))
+        {
+            Heatmap.Scores[CellIndex] = 0.0f;
+            Heatmap.Valid[CellIndex] = false;
+        }
+        else
+        {
+            const FPlacementScore Score = ComputePlacementScore(BuildingAsset, GridOrigin, Rotation, FloorLevel);
+            Heatmap.Scores[CellIndex] = Score.Score;
+            Heatmap.Valid[CellIndex] = Score.bIsValidPlacement;
+        }
+        
+        if ((CellIndex & 63) == 63 && FPlatformTime::Seconds() > EndTime)
+        {
+            return false;
+        }
+    }
+    
+    ApplyPlacementHeatmap();
+    Heatmap.bApplied = true;
+    return true;
+}
+
+void ABuildingGridManager::ApplyPlacementHeatmap()
+{
+    const int32 NumCells = GridSizeX * GridSizeY;
+    if (Heatmap.Scores.Num() != NumCells)
+    {
+        return;
+    }
+    
+    // Normalize the valid scores to 0-1, invalid origins stay at 0
+    float MinScore = MAX_flt;
+    float MaxScore = -MAX_flt;
+    for (TConstSetBitIterator<> It(Heatmap.Valid); It; ++It)
+    {
+        MinScore = FMath::Min(MinScore, Heatmap.Scores[It.GetIndex()]);
+        MaxScore = FMath::Max(MaxScore, Heatmap.Scores[It.GetIndex()]);
+    }
+    const float Range = FMath::Max(MaxScore - MinScore, KINDA_SMALL_NUMBER);
+    
+    if (bGridVisualizationEnabled && GridMeshComponent && Heatmap.FloorLevel == ActiveFloorLevel)
+    {
+        const int32 NumInstances = FMath::Min(NumCells, CellInstances.Num());
+        for (int32 CellIndex = 0; CellIndex < NumInstances; CellIndex++)
+        {
+            if (CellInstances[CellIndex] != INDEX_NONE)
+            {
+                const float Heat = Heatmap.Valid[CellIndex] ? (Heatmap.Scores[CellIndex] - MinScore) / Range : 0.0f;
+                GridMeshComponent->SetCustomDataValue(CellInstances[CellIndex], 0, Heat, false);
+            }
+        }
+        GridMeshComponent->MarkRenderStateDirty();
+    }
+}
+
+void ABuildingGridManager::ClearPlacementHeatmap()
+{
+    if (Heatmap.bApplied && GridMeshComponent)
+    {
+        const int32 NumInstances = GridMeshComponent->GetInstanceCount();
+        for (int32 InstanceIndex = 0; InstanceIndex < NumInstances; InstanceIndex++)
+        {
+            GridMeshComponent->SetCustomDataValue(InstanceIndex, 0, 0.0f, false);
+        }
+        GridMeshComponent->MarkRenderStateDirty();
+    }
+    
+    Heatmap = FPlacementHeatmapState();
+}
+
+TArray<FIntPoint> ABuildingGridManager::GetBestPlacementSpots(int32 Count) const
+{
+    TArray<FIntPoint> Result;
+    if (!Heatmap.bApplied || Count <= 0)
+    {
+        return Result;
+    }
+    
+    TArray<int32> Candidates;
+    for (TConstSetBitIterator<> It(Heatmap.Valid); It; ++It)
+    {
+        Candidates.Add(It.GetIndex());
+    }
+    
+    // Only the best few are needed, so a partial heap beats sorting everything
+    auto IsBetter = [this](int32 A, int32 B) { return Heatmap.Scores[A] > Heatmap.Scores[B]; };
+    Candidates.Heapify(IsBetter);
+    
+    while (Result.Num() < Count && Candidates.Num() > 0)
+    {
+        int32 CellIndex;
+        Candidates.HeapPop(CellIndex, IsBetter, EAllowShrinking::No);
+        Result.Add(FIntPoint(CellIndex % GridSizeX, CellIndex / GridSizeX));
+    }
+    
+    return Result;
+}
+
+bool ABuildingGridManager::FindNearestPlacement(UBuildingObjectAsset* BuildingAsset, const FIntPoint& GridPosition, int32 Rotation, int32 FloorLevel, int32 MaxDistance, FIntPoint& OutOrigin)
+{
+    if (!BuildingAsset || FloorLevel < 0 || FloorLevel >= MaxFloors)
+    {
+        return false;
+    }
+    
+    const TArray<FIntPoint> FootprintCells = BuildingAsset->GetFootprint().GetOccupiedCellPositions(FIntPoint::ZeroValue, Rotation);
+    FGridFootprintMask Footprint;
+    Footprint.Build(FootprintCells);
+    const bool bFillsBounds = FootprintCells.Num() == Footprint.Width * Footprint.Height;
+    
+    // Walk square rings outwards and keep the closest valid origin of the first ring that has one
+    for (int32 Distance = 0; Distance <= MaxDistance; Distance++)
+    {
+        int32 BestDistanceSquared = MAX_int32;
+        for (int32 OffsetY = -Distance; OffsetY <= Distance; OffsetY++)
+        {
+            // Inner rows of the ring only have their two ends
+            const bool bEdgeRow = FMath::Abs(OffsetY) == Distance;
+            const int32 StepX = bEdgeRow ? 1 : FMath::Max(2 * Distance, 1);
+            for (int32 OffsetX = -Distance; OffsetX <= Distance; OffsetX += StepX)
+            {
+                const FIntPoint Candidate(GridPosition.X + OffsetX, GridPosition.Y + OffsetY);
+                const int32 DistanceSquared = OffsetX * OffsetX + OffsetY * OffsetY;
+                if (DistanceSquared >= BestDistanceSquared || !IsValidGridPosition(Candidate, FloorLevel))
+                {
+                    continue;
+                }
+                
+                if (!IsFootprintCoarselyBlocked(Footprint, bFillsBounds, Candidate, FloorLevel) && CanPlaceBuildingAtCell(BuildingAsset, Candidate, Rotation, FloorLevel))
+                {
+                    BestDistanceSquared = DistanceSquared;
+                    OutOrigin = Candidate;
+                }
+            }
+        }
+        
+        if (BestDistanceSquared != MAX_int32)
+        {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+bool ABuildingGridManager::SnapPlacementLocation(UBuildingObjectAsset* BuildingAsset, const FVector& WorldLocation, int32 Rotation, int32 FloorLevel, int32 MaxDistance, FVector& OutLocation)
+{
+    int32 DetectedFloor;
+    FIntPoint Origin;
+    if (!FindNearestPlacement(BuildingAsset, WorldToGrid(WorldLocation, DetectedFloor), Rotation, FloorLevel, MaxDistance, Origin))
+    {
+        return false;
+    }
+    
+    // WorldToGrid rounds to the nearest cell corner, so the corner of the origin resolves back to it
+    OutLocation = GridToWorld(Origin, FloorLevel) - FVector(CellSize * 0.5f, CellSize * 0.5f, 0.0f);
+    return true;
+}
+
+void ABuildingGridManager::PrefetchValidityMap(UBuildingObjectAsset* BuildingAsset, int32 Rotation, int32 FloorLevel)
+{
+    if (!BuildingAsset || FloorLevel < 0 || FloorLevel >= MaxFloors)
+    {
+        return;
+    }
+    
+    FGridValidityKey Key;
+    Key.Asset = BuildingAsset;
+    Key.Rotation = Rotation;
+    Key.FloorLevel = FloorLevel;
+    Key.Version = GridVersion;
+    if (ValidityMaps.Contains(Key))
+    {
+        return;
+    }
+    
+    // The task works on copies, so the grid may change while it runs; its map is then just never used
+    FGridValiditySnapshot Snapshot;
+    Snapshot.Footprint.Build(BuildingAsset->GetFootprint().GetOccupiedCellPositions(FIntPoint::ZeroValue, Rotation));
+    Snapshot.Occupancy = OccupancyPlanes[FloorLevel];
+    Snapshot.bNeedsSupport = FloorLevel > 0;
+    if (Snapshot.bNeedsSupport)
+    {
+        Snapshot.Support = OccupancyPlanes[FloorLevel - 1];
+    }
+    Snapshot.bZoned = BuildingAsset->AllowedZones != 0;
+    if (Snapshot.bZoned)
+    {
+        ZoneLayers[FloorLevel].GetAllowedPlane(BuildingAsset->AllowedZones, Snapshot.AllowedZones);
+    }
+    Snapshot.bTerrainLimited = FloorLevel == 0 && Terrain.IsSampled() && !Snapshot.Footprint.IsEmpty()
+        && (BuildingAsset->MaxTerrainSlope > 0.0f || BuildingAsset->MaxTerrainHeightDelta > 0.0f);
+    if (Snapshot.bTerrainLimited)
+    {
+        Snapshot.SuitableTerrain = Terrain.GetSuitablePlane(FIntPoint(Snapshot.Footprint.Width, Snapshot.Footprint.Height), BuildingAsset->MaxTerrainSlope, BuildingAsset->MaxTerrainHeightDelta);
+    }
+    
+    ValidityMaps.Request(Key, MoveTemp(Snapshot));
+}
+
+const FGridBitPlane* ABuildingGridManager::FindValidityMap(const UBuildingObjectAsset* BuildingAsset, int32 Rotation, int32 FloorLevel)
+{
+    if (ValidityMaps.Num() == 0)
+    {
+        return nullptr;
+    }
+    
+    FGridValidityKey Key;
+    Key.Asset = BuildingAsset;
+    Key.Rotation = Rotation;
+    Key.FloorLevel = FloorLevel;
+    Key.Version = GridVersion;
+    return ValidityMaps.Find(Key);
+}
+
+ABuildingObject* ABuildingGridManager::PlaceBuilding(UBuildingObjectAsset* BuildingAsset, const FVector& WorldLocation, int32 Rotation, int32 FloorLevel)
+{
+    // First check if placement is possible
+    if (!CanPlaceBuilding(BuildingAsset, WorldLocation, Rotation, FloorLevel))
+    {
+        return nullptr;
+    }
+    
+    // Convert world location to grid position
+    int32 DetectedFloor;
+    FIntPoint GridOrigin = WorldToGrid(WorldLocation, DetectedFloor);
+    
+    // Use detected floor if not specified
+    if (FloorLevel < 0)
+    {
+        FloorLevel = DetectedFloor;
+    }
+    
+    ABuildingObject* Building = SpawnBuildingAtCell(BuildingAsset, GridOrigin, Rotation, FloorLevel);
+    
+    if (Building)
+    {
+        // Update visuals
+        UpdateAllCellVisuals();
+        
+        OnBuildingPlaced.Broadcast(Building->GetBuildingHandle(), Building);
+    }
+    
+    return Building;
+}
+
+ABuildingObject* ABuildingGridManager::SpawnBuildingAtCell(UBuildingObjectAsset* BuildingAsset, const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel)
+{
+    // Calculate world position for origin cell (center of cell)
+    FVector Origin = GridToWorld(GridOrigin, FloorLevel);
+    
+    // Spawn the building object
+    FActorSpawnParameters SpawnParams;
+    SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+    
+    ABuildingObject* Building = GetWorld()->SpawnActor<ABuildingObject>(
+        BuildingAsset->GetBuildingClass(), 
+        Origin, 
+        FRotator(0.0f, Rotation * 90.0f, 0.0f), 
+        SpawnParams
+    );
+    
+    if (Building)
+    {
+        // Initialize the building with its asset
+        Building->InitializeFromAsset(BuildingAsset);
+        
+        // Set the building's grid properties
+        Building->SetGridProperties(GridOrigin, FloorLevel, Rotation);
+        
+        // Navigation comes from the grid modifiers, the building's collision would only dirty it a second time
+        if (bUseGridNavModifiers)
+        {
+            Building->SetCanAffectNavigationGeneration(false);
+        }
+        
+        // Give the building a stable handle
+        Building->SetBuildingHandle(RegisterBuilding(Building));
+        
+        // Mark cells as occupied
+        MarkCellsAsOccupied(BuildingAsset->GetFootprint(), GridOrigin, Rotation, FloorLevel, Building, Building->GetBuildingHandle().Index);
+        
+        // Spread the building's ambience around its footprint
+        ApplyBuildingInfluence(BuildingAsset, BuildingAsset->GetFootprint().GetOccupiedCellPositions(GridOrigin, Rotation), FloorLevel, 1.0f);
+    }
+    
+    return Building;
+}
+
+bool ABuildingGridManager::RemoveBuilding(const FIntPoint& GridPosition, int32 FloorLevel)
+{
+    // Check if position is valid
+    if (!IsValidGridPosition(GridPosition, FloorLevel))
+    {
+        return false;
+    }
+    
+    // Get the cell data
+    const FGridCellData& Cell = GridData[FloorLevel].GetRow(GridPosition.Y).GetCell(GridPosition.X);
+    
+    // Check if cell is occupied
+    if (!Cell.bIsOccupied || !Cell.OccupyingObject)
+    {
+        return false;
+    }
+    
+    // Get the building object
+    ABuildingObject* Building = Cast<ABuildingObject>(Cell.OccupyingObject);
+    if (!Building)
+    {
+        return false;
+    }
+    
+    DestroyBuilding(Building);
+    
+    // Update visuals
+    UpdateAllCellVisuals();
+    
+    return true;
+}
+
+bool ABuildingGridManager::MoveBuilding(const FBuildingHandle& Handle, const FIntPoint& NewOrigin, int32 NewRotation, int32 NewFloor)
+{
+    ABuildingObject* Building = GetBuilding(Handle);
+    UBuildingObjectAsset* BuildingAsset = Building ? Building->GetBuildingAsset() : nullptr;
+    if (!BuildingAsset || NewFloor < 0 || NewFloor >= MaxFloors)
+    {
+        return false;
+    }
+    
+    FIntPoint OldOrigin;
+    int32 OldFloor;
+    int32 OldRotation;
+    Building->GetGridProperties(OldOrigin, OldFloor, OldRotation);
+    NewRotation = ((NewRotation % 4) + 4) % 4;
+    if (OldOrigin == NewOrigin && OldFloor == NewFloor && OldRotation == NewRotation)
+    {
+        return true;
+    }
+    
+    const FBuildingFootprint& Footprint = BuildingAsset->GetFootprint();
+    const TArray<FIntPoint> OldCells = Footprint.GetOccupiedCellPositions(OldOrigin, OldRotation);
+    const TArray<FIntPoint> NewCells = Footprint.GetOccupiedCellPositions(NewOrigin, NewRotation);
+    
+    // Whatever stands on a cell the building leaves would lose its support, which placement never allows
+    if (OccupancyPlanes.IsValidIndex(OldFloor + 1))
+    {
+        const FGridBitPlane& Above = OccupancyPlanes[OldFloor + 1];
+        for (const FIntPoint& Cell : OldCells)
+        {
+            const bool bFreed = OldFloor != NewFloor || !NewCells.Contains(Cell);
+            if (bFreed && Above.IsValidCell(Cell.X, Cell.Y) && Above.Get(Cell.X, Cell.Y))
+            {
+                return false;
+            }
+        }
+    }
+    
+    // Validate with the building lifted off its cells, so it neither blocks nor supports nor neighbours itself.
+    // The validity maps still contain the building and are bypassed.
+    auto SetOldCellsOccupied = [this, &OldCells, OldFloor](bool bOccupied)
+    {
+        for (const FIntPoint& Cell : OldCells)
+        {
+            if (IsValidGridPosition(Cell, OldFloor))
+            {
+                GridData[OldFloor].GetRow(Cell.Y).GetCell(Cell.X).bIsOccupied = bOccupied;
+                OccupancyPlanes[OldFloor].Set(Cell.X, Cell.Y, bOccupied);
+            }
+        }
+    };
+    
+    SetOldCellsOccupied(false);
+    FGridFootprintMask Mask;
+    Mask.Build(NewCells);
+    const bool bCanMove = IsFootprintMaskAvailable(Mask, NewFloor)
+        && (BuildingAsset->AllowedZones == 0 || Mask.IsEmpty() || ZoneLayers[NewFloor].IsFootprintInZones(Mask, BuildingAsset->AllowedZones))
+        && IsFootprintOnSuitableTerrain(BuildingAsset, Mask, NewFloor)
+        && CheckAdjacencyRequirements(BuildingAsset->GetAdjacencyRequirements(), NewOrigin, NewFloor);
+    SetOldCellsOccupied(true);
+    
+    if (!bCanMove)
+    {
+        return false;
+    }
+    
+    ApplyBuildingInfluence(BuildingAsset, OldCells, OldFloor, -1.0f);
+    
+    if (OldFloor == NewFloor)
+    {
+        // Cells in both footprints stay occupied, only the difference changes occupancy and rooms
+        TArray<FIntPoint> FreedCells;
+        TArray<FIntPoint> BlockedCells;
+        TArray<FIntPoint> KeptCells;
+        for (const FIntPoint& Cell : OldCells)
+        {
+            (NewCells.Contains(Cell) ? KeptCells : FreedCells).Add(Cell);
+        }
+        for (const FIntPoint& Cell : NewCells)
+        {
+            if (!OldCells.Contains(Cell))
+            {
+                BlockedCells.Add(Cell);
+            }
+        }
+        
+        MarkCellsAsUnoccupied(FreedCells, OldFloor);
+        MarkCellsAsOccupied(BlockedCells, NewOrigin, NewFloor, Building, Handle.Index);
+        for (const FIntPoint& Cell : KeptCells)
+        {
+            GridData[NewFloor].GetRow(Cell.Y).GetCell(Cell.X).ObjectOrigin = NewOrigin;
+        }
+    }
+    else
+    {
+        MarkCellsAsUnoccupied(OldCells, OldFloor);
+        MarkCellsAsOccupied(NewCells, NewOrigin, NewFloor, Building, Handle.Index);
+    }
+    
+    ApplyBuildingInfluence(BuildingAsset, NewCells, NewFloor, 1.0f);
+    
+    // The actor keeps its state, it is only given its new place
+    Building->SetGridProperties(NewOrigin, NewFloor, NewRotation);
+    Building->SetActorLocationAndRotation(GridToWorld(NewOrigin, NewFloor), FRotator(0.0f, NewRotation * 90.0f, 0.0f));
+    
+    OnBuildingMoved.Broadcast(Handle, Building);
+    
+    return true;
+}
+
+int32 ABuildingGridManager::RemoveBuildings(const TArray<FBuildingHandle>& Handles)
+{
+    int32 NumRemoved = 0;
+    
+    for (const FBuildingHandle& Handle : Handles)
+    {
+        // Duplicates resolve to nothing once the first copy was removed
+        if (ABuildingObject* Building = GetBuilding(Handle))
+        {
+            DestroyBuilding(Building);
+            NumRemoved++;
+        }
+    }
+    
+    // One visual refresh for the whole batch
+    if (NumRemoved > 0)
+    {
+        UpdateAllCellVisuals();
+    }
+    
+    return NumRemoved;
+}
+
+void ABuildingGridManager::DestroyBuilding(ABuildingObject* Building)
+{
+    // Get the building's grid properties
+    FIntPoint BuildingOrigin;
+    int32 BuildingFloor;
+    int32 BuildingRotation;
+    Building->GetGridProperties(BuildingOrigin, BuildingFloor, BuildingRotation);
+    
+    // Get the building's footprint
+    FBuildingFootprint Footprint = Building->GetFootprint();
+    
+    // Mark cells as unoccupied
+    MarkCellsAsUnoccupied(Footprint, BuildingOrigin, BuildingRotation, BuildingFloor);
+    
+    // Take the building's ambience back out of the fields
+    ApplyBuildingInfluence(Building->GetBuildingAsset(), Footprint.GetOccupiedCellPositions(BuildingOrigin, BuildingRotation), BuildingFloor, -1.0f);
+    
+    // Let listeners release the building while it still exists
+    const FBuildingHandle Handle = Building->GetBuildingHandle();
+    OnBuildingRemoved.Broadcast(Handle, Building);
+    UnregisterBuilding(Handle);
+    
+    // Destroy the building actor
+    Building->Destroy();
+}
+
+TArray<FBuildingHandle> ABuildingGridManager::GetBuildingsInRect(const FIntPoint& Min, const FIntPoint& Max, int32 MinFloor, int32 MaxFloor) const
+{
+    TArray<FBuildingHandle> Handles;
+    
+    const int32 FirstX = FMath::Max(FMath::Min(Min.X, Max.X), 0);
+    const int32 FirstY = FMath::Max(FMath::Min(Min.Y, Max.Y), 0);
+    const int32 LastX = FMath::Min(FMath::Max(Min.X, Max.X), GridSizeX - 1);
+    const int32 LastY = FMath::Min(FMath::Max(Min.Y, Max.Y), GridSizeY - 1);
+    const int32 FirstFloor = FMath::Max(FMath::Min(MinFloor, MaxFloor), 0);
+    const int32 LastFloor = FMath::Min(FMath::Max(MinFloor, MaxFloor), MaxFloors - 1);
+    if (FirstX > LastX || FirstY > LastY || FirstFloor > LastFloor)
+    {
+        return Handles;
+    }
+    
+    // One bit per registry slot, so a building spanning many cells and floors is reported once
+    TBitArray<> Seen(false, BuildingSlots.Num());
+    
+    for (int32 Floor = FirstFloor; Floor <= LastFloor; Floor++)
+    {
+        const FGridBitPlane& Occupancy = OccupancyPlanes[Floor];
+        const int32* Slots = BuildingSlotPlanes[Floor].GetData();
+        
+        for (int32 Y = FirstY; Y <= LastY; Y++)
+        {
+            // Only occupied cells are read from the slot plane, 64 columns at a time
+            for (int32 X = FirstX; X <= LastX; X += 64)
+            {
+                uint64 Bits = Occupancy.ExtractBits(Y, X) & FGridBitPlane::SpanMask(0, FMath::Min(LastX - X + 1, 64));
+                while (Bits)
+                {
+                    const int32 Column = X + static_cast<int32>(FMath::CountTrailingZeros64(Bits));
+                    Bits &= Bits - 1;
+                    
+                    const int32 Slot = Slots[Y * GridSizeX + Column];
+                    if (Slot != INDEX_NONE)
+                    {
+                        Seen[Slot] = true;
+                    }
+                }
+            }
+        }
+    }
+    
+    for (TConstSetBitIterator<> It(Seen); It; ++It)
+    {
+        Handles.Add(FBuildingHandle(It.GetIndex(), BuildingGenerations[It.GetIndex()]));
+    }
+    
+    return Handles;
+}
+
+void ABuildingGridManager::ShowBuildingSelection(const TArray<FBuildingHandle>& Handles)
+{
+    ResetCellVisualStates();
+    
+    for (const FBuildingHandle& Handle : Handles)
+    {
+        const ABuildingObject* Building = GetBuilding(Handle);
+        if (!Building)
+        {
+            continue;
+        }
+        
+        FIntPoint BuildingOrigin;
+        int32 BuildingFloor;
+        int32 BuildingRotation;
+        Building->GetGridProperties(BuildingOrigin, BuildingFloor, BuildingRotation);
+        
+        for (const FIntPoint& Cell : Building->GetFootprint().GetOccupiedCellPositions(BuildingOrigin, BuildingRotation))
+        {
+            if (IsValidGridPosition(Cell, BuildingFloor))
+            {
+                GridData[BuildingFloor].GetRow(Cell.Y).GetCell(Cell.X).VisualState = EGridCellVisualState::Selected;
+                UpdateCellVisual(Cell, BuildingFloor);
+            }
+        }
+    }
+}
+
+FBuildingStamp ABuildingGridManager::CaptureStamp(const FIntPoint& Min, const FIntPoint& Max, int32 MinFloor, int32 MaxFloor) const
+{
+    FBuildingStamp Stamp;
+    
+    const FIntPoint First(FMath::Max(FMath::Min(Min.X, Max.X), 0), FMath::Max(FMath::Min(Min.Y, Max.Y), 0));
+    const FIntPoint Last(FMath::Min(FMath::Max(Min.X, Max.X), GridSizeX - 1), FMath::Min(FMath::Max(Min.Y, Max.Y), GridSizeY - 1));
+    const int32 FirstFloor = FMath::Max(FMath::Min(MinFloor, MaxFloor), 0);
+    const int32 LastFloor = FMath::Min(FMath::Max(MinFloor, MaxFloor), MaxFloors - 1);
+    if (First.X > Last.X || First.Y > Last.Y || FirstFloor > LastFloor)
+    {
+        return Stamp;
+    }
+    
+    // The stamp origin is the region's first corner, wherever the captured buildings start
+    const FIntPoint StampOrigin(FMath::Min(Min.X, Max.X), FMath::Min(Min.Y, Max.Y));
+    Stamp.Size = FIntPoint(Last.X - First.X + 1, Last.Y - First.Y + 1);
+    Stamp.NumFloors = LastFloor - FirstFloor + 1;
+    
+    TSet<const ABuildingObject*> Captured;
+    for (int32 Floor = FirstFloor; Floor <= LastFloor; Floor++)
+    {
+        for (int32 Y = First.Y; Y <= Last.Y; Y++)
+        {
+            for (int32 X = First.X; X <= Last.X; X++)
+            {
+                const FGridCellData& Cell = GridData[Floor].GetRow(Y).GetCell(X);
+                const ABuildingObject* Building = Cell.bIsOccupied ? Cast<ABuildingObject>(Cell.OccupyingObject) : nullptr;
+                if (!Building || !Building->GetBuildingAsset())
+                {
+                    continue;
+                }
+                
+                bool bAlreadyCaptured = false;
+                Captured.Add(Building, &bAlreadyCaptured);
+                if (bAlreadyCaptured)
+                {
+                    continue;
+                }
+                
+                FIntPoint BuildingOrigin;
+                int32 BuildingFloor;
+                int32 BuildingRotation;
+                Building->GetGridProperties(BuildingOrigin, BuildingFloor, BuildingRotation);
+                
+                FBuildingStampEntry& Entry = Stamp.Entries.AddDefaulted_GetRef();
+                Entry.BuildingAsset = Building->GetBuildingAsset();
+                Entry.Offset = BuildingOrigin - StampOrigin;
+                Entry.Rotation = BuildingRotation;
+                Entry.FloorOffset = BuildingFloor - FirstFloor;
+            }
+        }
+    }
+    
+    // Lower floors first, so every building is placed after the ones it stands on
+    Stamp.Entries.StableSort([](const FBuildingStampEntry& A, const FBuildingStampEntry& B) { return A.FloorOffset < B.FloorOffset; });
+    
+    return Stamp;
+}
+
+void ABuildingGridManager::SetActiveStamp(const FBuildingStamp& Stamp)
+{
+    ActiveStamp.Compile(Stamp);
+    ActiveStampVersion++;
+}
+
+bool ABuildingGridManager::CanPlaceStamp(const FVector& WorldLocation, int32 Rotation, int32 FloorLevel)
+{
+    // Convert world location to grid position
+    int32 DetectedFloor;
+    FIntPoint GridOrigin = WorldToGrid(WorldLocation, DetectedFloor);
+    
+    // Use detected floor if not specified
+    if (FloorLevel < 0)
+    {
+        FloorLevel = DetectedFloor;
+    }
+    
+    return CanPlaceStampAtCell(GridOrigin, Rotation, FloorLevel);
+}
+
+bool ABuildingGridManager::CanPlaceStampAtCell(const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel)
+{
+    if (ActiveStamp.IsEmpty() || ActiveStamp.GetRotation(Rotation).bOverlaps)
+    {
+        return false;
+    }
+    
+    ActiveStamp.MoveTo(Rotation, GridOrigin);
+    const FCompiledBuildingStamp::FRotation& Rotated = ActiveStamp.GetRotation(Rotation);
+    
+    // One combined test per floor: bounds and occupancy for the whole floor, support only for the
+    // cells that do not stand on the stamp itself
+    for (int32 FloorOffset = 0; FloorOffset < Rotated.Floors.Num(); FloorOffset++)
+    {
+        const FCompiledBuildingStamp::FRotatedFloor& Floor = Rotated.Floors[FloorOffset];
+        const int32 TargetFloor = FloorLevel + FloorOffset;
+        if (Floor.Mask.IsEmpty())
+        {
+            continue;
+        }
+        
+        if (TargetFloor < 0 || TargetFloor >= MaxFloors)
+        {
+            return false;
+        }
+        
+        const FGridFootprintMask& Mask = Floor.Mask;
+        if (Mask.Min.X < 0 || Mask.Min.Y < 0 || Mask.Min.X + Mask.Width > GridSizeX || Mask.Min.Y + Mask.Height > GridSizeY)
+        {
+            return false;
+        }
+        
+        if (OccupancyPlanes[TargetFloor].Intersects(Mask))
+        {
+            return false;
+        }
+        
+        if (TargetFloor > 0 && !Floor.SupportMask.IsEmpty() && !OccupancyPlanes[TargetFloor - 1].Covers(Floor.SupportMask))
+        {
+            return false;
+        }
+    }
+    
+    // Zoning and adjacency are rules of the single buildings; neighbours from the stamp count as placed
+    for (const FCompiledBuildingStamp::FRotatedEntry& Entry : Rotated.Entries)
+    {
+        const FBuildingStampEntry& Source = ActiveStamp.GetStamp().Entries[Entry.EntryIndex];
+        const UBuildingObjectAsset* BuildingAsset = Source.BuildingAsset;
+        const int32 TargetFloor = FloorLevel + Source.FloorOffset;
+        
+        if (BuildingAsset->AllowedZones != 0 && !Entry.Mask.IsEmpty() && !ZoneLayers[TargetFloor].IsFootprintInZones(Entry.Mask, BuildingAsset->AllowedZones))
+        {
+            return false;
+        }
+        
+        if (!IsFootprintOnSuitableTerrain(BuildingAsset, Entry.Mask, TargetFloor))
+        {
+            return false;
+        }
+        
+        if (!CheckAdjacencyRequirements(BuildingAsset->GetAdjacencyRequirements(), GridOrigin + Entry.Offset, TargetFloor,
+            &Rotated.Floors[Source.FloorOffset].CellTypes, GridOrigin))
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+TArray<ABuildingObject*> ABuildingGridManager::PlaceStamp(const FVector& WorldLocation, int32 Rotation, int32 FloorLevel)
+{
+    TArray<ABuildingObject*> Buildings;
+    
+    // Convert world location to grid position
+    int32 DetectedFloor;
+    FIntPoint GridOrigin = WorldToGrid(WorldLocation, DetectedFloor);
+    
+    // Use detected floor if not specified
+    if (FloorLevel < 0)
+    {
+        FloorLevel = DetectedFloor;
+    }
+    
+    // The stamp is validated as a whole, so no building of it is placed unless all of them fit
+    if (!CanPlaceStampAtCell(GridOrigin, Rotation, FloorLevel))
+    {
+        return Buildings;
+    }
+    
+    const FCompiledBuildingStamp::FRotation& Rotated = ActiveStamp.GetRotation(Rotation);
+    Buildings.Reserve(Rotated.Entries.Num());
+    
+    for (const FCompiledBuildingStamp::FRotatedEntry& Entry : Rotated.Entries)
+    {
+        const FBuildingStampEntry& Source = ActiveStamp.GetStamp().Entries[Entry.EntryIndex];
+        if (ABuildingObject* Building = SpawnBuildingAtCell(Source.BuildingAsset, GridOrigin + Entry.Offset, Entry.Rotation, FloorLevel + Source.FloorOffset))
+        {
+            Buildings.Add(Building);
+        }
+    }
+    
+    // One visual refresh for the whole batch
+    UpdateAllCellVisuals();
+    
+    for (ABuildingObject* Building : Buildings)
+    {
+        OnBuildingPlaced.Broadcast(Building->GetBuildingHandle(), Building);
+    }
+    
+    return Buildings;
+}
+
+void ABuildingGridManager::UpdateStampPreview(const FVector& WorldLocation, int32 Rotation, int32 FloorLevel)
+{
+    if (ActiveStamp.IsEmpty())
+    {
+        ResetCellVisualStates();
+        return;
+    }
+    
+    // Convert world location to grid position
+    int32 DetectedFloor;
+    FIntPoint GridOrigin = WorldToGrid(WorldLocation, DetectedFloor);
+    
+    // Use detected floor if not specified
+    if (FloorLevel < 0)
+    {
+        FloorLevel = DetectedFloor;
+    }
+    
+    // Nothing to redraw while the cursor stays on the same cell
+    if (PreviewStampVersion == ActiveStampVersion && PreviewOrigin == GridOrigin && PreviewRotation == Rotation
+        && PreviewFloor == FloorLevel && PreviewVersion == GridVersion)
+    {
+        return;
+    }
+    
+    // Reset previous visualization
+    ResetCellVisualStates();
+    
+    PreviewStampVersion = ActiveStampVersion;
+    PreviewOrigin = GridOrigin;
+    PreviewRotation = Rotation;
+    PreviewFloor = FloorLevel;
+    PreviewVersion = GridVersion;
+    
+    const EGridCellVisualState VisualState = CanPlaceStampAtCell(GridOrigin, Rotation, FloorLevel) ?
+        EGridCellVisualState::Valid :
+        EGridCellVisualState::Invalid;
+    
+    // Colour the cells of every floor of the stamp
+    const FCompiledBuildingStamp::FRotation& Rotated = ActiveStamp.GetRotation(Rotation);
+    for (int32 FloorOffset = 0; FloorOffset < Rotated.Floors.Num(); FloorOffset++)
+    {
+        const int32 TargetFloor = FloorLevel + FloorOffset;
+        for (const FIntPoint& RelativeCell : Rotated.Floors[FloorOffset].Cells)
+        {
+            const FIntPoint Cell = GridOrigin + RelativeCell;
+            if (IsValidGridPosition(Cell, TargetFloor))
+            {
+                GridData[TargetFloor].GetRow(Cell.Y).GetCell(Cell.X).VisualState = VisualState;
+                UpdateCellVisual(Cell, TargetFloor);
+            }
+        }
+    }
+}
+
+ABuildingObject* ABuildingGridManager::GetBuilding(const FBuildingHandle& Handle) const
+{
+    if (!BuildingSlots.IsValidIndex(Handle.Index) || BuildingGenerations[Handle.Index] != Handle.Generation)
+    {
+        return nullptr;
+    }
+    
+    return BuildingSlots[Handle.Index];
+}
+
+TArray<FBuildingHandle> ABuildingGridManager::GetBuildingHandles() const
+{
+    TArray<FBuildingHandle> Handles;
+    Handles.Reserve(BuildingSlots.Num() - FreeBuildingSlots.Num());
+    
+    for (int32 Index = 0; Index < BuildingSlots.Num(); Index++)
+    {
+        if (BuildingSlots[Index])
+        {
+            Handles.Add(FBuildingHandle(Index, BuildingGenerations[Index]));
+        }
+    }
+    
+    return Handles;
+}
+
+FBuildingHandle ABuildingGridManager::RegisterBuilding(ABuildingObject* Building)
+{
+    int32 Index;
+    if (FreeBuildingSlots.Num() > 0)
+    {
+        Index = FreeBuildingSlots.Pop(EAllowShrinking::No);
+        BuildingSlots[Index] = Building;
+    }
+    else
+    {
+        Index = BuildingSlots.Add(Building);
+        BuildingGenerations.Add(0);
+    }
+    
+    return FBuildingHandle(Index, BuildingGenerations[Index]);
+}
+
+void ABuildingGridManager::UnregisterBuilding(const FBuildingHandle& Handle)
+{
+    if (!GetBuilding(Handle))
+    {
+        return;
+    }
+    
+    // Bumping the generation invalidates every outstanding copy of the handle
+    BuildingSlots[Handle.Index] = nullptr;
+    BuildingGenerations[Handle.Index]++;
+    FreeBuildingSlots.Add(Handle.Index);
+}
+
+void ABuildingGridManager::SetGridVisualizationEnabled(bool bEnabled)
+{
+    bGridVisualizationEnabled = bEnabled;
+    
+    // Show or hide the grid mesh
+    GridMeshComponent->SetVisibility(bEnabled);
+    
+    // Update all cell visuals if enabling
+    if (bEnabled)
+    {
+        UpdateAllCellVisuals();
+    }
+}
+
+void ABuildingGridManager::UpdatePlacementPreview(UBuildingObjectAsset* BuildingAsset, const FVector& WorldLocation, int32 Rotation, int32 FloorLevel)
+{
+    // Check if we have a valid asset
+    if (!BuildingAsset)
+    {
+        ResetCellVisualStates();
+        return;
+    }
+    
+    // Convert world location to grid position
+    int32 DetectedFloor;
+    FIntPoint GridOrigin = WorldToGrid(WorldLocation, DetectedFloor);
+    
+    // Use detected floor if not specified
+    if (FloorLevel < 0)
+    {
+        FloorLevel = DetectedFloor;
+    }
+    
+    // Nothing to redraw or rescore while the cursor stays on the same cell
+    if (PreviewAsset.Get() == BuildingAsset && PreviewOrigin == GridOrigin && PreviewRotation == Rotation
+        && PreviewFloor == FloorLevel && PreviewVersion == GridVersion)
+    {
+        return;
+    }
+    
+    // Reset previous visualization
+    ResetCellVisualStates();
+    
+    // Score the hovered location from the precomputed fields
+    PreviewScore = ComputePlacementScore(BuildingAsset, GridOrigin, Rotation, FloorLevel);
+    PreviewAsset = BuildingAsset;
+    PreviewOrigin = GridOrigin;
+    PreviewRotation = Rotation;
+    PreviewFloor = FloorLevel;
+    PreviewVersion = GridVersion;
+    
     // Get the building's footprint
-    FBuildingFootprint Footprint = Building->GetFootprint();
+    const FBuildingFootprint& Footprint = BuildingAsset->GetFootprint();
     
-    // Mark cells as unoccupied
-    MarkCellsAsUnoccupied(Footprint, BuildingOrigin, BuildingRotation, BuildingFloor);
+    // Get all occupied cells
+    TArray<FIntPoint> OccupiedCells = Footprint.GetOccupiedCellPositions(GridOrigin, Rotation);
     
-    // Destroy the building actor
-    Building->Destroy();
+    // Check if placement is valid
+    bool bIsValidPlacement = PreviewScore.bIsValidPlacement;
     
-    // Update visuals
+    // Update visual state for each cell
+    for (const FIntPoint& Cell : OccupiedCells)
+    {
+        if (IsValidGridPosition(Cell, FloorLevel))
+        {
+            // Set visual state based on placement validity
+            EGridCellVisualState VisualState = bIsValidPlacement ? 
+                EGridCellVisualState::Valid : 
+                EGridCellVisualState::Invalid;
+            
+            // Update cell data
+            FGridCellData& CellData = GridData[FloorLevel].GetRow(Cell.Y).GetCell(Cell.X);
+            CellData.VisualState = VisualState;
+            
+            // Update the visual
+            UpdateCellVisual(Cell, FloorLevel);
+        }
+    }
+}
+
+void ABuildingGridManager::ResetCellVisualStates()
+{
+    // The next preview has to redraw its cells
+    PreviewAsset.Reset();
+    PreviewStampVersion = MAX_uint32;
+    
+    // For each floor
+    for (int32 Floor = 0; Floor < MaxFloors; Floor++)
+    {
+        // For each row
+        for (int32 Y = 0; Y < GridSizeY; Y++)
+        {
+            // For each column
+            for (int32 X = 0; X < GridSizeX; X++)
+            {
+                // Reset visual state to normal
+                FGridCellData& Cell = GridData[Floor].GetRow(Y).GetCell(X);
+                Cell.VisualState = EGridCellVisualState::Normal;
+                
+                // Update the visual
+                UpdateCellVisual(FIntPoint(X, Y), Floor);
+            }
+        }
+    }
+}
+
+void ABuildingGridManager::SetActiveFloorLevel(int32 FloorLevel)
+{
+    // Clamp to valid range
+    ActiveFloorLevel = FMath::Clamp(FloorLevel, 0, MaxFloors - 1);
+    
+    // Update visuals to show only the active floor
     UpdateAllCellVisuals();
+}
+
+void ABuildingGridManager::UpdateCellVisual(const FIntPoint& GridPosition, int32 FloorLevel)
+{
+    // Only update if visualization is enabled
+    if (!bGridVisualizationEnabled || !GridMeshComponent)
+    {
+        return;
+    }
+    
+    // Only visualize cells on the active floor
+    if (FloorLevel != ActiveFloorLevel)
+    {
+        return;
+    }
+    
+    // Look up the instance of this cell
+    const int32 CellIndex = GridPosition.Y * GridSizeX + GridPosition.X;
+    if (!CellInstances.IsValidIndex(CellIndex))
+    {
+        return;
+    }
+    int32& InstanceIndex = CellInstances[CellIndex];
+    
+    // Check if instance already exists
+    if (InstanceIndex == INDEX_NONE)
+    {
+        // Add new instance
+        FTransform CellTransform;
+        CellTransform.SetLocation(GridToWorld(GridPosition, FloorLevel) - FVector(0, 0, CellSize * 0.5f)); // Place at bottom of cell
+        CellTransform.SetScale3D(FVector(CellSize / 100.0f)); // Assuming mesh is 100x100 units
+        
+        InstanceIndex = GridMeshComponent->AddInstance(CellTransform, true);
+    }
+    else
+    {
+        // Update existing instance
+        FTransform CellTransform;
+        CellTransform.SetLocation(GridToWorld(GridPosition, FloorLevel) - FVector(0, 0, CellSize * 0.5f));
+        CellTransform.SetScale3D(FVector(CellSize / 100.0f));
+        
+        GridMeshComponent->UpdateInstanceTransform(InstanceIndex, CellTransform, true);
+    }
+    
+    // Set material based on cell state
+    UMaterialInterface* CellMaterial = NormalCellMaterial;
+    
+    const FGridCellData& CellData = GridData[FloorLevel].GetRow(GridPosition.Y).GetCell(GridPosition.X);
+    switch (CellData.VisualState)
+    {
+        case EGridCellVisualState::Valid:
+            CellMaterial = ValidPlacementMaterial;
+            break;
+        case EGridCellVisualState::Invalid:
+            CellMaterial = InvalidPlacementMaterial;
+            break;
+        case EGridCellVisualState::Selected:
+            CellMaterial = SelectedCellMaterial;
+            break;
+        case EGridCellVisualState::Highlighted:
+            CellMaterial = HighlightedCellMaterial;
+            break;
+        default:
+            CellMaterial = NormalCellMaterial;
+            break;
+    }
+    
+    // Apply material to the instance
+    if (CellMaterial)
+    {
+        GridMeshComponent->SetMaterial(InstanceIndex, CellMaterial);
+    }
+}
+
+void ABuildingGridManager::UpdateAllCellVisuals()
+{
+    // Only update if visualization is enabled
+    if (!bGridVisualizationEnabled || !GridMeshComponent)
+    {
+        return;
+    }
+    
+    // Clear existing instances, the mesh starts over at the grid actor
+    GridMeshComponent->ClearInstances();
+    GridMeshComponent->SetRelativeLocation(FVector::ZeroVector);
+    CellInstances.Init(INDEX_NONE, GridSizeX * GridSizeY);
+    
+    // Only visualize cells on the active floor
+    int32 Floor = ActiveFloorLevel;
+    
+    // For each row
+    for (int32 Y = 0; Y < GridSizeY; Y++)
+    {
+        // For each column
+        for (int32 X = 0; X < GridSizeX; X++)
+        {
+            // Update the visual for this cell
+            UpdateCellVisual(FIntPoint(X, Y), Floor);
+        }
+    }
+    
+    // New instances start without custom data, so a finished heatmap has to be written again
+    if (Heatmap.bApplied)
+    {
+        ApplyPlacementHeatmap();
+    }
+}
+
+void ABuildingGridManager::SetCellData(const FIntPoint& GridPosition, int32 FloorLevel, const FGridCellData& CellData)
+{
+    // Check if position is valid
+    if (IsValidGridPosition(GridPosition, FloorLevel))
+    {
+        GridData[FloorLevel].GetRow(GridPosition.Y).GetCell(GridPosition.X) = CellData;
+        
+        // Update the visual
+        UpdateCellVisual(GridPosition, FloorLevel);
+    }
+}
+
+bool ABuildingGridManager::AreCellsAvailableForBuilding(const FBuildingFootprint& Footprint, const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel)
+{
+    FGridFootprintMask Mask;
+    Mask.Build(Footprint.GetOccupiedCellPositions(GridOrigin, Rotation));
+    return IsFootprintMaskAvailable(Mask, FloorLevel);
+}
+
+bool ABuildingGridManager::IsFootprintMaskAvailable(const FGridFootprintMask& Mask, int32 FloorLevel) const
+{
+    if (FloorLevel < 0 || FloorLevel >= MaxFloors)
+    {
+        return false;
+    }
+    
+    // An empty footprint occupies nothing
+    if (Mask.IsEmpty())
+    {
+        return true;
+    }
+    
+    // Check if the footprint bounds are within the grid
+    if (Mask.Min.X < 0 || Mask.Min.Y < 0 || Mask.Min.X + Mask.Width > GridSizeX || Mask.Min.Y + Mask.Height > GridSizeY)
+    {
+        return false;
+    }
+    
+    // Check if any cell is already occupied, 64 cells per test
+    if (OccupancyPlanes[FloorLevel].Intersects(Mask))
+    {
+        return false;
+    }
+    
+    // For upper floors, every cell needs a building below
+    if (FloorLevel > 0 && !OccupancyPlanes[FloorLevel - 1].Covers(Mask))
+    {
+        return false;
+    }
     
+    // All cells are available
     return true;
 }
 
-void ABuildingGridManager::SetGridVisualizationEnabled(bool bEnabled)
+bool ABuildingGridManager::IsFootprintCoarselyBlocked(const FGridFootprintMask& Footprint, bool bFillsBounds, const FIntPoint& GridOrigin, int32 FloorLevel) const
 {
-    bGridVisualizationEnabled = bEnabled;
+    if (Footprint.IsEmpty())
+    {
+        return false;
+    }
     
-    // Show or hide the grid mesh
-    GridMeshComponent->SetVisibility(bEnabled);
+    const FIntRect Bounds(Footprint.Min + GridOrigin, Footprint.Min + GridOrigin + FIntPoint(Footprint.Width, Footprint.Height));
+    if (Bounds.Min.X < 0 || Bounds.Min.Y < 0 || Bounds.Max.X > GridSizeX || Bounds.Max.Y > GridSizeY)
+    {
+        return true;
+    }
     
-    // Update all cell visuals if enabling
-    if (bEnabled)
+    // A full rectangle blocks any footprint in it, a partly occupied one only a footprint filling it
+    const EGridBlockState State = OccupancyPyramids[FloorLevel].GetRectState(OccupancyPlanes[FloorLevel], Bounds);
+    return State == EGridBlockState::Full || (bFillsBounds && State == EGridBlockState::Partial);
+}
+
+bool ABuildingGridManager::IsFootprintOnSuitableTerrain(const UBuildingObjectAsset* BuildingAsset, const FGridFootprintMask& Mask, int32 FloorLevel) const
+{
+    // Upper floors stand on the buildings below, not on the ground
+    if (FloorLevel != 0 || !Terrain.IsSampled() || Mask.IsEmpty()
+        || (BuildingAsset->MaxTerrainSlope <= 0.0f && BuildingAsset->MaxTerrainHeightDelta <= 0.0f))
     {
-        UpdateAllCellVisuals();
+        return true;
+    }
+    
+    // The limits apply to the footprint bounds; the plane for that size is built once and then answers with a bit
+    const FGridBitPlane& Suitable = Terrain.GetSuitablePlane(FIntPoint(Mask.Width, Mask.Height), BuildingAsset->MaxTerrainSlope, BuildingAsset->MaxTerrainHeightDelta);
+    return Suitable.IsValidCell(Mask.Min.X, Mask.Min.Y) && Suitable.Get(Mask.Min.X, Mask.Min.Y);
+}
+
+float ABuildingGridManager::TraceTerrainHeight(const FIntPoint& GridPosition, const FCollisionQueryParams& Params) const
+{
+    // Trace around the grid plane, not the ground sampled so far
+    const FVector Center = GetActorLocation() + FVector((GridPosition.X + 0.5f) * CellSize, (GridPosition.Y + 0.5f) * CellSize, 0.0f);
+    FHitResult Hit;
+    if (!GetWorld()->LineTraceSingleByChannel(Hit, Center + FVector(0.0f, 0.0f, TerrainTraceRange), Center - FVector(0.0f, 0.0f, TerrainTraceRange), TerrainTraceChannel, Params))
+    {
+        // No ground found, keep the grid plane
+        return 0.0f;
+    }
+    
+    return Hit.ImpactPoint.Z - GetActorLocation().Z;
+}
+
+FBox ABuildingGridManager::GetNavModifierBounds(const FIntRect& Cells) const
+{
+    // Tall enough for the ground under the cells and one floor above it
+    float MinHeight = 0.0f;
+    float MaxHeight = 0.0f;
+    if (Terrain.IsSampled())
+    {
+        MinHeight = MAX_flt;
+        MaxHeight = -MAX_flt;
+        for (int32 Y = Cells.Min.Y; Y < Cells.Max.Y; Y++)
+        {
+            for (int32 X = Cells.Min.X; X < Cells.Max.X; X++)
+            {
+                MinHeight = FMath::Min(MinHeight, Terrain.GetHeight(X, Y));
+                MaxHeight = FMath::Max(MaxHeight, Terrain.GetHeight(X, Y));
+            }
+        }
+    }
+    
+    const FVector Origin = GetActorLocation();
+    return FBox(
+        FVector(Origin.X + Cells.Min.X * CellSize, Origin.Y + Cells.Min.Y * CellSize, Origin.Z + MinHeight - FloorHeight * 0.5f),
+        FVector(Origin.X + Cells.Max.X * CellSize, Origin.Y + Cells.Max.Y * CellSize, Origin.Z + MaxHeight + FloorHeight));
+}
+
+void ABuildingGridManager::GetNavModifierBoxes(const FIntRect& Cells, TArray<FBox>& OutBoxes) const
+{
+    if (OccupancyPlanes.Num() == 0)
+    {
+        return;
+    }
+    
+    TArray<FIntRect> Rects;
+    OccupancyPlanes[0].CollectRects(Cells, Rects);
+    
+    const FBox Bounds = GetNavModifierBounds(Cells);
+    const FVector Origin = GetActorLocation();
+    OutBoxes.Reserve(OutBoxes.Num() + Rects.Num());
+    for (const FIntRect& Rect : Rects)
+    {
+        OutBoxes.Add(FBox(
+            FVector(Origin.X + Rect.Min.X * CellSize, Origin.Y + Rect.Min.Y * CellSize, Bounds.Min.Z),
+            FVector(Origin.X + Rect.Max.X * CellSize, Origin.Y + Rect.Max.Y * CellSize, Bounds.Max.Z)));
+    }
+}
+
+bool ABuildingGridManager::HasLineOfSight(const FIntPoint& From, const FIntPoint& To, int32 FloorLevel) const
+{
+    if (!IsValidGridPosition(From, FloorLevel) || !IsValidGridPosition(To, FloorLevel))
+    {
+        return false;
     }
+    
+    FGridRay Ray;
+    Ray.Start = FVector2D(From.X + 0.5, From.Y + 0.5);
+    Ray.End = FVector2D(To.X + 0.5, To.Y + 0.5);
+    
+    FGridRayHit Hit;
+    return FGridRaycaster(OccupancyPlanes[FloorLevel], EdgeGrids[FloorLevel]).Cast(Ray, Hit);
 }
 
-void ABuildingGridManager::UpdatePlacementPreview(UBuildingObjectAsset* BuildingAsset, const FVector& WorldLocation, int32 Rotation, int32 FloorLevel)
+float ABuildingGridManager::GetViewScore(const FBuildingHandle& Handle)
 {
-    // Reset previous visualization
-    ResetCellVisualStates();
-    
-    // Check if we have a valid asset
-    if (!BuildingAsset)
+    TArray<FBuildingHandle> Handles;
+    Handles.Add(Handle);
+    return GetViewScores(Handles)[0];
+}
+
+TArray<float> ABuildingGridManager::GetViewScores(const TArray<FBuildingHandle>& Handles)
+{
+    TArray<float> Scores;
+    Scores.SetNumZeroed(Handles.Num());
+    if (OccupancyPlanes.Num() == 0)
     {
-        return;
+        return Scores;
     }
     
-    // Convert world location to grid position
-    int32 DetectedFloor;
-    FIntPoint GridOrigin = WorldToGrid(WorldLocation, DetectedFloor);
+    EnsureSkyline();
     
-    // Use detected floor if not specified
-    if (FloorLevel < 0)
+    // Gather the rays of every building by floor, remembering which building each ray belongs to
+    TArray<TArray<FGridRay>> FloorRays;
+    TArray<TArray<int32>> FloorOwners;
+    FloorRays.SetNum(MaxFloors);
+    FloorOwners.SetNum(MaxFloors);
+    TArray<int32> RayCounts;
+    RayCounts.SetNumZeroed(Handles.Num());
+    for (int32 HandleIndex = 0; HandleIndex < Handles.Num(); HandleIndex++)
     {
-        FloorLevel = DetectedFloor;
+        const ABuildingObject* Building = GetBuilding(Handles[HandleIndex]);
+        if (!Building)
+        {
+            continue;
+        }
+        
+        FIntPoint Origin;
+        int32 Floor, Rotation;
+        Building->GetGridProperties(Origin, Floor, Rotation);
+        if (Floor < 0 || Floor >= MaxFloors)
+        {
+            continue;
+        }
+        
+        const int32 FirstRay = FloorRays[Floor].Num();
+        AddWindowViewRays(Building, FloorRays[Floor]);
+        RayCounts[HandleIndex] = FloorRays[Floor].Num() - FirstRay;
+        for (int32 RayIndex = FirstRay; RayIndex < FloorRays[Floor].Num(); RayIndex++)
+        {
+            FloorOwners[Floor].Add(HandleIndex);
+        }
     }
     
-    // Get the building's footprint
-    const FBuildingFootprint& Footprint = BuildingAsset->GetFootprint();
-    
-    // Get all occupied cells
-    TArray<FIntPoint> OccupiedCells = Footprint.GetOccupiedCellPositions(GridOrigin, Rotation);
-    
-    // Check if placement is valid
-    bool bIsValidPlacement = CanPlaceBuilding(BuildingAsset, WorldLocation, Rotation, FloorLevel);
+    // Views look out over the ground, so every floor sums the appeal of the ground floor
+    const TArray<float>& GroundAppeal = InfluenceFields[0].GetChannel(EGridInfluenceChannel::Appeal);
+    TArray<FGridRayHit> Hits;
+    for (int32 Floor = 0; Floor < MaxFloors; Floor++)
+    {
+        if (FloorRays[Floor].Num() == 0)
+        {
+            continue;
+        }
+        
+        FGridRaycaster Caster(OccupancyPlanes[Floor], EdgeGrids[Floor]);
+        Caster.SetHeights(&SkylineHeights);
+        Caster.SetValues(&GroundAppeal);
+        Caster.CastBatch(FloorRays[Floor], Hits);
+        
+        for (int32 RayIndex = 0; RayIndex < Hits.Num(); RayIndex++)
+        {
+            Scores[FloorOwners[Floor][RayIndex]] += Hits[RayIndex].VisibleValue;
+        }
+    }
     
-    // Update visual state for each cell
-    for (const FIntPoint& Cell : OccupiedCells)
+    for (int32 HandleIndex = 0; HandleIndex < Handles.Num(); HandleIndex++)
     {
-        if (IsValidGridPosition(Cell, FloorLevel))
+        if (RayCounts[HandleIndex] > 0)
         {
-            // Set visual state based on placement validity
-            EGridCellVisualState VisualState = bIsValidPlacement ? 
-                EGridCellVisualState::Valid : 
-                EGridCellVisualState::Invalid;
-            
-            // Update cell data
-            FGridCellData& CellData = GridData[FloorLevel].GetRow(Cell.Y).GetCell(Cell.X);
-            CellData.VisualState = VisualState;
-            
-            // Update the visual
-            UpdateCellVisual(Cell, FloorLevel);
+            Scores[HandleIndex] /= RayCounts[HandleIndex];
         }
     }
+    
+    return Scores;
 }
 
-void ABuildingGridManager::ResetCellVisualStates()
+void ABuildingGridManager::EnsureSkyline()
 {
-    // For each floor
+    if (SkylineVersion == GridVersion)
+    {
+        return;
+    }
+    
+    SkylineHeights.SetNumUninitialized(GridSizeX * GridSizeY);
+    for (int32 Y = 0; Y < GridSizeY; Y++)
+    {
+        for (int32 X = 0; X < GridSizeX; X++)
+        {
+            SkylineHeights[Y * GridSizeX + X] = Terrain.GetHeight(X, Y);
+        }
+    }
+    
+    // Floors are visited bottom up, so each occupied cell ends with the top of its highest floor
     for (int32 Floor = 0; Floor < MaxFloors; Floor++)
     {
-        // For each row
+        const FGridBitPlane& Occupancy = OccupancyPlanes[Floor];
         for (int32 Y = 0; Y < GridSizeY; Y++)
         {
-            // For each column
-            for (int32 X = 0; X < GridSizeX; X++)
+            for (int32 WordIndex = 0; WordIndex < Occupancy.GetWordsPerRow(); WordIndex++)
             {
-                // Reset visual state to normal
-                FGridCellData& Cell = GridData[Floor].GetRow(Y).GetCell(X);
-                Cell.VisualState = EGridCellVisualState::Normal;
-                
-                // Update the visual
-                UpdateCellVisual(FIntPoint(X, Y), Floor);
+                uint64 Bits = Occupancy.GetRowWords(Y)[WordIndex];
+                while (Bits)
+                {
+                    const int32 X = (WordIndex << 6) + static_cast<int32>(FMath::CountTrailingZeros64(Bits));
+                    Bits &= Bits - 1;
+                    SkylineHeights[Y * GridSizeX + X] = GetFloorBaseHeight(X, Y, Floor + 1);
+                }
             }
         }
     }
-}
-
-void ABuildingGridManager::SetActiveFloorLevel(int32 FloorLevel)
-{
-    // Clamp to valid range
-    ActiveFloorLevel = FMath::Clamp(FloorLevel, 0, MaxFloors - 1);
     
-    // Update visuals to show only the active floor
-    UpdateAllCellVisuals();
+    SkylineVersion = GridVersion;
 }
 
-void ABuildingGridManager::UpdateCellVisual(const FIntPoint& GridPosition, int32 FloorLevel)
+void ABuildingGridManager::AddWindowViewRays(const ABuildingObject* Building, TArray<FGridRay>& OutRays) const
 {
-    // Only update if visualization is enabled
-    if (!bGridVisualizationEnabled || !GridMeshComponent)
-    {
-        return;
-    }
-    
-    // Only visualize cells on the active floor
-    if (FloorLevel != ActiveFloorLevel)
+    const UBuildingObjectAsset* BuildingAsset = Building->GetBuildingAsset();
+    if (!BuildingAsset)
     {
         return;
     }
     
-    // Calculate instance index for this cell
-    int32 InstanceIndex = GridPosition.Y * GridSizeX + GridPosition.X;
+    FIntPoint Origin;
+    int32 Floor, Rotation;
+    Building->GetGridProperties(Origin, Floor, Rotation);
+    const int32 Slot = Building->GetBuildingHandle().Index;
+    const int32 NumRays = FMath::Max(1, ViewRaysPerWindow);
     
-    // Check if instance already exists
-    if (GridMeshComponent->GetInstanceCount() <= InstanceIndex)
+    static const EGridDirection Sides[] = { EGridDirection::North, EGridDirection::East, EGridDirection::South, EGridDirection::West };
+    for (const FIntPoint& Cell : BuildingAsset->GetFootprint().GetOccupiedCellPositions(Origin, Rotation))
     {
-        // Add new instance
-        FTransform CellTransform;
-        CellTransform.SetLocation(GridToWorld(GridPosition, FloorLevel) - FVector(0, 0, CellSize * 0.5f)); // Place at bottom of cell
-        CellTransform.SetScale3D(FVector(CellSize / 100.0f)); // Assuming mesh is 100x100 units
+        if (!IsValidGridPosition(Cell, Floor))
+        {
+            continue;
+        }
         
-        GridMeshComponent->AddInstance(CellTransform);
+        for (EGridDirection Side : Sides)
+        {
+            if (EdgeGrids[Floor].GetEdge(Cell, Side) != EGridEdgeType::Window)
+            {
+                continue;
+            }
+            
+            // Windows between two cells of the same building look inside it
+            const FIntPoint Outside = Cell + GridSystemHelpers::GetDirectionVector(Side);
+            if (IsValidGridPosition(Outside, Floor) && BuildingSlotPlanes[Floor][Outside.Y * GridSizeX + Outside.X] == Slot)
+            {
+                continue;
+            }
+            
+            // The cone starts on the cell just outside the window, at eye height in the middle of the floor
+            const FVector2D Facing(Outside.X - Cell.X, Outside.Y - Cell.Y);
+            const FVector2D Start(Outside.X + 0.5, Outside.Y + 0.5);
+            const float EyeHeight = GetFloorBaseHeight(Cell.X, Cell.Y, Floor) + 0.5f * FloorHeight;
+            for (int32 RayIndex = 0; RayIndex < NumRays; RayIndex++)
+            {
+                const float Angle = FMath::DegreesToRadians(ViewConeDegrees * ((RayIndex + 0.5f) / NumRays - 0.5f));
+                const float Cos = FMath::Cos(Angle);
+                const float Sin = FMath::Sin(Angle);
+                
+                FGridRay& Ray = OutRays.AddDefaulted_GetRef();
+                Ray.Start = Start;
+                Ray.End = Start + FVector2D(Facing.X * Cos - Facing.Y * Sin, Facing.X * Sin + Facing.Y * Cos) * ViewDistance;
+                Ray.StartHeight = EyeHeight;
+                Ray.EndHeight = EyeHeight;
+            }
+        }
     }
-    else
+}
+
+void ABuildingGridManager::CreateNavModifiers()
+{
+    for (UGridNavModifierComponent* Modifier : NavModifiers)
     {
-        // Update existing instance
-        FTransform CellTransform;
-        CellTransform.SetLocation(GridToWorld(GridPosition, FloorLevel) - FVector(0, 0, CellSize * 0.5f));
-        CellTransform.SetScale3D(FVector(CellSize / 100.0f));
-        
-        GridMeshComponent->UpdateInstanceTransform(InstanceIndex, CellTransform, true);
+        if (Modifier)
+        {
+            Modifier->DestroyComponent();
+        }
     }
+    NavModifiers.Reset();
+    DirtyNavChunks.Reset();
+    DirtyNavChunkList.Reset();
+    NavChunksX = 0;
     
-    // Set material based on cell state
-    UMaterialInterface* CellMaterial = NormalCellMaterial;
-    
-    const FGridCellData& CellData = GridData[FloorLevel].GetRow(GridPosition.Y).GetCell(GridPosition.X);
-    switch (CellData.VisualState)
+    if (!bUseGridNavModifiers || !GetWorld())
     {
-        case EGridCellVisualState::Valid:
-            CellMaterial = ValidPlacementMaterial;
-            break;
-        case EGridCellVisualState::Invalid:
-            CellMaterial = InvalidPlacementMaterial;
-            break;
-        case EGridCellVisualState::Selected:
-            CellMaterial = SelectedCellMaterial;
-            break;
-        case EGridCellVisualState::Highlighted:
-            CellMaterial = HighlightedCellMaterial;
-            break;
-        default:
-            CellMaterial = NormalCellMaterial;
-            break;
+        return;
     }
     
-    // Apply material to the instance
-    if (CellMaterial)
+    // Registering a chunk adds its modifiers to navigation once, later changes only refresh the chunks they touch
+    const int32 ChunkSize = FMath::Max(1, NavChunkSize);
+    NavChunksX = FMath::DivideAndRoundUp(GridSizeX, ChunkSize);
+    const int32 NavChunksY = FMath::DivideAndRoundUp(GridSizeY, ChunkSize);
+    for (int32 ChunkY = 0; ChunkY < NavChunksY; ChunkY++)
     {
-        GridMeshComponent->SetMaterial(InstanceIndex, CellMaterial);
+        for (int32 ChunkX = 0; ChunkX < NavChunksX; ChunkX++)
+        {
+            UGridNavModifierComponent* Modifier = NewObject<UGridNavModifierComponent>(this);
+            Modifier->SetCells(FIntRect(
+                ChunkX * ChunkSize, ChunkY * ChunkSize,
+                FMath::Min((ChunkX + 1) * ChunkSize, GridSizeX), FMath::Min((ChunkY + 1) * ChunkSize, GridSizeY)));
+            Modifier->RegisterComponent();
+            NavModifiers.Add(Modifier);
+        }
     }
+    DirtyNavChunks.Init(false, NavModifiers.Num());
 }
 
-void ABuildingGridManager::UpdateAllCellVisuals()
+void ABuildingGridManager::ExpandNavModifiers(const FIntPoint& Offset, int32 OldSizeX, int32 OldSizeY)
 {
-    // Only update if visualization is enabled
-    if (!bGridVisualizationEnabled || !GridMeshComponent)
+    // Chunks only keep their cells when the old chunk boundaries stay chunk boundaries, otherwise every chunk
+    // covers different cells and all of them are replaced
+    const int32 ChunkSize = FMath::Max(1, NavChunkSize);
+    const int32 OldChunksX = NavChunksX;
+    const int32 OldChunksY = FMath::DivideAndRoundUp(OldSizeY, ChunkSize);
+    if (NavModifiers.Num() == 0 || Offset.X % ChunkSize != 0 || Offset.Y % ChunkSize != 0
+        || OldChunksX != FMath::DivideAndRoundUp(OldSizeX, ChunkSize) || NavModifiers.Num() != OldChunksX * OldChunksY)
     {
+        CreateNavModifiers();
         return;
     }
     
-    // Clear existing instances
-    GridMeshComponent->ClearInstances();
+    TArray<UGridNavModifierComponent*> OldModifiers = MoveTemp(NavModifiers);
+    const TBitArray<> OldDirtyChunks = MoveTemp(DirtyNavChunks);
+    const FIntPoint ChunkOffset(Offset.X / ChunkSize, Offset.Y / ChunkSize);
     
-    // Only visualize cells on the active floor
-    int32 Floor = ActiveFloorLevel;
+    NavChunksX = FMath::DivideAndRoundUp(GridSizeX, ChunkSize);
+    const int32 NavChunksY = FMath::DivideAndRoundUp(GridSizeY, ChunkSize);
+    NavModifiers.Reset(NavChunksX * NavChunksY);
+    DirtyNavChunks.Init(false, NavChunksX * NavChunksY);
+    DirtyNavChunkList.Reset();
     
-    // For each row
-    for (int32 Y = 0; Y < GridSizeY; Y++)
+    for (int32 ChunkY = 0; ChunkY < NavChunksY; ChunkY++)
     {
-        // For each column
-        for (int32 X = 0; X < GridSizeX; X++)
+        for (int32 ChunkX = 0; ChunkX < NavChunksX; ChunkX++)
         {
-            // Update the visual for this cell
-            UpdateCellVisual(FIntPoint(X, Y), Floor);
+            const FIntRect Cells(
+                ChunkX * ChunkSize, ChunkY * ChunkSize,
+                FMath::Min((ChunkX + 1) * ChunkSize, GridSizeX), FMath::Min((ChunkY + 1) * ChunkSize, GridSizeY));
+            const int32 OldChunkX = ChunkX - ChunkOffset.X;
+            const int32 OldChunkY = ChunkY - ChunkOffset.Y;
+            const int32 Chunk = NavModifiers.Num();
+            
+            // An old chunk stays registered and keeps its place in the world, only its coordinates shift
+            const int32 OldChunk = OldChunkY * OldChunksX + OldChunkX;
+            if (OldChunkX >= 0 && OldChunkX < OldChunksX && OldChunkY >= 0 && OldChunkY < OldChunksY && OldModifiers[OldChunk])
+            {
+                UGridNavModifierComponent* Modifier = OldModifiers[OldChunk];
+                const bool bGrew = Modifier->GetCells().Size() != Cells.Size();
+                Modifier->SetCells(Cells);
+                NavModifiers.Add(Modifier);
+                
+                // A partial chunk at a side that grew now covers added cells
+                if (bGrew || OldDirtyChunks[OldChunk])
+                {
+                    DirtyNavChunks[Chunk] = true;
+                    DirtyNavChunkList.Add(Chunk);
+                }
+                continue;
+            }
+            
+            UGridNavModifierComponent* Modifier = NewObject<UGridNavModifierComponent>(this);
+            Modifier->SetCells(Cells);
+            Modifier->RegisterComponent();
+            NavModifiers.Add(Modifier);
         }
     }
 }
 
-void ABuildingGridManager::SetCellData(const FIntPoint& GridPosition, int32 FloorLevel, const FGridCellData& CellData)
+void ABuildingGridManager::MarkNavCellsDirty(const TArray<FIntPoint>& Cells, int32 FloorLevel)
 {
-    // Check if position is valid
-    if (IsValidGridPosition(GridPosition, FloorLevel))
+    if (FloorLevel != 0 || NavModifiers.Num() == 0)
     {
-        GridData[FloorLevel].GetRow(GridPosition.Y).GetCell(GridPosition.X) = CellData;
-        
-        // Update the visual
-        UpdateCellVisual(GridPosition, FloorLevel);
+        return;
     }
-}
-
-bool ABuildingGridManager::AreCellsAvailableForBuilding(const FBuildingFootprint& Footprint, const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel)
-{
-    // Get all cells the building would occupy
-    TArray<FIntPoint> OccupiedCells = Footprint.GetOccupiedCellPositions(GridOrigin, Rotation);
     
-    // Check each cell
-    for (const FIntPoint& Cell : OccupiedCells)
+    const int32 ChunkSize = FMath::Max(1, NavChunkSize);
+    for (const FIntPoint& Cell : Cells)
     {
-        // Check if cell is within grid bounds
         if (!IsValidGridPosition(Cell, FloorLevel))
         {
-            return false;
+            continue;
         }
         
-        // Check if cell is already occupied
-        const FGridCellData& CellData = GridData[FloorLevel].GetRow(Cell.Y).GetCell(Cell.X);
-        if (CellData.bIsOccupied)
+        const int32 Chunk = (Cell.Y / ChunkSize) * NavChunksX + Cell.X / ChunkSize;
+        if (!DirtyNavChunks[Chunk])
         {
-            return false;
+            DirtyNavChunks[Chunk] = true;
+            DirtyNavChunkList.Add(Chunk);
         }
-        
-        // For upper floors, check for structural support
-        if (FloorLevel > 0)
+    }
+}
+
+void ABuildingGridManager::FlushNavModifiers()
+{
+    // Each refresh re-gathers one chunk and dirties only its bounds, the navigation system rebuilds the tiles under them
+    for (int32 Chunk : DirtyNavChunkList)
+    {
+        DirtyNavChunks[Chunk] = false;
+        NavModifiers[Chunk]->RefreshNavigationModifiers();
+    }
+    DirtyNavChunkList.Reset();
+}
+
+FCollisionQueryParams ABuildingGridManager::MakeTerrainQueryParams() const
+{
+    FCollisionQueryParams Params(SCENE_QUERY_STAT(GridTerrainTrace), false, this);
+    for (ABuildingObject* Building : BuildingSlots)
+    {
+        if (Building)
         {
-            // Check if there's a building below
-            const FGridCellData& CellBelow = GridData[FloorLevel-1].GetRow(Cell.Y).GetCell(Cell.X);
-            if (!CellBelow.bIsOccupied)
-            {
-                return false;
-            }
+            Params.AddIgnoredActor(Building);
         }
     }
-    
-    // All cells are available
-    return true;
+    return Params;
 }
 
-void ABuildingGridManager::MarkCellsAsOccupied(const FBuildingFootprint& Footprint, const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel, AActor* Building)
+void ABuildingGridManager::MarkCellsAsOccupied(const FBuildingFootprint& Footprint, const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel, AActor* Building, int32 BuildingSlot)
+{
+    MarkCellsAsOccupied(Footprint.GetOccupiedCellPositions(GridOrigin, Rotation), GridOrigin, FloorLevel, Building, BuildingSlot);
+}
+
+void ABuildingGridManager::MarkCellsAsOccupied(const TArray<FIntPoint>& OccupiedCells, const FIntPoint& GridOrigin, int32 FloorLevel, AActor* Building, int32 BuildingSlot)
 {
-    // Get all cells the building occupies
-    TArray<FIntPoint> OccupiedCells = Footprint.GetOccupiedCellPositions(GridOrigin, Rotation);
-    
     // Mark each cell
     for (const FIntPoint& Cell : OccupiedCells)
     {
@@ -525,18 +2391,33 @@ void ABuildingGridManager::MarkCellsAsOccupied(const FBuildingFootprint& Footpri
             CellData.bIsOccupied = true;
             CellData.OccupyingObject = Building;
             CellData.ObjectOrigin = GridOrigin;
+            if (!OccupancyPlanes[FloorLevel].Get(Cell.X, Cell.Y))
+            {
+                OccupancyPlanes[FloorLevel].Set(Cell.X, Cell.Y, true);
+                OccupancyPyramids[FloorLevel].OnCellChanged(Cell.X, Cell.Y, true);
+            }
+            BuildingSlotPlanes[FloorLevel][Cell.Y * GridSizeX + Cell.X] = BuildingSlot;
             
             // Update visual
             UpdateCellVisual(Cell, FloorLevel);
         }
     }
+    
+    MarkGridChanged();
+    MarkNavCellsDirty(OccupiedCells, FloorLevel);
+    
+    // Split the rooms cut by the new footprint
+    RoomIndices[FloorLevel].OnCellsBlocked(OccupiedCells, OccupancyPlanes[FloorLevel], EdgeGrids[FloorLevel]);
+    NotifyRoomsChanged(FloorLevel);
 }
 
 void ABuildingGridManager::MarkCellsAsUnoccupied(const FBuildingFootprint& Footprint, const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel)
 {
-    // Get all cells the building occupies
-    TArray<FIntPoint> OccupiedCells = Footprint.GetOccupiedCellPositions(GridOrigin, Rotation);
-    
+    MarkCellsAsUnoccupied(Footprint.GetOccupiedCellPositions(GridOrigin, Rotation), FloorLevel);
+}
+
+void ABuildingGridManager::MarkCellsAsUnoccupied(const TArray<FIntPoint>& OccupiedCells, int32 FloorLevel)
+{
     // Mark each cell
     for (const FIntPoint& Cell : OccupiedCells)
     {
@@ -546,14 +2427,54 @@ void ABuildingGridManager::MarkCellsAsUnoccupied(const FBuildingFootprint& Footp
             CellData.bIsOccupied = false;
             CellData.OccupyingObject = nullptr;
             CellData.ObjectOrigin = Cell; // Reset to own position
+            if (OccupancyPlanes[FloorLevel].Get(Cell.X, Cell.Y))
+            {
+                OccupancyPlanes[FloorLevel].Set(Cell.X, Cell.Y, false);
+                OccupancyPyramids[FloorLevel].OnCellChanged(Cell.X, Cell.Y, false);
+            }
+            BuildingSlotPlanes[FloorLevel][Cell.Y * GridSizeX + Cell.X] = INDEX_NONE;
             
             // Update visual
             UpdateCellVisual(Cell, FloorLevel);
         }
     }
+    
+    MarkGridChanged();
+    MarkNavCellsDirty(OccupiedCells, FloorLevel);
+    
+    // Merge the rooms joined by the freed footprint
+    RoomIndices[FloorLevel].OnCellsFreed(OccupiedCells, OccupancyPlanes[FloorLevel], EdgeGrids[FloorLevel]);
+    NotifyRoomsChanged(FloorLevel);
+}
+
+void ABuildingGridManager::ApplyBuildingInfluence(const UBuildingObjectAsset* BuildingAsset, const TArray<FIntPoint>& FootprintCells, int32 FloorLevel, float Sign)
+{
+    if (!BuildingAsset || !InfluenceFields.IsValidIndex(FloorLevel))
+    {
+        return;
+    }
+    
+    // Only the region within each kernel's radius is touched
+    for (const FBuildingInfluenceEmitter& Emitter : BuildingAsset->GetInfluenceEmitters())
+    {
+        InfluenceFields[FloorLevel].ApplyEmitter(FootprintCells, Emitter, Sign);
+    }
+}
+
+void ABuildingGridManager::NotifyRoomsChanged(int32 FloorLevel)
+{
+    FGridRoomIndex& RoomIndex = RoomIndices[FloorLevel];
+    if (RoomIndex.GetChangedRooms().Num() == 0)
+    {
+        return;
+    }
+    
+    OnRoomsChanged.Broadcast(FloorLevel, RoomIndex.GetChangedRooms());
+    RoomIndex.ResetChangedRooms();
 }
 
-bool ABuildingGridManager::CheckAdjacencyRequirements(const TArray<FAdjacencyRequirement>& Requirements, const FIntPoint& GridOrigin, int32 FloorLevel)
+bool ABuildingGridManager::CheckAdjacencyRequirements(const TArray<FAdjacencyRequirement>& Requirements, const FIntPoint& GridOrigin, int32 FloorLevel,
+    const TMap<FIntPoint, EBuildingType>* PendingCellTypes, const FIntPoint& PendingOrigin)
 {
     // If no requirements, always valid
     if (Requirements.Num() == 0)
@@ -604,6 +2525,17 @@ bool ABuildingGridManager::CheckAdjacencyRequirements(const TArray<FAdjacencyReq
                 continue;
             }
             
+            // Buildings of the same batch are not on the grid yet
+            if (const EBuildingType* PendingType = PendingCellTypes ? PendingCellTypes->Find(Cell - PendingOrigin) : nullptr)
+            {
+                if (*PendingType == Requirement.RequiredBuildingType)
+                {
+                    bFoundMatch = true;
+                    break;
+                }
+                continue;
+            }
+            
             // Get the cell data
             const FGridCellData& CellData = GridData[FloorLevel].GetRow(Cell.Y).GetCell(Cell.X);
             
@@ -23,6 +23,7 @@ ABuildingObject::ABuildingObject()
     FloorLevel = 0;
     GridRotation = 0;
     BuildingState = 0; // Default state (planning/construction)
+    ConstructionProgress = 0.0f;
     OperationalEfficiency = 100.0f; // Start at 100% efficiency
 }
 
@@ -60,10 +61,14 @@ void ABuildingObject::InitializeFromAsset(UBuildingObjectAsset* Asset)
     // Initialize other properties from asset
     OperationalEfficiency = 100.0f;
     BuildingState = 0; // Construction state
+    ConstructionProgress = 0.0f;
     
     // Clear staff and guests
     AssignedStaff.Empty();
     CurrentGuests.Empty();
+    SimulatedGuests.Empty();
+    AgentGuests.Empty();
+    AgentStaff.Empty();
 }
 
 FBuildingFootprint ABuildingObject::GetFootprint() const
@@ -136,13 +141,40 @@ bool ABuildingObject::RemoveStaffMember(AActor* StaffMember)
     return false;
 }
 
+bool ABuildingObject::AssignAgentStaff(const FAgentHandle& StaffMember)
+{
+    if (!StaffMember.IsValid())
+    {
+        return false;
+    }
+    
+    if (!AgentStaff.Contains(StaffMember))
+    {
+        AgentStaff.Add(StaffMember);
+        UpdateEfficiency();
+    }
+    
+    return true;
+}
+
+bool ABuildingObject::RemoveAgentStaff(const FAgentHandle& StaffMember)
+{
+    if (AgentStaff.RemoveSingleSwap(StaffMember, EAllowShrinking::No) > 0)
+    {
+        UpdateEfficiency();
+        return true;
+    }
+    
+    return false;
+}
+
 bool ABuildingObject::HasAvailableCapacity() const
 {
     // Get max capacity from asset
     int32 MaxCapacity = BuildingAsset ? BuildingAsset->MaxGuests : 1;
     
     // Check current guests
-    return CurrentGuests.Num() < MaxCapacity;
+    return GetNumGuests() < MaxCapacity;
 }
 
 bool ABuildingObject::RegisterGuest(AActor* Guest)
@@ -183,6 +215,64 @@ bool ABuildingObject::RemoveGuest(AActor* Guest)
     return NumRemoved > 0;
 }
 
+bool ABuildingObject::RegisterSimulatedGuest(int32 GuestId)
+{
+    if (GuestId == INDEX_NONE)
+    {
+        return false;
+    }
+    
+    // Check if already registered
+    if (SimulatedGuests.Contains(GuestId))
+    {
+        return true;
+    }
+    
+    // Check capacity
+    if (!HasAvailableCapacity())
+    {
+        return false;
+    }
+    
+    SimulatedGuests.Add(GuestId);
+    
+    return true;
+}
+
+bool ABuildingObject::RemoveSimulatedGuest(int32 GuestId)
+{
+    return SimulatedGuests.RemoveSingleSwap(GuestId, EAllowShrinking::No) > 0;
+}
+
+bool ABuildingObject::RegisterAgentGuest(const FAgentHandle& Guest)
+{
+    if (!Guest.IsValid())
+    {
+        return false;
+    }
+    
+    // Check if already registered
+    if (AgentGuests.Contains(Guest))
+    {
+        return true;
+    }
+    
+    // Check capacity
+    if (!HasAvailableCapacity())
+    {
+        return false;
+    }
+    
+    AgentGuests.Add(Guest);
+    
+    return true;
+}
+
+bool ABuildingObject::RemoveAgentGuest(const FAgentHandle& Guest)
+{
+    return AgentGuests.RemoveSingleSwap(Guest, EAllowShrinking::No) > 0;
+}
+
 bool ABuildingObject::SupportsTreatment(const FName& TreatmentType) const
 {
     // Check if building asset is valid
@@ -212,7 +302,7 @@ bool ABuildingObject::IsOperational() const
         {
             // Count assigned staff of this type
             // Note: This is simplified, in a real implementation we would check the staff type
-            if (AssignedStaff.Num() < StaffRequirement.Value)
+            if (GetNumStaff() < StaffRequirement.Value)
             {
                 return false; // Not enough staff
             }
@@ -238,15 +328,31 @@ int32 ABuildingObject::CalculateMaintenanceCost() const
     return Cost;
 }
 
+void ABuildingObject::SetConstructionProgress(float Progress)
+{
+    ConstructionProgress = FMath::Clamp(Progress, 0.0f, 1.0f);
+}
+
+void ABuildingObject::CompleteConstruction()
+{
+    if (BuildingState != 0)
+    {
+        return;
+    }
+    
+    // Operational from now on
+    BuildingState = 1;
+    ConstructionProgress = 1.0f;
+    UpdateEfficiency();
+}
+
 void ABuildingObject::OnDailyUpdate()
 {
-    // Update building state if needed
-    // For example, progress from construction to operational
-    if (BuildingState == 0)
+    // Construction progress is simulated by the construction queue, which calls CompleteConstruction.
+    // Buildings that need no construction work still open on their first day without it
+    if (BuildingState == 0 && (!BuildingAsset || BuildingAsset->ConstructionHours <= 0.0f))
     {
-        // This would normally be based on construction progress
-        // For now, we'll just set it to operational
-        BuildingState = 1;
+        CompleteConstruction();
     }
     
     // Update efficiency
@@ -270,7 +376,7 @@ void ABuildingObject::UpdateEfficiency()
         {
             // Count assigned staff of this type
             // Note: This is simplified, in a real implementation we would check the staff type
-            float StaffRatio = FMath::Min(1.0f, (float)AssignedStaff.Num() / StaffRequirement.Value);
+            float StaffRatio = FMath::Min(1.0f, (float)GetNumStaff() / StaffRequirement.Value);
             
             // Staff efficiency is the minimum ratio across all required types
             StaffEfficiency = FMath::Min(StaffEfficiency, StaffRatio * 100.0f);
@@ -17,4 +17,55 @@ UBuildingObjectAsset::UBuildingObjectAsset()
     
 	// By default, we have no building class set
 	BuildingClass = nullptr;
-}
\ No newline at end of file
+}
+
+TArray<FBuildingInfluenceEmitter> UBuildingObjectAsset::GetInfluenceEmitters() const
+{
+	// Explicit emitters override the defaults
+	if (InfluenceEmitters.Num() > 0)
+	{
+		return InfluenceEmitters;
+	}
+    
+	return GetDefaultInfluenceEmitters(BuildingType);
+}
+
+TArray<FBuildingInfluenceEmitter> UBuildingObjectAsset::GetDefaultInfluenceEmitters(EBuildingType Type)
+{
+	TArray<FBuildingInfluenceEmitter> Emitters;
+    
+	switch (Type)
+	{
+		case EBuildingType::Garden:
+			Emitters.Add(FBuildingInfluenceEmitter(EGridInfluenceChannel::Tranquility, 1.0f, 6));
+			Emitters.Add(FBuildingInfluenceEmitter(EGridInfluenceChannel::Appeal, 0.6f, 5));
+			break;
+		case EBuildingType::MeditationRoom:
+		case EBuildingType::YogaStudio:
+			Emitters.Add(FBuildingInfluenceEmitter(EGridInfluenceChannel::Tranquility, 0.5f, 3));
+			break;
+		case EBuildingType::Villa:
+		case EBuildingType::Suite:
+			Emitters.Add(FBuildingInfluenceEmitter(EGridInfluenceChannel::Appeal, 0.4f, 3));
+			break;
+		case EBuildingType::Restaurant:
+			Emitters.Add(FBuildingInfluenceEmitter(EGridInfluenceChannel::Noise, 1.0f, 6));
+			Emitters.Add(FBuildingInfluenceEmitter(EGridInfluenceChannel::Appeal, 0.3f, 3));
+			break;
+		case EBuildingType::JuiceBar:
+			Emitters.Add(FBuildingInfluenceEmitter(EGridInfluenceChannel::Noise, 0.4f, 3));
+			break;
+		case EBuildingType::Utility:
+			Emitters.Add(FBuildingInfluenceEmitter(EGridInfluenceChannel::Noise, 1.2f, 5));
+			Emitters.Add(FBuildingInfluenceEmitter(EGridInfluenceChannel::Appeal, -0.8f, 4));
+			break;
+		case EBuildingType::StaffRoom:
+		case EBuildingType::Office:
+			Emitters.Add(FBuildingInfluenceEmitter(EGridInfluenceChannel::Noise, 0.3f, 2));
+			break;
+		default:
+			break;
+	}
+    
+	return Emitters;
+}
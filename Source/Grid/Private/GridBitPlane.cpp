@@ -0,0 +1,286 @@
+﻿// GridBitPlane.cpp - Implementation of bit-packed grid planes
+#include "GridBitPlane.h"
+
+void FGridFootprintMask::Build(const TArray<FIntPoint>& Cells)
+{
+    Words.Reset();
+    Width = 0;
+    Height = 0;
+    WordsPerRow = 0;
+
+    if (Cells.Num() == 0)
+    {
+        return;
+    }
+
+    // Bounds of the cells
+    FIntPoint Max = Cells[0];
+    Min = Cells[0];
+    for (const FIntPoint& Cell : Cells)
+    {
+        Min.X = FMath::Min(Min.X, Cell.X);
+        Min.Y = FMath::Min(Min.Y, Cell.Y);
+        Max.X = FMath::Max(Max.X, Cell.X);
+        Max.Y = FMath::Max(Max.Y, Cell.Y);
+    }
+
+    Width = Max.X - Min.X + 1;
+    Height = Max.Y - Min.Y + 1;
+    WordsPerRow = (Width + 63) >> 6;
+    Words.SetNumZeroed(WordsPerRow * Height);
+
+    for (const FIntPoint& Cell : Cells)
+    {
+        const int32 X = Cell.X - Min.X;
+        Words[(Cell.Y - Min.Y) * WordsPerRow + (X >> 6)] |= 1ull << (X & 63);
+    }
+}
+
+void FGridBitPlane::Init(int32 InSizeX, int32 InSizeY, bool bInitialValue)
+{
+    SizeX = FMath::Max(0, InSizeX);
+    SizeY = FMath::Max(0, InSizeY);
+    WordsPerRow = (SizeX + 63) >> 6;
+
+    Words.Reset();
+    Words.SetNumZeroed(WordsPerRow * SizeY);
+
+    if (bInitialValue)
+    {
+        SetRect(FIntRect(0, 0, SizeX, SizeY), true);
+    }
+}
+
+void FGridBitPlane::Expand(int32 NewSizeX, int32 NewSizeY, const FIntPoint& Offset)
+{
+    checkSlow(Offset.X >= 0 && Offset.Y >= 0 && NewSizeX >= SizeX + Offset.X && NewSizeY >= SizeY + Offset.Y);
+
+    FGridBitPlane Expanded(NewSizeX, NewSizeY, false);
+    if (SizeX > 0)
+    {
+        // Only the words the old row lands in are written; bits past the old width are clear, so nothing spills
+        const int32 FirstWord = Offset.X >> 6;
+        const int32 LastWord = (Offset.X + SizeX - 1) >> 6;
+        for (int32 Y = 0; Y < SizeY; Y++)
+        {
+            uint64* Row = Expanded.GetRowWords(Y + Offset.Y);
+            for (int32 WordIndex = FirstWord; WordIndex <= LastWord; WordIndex++)
+            {
+                Row[WordIndex] = ExtractBits(Y, (WordIndex << 6) - Offset.X);
+            }
+        }
+    }
+
+    *this = MoveTemp(Expanded);
+}
+
+void FGridBitPlane::SetRect(const FIntRect& Rect, bool bValue)
+{
+    // Clip to the plane
+    const int32 MinX = FMath::Max(Rect.Min.X, 0);
+    const int32 MinY = FMath::Max(Rect.Min.Y, 0);
+    const int32 MaxX = FMath::Min(Rect.Max.X, SizeX);
+    const int32 MaxY = FMath::Min(Rect.Max.Y, SizeY);
+
+    if (MinX >= MaxX || MinY >= MaxY)
+    {
+        return;
+    }
+
+    const int32 FirstWord = MinX >> 6;
+    const int32 LastWord = (MaxX - 1) >> 6;
+
+    for (int32 Y = MinY; Y < MaxY; Y++)
+    {
+        uint64* Row = GetRowWords(Y);
+
+        for (int32 WordIndex = FirstWord; WordIndex <= LastWord; WordIndex++)
+        {
+            const int32 FromBit = WordIndex == FirstWord ? (MinX & 63) : 0;
+            const int32 ToBit = WordIndex == LastWord ? (((MaxX - 1) & 63) + 1) : 64;
+            const uint64 Mask = SpanMask(FromBit, ToBit);
+
+            Row[WordIndex] = bValue ? (Row[WordIndex] | Mask) : (Row[WordIndex] & ~Mask);
+        }
+    }
+}
+
+bool FGridBitPlane::AnyInRect(const FIntRect& Rect) const
+{
+    // Clip to the plane
+    const int32 MinX = FMath::Max(Rect.Min.X, 0);
+    const int32 MinY = FMath::Max(Rect.Min.Y, 0);
+    const int32 MaxX = FMath::Min(Rect.Max.X, SizeX);
+    const int32 MaxY = FMath::Min(Rect.Max.Y, SizeY);
+
+    if (MinX >= MaxX || MinY >= MaxY)
+    {
+        return false;
+    }
+
+    const int32 FirstWord = MinX >> 6;
+    const int32 LastWord = (MaxX - 1) >> 6;
+
+    for (int32 Y = MinY; Y < MaxY; Y++)
+    {
+        const uint64* Row = GetRowWords(Y);
+
+        for (int32 WordIndex = FirstWord; WordIndex <= LastWord; WordIndex++)
+        {
+            const int32 FromBit = WordIndex == FirstWord ? (MinX & 63) : 0;
+            const int32 ToBit = WordIndex == LastWord ? (((MaxX - 1) & 63) + 1) : 64;
+
+            if (Row[WordIndex] & SpanMask(FromBit, ToBit))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void FGridBitPlane::CollectRects(const FIntRect& Area, TArray<FIntRect>& OutRects) const
+{
+    const FIntRect Clipped(
+        FMath::Max(Area.Min.X, 0), FMath::Max(Area.Min.Y, 0),
+        FMath::Min(Area.Max.X, SizeX), FMath::Min(Area.Max.Y, SizeY));
+    if (Clipped.Min.X >= Clipped.Max.X || Clipped.Min.Y >= Clipped.Max.Y)
+    {
+        return;
+    }
+
+    // Rectangles that reached the previous row, in column order
+    TArray<int32> Open;
+    TArray<int32> NextOpen;
+    for (int32 Y = Clipped.Min.Y; Y < Clipped.Max.Y; Y++)
+    {
+        NextOpen.Reset();
+        int32 OpenIndex = 0;
+        int32 X = Clipped.Min.X;
+        while (X < Clipped.Max.X)
+        {
+            // Skip to the first set cell, 64 cells at a time
+            uint64 Bits = ExtractBits(Y, X);
+            if (Clipped.Max.X - X < 64)
+            {
+                Bits &= SpanMask(0, Clipped.Max.X - X);
+            }
+            if (Bits == 0)
+            {
+                X += 64;
+                continue;
+            }
+            const int32 Start = X + static_cast<int32>(FMath::CountTrailingZeros64(Bits));
+
+            // Find the end of the run the same way on the inverted bits
+            int32 End = Start;
+            while (End < Clipped.Max.X)
+            {
+                uint64 Clear = ~ExtractBits(Y, End);
+                if (Clipped.Max.X - End < 64)
+                {
+                    Clear |= ~SpanMask(0, Clipped.Max.X - End);
+                }
+                if (Clear == 0)
+                {
+                    End += 64;
+                    continue;
+                }
+                End += static_cast<int32>(FMath::CountTrailingZeros64(Clear));
+                break;
+            }
+            End = FMath::Min(End, Clipped.Max.X);
+
+            // Extend the rectangle above if it spans exactly this run
+            while (OpenIndex < Open.Num() && OutRects[Open[OpenIndex]].Min.X < Start)
+            {
+                OpenIndex++;
+            }
+            if (OpenIndex < Open.Num() && OutRects[Open[OpenIndex]].Min.X == Start && OutRects[Open[OpenIndex]].Max.X == End)
+            {
+                OutRects[Open[OpenIndex]].Max.Y = Y + 1;
+                NextOpen.Add(Open[OpenIndex]);
+                OpenIndex++;
+            }
+            else
+            {
+                NextOpen.Add(OutRects.Add(FIntRect(Start, Y, End, Y + 1)));
+            }
+
+            X = End;
+        }
+
+        Swap(Open, NextOpen);
+    }
+}
+
+int32 FGridBitPlane::CountSetBits() const
+{
+    int32 Count = 0;
+
+    for (const uint64 Word : Words)
+    {
+        Count += FMath::CountBits(Word);
+    }
+
+    return Count;
+}
+
+uint64 FGridBitPlane::ExtractBits(int32 Y, int32 X) const
+{
+    if (Y < 0 || Y >= SizeY || X >= SizeX || X <= -64)
+    {
+        return 0;
+    }
+
+    const uint64* Row = GetRowWords(Y);
+    auto WordAt = [Row, this](int32 WordIndex) -> uint64
+    {
+        return (WordIndex >= 0 && WordIndex < WordsPerRow) ? Row[WordIndex] : 0;
+    };
+
+    // Arithmetic shift keeps negative columns in the word to the left
+    const int32 WordIndex = X >> 6;
+    const int32 Shift = X & 63;
+    if (Shift == 0)
+    {
+        return WordAt(WordIndex);
+    }
+
+    return (WordAt(WordIndex) >> Shift) | (WordAt(WordIndex + 1) << (64 - Shift));
+}
+
+bool FGridBitPlane::Intersects(const FGridFootprintMask& Mask) const
+{
+    for (int32 Row = 0; Row < Mask.Height; Row++)
+    {
+        const uint64* MaskRow = Mask.Words.GetData() + Row * Mask.WordsPerRow;
+        for (int32 WordIndex = 0; WordIndex < Mask.WordsPerRow; WordIndex++)
+        {
+            if (MaskRow[WordIndex] & ExtractBits(Mask.Min.Y + Row, Mask.Min.X + (WordIndex << 6)))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool FGridBitPlane::Covers(const FGridFootprintMask& Mask) const
+{
+    for (int32 Row = 0; Row < Mask.Height; Row++)
+    {
+        const uint64* MaskRow = Mask.Words.GetData() + Row * Mask.WordsPerRow;
+        for (int32 WordIndex = 0; WordIndex < Mask.WordsPerRow; WordIndex++)
+        {
+            if (MaskRow[WordIndex] & ~ExtractBits(Mask.Min.Y + Row, Mask.Min.X + (WordIndex << 6)))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
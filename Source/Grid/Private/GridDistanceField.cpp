@@ -0,0 +1,132 @@
+﻿// GridDistanceField.cpp - Implementation of the walking distance field
+#include "GridDistanceField.h"
+#include "GridBitPlane.h"
+#include "GridEdgeGrid.h"
+
+void FGridDistanceField::Build(const FGridBitPlane& Occupancy, const FGridEdgeGrid& Edges, const TArray<FIntPoint>& Sources)
+{
+    SizeX = Occupancy.GetSizeX();
+    SizeY = Occupancy.GetSizeY();
+    Distances.Init(Unreachable, SizeX * SizeY);
+
+    const int32 WordsPerRow = Occupancy.GetWordsPerRow();
+    const int32 NumWords = WordsPerRow * SizeY;
+    if (NumWords == 0)
+    {
+        return;
+    }
+
+    const uint64 TailMask = (SizeX & 63) != 0 ? FGridBitPlane::SpanMask(0, SizeX & 63) : ~0ull;
+
+    // Walkable cells and the sides agents can step through, one mask per row
+    TArray<uint64> Walkable, EastOpen, WestOpen, NorthOpen, SouthOpen;
+    Walkable.SetNumUninitialized(NumWords);
+    EastOpen.SetNumUninitialized(NumWords);
+    WestOpen.SetNumUninitialized(NumWords);
+    NorthOpen.SetNumUninitialized(NumWords);
+    SouthOpen.SetNumUninitialized(NumWords);
+
+    for (int32 Y = 0; Y < SizeY; Y++)
+    {
+        const uint64* OccupiedRow = Occupancy.GetRowWords(Y);
+        uint64* WalkableRow = Walkable.GetData() + Y * WordsPerRow;
+        for (int32 WordIndex = 0; WordIndex < WordsPerRow; WordIndex++)
+        {
+            WalkableRow[WordIndex] = ~OccupiedRow[WordIndex];
+        }
+        WalkableRow[WordsPerRow - 1] &= TailMask;
+
+        Edges.GetOpenSideRow(Y, EGridDirection::East, true, EastOpen.GetData() + Y * WordsPerRow);
+        Edges.GetOpenSideRow(Y, EGridDirection::West, true, WestOpen.GetData() + Y * WordsPerRow);
+        Edges.GetOpenSideRow(Y, EGridDirection::North, true, NorthOpen.GetData() + Y * WordsPerRow);
+        Edges.GetOpenSideRow(Y, EGridDirection::South, true, SouthOpen.GetData() + Y * WordsPerRow);
+    }
+
+    TArray<uint64> Visited, Frontier, Next;
+    Visited.SetNumZeroed(NumWords);
+    Frontier.SetNumZeroed(NumWords);
+    Next.SetNumZeroed(NumWords);
+
+    // Seed the search
+    bool bAnyFrontier = false;
+    for (const FIntPoint& Source : Sources)
+    {
+        if (!Occupancy.IsValidCell(Source.X, Source.Y) || Occupancy.Get(Source.X, Source.Y))
+        {
+            continue;
+        }
+
+        const int32 WordIndex = Source.Y * WordsPerRow + (Source.X >> 6);
+        const uint64 Bit = 1ull << (Source.X & 63);
+        Frontier[WordIndex] |= Bit;
+        Visited[WordIndex] |= Bit;
+        Distances[Source.Y * SizeX + Source.X] = 0;
+        bAnyFrontier = true;
+    }
+
+    // Expand the frontier one step at a time, a full row of words per operation
+    for (int32 Distance = 1; bAnyFrontier && Distance < Unreachable; Distance++)
+    {
+        FMemory::Memzero(Next.GetData(), NumWords * sizeof(uint64));
+
+        for (int32 Y = 0; Y < SizeY; Y++)
+        {
+            for (int32 WordIndex = 0; WordIndex < WordsPerRow; WordIndex++)
+            {
+                const int32 Index = Y * WordsPerRow + WordIndex;
+                const uint64 Cells = Frontier[Index];
+                if (!Cells)
+                {
+                    continue;
+                }
+
+                // Steps east move bits up by one, carrying into the next word
+                const uint64 East = Cells & EastOpen[Index];
+                Next[Index] |= East << 1;
+                if (WordIndex + 1 < WordsPerRow)
+                {
+                    Next[Index + 1] |= East >> 63;
+                }
+
+                // Steps west move bits down by one, borrowing from the previous word
+                const uint64 West = Cells & WestOpen[Index];
+                Next[Index] |= West >> 1;
+                if (WordIndex > 0)
+                {
+                    Next[Index - 1] |= West << 63;
+                }
+
+                if (Y > 0)
+                {
+                    Next[Index - WordsPerRow] |= Cells & NorthOpen[Index];
+                }
+
+                if (Y + 1 < SizeY)
+                {
+                    Next[Index + WordsPerRow] |= Cells & SouthOpen[Index];
+                }
+            }
+        }
+
+        // Keep only walkable cells reached for the first time and record their distance
+        bAnyFrontier = false;
+        for (int32 Index = 0; Index < NumWords; Index++)
+        {
+            uint64 Reached = Next[Index] & Walkable[Index] & ~Visited[Index];
+            Next[Index] = Reached;
+            Visited[Index] |= Reached;
+            bAnyFrontier |= Reached != 0;
+
+            const int32 Y = Index / WordsPerRow;
+            const int32 BaseX = (Index % WordsPerRow) << 6;
+            while (Reached)
+            {
+                const int32 Bit = static_cast<int32>(FMath::CountTrailingZeros64(Reached));
+                Distances[Y * SizeX + BaseX + Bit] = static_cast<uint16>(Distance);
+                Reached &= Reached - 1;
+            }
+        }
+
+        Swap(Frontier, Next);
+    }
+}
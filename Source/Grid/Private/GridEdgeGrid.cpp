@@ -0,0 +1,174 @@
+﻿// GridEdgeGrid.cpp - Implementation of the edge grid
+#include "GridEdgeGrid.h"
+
+void FGridEdgeGrid::Init(int32 InSizeX, int32 InSizeY)
+{
+    SizeX = FMath::Max(0, InSizeX);
+    SizeY = FMath::Max(0, InSizeY);
+
+    for (int32 Slot = 0; Slot < 3; Slot++)
+    {
+        Planes[Horizontal][Slot].Init(SizeX, SizeY + 1, false);
+        Planes[Vertical][Slot].Init(SizeX + 1, SizeY, false);
+    }
+}
+
+void FGridEdgeGrid::Expand(int32 NewSizeX, int32 NewSizeY, const FIntPoint& Offset)
+{
+    SizeX = NewSizeX;
+    SizeY = NewSizeY;
+
+    // Edge coordinates are cell coordinates, so both axes move with the cells
+    for (int32 Slot = 0; Slot < 3; Slot++)
+    {
+        Planes[Horizontal][Slot].Expand(SizeX, SizeY + 1, Offset);
+        Planes[Vertical][Slot].Expand(SizeX + 1, SizeY, Offset);
+    }
+}
+
+EGridEdgeType FGridEdgeGrid::GetEdge(const FIntPoint& Cell, EGridDirection Side) const
+{
+    int32 Axis, X, Y;
+    if (!ResolveEdge(Cell, Side, Axis, X, Y))
+    {
+        return EGridEdgeType::None;
+    }
+
+    if (Planes[Axis][TypeSlot(EGridEdgeType::Wall)].Get(X, Y))
+    {
+        return EGridEdgeType::Wall;
+    }
+
+    if (Planes[Axis][TypeSlot(EGridEdgeType::Door)].Get(X, Y))
+    {
+        return EGridEdgeType::Door;
+    }
+
+    if (Planes[Axis][TypeSlot(EGridEdgeType::Window)].Get(X, Y))
+    {
+        return EGridEdgeType::Window;
+    }
+
+    return EGridEdgeType::None;
+}
+
+bool FGridEdgeGrid::SetEdge(const FIntPoint& Cell, EGridDirection Side, EGridEdgeType EdgeType)
+{
+    int32 Axis, X, Y;
+    if (!ResolveEdge(Cell, Side, Axis, X, Y))
+    {
+        return false;
+    }
+
+    // An edge holds at most one element
+    for (int32 Slot = 0; Slot < 3; Slot++)
+    {
+        Planes[Axis][Slot].Set(X, Y, EdgeType != EGridEdgeType::None && Slot == TypeSlot(EdgeType));
+    }
+
+    return true;
+}
+
+bool FGridEdgeGrid::SeparatesRooms(const FIntPoint& Cell, EGridDirection Side) const
+{
+    return GetEdge(Cell, Side) != EGridEdgeType::None;
+}
+
+bool FGridEdgeGrid::BlocksMovement(const FIntPoint& Cell, EGridDirection Side) const
+{
+    const EGridEdgeType EdgeType = GetEdge(Cell, Side);
+    return EdgeType == EGridEdgeType::Wall || EdgeType == EGridEdgeType::Window;
+}
+
+bool FGridEdgeGrid::BlocksSight(const FIntPoint& Cell, EGridDirection Side) const
+{
+    int32 Axis, X, Y;
+    if (!ResolveEdge(Cell, Side, Axis, X, Y))
+    {
+        return false;
+    }
+
+    return Planes[Axis][TypeSlot(EGridEdgeType::Wall)].Get(X, Y) || Planes[Axis][TypeSlot(EGridEdgeType::Door)].Get(X, Y);
+}
+
+void FGridEdgeGrid::GetOpenSideRow(int32 Y, EGridDirection Side, bool bForMovement, uint64* OutWords) const
+{
+    const int32 CellWords = (SizeX + 63) >> 6;
+
+    // Pick the edge row and the bit offset between edge and cell coordinates
+    const int32 Axis = (Side == EGridDirection::North || Side == EGridDirection::South) ? Horizontal : Vertical;
+    const int32 EdgeRow = Side == EGridDirection::South ? Y + 1 : Y;
+    const int32 BitOffset = Side == EGridDirection::East ? 1 : 0;
+    const int32 EdgeWords = Planes[Axis][0].GetWordsPerRow();
+
+    const uint64* Walls = Planes[Axis][TypeSlot(EGridEdgeType::Wall)].GetRowWords(EdgeRow);
+    const uint64* Doors = Planes[Axis][TypeSlot(EGridEdgeType::Door)].GetRowWords(EdgeRow);
+    const uint64* Windows = Planes[Axis][TypeSlot(EGridEdgeType::Window)].GetRowWords(EdgeRow);
+
+    for (int32 WordIndex = 0; WordIndex < CellWords; WordIndex++)
+    {
+        auto Closed = [&](int32 Index) -> uint64
+        {
+            if (Index >= EdgeWords)
+            {
+                return 0;
+            }
+
+            uint64 Bits = Walls[Index] | Windows[Index];
+            if (!bForMovement)
+            {
+                Bits |= Doors[Index];
+            }
+            return Bits;
+        };
+
+        uint64 ClosedBits = Closed(WordIndex);
+        if (BitOffset)
+        {
+            // East sides live one column to the right, shift the next word in
+            ClosedBits = (ClosedBits >> 1) | (Closed(WordIndex + 1) << 63);
+        }
+
+        OutWords[WordIndex] = ~ClosedBits;
+    }
+
+    // Keep the padding past the last cell clear
+    if (CellWords > 0 && (SizeX & 63) != 0)
+    {
+        OutWords[CellWords - 1] &= FGridBitPlane::SpanMask(0, SizeX & 63);
+    }
+}
+
+bool FGridEdgeGrid::ResolveEdge(const FIntPoint& Cell, EGridDirection Side, int32& OutAxis, int32& OutX, int32& OutY) const
+{
+    if (Cell.X < 0 || Cell.X >= SizeX || Cell.Y < 0 || Cell.Y >= SizeY)
+    {
+        return false;
+    }
+
+    switch (Side)
+    {
+        case EGridDirection::North:
+            OutAxis = Horizontal;
+            OutX = Cell.X;
+            OutY = Cell.Y;
+            return true;
+        case EGridDirection::South:
+            OutAxis = Horizontal;
+            OutX = Cell.X;
+            OutY = Cell.Y + 1;
+            return true;
+        case EGridDirection::West:
+            OutAxis = Vertical;
+            OutX = Cell.X;
+            OutY = Cell.Y;
+            return true;
+        case EGridDirection::East:
+            OutAxis = Vertical;
+            OutX = Cell.X + 1;
+            OutY = Cell.Y;
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,157 @@
+﻿// GridInfluenceField.cpp - Implementation of the influence fields
+#include "GridInfluenceField.h"
+#include "GridBitPlane.h"
+
+void FGridInfluenceField::Init(int32 InSizeX, int32 InSizeY)
+{
+    SizeX = FMath::Max(0, InSizeX);
+    SizeY = FMath::Max(0, InSizeY);
+
+    for (int32 Channel = 0; Channel < NumChannels; Channel++)
+    {
+        Values[Channel].Reset();
+        Values[Channel].SetNumZeroed(SizeX * SizeY);
+    }
+}
+
+void FGridInfluenceField::Expand(int32 NewSizeX, int32 NewSizeY, const FIntPoint& Offset)
+{
+    for (int32 Channel = 0; Channel < NumChannels; Channel++)
+    {
+        ExpandGridValues(Values[Channel], SizeX, SizeY, NewSizeX, NewSizeY, Offset, 0.0f);
+    }
+
+    SizeX = NewSizeX;
+    SizeY = NewSizeY;
+}
+
+void FGridInfluenceField::ApplyEmitter(const TArray<FIntPoint>& FootprintCells, const FBuildingInfluenceEmitter& Emitter, float Sign)
+{
+    const int32 ChannelIndex = static_cast<int32>(Emitter.Channel);
+    if (FootprintCells.Num() == 0 || FMath::IsNearlyZero(Emitter.Strength) || ChannelIndex < 0 || ChannelIndex >= NumChannels)
+    {
+        return;
+    }
+
+    const int32 Radius = FMath::Clamp(Emitter.Radius, 0, 32);
+
+    // Bounds of the footprint
+    FIntPoint Min(MAX_int32, MAX_int32);
+    FIntPoint Max(MIN_int32, MIN_int32);
+    for (const FIntPoint& Cell : FootprintCells)
+    {
+        Min.X = FMath::Min(Min.X, Cell.X);
+        Min.Y = FMath::Min(Min.Y, Cell.Y);
+        Max.X = FMath::Max(Max.X, Cell.X);
+        Max.Y = FMath::Max(Max.Y, Cell.Y);
+    }
+
+    // The patch is the footprint grown by the radius; rows are padded to whole vectors
+    const int32 FootprintWidth = Max.X - Min.X + 1;
+    const int32 FootprintHeight = Max.Y - Min.Y + 1;
+    const int32 PatchWidth = FootprintWidth + Radius * 2;
+    const int32 PatchHeight = FootprintHeight + Radius * 2;
+    const int32 PaddedWidth = Align(PatchWidth, 4);
+    const int32 MaskStride = PaddedWidth + Radius * 2;
+    const FIntPoint PatchMin(Min.X - Radius, Min.Y - Radius);
+
+    BuildKernel(Radius, KernelScratch);
+
+    // Footprint mask, one row per footprint row with Radius zeros of padding on both sides
+    MaskScratch.Reset();
+    MaskScratch.SetNumZeroed(MaskStride * FootprintHeight);
+    for (const FIntPoint& Cell : FootprintCells)
+    {
+        MaskScratch[(Cell.Y - Min.Y) * MaskStride + Radius + (Cell.X - PatchMin.X)] = 1.0f;
+    }
+
+    // Horizontal pass: blur each footprint row across the patch width
+    BlurScratch.Reset();
+    BlurScratch.SetNumZeroed(PaddedWidth * (FootprintHeight + PatchHeight));
+    for (int32 Row = 0; Row < FootprintHeight; Row++)
+    {
+        const float* MaskRow = MaskScratch.GetData() + Row * MaskStride + Radius;
+        float* BlurRow = BlurScratch.GetData() + Row * PaddedWidth;
+
+        for (int32 X = 0; X < PaddedWidth; X += 4)
+        {
+            VectorRegister4Float Sum = VectorZeroFloat();
+            for (int32 Offset = -Radius; Offset <= Radius; Offset++)
+            {
+                Sum = VectorMultiplyAdd(VectorSetFloat1(KernelScratch[Offset + Radius]), VectorLoad(MaskRow + X + Offset), Sum);
+            }
+            VectorStore(Sum, BlurRow + X);
+        }
+    }
+
+    // Vertical pass: every patch row gathers the footprint rows within the radius. The whole patch is
+    // blurred before anything is clipped, so its peak does not depend on where the building stands.
+    float* PatchRows = BlurScratch.GetData() + PaddedWidth * FootprintHeight;
+    VectorRegister4Float PeakVector = VectorZeroFloat();
+    for (int32 PatchY = 0; PatchY < PatchHeight; PatchY++)
+    {
+        const int32 FirstRow = FMath::Max(0, PatchY - Radius * 2);
+        const int32 LastRow = FMath::Min(FootprintHeight - 1, PatchY);
+
+        for (int32 X = 0; X < PaddedWidth; X += 4)
+        {
+            VectorRegister4Float Sum = VectorZeroFloat();
+            for (int32 Row = FirstRow; Row <= LastRow; Row++)
+            {
+                Sum = VectorMultiplyAdd(VectorSetFloat1(KernelScratch[PatchY - Row]), VectorLoad(BlurScratch.GetData() + Row * PaddedWidth + X), Sum);
+            }
+            VectorStore(Sum, PatchRows + PatchY * PaddedWidth + X);
+            PeakVector = VectorMax(PeakVector, Sum);
+        }
+    }
+
+    // The summed kernels grow with the footprint; scaling by their peak makes the most covered
+    // footprint cell receive exactly Strength, whatever the size of the building
+    alignas(16) float PeakLanes[4];
+    VectorStoreAligned(PeakVector, PeakLanes);
+    const float Peak = FMath::Max(FMath::Max(PeakLanes[0], PeakLanes[1]), FMath::Max(PeakLanes[2], PeakLanes[3]));
+    const float ScaleValue = Sign * Emitter.Strength / FMath::Max(Peak, UE_SMALL_NUMBER);
+    const VectorRegister4Float Scale = VectorSetFloat1(ScaleValue);
+
+    // Add the patch into the field, clipped to the floor
+    float* Field = Values[ChannelIndex].GetData();
+    const int32 FirstX = FMath::Max(0, -PatchMin.X);
+    const int32 LastX = FMath::Min(PatchWidth, SizeX - PatchMin.X);
+
+    for (int32 PatchY = 0; PatchY < PatchHeight; PatchY++)
+    {
+        const int32 GridY = PatchMin.Y + PatchY;
+        if (GridY < 0 || GridY >= SizeY || FirstX >= LastX)
+        {
+            continue;
+        }
+
+        // Patch column X is field cell RowStart + X; only columns from FirstX on lie inside the floor
+        const int32 RowStart = GridY * SizeX + PatchMin.X;
+        const float* PatchRow = PatchRows + PatchY * PaddedWidth;
+        int32 X = FirstX;
+        for (; X + 4 <= LastX; X += 4)
+        {
+            float* FieldCells = Field + RowStart + X;
+            VectorStore(VectorMultiplyAdd(VectorLoad(PatchRow + X), Scale, VectorLoad(FieldCells)), FieldCells);
+        }
+        for (; X < LastX; X++)
+        {
+            Field[RowStart + X] += PatchRow[X] * ScaleValue;
+        }
+    }
+}
+
+void FGridInfluenceField::BuildKernel(int32 Radius, TArray<float>& OutWeights)
+{
+    OutWeights.SetNumUninitialized(Radius * 2 + 1);
+
+    // Gaussian falloff that reaches about 5% at the radius
+    const float Sigma = FMath::Max(0.5f, Radius * 0.4f);
+    const float InvTwoSigmaSquared = 1.0f / (2.0f * Sigma * Sigma);
+
+    for (int32 Offset = -Radius; Offset <= Radius; Offset++)
+    {
+        OutWeights[Offset + Radius] = FMath::Exp(-(Offset * Offset) * InvTwoSigmaSquared);
+    }
+}
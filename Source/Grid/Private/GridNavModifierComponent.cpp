@@ -0,0 +1,41 @@
+﻿// GridNavModifierComponent.cpp - Implementation of the grid navigation modifiers
+#include "GridNavModifierComponent.h"
+#include "AI/NavigationModifier.h"
+#include "AI/Navigation/NavigationRelevantData.h"
+#include "BuildingGridManager.h"
+
+UGridNavModifierComponent::UGridNavModifierComponent(const FObjectInitializer& ObjectInitializer)
+    : Super(ObjectInitializer)
+{
+    // Each chunk is its own navigation element, so refreshing one does not dirty the whole grid actor
+    bAttachToOwner = false;
+}
+
+void UGridNavModifierComponent::SetCells(const FIntRect& InCells)
+{
+    Cells = InCells;
+    bBoundsInitialized = false;
+}
+
+void UGridNavModifierComponent::GetNavigationData(FNavigationRelevantData& Data) const
+{
+    const ABuildingGridManager* GridManager = Cast<ABuildingGridManager>(GetOwner());
+    if (!GridManager)
+    {
+        return;
+    }
+
+    TArray<FBox> Boxes;
+    GridManager->GetNavModifierBoxes(Cells, Boxes);
+    for (const FBox& Box : Boxes)
+    {
+        Data.Modifiers.Add(FAreaNavModifier(Box, FTransform::Identity, GridManager->GetOccupiedNavArea()));
+    }
+}
+
+void UGridNavModifierComponent::CalcAndCacheBounds() const
+{
+    const ABuildingGridManager* GridManager = Cast<ABuildingGridManager>(GetOwner());
+    Bounds = GridManager ? GridManager->GetNavModifierBounds(Cells) : FBox(ForceInit);
+    bBoundsInitialized = true;
+}
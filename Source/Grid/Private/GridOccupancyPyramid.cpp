@@ -0,0 +1,155 @@
+﻿// GridOccupancyPyramid.cpp - Implementation of the occupancy pyramid
+#include "GridOccupancyPyramid.h"
+
+void FGridOccupancyPyramid::Build(const FGridBitPlane& Occupancy)
+{
+    SizeX = Occupancy.GetSizeX();
+    SizeY = Occupancy.GetSizeY();
+    Levels.Reset();
+
+    // Halve until a single block covers the floor
+    int32 LevelSizeX = SizeX;
+    int32 LevelSizeY = SizeY;
+    while (LevelSizeX > 1 || LevelSizeY > 1)
+    {
+        LevelSizeX = (LevelSizeX + 1) >> 1;
+        LevelSizeY = (LevelSizeY + 1) >> 1;
+
+        FLevel& Level = Levels.AddDefaulted_GetRef();
+        Level.SizeX = LevelSizeX;
+        Level.SizeY = LevelSizeY;
+        Level.Counts.SetNumZeroed(LevelSizeX * LevelSizeY);
+    }
+
+    if (Levels.Num() == 0)
+    {
+        return;
+    }
+
+    // Count level 1 from the plane, every further level from the one below
+    FLevel& First = Levels[0];
+    for (int32 Y = 0; Y < SizeY; Y++)
+    {
+        for (int32 WordIndex = 0; WordIndex < Occupancy.GetWordsPerRow(); WordIndex++)
+        {
+            uint64 Bits = Occupancy.GetRowWords(Y)[WordIndex];
+            while (Bits)
+            {
+                const int32 X = (WordIndex << 6) + static_cast<int32>(FMath::CountTrailingZeros64(Bits));
+                Bits &= Bits - 1;
+                First.Counts[(Y >> 1) * First.SizeX + (X >> 1)]++;
+            }
+        }
+    }
+
+    for (int32 LevelIndex = 1; LevelIndex < Levels.Num(); LevelIndex++)
+    {
+        const FLevel& Below = Levels[LevelIndex - 1];
+        FLevel& Level = Levels[LevelIndex];
+        for (int32 Y = 0; Y < Below.SizeY; Y++)
+        {
+            for (int32 X = 0; X < Below.SizeX; X++)
+            {
+                Level.Counts[(Y >> 1) * Level.SizeX + (X >> 1)] += Below.Counts[Y * Below.SizeX + X];
+            }
+        }
+    }
+}
+
+void FGridOccupancyPyramid::OnCellChanged(int32 X, int32 Y, bool bOccupied)
+{
+    const int32 Delta = bOccupied ? 1 : -1;
+    for (int32 LevelIndex = 0; LevelIndex < Levels.Num(); LevelIndex++)
+    {
+        FLevel& Level = Levels[LevelIndex];
+        const int32 Shift = LevelIndex + 1;
+        Level.Counts[(Y >> Shift) * Level.SizeX + (X >> Shift)] += Delta;
+    }
+}
+
+EGridBlockState FGridOccupancyPyramid::GetRectState(const FGridBitPlane& Occupancy, const FIntRect& Rect) const
+{
+    // Clip to the floor
+    const FIntRect Clipped(
+        FMath::Max(Rect.Min.X, 0), FMath::Max(Rect.Min.Y, 0),
+        FMath::Min(Rect.Max.X, SizeX), FMath::Min(Rect.Max.Y, SizeY));
+    if (Clipped.Min.X >= Clipped.Max.X || Clipped.Min.Y >= Clipped.Max.Y)
+    {
+        return EGridBlockState::Free;
+    }
+
+    bool bAnyFree = false;
+    bool bAnyOccupied = false;
+    AccumulateRectState(Occupancy, Clipped, Levels.Num(), 0, 0, bAnyFree, bAnyOccupied);
+
+    if (!bAnyOccupied)
+    {
+        return EGridBlockState::Free;
+    }
+    return bAnyFree ? EGridBlockState::Partial : EGridBlockState::Full;
+}
+
+EGridBlockState FGridOccupancyPyramid::GetBlockState(int32 Level, int32 BlockX, int32 BlockY) const
+{
+    checkSlow(Level >= 1 && Level <= Levels.Num());
+    const int32 Count = Levels[Level - 1].Counts[BlockY * Levels[Level - 1].SizeX + BlockX];
+    if (Count == 0)
+    {
+        return EGridBlockState::Free;
+    }
+    return Count == GetBlockArea(Level, BlockX, BlockY) ? EGridBlockState::Full : EGridBlockState::Partial;
+}
+
+int32 FGridOccupancyPyramid::GetBlockArea(int32 Level, int32 BlockX, int32 BlockY) const
+{
+    const int32 BlockSize = 1 << Level;
+    return FMath::Min(BlockSize, SizeX - BlockX * BlockSize) * FMath::Min(BlockSize, SizeY - BlockY * BlockSize);
+}
+
+void FGridOccupancyPyramid::AccumulateRectState(const FGridBitPlane& Occupancy, const FIntRect& Rect, int32 Level, int32 BlockX, int32 BlockY, bool& bAnyFree, bool& bAnyOccupied) const
+{
+    if (bAnyFree && bAnyOccupied)
+    {
+        return;
+    }
+
+    // Cells of the block inside the rectangle
+    const int32 BlockSize = 1 << Level;
+    const int32 MinX = FMath::Max(BlockX * BlockSize, Rect.Min.X);
+    const int32 MinY = FMath::Max(BlockY * BlockSize, Rect.Min.Y);
+    const int32 MaxX = FMath::Min((BlockX + 1) * BlockSize, Rect.Max.X);
+    const int32 MaxY = FMath::Min((BlockY + 1) * BlockSize, Rect.Max.Y);
+    if (MinX >= MaxX || MinY >= MaxY || BlockX * BlockSize >= SizeX || BlockY * BlockSize >= SizeY)
+    {
+        return;
+    }
+
+    if (Level == 0)
+    {
+        (Occupancy.Get(BlockX, BlockY) ? bAnyOccupied : bAnyFree) = true;
+        return;
+    }
+
+    const int32 Count = Levels[Level - 1].Counts[BlockY * Levels[Level - 1].SizeX + BlockX];
+    const int32 Area = GetBlockArea(Level, BlockX, BlockY);
+    if (Count == 0 || Count == Area)
+    {
+        (Count == 0 ? bAnyFree : bAnyOccupied) = true;
+        return;
+    }
+
+    // A partial block fully inside the rectangle has both kinds of cells
+    const int32 ClippedWidth = FMath::Min(BlockSize, SizeX - BlockX * BlockSize);
+    const int32 ClippedHeight = FMath::Min(BlockSize, SizeY - BlockY * BlockSize);
+    if ((MaxX - MinX) * (MaxY - MinY) == ClippedWidth * ClippedHeight)
+    {
+        bAnyFree = true;
+        bAnyOccupied = true;
+        return;
+    }
+
+    for (int32 Child = 0; Child < 4; Child++)
+    {
+        AccumulateRectState(Occupancy, Rect, Level - 1, BlockX * 2 + (Child & 1), BlockY * 2 + (Child >> 1), bAnyFree, bAnyOccupied);
+    }
+}
@@ -0,0 +1,121 @@
+﻿// GridRaycast.cpp - Implementation of the grid line of sight
+#include "GridRaycast.h"
+#include "GridEdgeGrid.h"
+#include "Async/ParallelFor.h"
+
+FGridRaycaster::FGridRaycaster(const FGridBitPlane& InBlocking, const FGridEdgeGrid& InEdges)
+    : Blocking(InBlocking)
+    , Edges(InEdges)
+{
+}
+
+bool FGridRaycaster::Cast(const FGridRay& Ray, FGridRayHit& OutHit) const
+{
+    OutHit = FGridRayHit();
+
+    FIntPoint Cell(FMath::FloorToInt(Ray.Start.X), FMath::FloorToInt(Ray.Start.Y));
+    const FIntPoint EndCell(FMath::FloorToInt(Ray.End.X), FMath::FloorToInt(Ray.End.Y));
+    if (!Blocking.IsValidCell(Cell.X, Cell.Y))
+    {
+        OutHit.bBlocked = true;
+        OutHit.Time = 0.0f;
+        return false;
+    }
+
+    // Ray parameter at the next X and Y boundary, and between two boundaries
+    const FVector2D Delta = Ray.End - Ray.Start;
+    const int32 StepX = Delta.X > 0.0 ? 1 : (Delta.X < 0.0 ? -1 : 0);
+    const int32 StepY = Delta.Y > 0.0 ? 1 : (Delta.Y < 0.0 ? -1 : 0);
+    const float DeltaTimeX = StepX != 0 ? static_cast<float>(1.0 / FMath::Abs(Delta.X)) : MAX_flt;
+    const float DeltaTimeY = StepY != 0 ? static_cast<float>(1.0 / FMath::Abs(Delta.Y)) : MAX_flt;
+    float NextTimeX = StepX > 0 ? static_cast<float>((Cell.X + 1 - Ray.Start.X) / Delta.X)
+        : (StepX < 0 ? static_cast<float>((Ray.Start.X - Cell.X) / -Delta.X) : MAX_flt);
+    float NextTimeY = StepY > 0 ? static_cast<float>((Cell.Y + 1 - Ray.Start.Y) / Delta.Y)
+        : (StepY < 0 ? static_cast<float>((Ray.Start.Y - Cell.Y) / -Delta.Y) : MAX_flt);
+
+    const int32 SizeX = Blocking.GetSizeX();
+    if (Values)
+    {
+        OutHit.VisibleValue += (*Values)[Cell.Y * SizeX + Cell.X];
+    }
+
+    const EGridDirection SideX = StepX > 0 ? EGridDirection::East : EGridDirection::West;
+    const EGridDirection SideY = StepY > 0 ? EGridDirection::South : EGridDirection::North;
+
+    // The walk ends once every boundary between the start and end cell has been crossed
+    const int32 NumSteps = FMath::Abs(EndCell.X - Cell.X) + FMath::Abs(EndCell.Y - Cell.Y);
+    for (int32 Step = 0; Step < NumSteps; Step++)
+    {
+        // Cross the nearer boundary, X first where the ray passes exactly through a corner
+        const bool bAlongX = NextTimeX <= NextTimeY;
+        const float Time = FMath::Min(bAlongX ? NextTimeX : NextTimeY, 1.0f);
+        const float Height = FMath::Lerp(Ray.StartHeight, Ray.EndHeight, Time);
+
+        if (Edges.BlocksSight(Cell, bAlongX ? SideX : SideY))
+        {
+            OutHit.bBlocked = true;
+            OutHit.Cell = Cell;
+            OutHit.Time = Time;
+            return false;
+        }
+
+        if (bAlongX)
+        {
+            Cell.X += StepX;
+            NextTimeX += DeltaTimeX;
+        }
+        else
+        {
+            Cell.Y += StepY;
+            NextTimeY += DeltaTimeY;
+        }
+
+        if (!Blocking.IsValidCell(Cell.X, Cell.Y))
+        {
+            OutHit.bBlocked = true;
+            OutHit.Cell = Cell - (bAlongX ? FIntPoint(StepX, 0) : FIntPoint(0, StepY));
+            OutHit.Time = Time;
+            return false;
+        }
+
+        const int32 Index = Cell.Y * SizeX + Cell.X;
+        if (Cell != EndCell)
+        {
+            // In 2.5D the ray must clear the cell over its whole crossing
+            const bool bCellBlocks = Heights
+                ? FMath::Min(Height, FMath::Lerp(Ray.StartHeight, Ray.EndHeight, FMath::Min(FMath::Min(NextTimeX, NextTimeY), 1.0f))) < (*Heights)[Index]
+                : Blocking.Get(Cell.X, Cell.Y);
+            if (bCellBlocks)
+            {
+                OutHit.bBlocked = true;
+                OutHit.Cell = Cell;
+                OutHit.Time = Time;
+                return false;
+            }
+        }
+
+        if (Values)
+        {
+            OutHit.VisibleValue += (*Values)[Index];
+        }
+    }
+
+    OutHit.Cell = Cell;
+    return true;
+}
+
+void FGridRaycaster::CastBatch(TConstArrayView<FGridRay> Rays, TArray<FGridRayHit>& OutHits) const
+{
+    OutHits.SetNum(Rays.Num());
+
+    // Rays only read the planes and each task writes its own range of hits
+    const int32 NumTasks = FMath::DivideAndRoundUp(Rays.Num(), RaysPerTask);
+    ParallelFor(NumTasks, [this, Rays, &OutHits](int32 Task)
+    {
+        const int32 End = FMath::Min((Task + 1) * RaysPerTask, Rays.Num());
+        for (int32 RayIndex = Task * RaysPerTask; RayIndex < End; RayIndex++)
+        {
+            Cast(Rays[RayIndex], OutHits[RayIndex]);
+        }
+    });
+}
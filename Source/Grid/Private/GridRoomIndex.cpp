@@ -0,0 +1,631 @@
+﻿// GridRoomIndex.cpp - Implementation of incremental room detection
+#include "GridRoomIndex.h"
+#include "GridBitPlane.h"
+#include "GridEdgeGrid.h"
+
+namespace GridRoomIndexPrivate
+{
+    // Neighbour offsets in EGridDirection order (North, East, South, West)
+    static const int32 DirectionX[4] = { 0, 1, 0, -1 };
+    static const int32 DirectionY[4] = { -1, 0, 1, 0 };
+
+    static FIntPoint DirectionOffset(EGridDirection Direction)
+    {
+        const int32 Index = static_cast<int32>(Direction);
+        return Index < 4 ? FIntPoint(DirectionX[Index], DirectionY[Index]) : FIntPoint::ZeroValue;
+    }
+}
+
+void FGridRoomIndex::Rebuild(const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges)
+{
+    SizeX = Blocked.GetSizeX();
+    SizeY = Blocked.GetSizeY();
+
+    const int32 NumCells = SizeX * SizeY;
+
+    Labels.Init(INDEX_NONE, NumCells);
+    Rooms.Reset();
+    FreeRoomIds.Reset();
+    ChangedRooms.Reset();
+
+    VisitStamps.Init(0, NumCells);
+    VisitOwners.Init(INDEX_NONE, NumCells);
+    CurrentStamp = 0;
+
+    // Flood every free cell that has not been reached yet
+    for (int32 Y = 0; Y < SizeY; Y++)
+    {
+        for (int32 X = 0; X < SizeX; X++)
+        {
+            const int32 Index = Y * SizeX + X;
+            if (Labels[Index] == INDEX_NONE && !Blocked.Get(X, Y))
+            {
+                FloodNewRoom(Index, Blocked, Edges);
+            }
+        }
+    }
+}
+
+void FGridRoomIndex::Expand(const FIntPoint& Offset, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges)
+{
+    const int32 OldSizeX = SizeX;
+    const int32 OldSizeY = SizeY;
+    const int32 NewSizeX = Blocked.GetSizeX();
+    const int32 NewSizeY = Blocked.GetSizeY();
+    const bool bGrowsLeft = Offset.X > 0;
+    const bool bGrowsRight = NewSizeX > OldSizeX + Offset.X;
+    const bool bGrowsUp = Offset.Y > 0;
+    const bool bGrowsDown = NewSizeY > OldSizeY + Offset.Y;
+
+    // Cells on an old outer edge that now has land beyond it are no longer on the border
+    for (int32 Y = 0; Y < OldSizeY; Y++)
+    {
+        // Inner rows only have their two ends on the edge
+        const bool bEdgeRow = Y == 0 || Y == OldSizeY - 1;
+        const int32 StepX = bEdgeRow ? 1 : FMath::Max(OldSizeX - 1, 1);
+        for (int32 X = 0; X < OldSizeX; X += StepX)
+        {
+            const int32 RoomId = Labels[Y * OldSizeX + X];
+            if (RoomId == INDEX_NONE)
+            {
+                continue;
+            }
+
+            const bool bStillBorder = (X == 0 && !bGrowsLeft) || (X == OldSizeX - 1 && !bGrowsRight)
+                || (Y == 0 && !bGrowsUp) || (Y == OldSizeY - 1 && !bGrowsDown);
+            if (!bStillBorder)
+            {
+                Rooms[RoomId].BorderCellCount--;
+                MarkRoomChanged(RoomId);
+            }
+        }
+    }
+
+    ExpandGridValues(Labels, OldSizeX, OldSizeY, NewSizeX, NewSizeY, Offset, static_cast<int32>(INDEX_NONE));
+    VisitStamps.Init(0, NewSizeX * NewSizeY);
+    VisitOwners.Init(INDEX_NONE, NewSizeX * NewSizeY);
+    CurrentStamp = 0;
+    SizeX = NewSizeX;
+    SizeY = NewSizeY;
+
+    // The added cells are free, so they merge into the rooms along the old edges
+    TArray<FIntPoint> AddedCells;
+    AddedCells.Reserve(NewSizeX * NewSizeY - OldSizeX * OldSizeY);
+    for (int32 Y = 0; Y < NewSizeY; Y++)
+    {
+        const bool bOldRow = Y >= Offset.Y && Y < Offset.Y + OldSizeY;
+        for (int32 X = 0; X < NewSizeX; X++)
+        {
+            if (bOldRow && X == Offset.X)
+            {
+                // Jump over the old cells of the row
+                X += OldSizeX - 1;
+                continue;
+            }
+            AddedCells.Add(FIntPoint(X, Y));
+        }
+    }
+    OnCellsFreed(AddedCells, Blocked, Edges);
+}
+
+void FGridRoomIndex::OnCellsBlocked(const TArray<FIntPoint>& Cells, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges)
+{
+    // Detach the cells from their rooms
+    for (const FIntPoint& Cell : Cells)
+    {
+        if (!Blocked.IsValidCell(Cell.X, Cell.Y))
+        {
+            continue;
+        }
+
+        const int32 Index = Cell.Y * SizeX + Cell.X;
+        const int32 RoomId = Labels[Index];
+        if (RoomId == INDEX_NONE)
+        {
+            continue;
+        }
+
+        FRoomRecord& Room = Rooms[RoomId];
+        Room.CellCount--;
+        if (IsBorderCell(Index))
+        {
+            Room.BorderCellCount--;
+        }
+
+        Labels[Index] = INDEX_NONE;
+        MarkRoomChanged(RoomId);
+    }
+
+    // Gather the free neighbours of the change, grouped by the room they belong to
+    TMap<int32, TArray<int32>> SeedsByRoom;
+
+    for (const FIntPoint& Cell : Cells)
+    {
+        if (!Blocked.IsValidCell(Cell.X, Cell.Y))
+        {
+            continue;
+        }
+
+        const int32 Index = Cell.Y * SizeX + Cell.X;
+        for (int32 Direction = 0; Direction < 4; Direction++)
+        {
+            int32 Neighbour;
+            if (GetLinkedNeighbour(Index, Direction, Blocked, Edges, Neighbour) && Labels[Neighbour] != INDEX_NONE)
+            {
+                SeedsByRoom.FindOrAdd(Labels[Neighbour]).AddUnique(Neighbour);
+            }
+        }
+    }
+
+    // Only rooms touched in more than one place can have been cut in two
+    for (const TPair<int32, TArray<int32>>& Pair : SeedsByRoom)
+    {
+        if (Pair.Value.Num() > 1)
+        {
+            SplitRoom(Pair.Key, Pair.Value, Blocked, Edges);
+        }
+    }
+
+    // Drop rooms that were filled completely
+    for (int32 ChangedIndex = 0; ChangedIndex < ChangedRooms.Num(); ChangedIndex++)
+    {
+        const int32 RoomId = ChangedRooms[ChangedIndex];
+        if (Rooms[RoomId].bInUse && Rooms[RoomId].CellCount <= 0)
+        {
+            ReleaseRoom(RoomId);
+        }
+    }
+}
+
+void FGridRoomIndex::OnCellsFreed(const TArray<FIntPoint>& Cells, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges)
+{
+    for (const FIntPoint& Cell : Cells)
+    {
+        if (!Blocked.IsValidCell(Cell.X, Cell.Y) || Blocked.Get(Cell.X, Cell.Y))
+        {
+            continue;
+        }
+
+        // Cells connected to an earlier freed cell are already labelled
+        const int32 Index = Cell.Y * SizeX + Cell.X;
+        if (Labels[Index] == INDEX_NONE)
+        {
+            MergeAround(Index, Blocked, Edges);
+        }
+    }
+}
+
+void FGridRoomIndex::OnEdgeClosed(const FIntPoint& Cell, EGridDirection Side, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges)
+{
+    const FIntPoint Other = Cell + GridRoomIndexPrivate::DirectionOffset(Side);
+    const int32 RoomA = GetRoomId(Cell);
+    const int32 RoomB = GetRoomId(Other);
+
+    // The edge can only cut a room that lies on both sides of it
+    if (RoomA == INDEX_NONE || RoomA != RoomB)
+    {
+        return;
+    }
+
+    TArray<int32> Seeds;
+    Seeds.Add(Cell.Y * SizeX + Cell.X);
+    Seeds.Add(Other.Y * SizeX + Other.X);
+    SplitRoom(RoomA, Seeds, Blocked, Edges);
+}
+
+void FGridRoomIndex::OnEdgeOpened(const FIntPoint& Cell, EGridDirection Side, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges)
+{
+    const FIntPoint Other = Cell + GridRoomIndexPrivate::DirectionOffset(Side);
+    const int32 RoomA = GetRoomId(Cell);
+    const int32 RoomB = GetRoomId(Other);
+
+    if (RoomA == INDEX_NONE || RoomB == INDEX_NONE || RoomA == RoomB)
+    {
+        return;
+    }
+
+    // Relabel the smaller room into the larger one
+    if (Rooms[RoomA].CellCount >= Rooms[RoomB].CellCount)
+    {
+        AbsorbRoom(RoomA, RoomB, Other.Y * SizeX + Other.X, Blocked, Edges);
+    }
+    else
+    {
+        AbsorbRoom(RoomB, RoomA, Cell.Y * SizeX + Cell.X, Blocked, Edges);
+    }
+}
+
+int32 FGridRoomIndex::GetRoomId(const FIntPoint& Cell) const
+{
+    if (Cell.X < 0 || Cell.X >= SizeX || Cell.Y < 0 || Cell.Y >= SizeY)
+    {
+        return INDEX_NONE;
+    }
+
+    return Labels[Cell.Y * SizeX + Cell.X];
+}
+
+bool FGridRoomIndex::GetRoomInfo(int32 RoomId, FGridRoomInfo& OutInfo) const
+{
+    if (!Rooms.IsValidIndex(RoomId) || !Rooms[RoomId].bInUse)
+    {
+        return false;
+    }
+
+    const FRoomRecord& Room = Rooms[RoomId];
+    OutInfo.RoomId = RoomId;
+    OutInfo.CellCount = Room.CellCount;
+    OutInfo.bIsEnclosed = Room.BorderCellCount == 0;
+    return true;
+}
+
+int32 FGridRoomIndex::AllocateRoom()
+{
+    int32 RoomId;
+    if (FreeRoomIds.Num() > 0)
+    {
+        RoomId = FreeRoomIds.Pop(EAllowShrinking::No);
+    }
+    else
+    {
+        RoomId = Rooms.AddDefaulted();
+    }
+
+    Rooms[RoomId] = FRoomRecord();
+    Rooms[RoomId].bInUse = true;
+    MarkRoomChanged(RoomId);
+    return RoomId;
+}
+
+void FGridRoomIndex::ReleaseRoom(int32 RoomId)
+{
+    Rooms[RoomId] = FRoomRecord();
+    FreeRoomIds.Add(RoomId);
+    MarkRoomChanged(RoomId);
+}
+
+void FGridRoomIndex::MarkRoomChanged(int32 RoomId)
+{
+    ChangedRooms.AddUnique(RoomId);
+}
+
+void FGridRoomIndex::BeginVisit()
+{
+    CurrentStamp++;
+
+    // On wrap-around stale stamps could alias the new pass, so clear them once
+    if (CurrentStamp == 0)
+    {
+        FMemory::Memzero(VisitStamps.GetData(), VisitStamps.Num() * sizeof(uint32));
+        CurrentStamp = 1;
+    }
+}
+
+bool FGridRoomIndex::GetLinkedNeighbour(int32 Index, int32 Direction, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges, int32& OutNeighbour) const
+{
+    const int32 X = Index % SizeX + GridRoomIndexPrivate::DirectionX[Direction];
+    const int32 Y = Index / SizeX + GridRoomIndexPrivate::DirectionY[Direction];
+
+    if (X < 0 || X >= SizeX || Y < 0 || Y >= SizeY || Blocked.Get(X, Y))
+    {
+        return false;
+    }
+
+    // Walls, doors and windows all split rooms
+    if (Edges.SeparatesRooms(FIntPoint(Index % SizeX, Index / SizeX), static_cast<EGridDirection>(Direction)))
+    {
+        return false;
+    }
+
+    OutNeighbour = Y * SizeX + X;
+    return true;
+}
+
+void FGridRoomIndex::FloodNewRoom(int32 SeedIndex, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges)
+{
+    const int32 RoomId = AllocateRoom();
+
+    TArray<int32> Queue;
+    Queue.Add(SeedIndex);
+    Labels[SeedIndex] = RoomId;
+
+    for (int32 Head = 0; Head < Queue.Num(); Head++)
+    {
+        const int32 Index = Queue[Head];
+
+        Rooms[RoomId].CellCount++;
+        if (IsBorderCell(Index))
+        {
+            Rooms[RoomId].BorderCellCount++;
+        }
+
+        for (int32 Direction = 0; Direction < 4; Direction++)
+        {
+            int32 Neighbour;
+            if (GetLinkedNeighbour(Index, Direction, Blocked, Edges, Neighbour) && Labels[Neighbour] == INDEX_NONE)
+            {
+                Labels[Neighbour] = RoomId;
+                Queue.Add(Neighbour);
+            }
+        }
+    }
+}
+
+void FGridRoomIndex::SplitRoom(int32 RoomId, const TArray<int32>& Seeds, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges)
+{
+    // One breadth-first front per seed, expanded in lockstep. Fronts that meet are joined.
+    // Once a joined set runs out of cells it is a finished piece of the old room. The search
+    // stops as soon as a single set is still growing: that piece keeps the old id, so the
+    // largest piece (usually the outdoors) is never walked completely.
+    struct FFront
+    {
+        TArray<int32> Cells;
+        int32 Head = 0;
+        int32 BorderCells = 0;
+    };
+
+    TArray<FFront> Fronts;
+    TArray<int32> Parents;
+    TArray<int32> LiveFronts;
+    int32 ActiveSets = 0;
+
+    auto FindRoot = [&Parents](int32 Front)
+    {
+        while (Parents[Front] != Front)
+        {
+            Parents[Front] = Parents[Parents[Front]];
+            Front = Parents[Front];
+        }
+        return Front;
+    };
+
+    auto Join = [&](int32 A, int32 B)
+    {
+        A = FindRoot(A);
+        B = FindRoot(B);
+        if (A == B)
+        {
+            return;
+        }
+
+        const int32 ActiveBefore = (LiveFronts[A] > 0 ? 1 : 0) + (LiveFronts[B] > 0 ? 1 : 0);
+        Parents[B] = A;
+        LiveFronts[A] += LiveFronts[B];
+        LiveFronts[B] = 0;
+        ActiveSets += (LiveFronts[A] > 0 ? 1 : 0) - ActiveBefore;
+    };
+
+    BeginVisit();
+
+    for (const int32 Seed : Seeds)
+    {
+        if (IsVisited(Seed))
+        {
+            continue;
+        }
+
+        const int32 FrontIndex = Fronts.AddDefaulted();
+        Fronts[FrontIndex].Cells.Add(Seed);
+        Fronts[FrontIndex].BorderCells = IsBorderCell(Seed) ? 1 : 0;
+        Parents.Add(FrontIndex);
+        LiveFronts.Add(1);
+        ActiveSets++;
+
+        MarkVisited(Seed);
+        VisitOwners[Seed] = FrontIndex;
+    }
+
+    while (ActiveSets > 1)
+    {
+        for (int32 FrontIndex = 0; FrontIndex < Fronts.Num() && ActiveSets > 1; FrontIndex++)
+        {
+            FFront& Front = Fronts[FrontIndex];
+            if (Front.Head >= Front.Cells.Num())
+            {
+                continue;
+            }
+
+            const int32 Index = Front.Cells[Front.Head++];
+
+            for (int32 Direction = 0; Direction < 4; Direction++)
+            {
+                int32 Neighbour;
+                if (!GetLinkedNeighbour(Index, Direction, Blocked, Edges, Neighbour) || Labels[Neighbour] != RoomId)
+                {
+                    continue;
+                }
+
+                if (!IsVisited(Neighbour))
+                {
+                    MarkVisited(Neighbour);
+                    VisitOwners[Neighbour] = FrontIndex;
+                    Front.Cells.Add(Neighbour);
+                    if (IsBorderCell(Neighbour))
+                    {
+                        Front.BorderCells++;
+                    }
+                }
+                else
+                {
+                    Join(FrontIndex, VisitOwners[Neighbour]);
+                }
+            }
+
+            // This front has nothing left to expand
+            if (Front.Head >= Front.Cells.Num())
+            {
+                const int32 Root = FindRoot(FrontIndex);
+                LiveFronts[Root]--;
+                if (LiveFronts[Root] == 0)
+                {
+                    ActiveSets--;
+                }
+            }
+        }
+    }
+
+    // Total the cells reached by each set
+    TMap<int32, int32> CellsPerSet;
+    for (int32 FrontIndex = 0; FrontIndex < Fronts.Num(); FrontIndex++)
+    {
+        CellsPerSet.FindOrAdd(FindRoot(FrontIndex)) += Fronts[FrontIndex].Cells.Num();
+    }
+
+    if (CellsPerSet.Num() <= 1)
+    {
+        return;
+    }
+
+    // The set that is still growing keeps the old id, otherwise the biggest finished one does
+    int32 KeeperRoot = INDEX_NONE;
+    int32 KeeperCells = -1;
+    for (const TPair<int32, int32>& Pair : CellsPerSet)
+    {
+        if (LiveFronts[Pair.Key] > 0)
+        {
+            KeeperRoot = Pair.Key;
+            break;
+        }
+
+        if (Pair.Value > KeeperCells)
+        {
+            KeeperRoot = Pair.Key;
+            KeeperCells = Pair.Value;
+        }
+    }
+
+    // Move every other set into a room of its own
+    TMap<int32, int32> NewRoomPerSet;
+    for (const TPair<int32, int32>& Pair : CellsPerSet)
+    {
+        if (Pair.Key != KeeperRoot)
+        {
+            NewRoomPerSet.Add(Pair.Key, AllocateRoom());
+        }
+    }
+
+    for (int32 FrontIndex = 0; FrontIndex < Fronts.Num(); FrontIndex++)
+    {
+        const int32* NewRoomId = NewRoomPerSet.Find(FindRoot(FrontIndex));
+        if (!NewRoomId)
+        {
+            continue;
+        }
+
+        const FFront& Front = Fronts[FrontIndex];
+        for (const int32 Index : Front.Cells)
+        {
+            Labels[Index] = *NewRoomId;
+        }
+
+        Rooms[*NewRoomId].CellCount += Front.Cells.Num();
+        Rooms[*NewRoomId].BorderCellCount += Front.BorderCells;
+        Rooms[RoomId].CellCount -= Front.Cells.Num();
+        Rooms[RoomId].BorderCellCount -= Front.BorderCells;
+    }
+
+    MarkRoomChanged(RoomId);
+}
+
+void FGridRoomIndex::MergeAround(int32 SeedIndex, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges)
+{
+    // Collect the connected blob of unlabelled free cells and the rooms bordering it
+    TArray<int32> Blob;
+    TArray<int32, TInlineAllocator<8>> AdjacentRooms;
+    TArray<int32, TInlineAllocator<8>> AdjacentSeeds;
+
+    BeginVisit();
+    Blob.Add(SeedIndex);
+    MarkVisited(SeedIndex);
+
+    for (int32 Head = 0; Head < Blob.Num(); Head++)
+    {
+        const int32 Index = Blob[Head];
+
+        for (int32 Direction = 0; Direction < 4; Direction++)
+        {
+            int32 Neighbour;
+            if (!GetLinkedNeighbour(Index, Direction, Blocked, Edges, Neighbour))
+            {
+                continue;
+            }
+
+            const int32 NeighbourRoom = Labels[Neighbour];
+            if (NeighbourRoom == INDEX_NONE)
+            {
+                if (!IsVisited(Neighbour))
+                {
+                    MarkVisited(Neighbour);
+                    Blob.Add(Neighbour);
+                }
+            }
+            else if (!AdjacentRooms.Contains(NeighbourRoom))
+            {
+                AdjacentRooms.Add(NeighbourRoom);
+                AdjacentSeeds.Add(Neighbour);
+            }
+        }
+    }
+
+    // The largest neighbouring room absorbs everything else
+    int32 TargetRoom = INDEX_NONE;
+    for (const int32 RoomId : AdjacentRooms)
+    {
+        if (TargetRoom == INDEX_NONE || Rooms[RoomId].CellCount > Rooms[TargetRoom].CellCount)
+        {
+            TargetRoom = RoomId;
+        }
+    }
+
+    if (TargetRoom == INDEX_NONE)
+    {
+        TargetRoom = AllocateRoom();
+    }
+
+    for (const int32 Index : Blob)
+    {
+        Labels[Index] = TargetRoom;
+        Rooms[TargetRoom].CellCount++;
+        if (IsBorderCell(Index))
+        {
+            Rooms[TargetRoom].BorderCellCount++;
+        }
+    }
+
+    // Relabel the smaller rooms that are now connected
+    for (int32 AdjacentIndex = 0; AdjacentIndex < AdjacentRooms.Num(); AdjacentIndex++)
+    {
+        if (AdjacentRooms[AdjacentIndex] != TargetRoom)
+        {
+            AbsorbRoom(TargetRoom, AdjacentRooms[AdjacentIndex], AdjacentSeeds[AdjacentIndex], Blocked, Edges);
+        }
+    }
+
+    MarkRoomChanged(TargetRoom);
+}
+
+void FGridRoomIndex::AbsorbRoom(int32 TargetRoom, int32 RoomId, int32 SeedIndex, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges)
+{
+    TArray<int32> Queue;
+    Queue.Add(SeedIndex);
+    Labels[SeedIndex] = TargetRoom;
+
+    for (int32 Head = 0; Head < Queue.Num(); Head++)
+    {
+        const int32 Index = Queue[Head];
+        for (int32 Direction = 0; Direction < 4; Direction++)
+        {
+            int32 Neighbour;
+            if (GetLinkedNeighbour(Index, Direction, Blocked, Edges, Neighbour) && Labels[Neighbour] == RoomId)
+            {
+                Labels[Neighbour] = TargetRoom;
+                Queue.Add(Neighbour);
+            }
+        }
+    }
+
+    Rooms[TargetRoom].CellCount += Rooms[RoomId].CellCount;
+    Rooms[TargetRoom].BorderCellCount += Rooms[RoomId].BorderCellCount;
+    ReleaseRoom(RoomId);
+    MarkRoomChanged(TargetRoom);
+}
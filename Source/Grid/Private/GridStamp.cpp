@@ -0,0 +1,105 @@
+﻿// GridStamp.cpp - Implementation of compiled building stamps
+#include "GridStamp.h"
+#include "BuildingObjectAsset.h"
+
+namespace
+{
+    // Turn a point about the stamp origin, the same way footprints are turned
+    FIntPoint RotateStampPoint(const FIntPoint& Point, int32 Quarters)
+    {
+        switch (Quarters & 3)
+        {
+            case 1: return FIntPoint(-Point.Y, Point.X);
+            case 2: return FIntPoint(-Point.X, -Point.Y);
+            case 3: return FIntPoint(Point.Y, -Point.X);
+            default: return Point;
+        }
+    }
+}
+
+void FCompiledBuildingStamp::Compile(const FBuildingStamp& InStamp)
+{
+    Stamp = InStamp;
+
+    for (int32 Rotation = 0; Rotation < 4; Rotation++)
+    {
+        FRotation& Rotated = Rotations[Rotation];
+        Rotated.Entries.Reset();
+        Rotated.Floors.Reset();
+        Rotated.Floors.SetNum(FMath::Max(Stamp.NumFloors, 0));
+        Rotated.Origin = FIntPoint::ZeroValue;
+        Rotated.bOverlaps = false;
+
+        TArray<TSet<FIntPoint>> FloorCells;
+        FloorCells.SetNum(Rotated.Floors.Num());
+
+        for (int32 EntryIndex = 0; EntryIndex < Stamp.Entries.Num(); EntryIndex++)
+        {
+            const FBuildingStampEntry& Entry = Stamp.Entries[EntryIndex];
+            if (!Entry.BuildingAsset || !Rotated.Floors.IsValidIndex(Entry.FloorOffset))
+            {
+                continue;
+            }
+
+            // Cells come from the footprint at the turned origin, exactly what placing it will occupy
+            FRotatedEntry& RotatedEntry = Rotated.Entries.AddDefaulted_GetRef();
+            RotatedEntry.EntryIndex = EntryIndex;
+            RotatedEntry.Offset = RotateStampPoint(Entry.Offset, Rotation);
+            RotatedEntry.Rotation = (Entry.Rotation + Rotation) & 3;
+
+            const TArray<FIntPoint> Cells = Entry.BuildingAsset->GetFootprint().GetOccupiedCellPositions(RotatedEntry.Offset, RotatedEntry.Rotation);
+            RotatedEntry.Mask.Build(Cells);
+
+            FRotatedFloor& Floor = Rotated.Floors[Entry.FloorOffset];
+            for (const FIntPoint& Cell : Cells)
+            {
+                bool bAlreadyInStamp = false;
+                FloorCells[Entry.FloorOffset].Add(Cell, &bAlreadyInStamp);
+                Rotated.bOverlaps |= bAlreadyInStamp;
+
+                Floor.Cells.Add(Cell);
+                Floor.CellTypes.Add(Cell, Entry.BuildingAsset->BuildingType);
+            }
+        }
+
+        for (int32 FloorOffset = 0; FloorOffset < Rotated.Floors.Num(); FloorOffset++)
+        {
+            FRotatedFloor& Floor = Rotated.Floors[FloorOffset];
+            Floor.Mask.Build(Floor.Cells);
+
+            // Cells above the stamp's own floor below are supported once it is placed
+            TArray<FIntPoint> UnsupportedCells;
+            for (const FIntPoint& Cell : Floor.Cells)
+            {
+                if (FloorOffset == 0 || !FloorCells[FloorOffset - 1].Contains(Cell))
+                {
+                    UnsupportedCells.Add(Cell);
+                }
+            }
+            Floor.SupportMask.Build(UnsupportedCells);
+        }
+    }
+}
+
+void FCompiledBuildingStamp::MoveTo(int32 Rotation, const FIntPoint& Origin)
+{
+    FRotation& Rotated = Rotations[Rotation & 3];
+    const FIntPoint Delta = Origin - Rotated.Origin;
+    if (Delta == FIntPoint::ZeroValue)
+    {
+        return;
+    }
+
+    for (FRotatedEntry& Entry : Rotated.Entries)
+    {
+        Entry.Mask.Min += Delta;
+    }
+
+    for (FRotatedFloor& Floor : Rotated.Floors)
+    {
+        Floor.Mask.Min += Delta;
+        Floor.SupportMask.Min += Delta;
+    }
+
+    Rotated.Origin = Origin;
+}
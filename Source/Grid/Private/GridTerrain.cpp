@@ -0,0 +1,233 @@
+﻿// GridTerrain.cpp - Implementation of the terrain samples and suitability planes
+#include "GridTerrain.h"
+
+namespace
+{
+    /**
+     * Extreme of every window of Window consecutive values along a line, using a monotonic queue of indices.
+     * Every value enters and leaves the queue once, so the cost does not depend on the window size.
+     * @param In First value of the line
+     * @param Count Number of values on the line
+     * @param InStride Distance between consecutive values in In
+     * @param Out First result, Count - Window + 1 results are written
+     * @param OutStride Distance between consecutive results in Out
+     * @param Queue Scratch storage for at least Count indices
+     * @param Prefer True if the first value should be kept over the second
+     */
+    template <typename ValueType, typename PredicateType>
+    void SlidingWindowExtreme(const ValueType* In, int32 Count, int32 InStride, int32 Window, ValueType* Out, int32 OutStride, int32* Queue, PredicateType Prefer)
+    {
+        int32 Head = 0;
+        int32 Tail = 0;
+        for (int32 Index = 0; Index < Count; Index++)
+        {
+            // Values that can no longer be the extreme of any window leave from the back
+            const ValueType Value = In[Index * InStride];
+            while (Tail > Head && !Prefer(In[Queue[Tail - 1] * InStride], Value))
+            {
+                Tail--;
+            }
+            Queue[Tail++] = Index;
+
+            // The front leaves once the window has passed it
+            if (Queue[Head] <= Index - Window)
+            {
+                Head++;
+            }
+
+            if (Index >= Window - 1)
+            {
+                Out[(Index - Window + 1) * OutStride] = In[Queue[Head] * InStride];
+            }
+        }
+    }
+
+    /**
+     * Extreme of every Window.X x Window.Y window of a row-major array, as a row pass followed by a column pass
+     * @param Out Receives (SizeX - Window.X + 1) * (SizeY - Window.Y + 1) values, row-major
+     */
+    template <typename ValueType, typename PredicateType>
+    void SlidingWindowExtreme2D(const TArray<ValueType>& In, int32 SizeX, int32 SizeY, const FIntPoint& Window, TArray<ValueType>& Out, TArray<int32>& Queue, PredicateType Prefer)
+    {
+        const int32 OutSizeX = SizeX - Window.X + 1;
+        const int32 OutSizeY = SizeY - Window.Y + 1;
+        Queue.SetNumUninitialized(FMath::Max(SizeX, SizeY));
+
+        TArray<ValueType> RowExtremes;
+        RowExtremes.SetNumUninitialized(OutSizeX * SizeY);
+        for (int32 Y = 0; Y < SizeY; Y++)
+        {
+            SlidingWindowExtreme(In.GetData() + Y * SizeX, SizeX, 1, Window.X, RowExtremes.GetData() + Y * OutSizeX, 1, Queue.GetData(), Prefer);
+        }
+
+        Out.SetNumUninitialized(OutSizeX * OutSizeY);
+        for (int32 X = 0; X < OutSizeX; X++)
+        {
+            SlidingWindowExtreme(RowExtremes.GetData() + X, SizeY, OutSizeX, Window.Y, Out.GetData() + X, OutSizeX, Queue.GetData(), Prefer);
+        }
+    }
+}
+
+void FGridTerrain::Init(int32 InSizeX, int32 InSizeY, float InCellSize, TFunctionRef<float(int32 X, int32 Y)> SampleHeight)
+{
+    SizeX = FMath::Max(0, InSizeX);
+    SizeY = FMath::Max(0, InSizeY);
+    CellSize = FMath::Max(InCellSize, KINDA_SMALL_NUMBER);
+    Heights.SetNumUninitialized(SizeX * SizeY);
+    Slopes.SetNumUninitialized(SizeX * SizeY);
+    SuitablePlanes.Reset();
+
+    for (int32 Y = 0; Y < SizeY; Y++)
+    {
+        for (int32 X = 0; X < SizeX; X++)
+        {
+            StoreHeight(X, Y, SampleHeight(X, Y));
+        }
+    }
+
+    UpdateSlopes(FIntRect(0, 0, SizeX, SizeY));
+}
+
+void FGridTerrain::Expand(int32 NewSizeX, int32 NewSizeY, const FIntPoint& Offset, TFunctionRef<float(int32 X, int32 Y)> SampleHeight)
+{
+    const FIntRect OldRect(Offset, Offset + FIntPoint(SizeX, SizeY));
+    ExpandGridValues(Heights, SizeX, SizeY, NewSizeX, NewSizeY, Offset, static_cast<int16>(0));
+    ExpandGridValues(Slopes, SizeX, SizeY, NewSizeX, NewSizeY, Offset, static_cast<uint8>(0));
+    SizeX = NewSizeX;
+    SizeY = NewSizeY;
+    SuitablePlanes.Reset();
+
+    for (int32 Y = 0; Y < SizeY; Y++)
+    {
+        const bool bOldRow = Y >= OldRect.Min.Y && Y < OldRect.Max.Y;
+        for (int32 X = 0; X < SizeX; X++)
+        {
+            if (bOldRow && X == OldRect.Min.X)
+            {
+                X = OldRect.Max.X - 1;
+                continue;
+            }
+            StoreHeight(X, Y, SampleHeight(X, Y));
+        }
+    }
+
+    // The old cells on the old border now have neighbours on the added side
+    UpdateSlopes(FIntRect(0, 0, SizeX, OldRect.Min.Y + 1));
+    UpdateSlopes(FIntRect(0, OldRect.Max.Y - 1, SizeX, SizeY));
+    UpdateSlopes(FIntRect(0, OldRect.Min.Y, OldRect.Min.X + 1, OldRect.Max.Y));
+    UpdateSlopes(FIntRect(OldRect.Max.X - 1, OldRect.Min.Y, SizeX, OldRect.Max.Y));
+}
+
+void FGridTerrain::Reset()
+{
+    SizeX = 0;
+    SizeY = 0;
+    Heights.Reset();
+    Slopes.Reset();
+    SuitablePlanes.Reset();
+}
+
+const FGridBitPlane& FGridTerrain::GetSuitablePlane(const FIntPoint& WindowSize, float MaxSlope, float MaxHeightDelta) const
+{
+    const int32 SlopeLimit = QuantizeSlopeLimit(MaxSlope);
+    const int32 HeightLimit = QuantizeHeightLimit(MaxHeightDelta);
+
+    for (int32 Index = 0; Index < SuitablePlanes.Num(); Index++)
+    {
+        const FSuitablePlane& Cached = SuitablePlanes[Index];
+        if (Cached.WindowSize == WindowSize && Cached.MaxSlope == SlopeLimit && Cached.MaxHeightDelta == HeightLimit)
+        {
+            // Move to the back so the least recently used plane is dropped first
+            if (Index != SuitablePlanes.Num() - 1)
+            {
+                FSuitablePlane Used = MoveTemp(SuitablePlanes[Index]);
+                SuitablePlanes.RemoveAt(Index);
+                SuitablePlanes.Add(MoveTemp(Used));
+            }
+            return SuitablePlanes.Last().Plane;
+        }
+    }
+
+    if (SuitablePlanes.Num() >= MaxSuitablePlanes)
+    {
+        SuitablePlanes.RemoveAt(0);
+    }
+
+    FSuitablePlane& Entry = SuitablePlanes.AddDefaulted_GetRef();
+    Entry.WindowSize = WindowSize;
+    Entry.MaxSlope = SlopeLimit;
+    Entry.MaxHeightDelta = HeightLimit;
+    Entry.Plane.Init(SizeX, SizeY, false);
+
+    const int32 OutSizeX = SizeX - WindowSize.X + 1;
+    const int32 OutSizeY = SizeY - WindowSize.Y + 1;
+    if (WindowSize.X <= 0 || WindowSize.Y <= 0 || OutSizeX <= 0 || OutSizeY <= 0)
+    {
+        return Entry.Plane;
+    }
+
+    TArray<int32> Queue;
+    TArray<int16> MinHeights;
+    TArray<int16> MaxHeights;
+    TArray<uint8> MaxSlopes;
+    if (HeightLimit != MAX_int32)
+    {
+        SlidingWindowExtreme2D(Heights, SizeX, SizeY, WindowSize, MinHeights, Queue, [](int16 A, int16 B) { return A < B; });
+        SlidingWindowExtreme2D(Heights, SizeX, SizeY, WindowSize, MaxHeights, Queue, [](int16 A, int16 B) { return A > B; });
+    }
+    if (SlopeLimit != MAX_int32)
+    {
+        SlidingWindowExtreme2D(Slopes, SizeX, SizeY, WindowSize, MaxSlopes, Queue, [](uint8 A, uint8 B) { return A > B; });
+    }
+
+    for (int32 Y = 0; Y < OutSizeY; Y++)
+    {
+        for (int32 X = 0; X < OutSizeX; X++)
+        {
+            const int32 Index = Y * OutSizeX + X;
+            if ((HeightLimit == MAX_int32 || MaxHeights[Index] - MinHeights[Index] <= HeightLimit)
+                && (SlopeLimit == MAX_int32 || MaxSlopes[Index] <= SlopeLimit))
+            {
+                Entry.Plane.Set(X, Y, true);
+            }
+        }
+    }
+
+    return Entry.Plane;
+}
+
+int32 FGridTerrain::QuantizeSlopeLimit(float MaxSlope)
+{
+    // Slopes are rounded up when stored, so a whole-degree limit rounded down never lets a steeper cell pass
+    return MaxSlope > 0.0f ? FMath::FloorToInt(MaxSlope) : MAX_int32;
+}
+
+int32 FGridTerrain::QuantizeHeightLimit(float MaxHeightDelta)
+{
+    return MaxHeightDelta > 0.0f ? FMath::FloorToInt(MaxHeightDelta) : MAX_int32;
+}
+
+void FGridTerrain::StoreHeight(int32 X, int32 Y, float Height)
+{
+    Heights[Y * SizeX + X] = static_cast<int16>(FMath::Clamp(FMath::RoundToInt(Height), static_cast<int32>(MIN_int16), static_cast<int32>(MAX_int16)));
+}
+
+void FGridTerrain::UpdateSlopes(const FIntRect& Rect)
+{
+    for (int32 Y = FMath::Max(Rect.Min.Y, 0); Y < FMath::Min(Rect.Max.Y, SizeY); Y++)
+    {
+        for (int32 X = FMath::Max(Rect.Min.X, 0); X < FMath::Min(Rect.Max.X, SizeX); X++)
+        {
+            // Central differences, one-sided on the border of the terrain
+            const int32 Left = FMath::Max(X - 1, 0);
+            const int32 Right = FMath::Min(X + 1, SizeX - 1);
+            const int32 Down = FMath::Max(Y - 1, 0);
+            const int32 Up = FMath::Min(Y + 1, SizeY - 1);
+            const float GradientX = Right > Left ? (Heights[Y * SizeX + Right] - Heights[Y * SizeX + Left]) / ((Right - Left) * CellSize) : 0.0f;
+            const float GradientY = Up > Down ? (Heights[Up * SizeX + X] - Heights[Down * SizeX + X]) / ((Up - Down) * CellSize) : 0.0f;
+
+            const float Degrees = FMath::RadiansToDegrees(FMath::Atan(FMath::Sqrt(GradientX * GradientX + GradientY * GradientY)));
+            Slopes[Y * SizeX + X] = static_cast<uint8>(FMath::Clamp(FMath::CeilToInt(Degrees - KINDA_SMALL_NUMBER), 0, 90));
+        }
+    }
+}
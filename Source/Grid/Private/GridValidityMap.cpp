@@ -0,0 +1,98 @@
+﻿// GridValidityMap.cpp - Implementation of background validity maps
+#include "GridValidityMap.h"
+
+FGridBitPlane FGridValiditySnapshot::Build() const
+{
+    const int32 SizeX = Occupancy.GetSizeX();
+    const int32 SizeY = Occupancy.GetSizeY();
+    FGridBitPlane Valid(SizeX, SizeY, false);
+
+    if (Footprint.IsEmpty())
+    {
+        Valid.SetRect(FIntRect(0, 0, SizeX, SizeY), true);
+        return Valid;
+    }
+
+    // Only origins that keep the footprint bounds inside the floor are tested
+    const int32 FirstX = FMath::Max(0, -Footprint.Min.X);
+    const int32 FirstY = FMath::Max(0, -Footprint.Min.Y);
+    const int32 LastX = FMath::Min(SizeX - 1, SizeX - Footprint.Width - Footprint.Min.X);
+    const int32 LastY = FMath::Min(SizeY - 1, SizeY - Footprint.Height - Footprint.Min.Y);
+
+    FGridFootprintMask Mask = Footprint;
+    for (int32 Y = FirstY; Y <= LastY; Y++)
+    {
+        for (int32 X = FirstX; X <= LastX; X++)
+        {
+            Mask.Min = FIntPoint(Footprint.Min.X + X, Footprint.Min.Y + Y);
+
+            if (!Occupancy.Intersects(Mask)
+                && (!bNeedsSupport || Support.Covers(Mask))
+                && (!bZoned || AllowedZones.Covers(Mask))
+                && (!bTerrainLimited || SuitableTerrain.Get(Mask.Min.X, Mask.Min.Y)))
+            {
+                Valid.Set(X, Y, true);
+            }
+        }
+    }
+
+    return Valid;
+}
+
+const FGridBitPlane* FGridValidityCache::Find(const FGridValidityKey& Key)
+{
+    for (FEntry& Entry : Entries)
+    {
+        if (Entry.Key == Key)
+        {
+            if (!Entry.Task.IsCompleted())
+            {
+                return nullptr;
+            }
+
+            Entry.LastUse = ++UseCounter;
+            return &Entry.Task.GetResult();
+        }
+    }
+
+    return nullptr;
+}
+
+bool FGridValidityCache::Contains(const FGridValidityKey& Key) const
+{
+    return Entries.ContainsByPredicate([&Key](const FEntry& Entry) { return Entry.Key == Key; });
+}
+
+void FGridValidityCache::Request(const FGridValidityKey& Key, FGridValiditySnapshot&& Snapshot)
+{
+    if (Contains(Key))
+    {
+        return;
+    }
+
+    if (Entries.Num() >= Capacity)
+    {
+        // Maps of an older grid version can never be used again, otherwise drop the least recently used
+        int32 Victim = 0;
+        for (int32 Index = 1; Index < Entries.Num(); Index++)
+        {
+            const bool bStale = Entries[Index].Key.Version != Key.Version;
+            const bool bVictimStale = Entries[Victim].Key.Version != Key.Version;
+            if (bStale != bVictimStale ? bStale : Entries[Index].LastUse < Entries[Victim].LastUse)
+            {
+                Victim = Index;
+            }
+        }
+        Entries.RemoveAtSwap(Victim, 1, EAllowShrinking::No);
+    }
+
+    FEntry& Entry = Entries.AddDefaulted_GetRef();
+    Entry.Key = Key;
+    Entry.LastUse = ++UseCounter;
+    Entry.Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Snapshot = MoveTemp(Snapshot)]() { return Snapshot.Build(); });
+}
+
+void FGridValidityCache::Reset()
+{
+    Entries.Reset();
+}
@@ -0,0 +1,295 @@
+﻿// GridZoneLayer.cpp - Implementation of the zone layer
+#include "GridZoneLayer.h"
+
+void FGridZoneLayer::Init(int32 InSizeX, int32 InSizeY)
+{
+    SizeX = FMath::Max(0, InSizeX);
+    SizeY = FMath::Max(0, InSizeY);
+
+    Zones.Init(static_cast<uint8>(EGridZone::None), SizeX * SizeY);
+
+    for (int32 Zone = 0; Zone < NumZones; Zone++)
+    {
+        ZonePlanes[Zone].Init(SizeX, SizeY, Zone == static_cast<int32>(EGridZone::None));
+        CellCounts[Zone] = 0;
+    }
+    CellCounts[static_cast<int32>(EGridZone::None)] = SizeX * SizeY;
+
+    // Every row starts as a single unzoned run
+    RowRuns.SetNum(SizeY);
+    for (TArray<FGridZoneRun>& Runs : RowRuns)
+    {
+        Runs.Reset();
+        if (SizeX > 0)
+        {
+            FGridZoneRun Run;
+            Run.StartX = 0;
+            Run.Length = SizeX;
+            Run.Zone = EGridZone::None;
+            Runs.Add(Run);
+        }
+    }
+}
+
+void FGridZoneLayer::Expand(int32 NewSizeX, int32 NewSizeY, const FIntPoint& Offset)
+{
+    const int32 OldSizeX = SizeX;
+    const int32 OldSizeY = SizeY;
+    const int32 None = static_cast<int32>(EGridZone::None);
+
+    ExpandGridValues(Zones, OldSizeX, OldSizeY, NewSizeX, NewSizeY, Offset, static_cast<uint8>(EGridZone::None));
+    for (int32 Zone = 0; Zone < NumZones; Zone++)
+    {
+        ZonePlanes[Zone].Expand(NewSizeX, NewSizeY, Offset);
+    }
+
+    // Added cells: whole rows above and below the old ones, and the margins beside them
+    const int32 OldMaxX = Offset.X + OldSizeX;
+    const int32 OldMaxY = Offset.Y + OldSizeY;
+    ZonePlanes[None].SetRect(FIntRect(0, 0, NewSizeX, Offset.Y), true);
+    ZonePlanes[None].SetRect(FIntRect(0, OldMaxY, NewSizeX, NewSizeY), true);
+    ZonePlanes[None].SetRect(FIntRect(0, Offset.Y, Offset.X, OldMaxY), true);
+    ZonePlanes[None].SetRect(FIntRect(OldMaxX, Offset.Y, NewSizeX, OldMaxY), true);
+    CellCounts[None] += NewSizeX * NewSizeY - OldSizeX * OldSizeY;
+
+    // Old rows move down and gain unzoned margins, merged into their outer runs where those are unzoned
+    TArray<TArray<FGridZoneRun>> OldRuns = MoveTemp(RowRuns);
+    RowRuns.SetNum(NewSizeY);
+    for (int32 Y = 0; Y < NewSizeY; Y++)
+    {
+        TArray<FGridZoneRun>& Runs = RowRuns[Y];
+        const int32 OldY = Y - Offset.Y;
+        if (OldY < 0 || OldY >= OldSizeY)
+        {
+            FGridZoneRun Run;
+            Run.Length = NewSizeX;
+            Runs.Add(Run);
+            continue;
+        }
+
+        Runs = MoveTemp(OldRuns[OldY]);
+        for (FGridZoneRun& Run : Runs)
+        {
+            Run.StartX += Offset.X;
+        }
+
+        if (Offset.X > 0)
+        {
+            if (Runs.Num() > 0 && Runs[0].Zone == EGridZone::None)
+            {
+                Runs[0].StartX = 0;
+                Runs[0].Length += Offset.X;
+            }
+            else
+            {
+                FGridZoneRun Margin;
+                Margin.Length = Offset.X;
+                Runs.Insert(Margin, 0);
+            }
+        }
+
+        if (NewSizeX > OldMaxX)
+        {
+            if (Runs.Num() > 0 && Runs.Last().Zone == EGridZone::None)
+            {
+                Runs.Last().Length += NewSizeX - OldMaxX;
+            }
+            else
+            {
+                FGridZoneRun Margin;
+                Margin.StartX = OldMaxX;
+                Margin.Length = NewSizeX - OldMaxX;
+                Runs.Add(Margin);
+            }
+        }
+    }
+
+    SizeX = NewSizeX;
+    SizeY = NewSizeY;
+}
+
+void FGridZoneLayer::PaintRect(const FIntRect& Rect, EGridZone Zone)
+{
+    const int32 MinY = FMath::Max(Rect.Min.Y, 0);
+    const int32 MaxY = FMath::Min(Rect.Max.Y, SizeY);
+
+    for (int32 Y = MinY; Y < MaxY; Y++)
+    {
+        PaintRowSpan(Y, Rect.Min.X, Rect.Max.X, Zone);
+    }
+}
+
+void FGridZoneLayer::PaintBrush(const FIntPoint& Center, int32 Radius, EGridZone Zone)
+{
+    Radius = FMath::Max(0, Radius);
+
+    // A circle is one span per row, its half width shrinking away from the center
+    for (int32 OffsetY = -Radius; OffsetY <= Radius; OffsetY++)
+    {
+        const int32 Y = Center.Y + OffsetY;
+        if (Y < 0 || Y >= SizeY)
+        {
+            continue;
+        }
+
+        const int32 HalfWidth = FMath::FloorToInt(FMath::Sqrt(static_cast<float>(Radius * Radius - OffsetY * OffsetY)));
+        PaintRowSpan(Y, Center.X - HalfWidth, Center.X + HalfWidth + 1, Zone);
+    }
+}
+
+bool FGridZoneLayer::IsFootprintInZones(const FGridFootprintMask& Mask, int32 AllowedZoneBits) const
+{
+    for (int32 Row = 0; Row < Mask.Height; Row++)
+    {
+        const uint64* MaskRow = Mask.Words.GetData() + Row * Mask.WordsPerRow;
+        for (int32 WordIndex = 0; WordIndex < Mask.WordsPerRow; WordIndex++)
+        {
+            const int32 Y = Mask.Min.Y + Row;
+            const int32 X = Mask.Min.X + (WordIndex << 6);
+
+            // Union of the allowed zone planes for this word
+            uint64 AllowedCells = 0;
+            for (int32 Zone = 0; Zone < NumZones; Zone++)
+            {
+                if (AllowedZoneBits & (1 << Zone))
+                {
+                    AllowedCells |= ZonePlanes[Zone].ExtractBits(Y, X);
+                }
+            }
+
+            if (MaskRow[WordIndex] & ~AllowedCells)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void FGridZoneLayer::GetAllowedPlane(int32 AllowedZoneBits, FGridBitPlane& OutPlane) const
+{
+    OutPlane.Init(SizeX, SizeY, false);
+
+    for (int32 Zone = 0; Zone < NumZones; Zone++)
+    {
+        if (!(AllowedZoneBits & (1 << Zone)))
+        {
+            continue;
+        }
+
+        for (int32 Y = 0; Y < SizeY; Y++)
+        {
+            const uint64* ZoneRow = ZonePlanes[Zone].GetRowWords(Y);
+            uint64* Row = OutPlane.GetRowWords(Y);
+            for (int32 WordIndex = 0; WordIndex < OutPlane.GetWordsPerRow(); WordIndex++)
+            {
+                Row[WordIndex] |= ZoneRow[WordIndex];
+            }
+        }
+    }
+}
+
+void FGridZoneLayer::ForEachRun(EGridZone Zone, TFunctionRef<void(int32 Y, int32 StartX, int32 Length)> Visitor) const
+{
+    if (CellCounts[static_cast<int32>(Zone)] == 0)
+    {
+        return;
+    }
+
+    for (int32 Y = 0; Y < RowRuns.Num(); Y++)
+    {
+        for (const FGridZoneRun& Run : RowRuns[Y])
+        {
+            if (Run.Zone == Zone)
+            {
+                Visitor(Y, Run.StartX, Run.Length);
+            }
+        }
+    }
+}
+
+int32 FGridZoneLayer::CountCells(EGridZone Zone) const
+{
+    return CellCounts[static_cast<int32>(Zone)];
+}
+
+void FGridZoneLayer::PaintRowSpan(int32 Y, int32 StartX, int32 EndX, EGridZone Zone)
+{
+    StartX = FMath::Max(StartX, 0);
+    EndX = FMath::Min(EndX, SizeX);
+    if (Y < 0 || Y >= SizeY || StartX >= EndX || Zone == EGridZone::Count)
+    {
+        return;
+    }
+
+    TArray<FGridZoneRun>& Runs = RowRuns[Y];
+
+    // Find the runs overlapping the span
+    int32 FirstRun = 0;
+    while (Runs[FirstRun].StartX + Runs[FirstRun].Length <= StartX)
+    {
+        FirstRun++;
+    }
+
+    int32 LastRun = FirstRun;
+    while (LastRun + 1 < Runs.Num() && Runs[LastRun + 1].StartX < EndX)
+    {
+        LastRun++;
+    }
+
+    // Take the overlapped cells out of their old zones
+    for (int32 RunIndex = FirstRun; RunIndex <= LastRun; RunIndex++)
+    {
+        const FGridZoneRun& Run = Runs[RunIndex];
+        const int32 OverlapStart = FMath::Max(Run.StartX, StartX);
+        const int32 OverlapEnd = FMath::Min(Run.StartX + Run.Length, EndX);
+
+        CellCounts[static_cast<int32>(Run.Zone)] -= OverlapEnd - OverlapStart;
+        ZonePlanes[static_cast<int32>(Run.Zone)].SetRect(FIntRect(OverlapStart, Y, OverlapEnd, Y + 1), false);
+    }
+
+    CellCounts[static_cast<int32>(Zone)] += EndX - StartX;
+    ZonePlanes[static_cast<int32>(Zone)].SetRect(FIntRect(StartX, Y, EndX, Y + 1), true);
+    FMemory::Memset(Zones.GetData() + Y * SizeX + StartX, static_cast<uint8>(Zone), EndX - StartX);
+
+    // Replace the overlapped runs with the untouched remainders and the new run
+    TArray<FGridZoneRun, TInlineAllocator<3>> Replacement;
+
+    const FGridZoneRun First = Runs[FirstRun];
+    if (First.StartX < StartX)
+    {
+        FGridZoneRun Left = First;
+        Left.Length = StartX - First.StartX;
+        Replacement.Add(Left);
+    }
+
+    FGridZoneRun Painted;
+    Painted.StartX = StartX;
+    Painted.Length = EndX - StartX;
+    Painted.Zone = Zone;
+    Replacement.Add(Painted);
+
+    const FGridZoneRun Last = Runs[LastRun];
+    if (Last.StartX + Last.Length > EndX)
+    {
+        FGridZoneRun Right = Last;
+        Right.StartX = EndX;
+        Right.Length = Last.StartX + Last.Length - EndX;
+        Replacement.Add(Right);
+    }
+
+    Runs.RemoveAt(FirstRun, LastRun - FirstRun + 1, EAllowShrinking::No);
+    Runs.Insert(Replacement.GetData(), Replacement.Num(), FirstRun);
+
+    // Merge runs of the same zone around the edit
+    const int32 MergeEnd = FMath::Min(FirstRun + Replacement.Num(), Runs.Num() - 1);
+    for (int32 RunIndex = MergeEnd; RunIndex > FMath::Max(FirstRun - 1, 0); RunIndex--)
+    {
+        if (Runs[RunIndex - 1].Zone == Runs[RunIndex].Zone)
+        {
+            Runs[RunIndex - 1].Length += Runs[RunIndex].Length;
+            Runs.RemoveAt(RunIndex, 1, EAllowShrinking::No);
+        }
+    }
+}
@@ -4,6 +4,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerController.h"
 #include "EGridTypes.h"
+#include "GridStamp.h"
 #include "BuildingController.generated.h"
 
 class ABuildingGridManager;
@@ -40,6 +41,10 @@ protected:
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Building")
     bool bBuildingModeActive;
 
+    // Whether the grid manager's active stamp is placed instead of a single building
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Building")
+    bool bStampModeActive;
+
     // Current rotation of building preview (0-3)
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Building")
     int32 CurrentRotation;
@@ -48,6 +53,41 @@ protected:
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Building")
     int32 CurrentFloorLevel;
 
+    // Whether the placement heatmap is shown while in building mode
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Building")
+    bool bShowPlacementHeatmap;
+
+    // Whether validity maps for the other rotations and the adjacent floors are built in the background while hovering
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Building")
+    bool bPrefetchValidityMaps;
+
+    // Time the placement heatmap may use per frame, in milliseconds
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Building")
+    float HeatmapBudgetMilliseconds;
+
+    // Whether the preview and placement move to the closest valid origin when the hovered one is blocked
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building")
+    bool bSnapToValidPlacement;
+
+    // How far, in cells, snapping searches for a valid origin
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building", meta = (ClampMin = "0"))
+    int32 SnapSearchDistance;
+
+    // Whether box selection reaches through every floor instead of only the current one
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Selection")
+    bool bBoxSelectAllFloors;
+
+    // Buildings picked by the last box selection
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Selection")
+    TArray<FBuildingHandle> SelectedBuildings;
+
+    // Whether a selection box is being dragged
+    bool bBoxSelecting;
+
+    // Cells under the cursor when the drag started and on the last update
+    FIntPoint BoxSelectionStart;
+    FIntPoint BoxSelectionEnd;
+
     // Building UI widget class
     UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "UI")
     TSubclassOf<UUserWidget> BuildingUIWidgetClass;
@@ -62,9 +102,15 @@ protected:
     // Trace from screen position to world
     bool GetHitUnderCursor(FHitResult& OutHit);
 
+    // Location under the cursor to place the selected building at, snapped if enabled
+    bool GetPlacementLocation(FVector& OutLocation);
+
     // Handle building rotation input
     void RotateBuilding();
 
+    // Request validity maps for the current placement and the ones the player is likely to switch to
+    void PrefetchValidityMaps();
+
     // Handle building placement confirmation
     void ConfirmPlacement();
 
@@ -77,6 +123,21 @@ protected:
     // Handle changing floor level down
     void DecrementFloorLevel();
 
+    // Start dragging a selection box at the cursor
+    void BeginBoxSelection();
+
+    // Finish the selection box at the cursor
+    void EndBoxSelection();
+
+    // Grow the selection box to the cell under the cursor
+    void UpdateBoxSelection();
+
+    // Handle bulk demolish input
+    void DemolishSelection();
+
+    // Grid cell under the cursor on the current floor
+    bool GetCellUnderCursor(FIntPoint& OutCell);
+
 public:
     /**
      * Enter building placement mode with the specified asset
@@ -85,6 +146,13 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Building")
     void EnterBuildingMode(UBuildingObjectAsset* BuildingAsset);
 
+    /**
+     * Enter building placement mode with a stamp of several buildings
+     * @param Stamp The stamp to place, e.g. captured with ABuildingGridManager::CaptureStamp
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    void EnterStampMode(const FBuildingStamp& Stamp);
+
     /**
      * Exit building placement mode
      */
@@ -111,4 +179,49 @@ public:
      */
     UFUNCTION(BlueprintCallable, Category = "Building")
     int32 GetCurrentFloorLevel() const { return CurrentFloorLevel; }
+
+    /**
+     * Select every building with a cell inside a rectangle
+     * @param Min First corner of the rectangle (inclusive)
+     * @param Max Opposite corner of the rectangle (inclusive)
+     * @param MinFloor Lowest floor to select on
+     * @param MaxFloor Highest floor to select on
+     * @return Handles of the selected buildings
+     */
+    UFUNCTION(BlueprintCallable, Category = "Selection")
+    TArray<FBuildingHandle> SelectBuildingsInBox(const FIntPoint& Min, const FIntPoint& Max, int32 MinFloor, int32 MaxFloor);
+
+    /**
+     * Get the buildings picked by the last box selection
+     * @return Handles of the selected buildings, some may have been removed since
+     */
+    UFUNCTION(BlueprintCallable, Category = "Selection")
+    const TArray<FBuildingHandle>& GetSelectedBuildings() const { return SelectedBuildings; }
+
+    /**
+     * Demolish every selected building in one batch
+     * @return Number of buildings removed
+     */
+    UFUNCTION(BlueprintCallable, Category = "Selection")
+    int32 DemolishSelectedBuildings();
+
+    /**
+     * Drop the current selection
+     */
+    UFUNCTION(BlueprintCallable, Category = "Selection")
+    void ClearSelection();
+
+    /**
+     * Get the expected tranquility, noise and walking distance of the hovered location
+     * @return Score of the current placement preview
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    FPlacementScore GetPreviewScore() const;
+
+    /**
+     * Show or hide the heatmap of the best spots for the selected building
+     * @param bVisible Whether the heatmap should be shown
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    void SetPlacementHeatmapVisible(bool bVisible);
 };
\ No newline at end of file
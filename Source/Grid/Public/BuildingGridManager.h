@@ -4,10 +4,35 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "EGridTypes.h"
+#include "GridBitPlane.h"
+#include "GridOccupancyPyramid.h"
+#include "GridRoomIndex.h"
+#include "GridEdgeGrid.h"
+#include "GridInfluenceField.h"
+#include "GridDistanceField.h"
+#include "GridZoneLayer.h"
+#include "GridTerrain.h"
+#include "GridRaycast.h"
+#include "GridStamp.h"
+#include "GridValidityMap.h"
 #include "BuildingGridManager.generated.h"
 
 class UBuildingObjectAsset;
 class ABuildingObject;
+class UGridNavModifierComponent;
+class UNavArea;
+
+// Broadcast when rooms on a floor were created, resized or removed
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnGridRoomsChanged, int32, FloorLevel, const TArray<int32>&, RoomIds);
+
+// Broadcast when a wall, door or window is placed or removed
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams(FOnGridEdgeChanged, FIntPoint, GridPosition, EGridDirection, Side, int32, FloorLevel, EGridEdgeType, EdgeType);
+
+// Broadcast after a building was placed or moved, or before a removed building is destroyed
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnGridBuildingChanged, FBuildingHandle, Handle, ABuildingObject*, Building);
+
+// Broadcast after the grid grew; CellOffset was added to every existing grid coordinate
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnGridExpanded, FIntPoint, CellOffset);
 
 /**
  * Manages the grid-based building system including cell occupancy, validation, and visualization
@@ -45,6 +70,62 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Grid Setup")
     float FloorHeight = 400.0f;
 
+    // Cell where guests enter the resort, walking distances are measured from here on every floor
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Grid Setup")
+    FIntPoint EntranceCell = FIntPoint::ZeroValue;
+
+    // Sample the ground under the ground floor when the grid is initialized, otherwise the ground is the grid plane
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Grid Setup")
+    bool bSampleTerrain = false;
+
+    // Channel traced down onto the landscape to sample the ground
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Grid Setup", meta = (EditCondition = "bSampleTerrain"))
+    TEnumAsByte<ECollisionChannel> TerrainTraceChannel = ECC_WorldStatic;
+
+    // Distance above and below the grid plane searched for ground
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Grid Setup", meta = (EditCondition = "bSampleTerrain", ClampMin = "0"))
+    float TerrainTraceRange = 10000.0f;
+
+    // Build navigation from grid occupancy instead of building collision
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Navigation")
+    bool bUseGridNavModifiers = false;
+
+    // Navigation area of occupied ground floor cells
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Navigation", meta = (EditCondition = "bUseGridNavModifiers"))
+    TSubclassOf<UNavArea> OccupiedNavArea;
+
+    // Width and height in cells of the chunks navigation is refreshed in
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Navigation", meta = (EditCondition = "bUseGridNavModifiers", ClampMin = "1"))
+    int32 NavChunkSize = 16;
+
+    // Rays cast from every window for view scores
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Sightlines", meta = (ClampMin = "1"))
+    int32 ViewRaysPerWindow = 16;
+
+    // Opening angle of the view cone of a window in degrees
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Sightlines", meta = (ClampMin = "0", ClampMax = "180"))
+    float ViewConeDegrees = 90.0f;
+
+    // Length of view rays in cells
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Sightlines", meta = (ClampMin = "1"))
+    float ViewDistance = 24.0f;
+
+    // Weight of tranquility in placement scores
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Placement Score")
+    float TranquilityScoreWeight = 1.0f;
+
+    // Weight of appeal in placement scores
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Placement Score")
+    float AppealScoreWeight = 1.0f;
+
+    // Penalty per unit of noise in placement scores
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Placement Score")
+    float NoiseScoreWeight = 1.0f;
+
+    // Penalty per step of walking distance in placement scores
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Placement Score")
+    float WalkingDistanceScoreWeight = 0.02f;
+
     // Static mesh for grid cell visualization
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Visualization")
     UStaticMesh* GridCellMesh;
@@ -85,6 +166,107 @@ protected:
     UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Grid")
     int32 ActiveFloorLevel = 0;
 
+    // Bit-packed occupancy per floor, mirrors FGridCellData::bIsOccupied
+    TArray<FGridBitPlane> OccupancyPlanes;
+
+    // Occupied cell counts of ever coarser blocks per floor, kept in step with OccupancyPlanes
+    TArray<FGridOccupancyPyramid> OccupancyPyramids;
+
+    // Room labelling per floor, kept up to date incrementally
+    TArray<FGridRoomIndex> RoomIndices;
+
+    // Walls, doors and windows between cells per floor
+    TArray<FGridEdgeGrid> EdgeGrids;
+
+    // Appeal, noise and tranquility fields per floor
+    TArray<FGridInfluenceField> InfluenceFields;
+
+    // Walking distance from the entrance per floor, rebuilt lazily after the grid changes
+    TArray<FGridDistanceField> DistanceFields;
+
+    // Overlay instance of each cell of the active floor, row-major, INDEX_NONE before it has one
+    TArray<int32> CellInstances;
+
+    // Painted zones per floor
+    TArray<FGridZoneLayer> ZoneLayers;
+
+    // Ground height and slope under the ground floor, empty unless bSampleTerrain
+    FGridTerrain Terrain;
+
+    // Navigation modifiers of the ground floor, one per chunk of NavChunkSize cells, row-major
+    UPROPERTY(Transient)
+    TArray<UGridNavModifierComponent*> NavModifiers;
+
+    // Number of navigation chunks per row
+    int32 NavChunksX = 0;
+
+    // Chunks whose occupancy changed this frame, refreshed together in Tick
+    TBitArray<> DirtyNavChunks;
+    TArray<int32> DirtyNavChunkList;
+
+    // Placed buildings indexed by FBuildingHandle::Index, null for free slots
+    UPROPERTY()
+    TArray<ABuildingObject*> BuildingSlots;
+
+    // Generation of each registry slot, bumped when its building is removed
+    TArray<int32> BuildingGenerations;
+
+    // Registry slots available for reuse
+    TArray<int32> FreeBuildingSlots;
+
+    // Registry slot of the building on each cell per floor, row-major, INDEX_NONE for free cells
+    TArray<TArray<int32>> BuildingSlotPlanes;
+
+    // Incremented on every change to occupancy or edges
+    uint32 GridVersion = 0;
+
+    // Grid version each floor's distance field was built for
+    TArray<uint32> DistanceFieldVersions;
+
+    // Top of the ground and the highest occupied floor of every cell relative to the grid plane, row-major
+    TArray<float> SkylineHeights;
+
+    // Grid version the skyline was built for
+    uint32 SkylineVersion = MAX_uint32;
+
+    // Score of the last placement preview
+    FPlacementScore PreviewScore;
+
+    // Inputs of the last placement preview, used to skip redundant updates
+    TWeakObjectPtr<UBuildingObjectAsset> PreviewAsset;
+    FIntPoint PreviewOrigin = FIntPoint(INDEX_NONE, INDEX_NONE);
+    int32 PreviewRotation = INDEX_NONE;
+    int32 PreviewFloor = INDEX_NONE;
+    uint32 PreviewVersion = MAX_uint32;
+
+    // Progress of a time-sliced placement heatmap
+    struct FPlacementHeatmapState
+    {
+        TWeakObjectPtr<UBuildingObjectAsset> Asset;
+        int32 Rotation = INDEX_NONE;
+        int32 FloorLevel = INDEX_NONE;
+        uint32 Version = MAX_uint32;
+        int32 NextCell = 0;
+        bool bApplied = false;
+        FGridFootprintMask Footprint;
+        bool bFootprintFillsBounds = false;
+        TArray<float> Scores;
+        TBitArray<> Valid;
+    };
+    FPlacementHeatmapState Heatmap;
+
+    // Validity maps prefetched for building mode, keyed by asset, rotation, floor and grid version
+    FGridValidityCache ValidityMaps;
+
+    // Stamp being placed, rasterized for every rotation
+    FCompiledBuildingStamp ActiveStamp;
+
+    // Incremented whenever the active stamp changes
+    uint32 ActiveStampVersion = 0;
+
+    // Active stamp version of the last stamp preview, MAX_uint32 if the last preview was not a stamp
+    uint32 PreviewStampVersion = MAX_uint32;
+
 public:
     // Called every frame
     virtual void Tick(float DeltaTime) override;
@@ -99,6 +281,22 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Grid")
     void InitializeGrid(int32 SizeX = 50, int32 SizeY = 50, float CellSizeValue = 100.0f, int32 MaxFloorsValue = 5);
 
+    /**
+     * Grow the grid without reinitializing it. Cells, buildings, handles, edges, zones and rooms are kept and
+     * only the added cells are set up. Cells added before the first column or row shift every grid coordinate
+     * by AddMin; the grid actor moves the other way, so nothing changes place in the world.
+     * @param AddMin Columns (X) and rows (Y) to add before the first ones
+     * @param AddMax Columns (X) and rows (Y) to add after the last ones
+     * @param AddFloors Floors to add on top
+     * @return True if the grid grew
+     */
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    bool ExpandGrid(const FIntPoint& AddMin, const FIntPoint& AddMax, int32 AddFloors = 0);
+
+    // Called after the grid grew, with the offset added to existing grid coordinates
+    UPROPERTY(BlueprintAssignable, Category = "Grid")
+    FOnGridExpanded OnGridExpanded;
+
     /**
      * Get the cell data at the specified grid position and floor
      * @param GridPosition Grid position (not world position)
@@ -111,7 +309,7 @@ public:
     /**
      * Convert world position to grid position
      * @param WorldPosition Position in world space
-     * @param FloorLevel Optional output parameter for detected floor level
+     * @param FloorLevel Optional output parameter for detected floor level, from the height above the grid and the ground
      * @return Grid position
      */
     UFUNCTION(BlueprintCallable, Category = "Grid")
@@ -121,7 +319,7 @@ public:
      * Convert grid position to world position
      * @param GridPosition Grid coordinates
      * @param FloorLevel Floor level
-     * @return World position (center of cell)
+     * @return World position (center of cell), on the sampled ground for the ground floor
      */
     UFUNCTION(BlueprintCallable, Category = "Grid")
     FVector GridToWorld(const FIntPoint& GridPosition, int32 FloorLevel = 0) const;
@@ -203,6 +401,397 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Grid")
     int32 GetMaxFloors() const { return MaxFloors; }
 
+    /**
+     * Get the cell where guests enter the resort
+     * @return Entrance cell
+     */
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    FIntPoint GetEntranceCell() const { return EntranceCell; }
+
+    /**
+     * Get the room that contains a cell
+     * @param GridPosition Grid coordinates
+     * @param FloorLevel Floor level
+     * @return Room id or INDEX_NONE if the cell is occupied or out of bounds
+     */
+    UFUNCTION(BlueprintCallable, Category = "Rooms")
+    int32 GetRoomIdAt(const FIntPoint& GridPosition, int32 FloorLevel = 0) const;
+
+    /**
+     * Get the summary of a room
+     * @param RoomId Room to query
+     * @param FloorLevel Floor level of the room
+     * @param OutInfo Output room summary
+     * @return True if the room exists
+     */
+    UFUNCTION(BlueprintCallable, Category = "Rooms")
+    bool GetRoomInfo(int32 RoomId, int32 FloorLevel, FGridRoomInfo& OutInfo) const;
+
+    // Called when rooms change after a placement or removal
+    UPROPERTY(BlueprintAssignable, Category = "Rooms")
+    FOnGridRoomsChanged OnRoomsChanged;
+
+    /**
+     * Get the height of the ground under a cell
+     * @param GridPosition Cell to sample
+     * @return World Z of the ground, the grid plane if the terrain was not sampled
+     */
+    UFUNCTION(BlueprintCallable, Category = "Terrain")
+    float GetTerrainHeight(const FIntPoint& GridPosition) const;
+
+    /**
+     * Get the slope of the ground under a cell
+     * @param GridPosition Cell to sample
+     * @return Slope in degrees, 0 if the terrain was not sampled
+     */
+    UFUNCTION(BlueprintCallable, Category = "Terrain")
+    float GetTerrainSlope(const FIntPoint& GridPosition) const;
+
+    // World bounds of a rectangle of ground floor cells as seen by navigation
+    FBox GetNavModifierBounds(const FIntRect& Cells) const;
+
+    // Boxes covering the occupied ground floor cells of a rectangle, one per run of cells shared by consecutive rows
+    void GetNavModifierBoxes(const FIntRect& Cells, TArray<FBox>& OutBoxes) const;
+
+    // Navigation area of occupied ground floor cells
+    TSubclassOf<UNavArea> GetOccupiedNavArea() const { return OccupiedNavArea; }
+
+    /**
+     * Check if one cell can be seen from another across buildings, walls and doors of a floor
+     * @param From Cell the viewer stands on
+     * @param To Cell to look at
+     * @param FloorLevel Floor of both cells
+     * @return True if nothing between the cells blocks the line between their centers
+     */
+    UFUNCTION(BlueprintCallable, Category = "Sightlines")
+    bool HasLineOfSight(const FIntPoint& From, const FIntPoint& To, int32 FloorLevel = 0) const;
+
+    /**
+     * Rate the view out of a building's windows
+     * @param Handle Building to rate
+     * @return Ground appeal seen per view ray, 0 for buildings without windows
+     */
+    UFUNCTION(BlueprintCallable, Category = "Sightlines")
+    float GetViewScore(const FBuildingHandle& Handle);
+
+    /**
+     * Rate the views of many buildings, casting all of their rays in one parallel batch per floor
+     * @param Handles Buildings to rate
+     * @return One score per handle, see GetViewScore
+     */
+    UFUNCTION(BlueprintCallable, Category = "Sightlines")
+    TArray<float> GetViewScores(const TArray<FBuildingHandle>& Handles);
+
+    /**
+     * Place a wall, door or window on one side of a cell
+     * @param GridPosition Cell next to the edge
+     * @param Side Side of the cell the edge lies on
+     * @param EdgeType Element to place
+     * @param FloorLevel Floor level
+     * @return True if the element was placed
+     */
+    UFUNCTION(BlueprintCallable, Category = "Edges")
+    bool PlaceEdge(const FIntPoint& GridPosition, EGridDirection Side, EGridEdgeType EdgeType, int32 FloorLevel = 0);
+
+    /**
+     * Remove the element on one side of a cell
+     * @param GridPosition Cell next to the edge
+     * @param Side Side of the cell the edge lies on
+     * @param FloorLevel Floor level
+     * @return True if an element was removed
+     */
+    UFUNCTION(BlueprintCallable, Category = "Edges")
+    bool RemoveEdge(const FIntPoint& GridPosition, EGridDirection Side, int32 FloorLevel = 0);
+
+    /**
+     * Get the element on one side of a cell
+     * @param GridPosition Cell next to the edge
+     * @param Side Side of the cell the edge lies on
+     * @param FloorLevel Floor level
+     * @return Element type or None
+     */
+    UFUNCTION(BlueprintCallable, Category = "Edges")
+    EGridEdgeType GetEdge(const FIntPoint& GridPosition, EGridDirection Side, int32 FloorLevel = 0) const;
+
+    /**
+     * Check if an agent can step from a cell to its neighbour
+     * @param GridPosition Cell to step from
+     * @param Direction Direction of the step
+     * @param FloorLevel Floor level
+     * @return True if the neighbour is occupied, out of bounds or a wall or window is in the way
+     */
+    UFUNCTION(BlueprintCallable, Category = "Edges")
+    bool IsMovementBlocked(const FIntPoint& GridPosition, EGridDirection Direction, int32 FloorLevel = 0) const;
+
+    // Called when a wall, door or window is placed or removed
+    UPROPERTY(BlueprintAssignable, Category = "Edges")
+    FOnGridEdgeChanged OnEdgeChanged;
+
+    /**
+     * Get the value of an influence channel at a cell
+     * @param GridPosition Grid coordinates
+     * @param Channel Influence channel
+     * @param FloorLevel Floor level
+     * @return Accumulated influence of every building in range
+     */
+    UFUNCTION(BlueprintCallable, Category = "Influence")
+    float GetInfluenceAt(const FIntPoint& GridPosition, EGridInfluenceChannel Channel, int32 FloorLevel = 0) const;
+
+    /**
+     * Score a placement by sampling the influence and distance fields under the footprint
+     * @param BuildingAsset Building asset to place
+     * @param WorldLocation World location for placement
+     * @param Rotation Rotation in quarters (0-3)
+     * @param FloorLevel Floor level for placement
+     * @return Placement score
+     */
+    UFUNCTION(BlueprintCallable, Category = "Placement Score")
+    FPlacementScore GetPlacementScore(UBuildingObjectAsset* BuildingAsset, const FVector& WorldLocation, int32 Rotation = 0, int32 FloorLevel = 0);
+
+    /**
+     * Get the score computed by the last placement preview
+     * @return Placement score of the hovered location
+     */
+    UFUNCTION(BlueprintCallable, Category = "Placement Score")
+    FPlacementScore GetPreviewScore() const { return PreviewScore; }
+
+    /**
+     * Continue building the placement heatmap for an asset on a floor, within a time budget.
+     * Scores are written to the first custom data float of the cell instances once complete.
+     * @param BuildingAsset Building asset to score
+     * @param Rotation Rotation in quarters (0-3)
+     * @param FloorLevel Floor level to score
+     * @param BudgetMilliseconds Time allowed for this call
+     * @return True once the heatmap is complete and visible
+     */
+    UFUNCTION(BlueprintCallable, Category = "Placement Score")
+    bool UpdatePlacementHeatmap(UBuildingObjectAsset* BuildingAsset, int32 Rotation, int32 FloorLevel, float BudgetMilliseconds = 1.0f);
+
+    /**
+     * Hide the placement heatmap and drop its progress
+     */
+    UFUNCTION(BlueprintCallable, Category = "Placement Score")
+    void ClearPlacementHeatmap();
+
+    /**
+     * Get the best scoring valid origins of the completed heatmap
+     * @param Count Maximum number of origins to return
+     * @return Grid origins sorted from best to worst
+     */
+    UFUNCTION(BlueprintCallable, Category = "Placement Score")
+    TArray<FIntPoint> GetBestPlacementSpots(int32 Count = 5) const;
+
+    /**
+     * Find the valid origin closest to a cell, searching rings of growing distance around it
+     * @param BuildingAsset Building asset to place
+     * @param GridPosition Cell to search around
+     * @param Rotation Rotation in quarters (0-3)
+     * @param FloorLevel Floor level for placement
+     * @param MaxDistance Largest distance in cells, along either axis, to search
+     * @param OutOrigin Closest valid origin if found
+     * @return True if a valid origin was found
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    bool FindNearestPlacement(UBuildingObjectAsset* BuildingAsset, const FIntPoint& GridPosition, int32 Rotation, int32 FloorLevel, int32 MaxDistance, FIntPoint& OutOrigin);
+
+    /**
+     * Move a placement location to the closest valid origin
+     * @param BuildingAsset Building asset to place
+     * @param WorldLocation Location to snap
+     * @param Rotation Rotation in quarters (0-3)
+     * @param FloorLevel Floor level for placement
+     * @param MaxDistance Largest distance in cells, along either axis, to search
+     * @param OutLocation World location resolving to the closest valid origin if found
+     * @return True if a valid origin was found
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    bool SnapPlacementLocation(UBuildingObjectAsset* BuildingAsset, const FVector& WorldLocation, int32 Rotation, int32 FloorLevel, int32 MaxDistance, FVector& OutLocation);
+
+    /**
+     * Start building the map of valid origins for an asset on a background task, unless it is cached.
+     * Once finished, placement checks for the asset read bounds, occupancy, support and zoning from it.
+     * @param BuildingAsset Building asset to map
+     * @param Rotation Rotation in quarters (0-3)
+     * @param FloorLevel Floor level to map
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    void PrefetchValidityMap(UBuildingObjectAsset* BuildingAsset, int32 Rotation, int32 FloorLevel);
+
+    /**
+     * Get the number of changes made to the grid so far
+     * @return Grid version
+     */
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    int32 GetGridVersion() const { return static_cast<int32>(GridVersion); }
+
+    // Called after a building was placed
+    UPROPERTY(BlueprintAssignable, Category = "Building")
+    FOnGridBuildingChanged OnBuildingPlaced;
+
+    // Called when a building is removed, before its actor is destroyed
+    UPROPERTY(BlueprintAssignable, Category = "Building")
+    FOnGridBuildingChanged OnBuildingRemoved;
+
+    // Called after a building was moved to a new origin, rotation or floor
+    UPROPERTY(BlueprintAssignable, Category = "Building")
+    FOnGridBuildingChanged OnBuildingMoved;
+
+    /**
+     * Move a placed building to another origin, rotation or floor without respawning it.
+     * Its own cells do not block the new location; only the cells of the old and new footprint are updated.
+     * A building that supports anything on the floor above cannot leave the supporting cells.
+     * @param Handle Building to move
+     * @param NewOrigin Grid origin of the new location
+     * @param NewRotation Rotation in quarters (0-3)
+     * @param NewFloor Floor level of the new location
+     * @return True if the building was moved or already there
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    bool MoveBuilding(const FBuildingHandle& Handle, const FIntPoint& NewOrigin, int32 NewRotation, int32 NewFloor);
+
+    /**
+     * Remove several buildings at once with a single visual refresh
+     * @param Handles Buildings to remove, stale handles are skipped
+     * @return Number of buildings removed
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    int32 RemoveBuildings(const TArray<FBuildingHandle>& Handles);
+
+    /**
+     * Get every building with at least one cell inside a rectangle
+     * @param Min First corner of the rectangle (inclusive)
+     * @param Max Opposite corner of the rectangle (inclusive)
+     * @param MinFloor Lowest floor to search
+     * @param MaxFloor Highest floor to search
+     * @return Handles of the buildings, each once, in registry order
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    TArray<FBuildingHandle> GetBuildingsInRect(const FIntPoint& Min, const FIntPoint& Max, int32 MinFloor = 0, int32 MaxFloor = 0) const;
+
+    /**
+     * Mark the cells of buildings as selected, replacing any preview
+     * @param Handles Buildings to show as selected, empty clears the selection
+     */
+    UFUNCTION(BlueprintCallable, Category = "Visualization")
+    void ShowBuildingSelection(const TArray<FBuildingHandle>& Handles);
+
+    /**
+     * Resolve a building handle
+     * @param Handle Handle issued on placement
+     * @return The building, or nullptr if it was removed
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    ABuildingObject* GetBuilding(const FBuildingHandle& Handle) const;
+
+    /**
+     * Get the handles of all placed buildings
+     * @return Handles in registry order
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    TArray<FBuildingHandle> GetBuildingHandles() const;
+
+    /**
+     * Paint a rectangle of cells with a zone
+     * @param Min First corner of the rectangle (inclusive)
+     * @param Max Opposite corner of the rectangle (inclusive)
+     * @param Zone Zone to assign, None clears the zone
+     * @param FloorLevel Floor level
+     */
+    UFUNCTION(BlueprintCallable, Category = "Zones")
+    void PaintZoneRect(const FIntPoint& Min, const FIntPoint& Max, EGridZone Zone, int32 FloorLevel = 0);
+
+    /**
+     * Paint a filled circle of cells with a zone
+     * @param Center Center cell of the brush
+     * @param Radius Brush radius in cells
+     * @param Zone Zone to assign, None clears the zone
+     * @param FloorLevel Floor level
+     */
+    UFUNCTION(BlueprintCallable, Category = "Zones")
+    void PaintZoneBrush(const FIntPoint& Center, int32 Radius, EGridZone Zone, int32 FloorLevel = 0);
+
+    /**
+     * Get the zone of a cell
+     * @param GridPosition Grid coordinates
+     * @param FloorLevel Floor level
+     * @return Zone of the cell, None if unzoned or invalid
+     */
+    UFUNCTION(BlueprintCallable, Category = "Zones")
+    EGridZone GetZoneAt(const FIntPoint& GridPosition, int32 FloorLevel = 0) const;
+
+    /**
+     * Get every cell painted with a zone
+     * @param Zone Zone to collect
+     * @param FloorLevel Floor level
+     * @return Cells of the zone, row by row
+     */
+    UFUNCTION(BlueprintCallable, Category = "Zones")
+    TArray<FIntPoint> GetZoneCells(EGridZone Zone, int32 FloorLevel = 0) const;
+
+    /**
+     * Count the cells painted with a zone
+     * @param Zone Zone to count
+     * @param FloorLevel Floor level
+     * @return Number of cells
+     */
+    UFUNCTION(BlueprintCallable, Category = "Zones")
+    int32 CountZoneCells(EGridZone Zone, int32 FloorLevel = 0) const;
+
+    /**
+     * Capture the buildings in a region into a stamp.
+     * Buildings that reach into the region are captured whole.
+     * @param Min First corner of the region (inclusive), becomes the stamp origin
+     * @param Max Opposite corner of the region (inclusive)
+     * @param MinFloor Lowest floor to capture, becomes the stamp's ground floor
+     * @param MaxFloor Highest floor to capture
+     * @return Stamp with the buildings sorted by floor
+     */
+    UFUNCTION(BlueprintCallable, Category = "Stamp")
+    FBuildingStamp CaptureStamp(const FIntPoint& Min, const FIntPoint& Max, int32 MinFloor = 0, int32 MaxFloor = 0) const;
+
+    /**
+     * Select the stamp used by stamp previews and placement, rasterizing it for every rotation
+     * @param Stamp Stamp to place, an empty stamp clears the selection
+     */
+    UFUNCTION(BlueprintCallable, Category = "Stamp")
+    void SetActiveStamp(const FBuildingStamp& Stamp);
+
+    /**
+     * Get the stamp used by stamp previews and placement
+     * @return The active stamp
+     */
+    UFUNCTION(BlueprintCallable, Category = "Stamp")
+    const FBuildingStamp& GetActiveStamp() const { return ActiveStamp.GetStamp(); }
+
+    /**
+     * Check if every building of the active stamp can be placed
+     * @param WorldLocation World location of the stamp origin
+     * @param Rotation Rotation of the whole stamp in quarters (0-3)
+     * @param FloorLevel Floor the stamp's ground floor is placed on
+     * @return True if the whole stamp fits
+     */
+    UFUNCTION(BlueprintCallable, Category = "Stamp")
+    bool CanPlaceStamp(const FVector& WorldLocation, int32 Rotation = 0, int32 FloorLevel = 0);
+
+    /**
+     * Place every building of the active stamp, or none of them if any would not fit
+     * @param WorldLocation World location of the stamp origin
+     * @param Rotation Rotation of the whole stamp in quarters (0-3)
+     * @param FloorLevel Floor the stamp's ground floor is placed on
+     * @return Spawned buildings in stamp order, empty if placement failed
+     */
+    UFUNCTION(BlueprintCallable, Category = "Stamp")
+    TArray<ABuildingObject*> PlaceStamp(const FVector& WorldLocation, int32 Rotation = 0, int32 FloorLevel = 0);
+
+    /**
+     * Update the visual state of cells for a preview of the active stamp
+     * @param WorldLocation World location of the stamp origin
+     * @param Rotation Rotation of the whole stamp in quarters (0-3)
+     * @param FloorLevel Floor the stamp's ground floor is placed on
+     */
+    UFUNCTION(BlueprintCallable, Category = "Stamp")
+    void UpdateStampPreview(const FVector& WorldLocation, int32 Rotation = 0, int32 FloorLevel = 0);
+
 private:
     // Update the visual representation of a specific cell
     void UpdateCellVisual(const FIntPoint& GridPosition, int32 FloorLevel);
@@ -210,18 +799,108 @@ private:
     // Update all grid cell visuals
     void UpdateAllCellVisuals();
 
+    // Carry the cell instances over after the grid grew, adding instances only for added cells
+    void RemapCellVisuals(int32 OldSizeX, int32 OldSizeY, const FIntPoint& Offset);
+
+    // Size every per-floor structure of a floor for the grid and clear it
+    void InitializeFloor(int32 Floor);
+
+    // Reset a cell to its free state
+    void InitializeCell(FGridCellData& Cell, const FIntPoint& GridPosition, int32 Floor) const;
+
     // Set cell data at specified position
     void SetCellData(const FIntPoint& GridPosition, int32 FloorLevel, const FGridCellData& CellData);
 
     // Checks if all cells a building would occupy are available
     bool AreCellsAvailableForBuilding(const FBuildingFootprint& Footprint, const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel);
 
-    // Marks cells as occupied by a building
-    void MarkCellsAsOccupied(const FBuildingFootprint& Footprint, const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel, AActor* Building);
+    // Add a building to the registry and return its handle
+    FBuildingHandle RegisterBuilding(ABuildingObject* Building);
+
+    // Remove a building from the registry, invalidating its handle
+    void UnregisterBuilding(const FBuildingHandle& Handle);
+
+    // Checks a rasterized footprint against the bounds, occupancy and support of a floor
+    bool IsFootprintMaskAvailable(const FGridFootprintMask& Mask, int32 FloorLevel) const;
+
+    // Rejects an origin from the bounds of a footprint relative to it and the occupancy pyramid alone.
+    // False only means the exact checks are still needed.
+    bool IsFootprintCoarselyBlocked(const FGridFootprintMask& Footprint, bool bFillsBounds, const FIntPoint& GridOrigin, int32 FloorLevel) const;
+
+    // Check the ground under the bounds of a footprint against the building's slope and height limits
+    bool IsFootprintOnSuitableTerrain(const UBuildingObjectAsset* BuildingAsset, const FGridFootprintMask& Mask, int32 FloorLevel) const;
+
+    // Bottom of a floor of a cell relative to the grid plane; floors are stacked on the ground under the cell
+    FORCEINLINE float GetFloorBaseHeight(int32 X, int32 Y, int32 FloorLevel) const { return Terrain.GetHeight(X, Y) + FloorLevel * FloorHeight; }
+
+    // Trace down onto the ground under a cell, height relative to the grid plane
+    float TraceTerrainHeight(const FIntPoint& GridPosition, const FCollisionQueryParams& Params) const;
+
+    // Query parameters for terrain traces, ignoring the grid and every building
+    FCollisionQueryParams MakeTerrainQueryParams() const;
+
+    // Create one navigation modifier per chunk of the ground floor, replacing the previous ones
+    void CreateNavModifiers();
+
+    // Lay the navigation chunks out for a grown grid, keeping the registered ones when the offset is whole chunks
+    void ExpandNavModifiers(const FIntPoint& Offset, int32 OldSizeX, int32 OldSizeY);
+
+    // Queue the navigation chunks containing changed cells
+    void MarkNavCellsDirty(const TArray<FIntPoint>& Cells, int32 FloorLevel);
+
+    // Refresh the navigation modifiers of every queued chunk
+    void FlushNavModifiers();
+
+    // Rebuild the skyline if the grid changed since it was built
+    void EnsureSkyline();
+
+    // Add the rays of a view cone from every outside window of a building
+    void AddWindowViewRays(const ABuildingObject* Building, TArray<FGridRay>& OutRays) const;
+
+    // Marks cells as occupied by a building and its registry slot
+    void MarkCellsAsOccupied(const FBuildingFootprint& Footprint, const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel, AActor* Building, int32 BuildingSlot);
+
+    void MarkCellsAsOccupied(const TArray<FIntPoint>& OccupiedCells, const FIntPoint& GridOrigin, int32 FloorLevel, AActor* Building, int32 BuildingSlot);
 
     // Marks cells as unoccupied
     void MarkCellsAsUnoccupied(const FBuildingFootprint& Footprint, const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel);
+    void MarkCellsAsUnoccupied(const TArray<FIntPoint>& OccupiedCells, int32 FloorLevel);
+
+    // Placement validity for a grid origin
+    bool CanPlaceBuildingAtCell(const UBuildingObjectAsset* BuildingAsset, const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel);
+
+    // Finished validity map for the current grid version, nullptr if not prefetched or still building
+    const FGridBitPlane* FindValidityMap(const UBuildingObjectAsset* BuildingAsset, int32 Rotation, int32 FloorLevel);
+
+    // Spawn and register a building at a validated grid origin, leaving the full visual refresh to the caller
+    ABuildingObject* SpawnBuildingAtCell(UBuildingObjectAsset* BuildingAsset, const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel);
+
+    // Take a building off the grid and destroy it, leaving the full visual refresh to the caller
+    void DestroyBuilding(ABuildingObject* Building);
+
+    // Placement validity of the active stamp for a grid origin
+    bool CanPlaceStampAtCell(const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel);
+
+    // Sample the fields under a footprint
+    FPlacementScore ComputePlacementScore(const UBuildingObjectAsset* BuildingAsset, const FIntPoint& GridOrigin, int32 Rotation, int32 FloorLevel);
+
+    // Rebuild the distance field of a floor if the grid changed since it was built
+    void EnsureDistanceField(int32 FloorLevel);
+
+    // Write the finished placement heatmap to the grid overlay
+    void ApplyPlacementHeatmap();
+
+    // Record a change to occupancy or edges
+    void MarkGridChanged() { GridVersion++; }
+
+    // Add (Sign = 1) or remove (Sign = -1) the influence kernels of a building
+    void ApplyBuildingInfluence(const UBuildingObjectAsset* BuildingAsset, const TArray<FIntPoint>& FootprintCells, int32 FloorLevel, float Sign);
+
+    // Broadcast and clear the changed rooms of a floor
+    void NotifyRoomsChanged(int32 FloorLevel);
 
-    // Check if placement meets adjacency requirements
-    bool CheckAdjacencyRequirements(const TArray<FAdjacencyRequirement>& Requirements, const FIntPoint& GridOrigin, int32 FloorLevel);
+    // Check if placement meets adjacency requirements; PendingCellTypes holds buildings placed in the same
+    // batch, keyed by cell relative to PendingOrigin, which are looked up before the grid
+    bool CheckAdjacencyRequirements(const TArray<FAdjacencyRequirement>& Requirements, const FIntPoint& GridOrigin, int32 FloorLevel,
+        const TMap<FIntPoint, EBuildingType>* PendingCellTypes = nullptr, const FIntPoint& PendingOrigin = FIntPoint::ZeroValue);
 };
\ No newline at end of file
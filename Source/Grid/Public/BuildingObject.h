@@ -53,6 +53,10 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building")
     uint8 BuildingState;
     
+    // Share of the construction work that is done (0-1)
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Building")
+    float ConstructionProgress;
+    
     // Current operational efficiency (0-100%)
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building")
     float OperationalEfficiency;
@@ -64,6 +68,22 @@ protected:
     // Current guests using this building
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Guests")
     TArray<AActor*> CurrentGuests;
+    
+    // Simulated guests using this building, by guest id; they share capacity with CurrentGuests
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Guests")
+    TArray<int32> SimulatedGuests;
+    
+    // Entity guests using this building; they share capacity with CurrentGuests
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Guests")
+    TArray<FAgentHandle> AgentGuests;
+    
+    // Entity staff working at this building, counted together with AssignedStaff
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Staff")
+    TArray<FAgentHandle> AgentStaff;
+    
+    // Handle in the grid manager's building registry
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Building")
+    FBuildingHandle BuildingHandle;
 
 public:
     // Called every frame
@@ -83,6 +103,13 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Building")
     FBuildingFootprint GetFootprint() const;
     
+    /**
+     * Get the asset this building was created from
+     * @return Building asset or nullptr
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    UBuildingObjectAsset* GetBuildingAsset() const { return BuildingAsset; }
+    
     /**
      * Get the building's type
      * @return Building type enum
@@ -90,6 +117,19 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Building")
     EBuildingType GetBuildingType() const { return BuildingType; }
     
+    /**
+     * Get the handle of the building in the grid manager's registry
+     * @return Building handle, invalid if the building was not placed by a grid manager
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    FBuildingHandle GetBuildingHandle() const { return BuildingHandle; }
+    
+    /**
+     * Set the handle of the building, called by the grid manager on placement
+     * @param Handle Registry handle
+     */
+    void SetBuildingHandle(const FBuildingHandle& Handle) { BuildingHandle = Handle; }
+    
     /**
      * Set the building's grid properties
      * @param Origin Grid origin position
@@ -124,6 +164,29 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Staff")
     bool RemoveStaffMember(AActor* StaffMember);
     
+    /**
+     * Assign an entity staff member to this building
+     * @param StaffMember Handle of the staff entity
+     * @return True if successfully assigned
+     */
+    UFUNCTION(BlueprintCallable, Category = "Staff")
+    bool AssignAgentStaff(const FAgentHandle& StaffMember);
+    
+    /**
+     * Remove an entity staff member from this building
+     * @param StaffMember Handle of the staff entity
+     * @return True if successfully removed
+     */
+    UFUNCTION(BlueprintCallable, Category = "Staff")
+    bool RemoveAgentStaff(const FAgentHandle& StaffMember);
+    
+    /**
+     * Get the number of staff working at this building, actors and entities
+     * @return Staff count
+     */
+    UFUNCTION(BlueprintCallable, Category = "Staff")
+    int32 GetNumStaff() const { return AssignedStaff.Num() + AgentStaff.Num(); }
+    
     /**
      * Check if building has available capacity for guests
      * @return True if has available capacity
@@ -147,6 +210,45 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Guests")
     bool RemoveGuest(AActor* Guest);
     
+    /**
+     * Register a simulated guest using this building
+     * @param GuestId Guest id in the resort simulation
+     * @return True if successfully registered
+     */
+    UFUNCTION(BlueprintCallable, Category = "Guests")
+    bool RegisterSimulatedGuest(int32 GuestId);
+    
+    /**
+     * Remove a simulated guest from this building
+     * @param GuestId Guest id in the resort simulation
+     * @return True if successfully removed
+     */
+    UFUNCTION(BlueprintCallable, Category = "Guests")
+    bool RemoveSimulatedGuest(int32 GuestId);
+    
+    /**
+     * Register an entity guest using this building
+     * @param Guest Handle of the guest entity
+     * @return True if successfully registered
+     */
+    UFUNCTION(BlueprintCallable, Category = "Guests")
+    bool RegisterAgentGuest(const FAgentHandle& Guest);
+    
+    /**
+     * Remove an entity guest from this building
+     * @param Guest Handle of the guest entity
+     * @return True if successfully removed
+     */
+    UFUNCTION(BlueprintCallable, Category = "Guests")
+    bool RemoveAgentGuest(const FAgentHandle& Guest);
+    
+    /**
+     * Get the number of guests using this building, actors, simulated and entities
+     * @return Guest count
+     */
+    UFUNCTION(BlueprintCallable, Category = "Guests")
+    int32 GetNumGuests() const { return CurrentGuests.Num() + SimulatedGuests.Num() + AgentGuests.Num(); }
+    
     /**
      * Check if this building supports a specific treatment type
      * @param TreatmentType The treatment type name
@@ -176,6 +278,33 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Economy")
     int32 CalculateMaintenanceCost() const;
     
+    /**
+     * Check if the building is still being built
+     * @return True until construction has completed
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    bool IsUnderConstruction() const { return BuildingState == 0; }
+    
+    /**
+     * Get the construction progress
+     * @return Share of the construction work that is done (0-1)
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    float GetConstructionProgress() const { return ConstructionProgress; }
+    
+    /**
+     * Set the construction progress, called by the construction simulation
+     * @param Progress Share of the construction work that is done (0-1)
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    void SetConstructionProgress(float Progress);
+    
+    /**
+     * Finish construction and make the building operational
+     */
+    UFUNCTION(BlueprintCallable, Category = "Building")
+    virtual void CompleteConstruction();
+    
     /**
      * Handle daily update (called by game system)
      * Updates efficiency, condition, etc.
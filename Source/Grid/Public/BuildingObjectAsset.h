@@ -51,6 +51,14 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Economy")
     int32 ConstructionCost = 1000;
     
+    // Builder-hours of work until the building opens, 0 opens it on placement
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Construction", meta = (ClampMin = "0"))
+    float ConstructionHours = 0.0f;
+    
+    // Most builders that can work on the building at once
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Construction", meta = (ClampMin = "1"))
+    int32 MaxBuilders = 2;
+    
     // Maintenance cost per day
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Economy")
     int32 MaintenanceCost = 50;
@@ -74,14 +82,34 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Requirements")
     TArray<FAdjacencyRequirement> AdjacencyRequirements;
     
+    // Zones the building may be placed in, any zone when empty
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Requirements", meta = (Bitmask, BitmaskEnum = "/Script/Grid.EGridZone"))
+    int32 AllowedZones = 0;
+    
+    // Steepest ground slope in degrees allowed under a ground floor footprint, any slope when 0
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Requirements", meta = (ClampMin = "0", ClampMax = "90"))
+    float MaxTerrainSlope = 0.0f;
+    
+    // Largest ground height difference allowed under a ground floor footprint, any difference when 0
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Requirements", meta = (ClampMin = "0"))
+    float MaxTerrainHeightDelta = 0.0f;
+    
     // Guest capacity
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Guests")
     int32 MaxGuests = 1;
     
+    // Simulated minutes a guest spends per visit (treatment, meal, ...)
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Guests", meta = (ClampMin = "1"))
+    int32 VisitDurationMinutes = 60;
+    
     // Treatment types supported by this building
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Treatments")
     TArray<FName> SupportedTreatments;
     
+    // Ambience spread around the building, defaults for the building type are used when empty
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Influence")
+    TArray<FBuildingInfluenceEmitter> InfluenceEmitters;
+    
     // Get the building's footprint
     UFUNCTION(BlueprintCallable, Category = "Building")
     const FBuildingFootprint& GetFootprint() const { return Footprint; }
@@ -94,6 +122,13 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Building")
     const TArray<FAdjacencyRequirement>& GetAdjacencyRequirements() const { return AdjacencyRequirements; }
     
+    // Get the influence kernels of the building, falling back to the building type defaults
+    UFUNCTION(BlueprintCallable, Category = "Influence")
+    TArray<FBuildingInfluenceEmitter> GetInfluenceEmitters() const;
+    
+    // Default influence kernels for a building type
+    static TArray<FBuildingInfluenceEmitter> GetDefaultInfluenceEmitters(EBuildingType Type);
+    
     // Asset ID for saving/loading
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Asset")
     FPrimaryAssetId PrimaryAssetId;
@@ -55,6 +55,43 @@ enum class EGridDirection : uint8
     Any        UMETA(DisplayName = "Any Direction")
 };
 
+/**
+ * Element that can be placed on the edge between two cells
+ */
+UENUM(BlueprintType)
+enum class EGridEdgeType : uint8
+{
+    None       UMETA(DisplayName = "None"),
+    Wall       UMETA(DisplayName = "Wall"),
+    Door       UMETA(DisplayName = "Door"),
+    Window     UMETA(DisplayName = "Window")
+};
+
+/**
+ * Zones painted on the grid, used as bit indices in zone masks
+ */
+UENUM(BlueprintType, meta = (Bitflags))
+enum class EGridZone : uint8
+{
+    None          UMETA(DisplayName = "Unzoned"),
+    GuestArea     UMETA(DisplayName = "Guest Area"),
+    StaffOnly     UMETA(DisplayName = "Staff Only"),
+    WellnessWing  UMETA(DisplayName = "Wellness Wing"),
+    Count         UMETA(Hidden)
+};
+
+/**
+ * Ambience channels tracked by the influence fields
+ */
+UENUM(BlueprintType)
+enum class EGridInfluenceChannel : uint8
+{
+    Appeal      UMETA(DisplayName = "Appeal"),
+    Noise       UMETA(DisplayName = "Noise"),
+    Tranquility UMETA(DisplayName = "Tranquility"),
+    Count       UMETA(Hidden)
+};
+
 /**
  * Data structure for a single grid cell
  */
@@ -229,6 +266,168 @@ struct GRID_API FAdjacencyRequirement
     {}
 };
 
+/**
+ * Summary of a room detected on the grid.
+ * A room is a connected region of free cells; it is enclosed when walls or buildings separate it from the grid border.
+ */
+USTRUCT(BlueprintType)
+struct GRID_API FGridRoomInfo
+{
+    GENERATED_BODY()
+
+    // Identifier of the room on its floor
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rooms")
+    int32 RoomId = INDEX_NONE;
+
+    // Number of cells belonging to the room
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rooms")
+    int32 CellCount = 0;
+
+    // True if the room does not reach the edge of the grid
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rooms")
+    bool bIsEnclosed = false;
+};
+
+/**
+ * Influence a building spreads around its footprint on one channel
+ */
+USTRUCT(BlueprintType)
+struct GRID_API FBuildingInfluenceEmitter
+{
+    GENERATED_BODY()
+
+    // Channel the building contributes to
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Influence")
+    EGridInfluenceChannel Channel = EGridInfluenceChannel::Appeal;
+
+    // Contribution at the footprint cells whatever the building's size, fading out around it; negative values lower the channel
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Influence")
+    float Strength = 1.0f;
+
+    // Distance in cells over which the contribution fades out
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Influence", meta = (ClampMin = "0", ClampMax = "32"))
+    int32 Radius = 4;
+
+    // Constructor
+    FBuildingInfluenceEmitter()
+    {}
+
+    FBuildingInfluenceEmitter(EGridInfluenceChannel InChannel, float InStrength, int32 InRadius)
+        : Channel(InChannel)
+        , Strength(InStrength)
+        , Radius(InRadius)
+    {}
+};
+
+/**
+ * Expected quality of a placement, sampled from the influence and distance fields
+ */
+USTRUCT(BlueprintType)
+struct GRID_API FPlacementScore
+{
+    GENERATED_BODY()
+
+    // Whether the building can be placed at the location
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Placement")
+    bool bIsValidPlacement = false;
+
+    // Average tranquility under the footprint
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Placement")
+    float Tranquility = 0.0f;
+
+    // Average noise exposure under the footprint
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Placement")
+    float Noise = 0.0f;
+
+    // Average appeal under the footprint
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Placement")
+    float Appeal = 0.0f;
+
+    // Steps from the entrance to the closest footprint cell, -1 if unreachable
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Placement")
+    float WalkingDistance = -1.0f;
+
+    // Weighted combination of the values above, higher is better
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Placement")
+    float Score = 0.0f;
+};
+
+/**
+ * Stable reference to a placed building.
+ * Indexes the grid manager's building registry; the generation detects slots reused after a removal.
+ */
+USTRUCT(BlueprintType)
+struct GRID_API FBuildingHandle
+{
+    GENERATED_BODY()
+
+    // Slot in the building registry
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Building")
+    int32 Index = INDEX_NONE;
+
+    // Generation of the slot when the handle was issued
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Building")
+    int32 Generation = 0;
+
+    // Constructor
+    FBuildingHandle()
+    {}
+
+    FBuildingHandle(int32 InIndex, int32 InGeneration)
+        : Index(InIndex)
+        , Generation(InGeneration)
+    {}
+
+    // True if the handle was ever issued; it may still refer to a removed building
+    bool IsValid() const { return Index != INDEX_NONE; }
+
+    bool operator==(const FBuildingHandle& Other) const { return Index == Other.Index && Generation == Other.Generation; }
+    bool operator!=(const FBuildingHandle& Other) const { return !(*this == Other); }
+
+    friend uint32 GetTypeHash(const FBuildingHandle& Handle)
+    {
+        return HashCombine(GetTypeHash(Handle.Index), GetTypeHash(Handle.Generation));
+    }
+};
+
+/**
+ * Handle of an agent that is not an actor, e.g. a MassEntity guest or staff member.
+ * Mirrors the index and serial number of the entity so buildings can track agents without
+ * depending on the module that simulates them.
+ */
+USTRUCT(BlueprintType)
+struct GRID_API FAgentHandle
+{
+    GENERATED_BODY()
+
+    // Index of the agent
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Agent")
+    int32 Index = 0;
+
+    // Serial number of the agent, 0 for an invalid handle
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Agent")
+    int32 SerialNumber = 0;
+
+    // Constructor
+    FAgentHandle()
+    {}
+
+    FAgentHandle(int32 InIndex, int32 InSerialNumber)
+        : Index(InIndex)
+        , SerialNumber(InSerialNumber)
+    {}
+
+    bool IsValid() const { return SerialNumber != 0; }
+
+    bool operator==(const FAgentHandle& Other) const { return Index == Other.Index && SerialNumber == Other.SerialNumber; }
+    bool operator!=(const FAgentHandle& Other) const { return !(*this == Other); }
+
+    friend uint32 GetTypeHash(const FAgentHandle& Handle)
+    {
+        return HashCombine(GetTypeHash(Handle.Index), GetTypeHash(Handle.SerialNumber));
+    }
+};
+
 /**
  * Row of grid cells
  */
@@ -0,0 +1,146 @@
+﻿// GridBitPlane.h - Bit-packed per-cell planes used for fast grid queries
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Cells of a building footprint rasterized into bit rows relative to the footprint bounds.
+ * Tested against FGridBitPlane one 64-cell word at a time.
+ */
+struct GRID_API FGridFootprintMask
+{
+    // Rasterize a list of cells
+    void Build(const TArray<FIntPoint>& Cells);
+
+    // True if the mask has no cells
+    FORCEINLINE bool IsEmpty() const { return Width <= 0 || Height <= 0; }
+
+    // Grid position of bit 0 of row 0
+    FIntPoint Min = FIntPoint::ZeroValue;
+
+    // Size of the bounds in cells
+    int32 Width = 0;
+    int32 Height = 0;
+
+    // Number of 64-bit words per row
+    int32 WordsPerRow = 0;
+
+    // Packed footprint bits, row-major
+    TArray<uint64> Words;
+};
+
+/**
+ * Two dimensional plane storing one bit per grid cell.
+ * Rows are packed into 64-bit words so whole spans of cells can be tested or written at once.
+ * Bits past SizeX in the last word of each row are always kept clear.
+ */
+struct GRID_API FGridBitPlane
+{
+    FGridBitPlane()
+    {
+    }
+
+    FGridBitPlane(int32 InSizeX, int32 InSizeY, bool bInitialValue = false)
+    {
+        Init(InSizeX, InSizeY, bInitialValue);
+    }
+
+    // Resize the plane and set every cell to the given value
+    void Init(int32 InSizeX, int32 InSizeY, bool bInitialValue = false);
+
+    // Grow the plane, moving cell (X, Y) to (X + Offset.X, Y + Offset.Y); added cells are clear
+    void Expand(int32 NewSizeX, int32 NewSizeY, const FIntPoint& Offset);
+
+    // Check if the coordinates are inside the plane
+    FORCEINLINE bool IsValidCell(int32 X, int32 Y) const
+    {
+        return X >= 0 && X < SizeX && Y >= 0 && Y < SizeY;
+    }
+
+    // Read a single cell
+    FORCEINLINE bool Get(int32 X, int32 Y) const
+    {
+        checkSlow(IsValidCell(X, Y));
+        return ((Words[Y * WordsPerRow + (X >> 6)] >> (X & 63)) & 1ull) != 0;
+    }
+
+    // Write a single cell
+    FORCEINLINE void Set(int32 X, int32 Y, bool bValue)
+    {
+        checkSlow(IsValidCell(X, Y));
+        uint64& Word = Words[Y * WordsPerRow + (X >> 6)];
+        const uint64 Bit = 1ull << (X & 63);
+        Word = bValue ? (Word | Bit) : (Word & ~Bit);
+    }
+
+    // Write a rectangle of cells (Min inclusive, Max exclusive), clipped to the plane
+    void SetRect(const FIntRect& Rect, bool bValue);
+
+    // Check if any cell inside the rectangle is set
+    bool AnyInRect(const FIntRect& Rect) const;
+
+    // Cover the set cells inside a rectangle with rectangles; equal runs of consecutive rows share one rectangle
+    void CollectRects(const FIntRect& Area, TArray<FIntRect>& OutRects) const;
+
+    // Number of set cells in the whole plane
+    int32 CountSetBits() const;
+
+    // Read 64 cells of a row starting at column X; cells outside the plane read as clear
+    uint64 ExtractBits(int32 Y, int32 X) const;
+
+    // True if any footprint cell is set in this plane
+    bool Intersects(const FGridFootprintMask& Mask) const;
+
+    // True if every footprint cell is set in this plane (cells outside the plane count as clear)
+    bool Covers(const FGridFootprintMask& Mask) const;
+
+    // Direct access to the packed words of a row
+    FORCEINLINE const uint64* GetRowWords(int32 Y) const { return Words.GetData() + Y * WordsPerRow; }
+    FORCEINLINE uint64* GetRowWords(int32 Y) { return Words.GetData() + Y * WordsPerRow; }
+
+    FORCEINLINE int32 GetSizeX() const { return SizeX; }
+    FORCEINLINE int32 GetSizeY() const { return SizeY; }
+    FORCEINLINE int32 GetWordsPerRow() const { return WordsPerRow; }
+
+    // Mask selecting bits [FromBit, ToBit) of a single word
+    static FORCEINLINE uint64 SpanMask(int32 FromBit, int32 ToBit)
+    {
+        const uint64 High = ToBit >= 64 ? ~0ull : ((1ull << ToBit) - 1ull);
+        const uint64 Low = (1ull << FromBit) - 1ull;
+        return High & ~Low;
+    }
+
+private:
+    // Number of cells in X dimension
+    int32 SizeX = 0;
+
+    // Number of cells in Y dimension
+    int32 SizeY = 0;
+
+    // Number of 64-bit words used by a single row
+    int32 WordsPerRow = 0;
+
+    // Packed cell bits, row-major
+    TArray<uint64> Words;
+};
+
+/**
+ * Grow a row-major array of per-cell values, moving cell (X, Y) to (X + Offset.X, Y + Offset.Y).
+ * Each old row moves with a single copy.
+ * @param Values Values of OldSizeX * OldSizeY cells, replaced by NewSizeX * NewSizeY cells
+ * @param Fill Value of the added cells
+ */
+template <typename ValueType>
+void ExpandGridValues(TArray<ValueType>& Values, int32 OldSizeX, int32 OldSizeY, int32 NewSizeX, int32 NewSizeY, const FIntPoint& Offset, const ValueType& Fill)
+{
+    static_assert(std::is_trivially_copyable_v<ValueType>, "Rows are moved with memcpy");
+    checkSlow(Offset.X >= 0 && Offset.Y >= 0 && NewSizeX >= OldSizeX + Offset.X && NewSizeY >= OldSizeY + Offset.Y);
+
+    TArray<ValueType> Expanded;
+    Expanded.Init(Fill, NewSizeX * NewSizeY);
+    for (int32 Y = 0; Y < OldSizeY; Y++)
+    {
+        FMemory::Memcpy(Expanded.GetData() + (Y + Offset.Y) * NewSizeX + Offset.X, Values.GetData() + Y * OldSizeX, OldSizeX * sizeof(ValueType));
+    }
+    Values = MoveTemp(Expanded);
+}
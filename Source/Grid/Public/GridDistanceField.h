@@ -0,0 +1,49 @@
+﻿// GridDistanceField.h - Walking distance from entrances over a grid floor
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FGridBitPlane;
+class FGridEdgeGrid;
+
+/**
+ * Walking distance in steps from a set of source cells to every reachable free cell of a floor.
+ * The breadth-first search advances whole rows of the frontier per step using the occupancy
+ * plane and the open-side masks of the edge grid, the same bit operations used by placement
+ * and room queries.
+ */
+class GRID_API FGridDistanceField
+{
+public:
+    // Distance stored for cells that cannot be reached
+    static constexpr uint16 Unreachable = MAX_uint16;
+
+    /**
+     * Recompute the field
+     * @param Occupancy Occupied cells of the floor, which cannot be walked through
+     * @param Edges Walls, doors and windows of the floor
+     * @param Sources Cells at distance zero
+     */
+    void Build(const FGridBitPlane& Occupancy, const FGridEdgeGrid& Edges, const TArray<FIntPoint>& Sources);
+
+    // Distance of a cell in steps, Unreachable if it cannot be reached or is out of bounds
+    FORCEINLINE uint16 GetDistance(int32 X, int32 Y) const
+    {
+        if (X < 0 || X >= SizeX || Y < 0 || Y >= SizeY)
+        {
+            return Unreachable;
+        }
+
+        return Distances[Y * SizeX + X];
+    }
+
+private:
+    // Number of cells in X dimension
+    int32 SizeX = 0;
+
+    // Number of cells in Y dimension
+    int32 SizeY = 0;
+
+    // Distance per cell, row-major
+    TArray<uint16> Distances;
+};
@@ -0,0 +1,93 @@
+﻿// GridEdgeGrid.h - Bit-packed walls, doors and windows between grid cells
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EGridTypes.h"
+#include "GridBitPlane.h"
+
+/**
+ * Companion to the cell grid of a floor that stores elements placed between cells.
+ * Horizontal edges run along X and separate a cell from its northern neighbour; the plane has
+ * SizeY + 1 rows so the southern border is included. Vertical edges run along Y and separate a
+ * cell from its western neighbour; the plane has SizeX + 1 columns. Each element type has its
+ * own bit plane, so queries combine planes the same way occupancy queries do.
+ */
+class GRID_API FGridEdgeGrid
+{
+public:
+    /**
+     * Resize the edge planes for a floor and clear every edge
+     * @param InSizeX Number of cells in X direction
+     * @param InSizeY Number of cells in Y direction
+     */
+    void Init(int32 InSizeX, int32 InSizeY);
+
+    /**
+     * Grow the floor, keeping every edge; added edges are empty
+     * @param NewSizeX Number of cells in X direction
+     * @param NewSizeY Number of cells in Y direction
+     * @param Offset Amount every existing cell moves by
+     */
+    void Expand(int32 NewSizeX, int32 NewSizeY, const FIntPoint& Offset);
+
+    /**
+     * Get the element on one side of a cell
+     * @param Cell Grid position
+     * @param Side Side of the cell (Any is not supported)
+     * @return Element type or None
+     */
+    EGridEdgeType GetEdge(const FIntPoint& Cell, EGridDirection Side) const;
+
+    /**
+     * Set the element on one side of a cell, replacing what was there
+     * @param Cell Grid position
+     * @param Side Side of the cell (Any is not supported)
+     * @param EdgeType Element to store, None clears the edge
+     * @return True if the edge exists
+     */
+    bool SetEdge(const FIntPoint& Cell, EGridDirection Side, EGridEdgeType EdgeType);
+
+    // True if any element (wall, door or window) sits on the side, which separates rooms
+    bool SeparatesRooms(const FIntPoint& Cell, EGridDirection Side) const;
+
+    // True if walls or windows sit on the side, which agents cannot walk through
+    bool BlocksMovement(const FIntPoint& Cell, EGridDirection Side) const;
+
+    // True if walls or doors sit on the side, which cannot be seen through
+    bool BlocksSight(const FIntPoint& Cell, EGridDirection Side) const;
+
+    /**
+     * Build a row mask of cells whose side is open, in the same layout as FGridBitPlane rows
+     * @param Y Row of cells
+     * @param Side Side of the cells to test
+     * @param bForMovement True to only treat walls and windows as closed, false to treat every element as closed
+     * @param OutWords Output words, must hold WordsPerRow entries of a cell plane
+     */
+    void GetOpenSideRow(int32 Y, EGridDirection Side, bool bForMovement, uint64* OutWords) const;
+
+    FORCEINLINE int32 GetSizeX() const { return SizeX; }
+    FORCEINLINE int32 GetSizeY() const { return SizeY; }
+
+private:
+    // Edge plane orientation
+    enum EEdgeAxis : int32
+    {
+        Horizontal = 0,
+        Vertical = 1
+    };
+
+    // Element type slot in the plane array (None has no plane)
+    static FORCEINLINE int32 TypeSlot(EGridEdgeType EdgeType) { return static_cast<int32>(EdgeType) - 1; }
+
+    // Map a cell side to the plane and coordinates that store it
+    bool ResolveEdge(const FIntPoint& Cell, EGridDirection Side, int32& OutAxis, int32& OutX, int32& OutY) const;
+
+    // Number of cells in X dimension
+    int32 SizeX = 0;
+
+    // Number of cells in Y dimension
+    int32 SizeY = 0;
+
+    // One plane per axis and element type: [Axis][Wall, Door, Window]
+    FGridBitPlane Planes[2][3];
+};
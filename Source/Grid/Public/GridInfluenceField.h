@@ -0,0 +1,78 @@
+﻿// GridInfluenceField.h - Per-floor ambience fields updated by building kernels
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EGridTypes.h"
+
+/**
+ * Float fields for each influence channel of a single floor.
+ * Buildings stamp a blurred copy of their footprint, scaled so it peaks at the emitter strength,
+ * into the field when placed and subtract the identical stamp when removed, so only the region
+ * within the kernel radius is touched.
+ * The blur is separable (one horizontal and one vertical 1D pass) and runs four cells at a time.
+ */
+class GRID_API FGridInfluenceField
+{
+public:
+    /**
+     * Resize the fields for a floor and clear them
+     * @param InSizeX Number of cells in X direction
+     * @param InSizeY Number of cells in Y direction
+     */
+    void Init(int32 InSizeX, int32 InSizeY);
+
+    /**
+     * Grow the fields, keeping every value; added cells start at zero.
+     * Kernels clipped by the old bounds are not extended, the caller re-applies them.
+     * @param NewSizeX Number of cells in X direction
+     * @param NewSizeY Number of cells in Y direction
+     * @param Offset Amount every existing cell moves by
+     */
+    void Expand(int32 NewSizeX, int32 NewSizeY, const FIntPoint& Offset);
+
+    /**
+     * Add or subtract an emitter kernel around a footprint
+     * @param FootprintCells Cells covered by the building
+     * @param Emitter Channel, strength and radius of the kernel
+     * @param Sign +1 when placing the building, -1 when removing it
+     */
+    void ApplyEmitter(const TArray<FIntPoint>& FootprintCells, const FBuildingInfluenceEmitter& Emitter, float Sign);
+
+    // Read the value of a channel at a cell (0 outside the floor)
+    FORCEINLINE float GetValue(EGridInfluenceChannel Channel, int32 X, int32 Y) const
+    {
+        if (X < 0 || X >= SizeX || Y < 0 || Y >= SizeY)
+        {
+            return 0.0f;
+        }
+
+        return Values[static_cast<int32>(Channel)][Y * SizeX + X];
+    }
+
+    // Direct access to a channel, row-major with SizeX values per row
+    FORCEINLINE const TArray<float>& GetChannel(EGridInfluenceChannel Channel) const { return Values[static_cast<int32>(Channel)]; }
+
+    FORCEINLINE int32 GetSizeX() const { return SizeX; }
+    FORCEINLINE int32 GetSizeY() const { return SizeY; }
+
+    // Number of channels stored per floor
+    static constexpr int32 NumChannels = static_cast<int32>(EGridInfluenceChannel::Count);
+
+private:
+    // Fill a 1D falloff kernel of Radius * 2 + 1 weights, peaking at 1 in the middle
+    static void BuildKernel(int32 Radius, TArray<float>& OutWeights);
+
+    // Number of cells in X dimension
+    int32 SizeX = 0;
+
+    // Number of cells in Y dimension
+    int32 SizeY = 0;
+
+    // Field values per channel
+    TArray<float> Values[NumChannels];
+
+    // Scratch buffers reused between stamps
+    TArray<float> MaskScratch;
+    TArray<float> BlurScratch;
+    TArray<float> KernelScratch;
+};
@@ -0,0 +1,39 @@
+﻿// GridNavModifierComponent.h - Navigation modifiers generated from grid occupancy
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NavRelevantComponent.h"
+#include "GridNavModifierComponent.generated.h"
+
+/**
+ * Marks the occupied ground floor cells of one chunk of the grid with the grid's occupied navigation area.
+ * The grid manager owns one component per chunk, so navigation follows the grid instead of building
+ * collision, and an occupancy change only dirties the bounds of the chunks it touched.
+ */
+UCLASS(ClassGroup = (Grid))
+class GRID_API UGridNavModifierComponent : public UNavRelevantComponent
+{
+    GENERATED_BODY()
+
+public:
+    UGridNavModifierComponent(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+    /**
+     * Set the cells covered by this component
+     * @param InCells Cells of the ground floor (Min inclusive, Max exclusive)
+     */
+    void SetCells(const FIntRect& InCells);
+
+    // Cells covered by this component
+    FORCEINLINE const FIntRect& GetCells() const { return Cells; }
+
+    // INavRelevantInterface
+    virtual void GetNavigationData(FNavigationRelevantData& Data) const override;
+
+protected:
+    // UNavRelevantComponent
+    virtual void CalcAndCacheBounds() const override;
+
+    // Cells of the ground floor covered by this component
+    FIntRect Cells;
+};
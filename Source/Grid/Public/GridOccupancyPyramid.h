@@ -0,0 +1,78 @@
+﻿// GridOccupancyPyramid.h - Multi-resolution occupancy of a floor for coarse area tests
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridBitPlane.h"
+
+/**
+ * Occupancy of a block of cells as seen from a coarse level
+ */
+enum class EGridBlockState : uint8
+{
+    Free,
+    Partial,
+    Full
+};
+
+/**
+ * Mip pyramid over a floor's occupancy plane. Level k counts the occupied cells of every
+ * 2^k x 2^k block, up to a single block covering the whole floor; level 0 is the plane itself.
+ * A count of zero means the block is free and a count equal to its area means it is full, so area
+ * queries only descend into partial blocks that straddle the edge of the queried rectangle.
+ * A changed cell updates one count per level, along the path from the cell to the root.
+ */
+class GRID_API FGridOccupancyPyramid
+{
+public:
+    /**
+     * Resize the pyramid for a floor and count the occupied cells of a plane
+     * @param Occupancy Occupancy plane of the floor
+     */
+    void Build(const FGridBitPlane& Occupancy);
+
+    /**
+     * Record that a cell became occupied or free
+     * @param X Column of the cell
+     * @param Y Row of the cell
+     * @param bOccupied New occupancy of the cell
+     */
+    void OnCellChanged(int32 X, int32 Y, bool bOccupied);
+
+    /**
+     * Get the occupancy of a rectangle of cells
+     * @param Occupancy Occupancy plane the pyramid was built for, read for single cells
+     * @param Rect Cells to test (Min inclusive, Max exclusive), clipped to the floor
+     * @return Free if no cell is occupied, Full if every cell is, Partial otherwise
+     */
+    EGridBlockState GetRectState(const FGridBitPlane& Occupancy, const FIntRect& Rect) const;
+
+    // Number of coarse levels above the occupancy plane
+    FORCEINLINE int32 GetNumLevels() const { return Levels.Num(); }
+
+    // State of one block of a level, 1 to GetNumLevels()
+    EGridBlockState GetBlockState(int32 Level, int32 BlockX, int32 BlockY) const;
+
+private:
+    // Occupied cell counts of one level, row-major
+    struct FLevel
+    {
+        int32 SizeX = 0;
+        int32 SizeY = 0;
+        TArray<int32> Counts;
+    };
+
+    // Number of cells of a block, smaller for blocks cut by the floor's edge
+    int32 GetBlockArea(int32 Level, int32 BlockX, int32 BlockY) const;
+
+    // Visit the blocks of a level overlapping a rectangle, descending into partial blocks on its edge
+    void AccumulateRectState(const FGridBitPlane& Occupancy, const FIntRect& Rect, int32 Level, int32 BlockX, int32 BlockY, bool& bAnyFree, bool& bAnyOccupied) const;
+
+    // Number of cells in X dimension
+    int32 SizeX = 0;
+
+    // Number of cells in Y dimension
+    int32 SizeY = 0;
+
+    // Levels 1 and up, Levels[0] holds 2x2 blocks
+    TArray<FLevel> Levels;
+};
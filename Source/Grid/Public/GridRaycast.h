@@ -0,0 +1,88 @@
+﻿// GridRaycast.h - Line of sight over the cells and edges of a floor
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridBitPlane.h"
+
+class FGridEdgeGrid;
+
+/**
+ * Segment cast over a floor in cell units; cell (X, Y) covers [X, X + 1) x [Y, Y + 1).
+ * Heights are only used by 2.5D casts, in world units relative to the grid plane.
+ */
+struct FGridRay
+{
+    FVector2D Start = FVector2D::ZeroVector;
+    FVector2D End = FVector2D::ZeroVector;
+    float StartHeight = 0.0f;
+    float EndHeight = 0.0f;
+};
+
+/**
+ * Result of a grid ray
+ */
+struct FGridRayHit
+{
+    // True if the ray was stopped before its end
+    bool bBlocked = false;
+
+    // Blocking cell, or the last cell reached when an edge or the floor's border stopped the ray
+    FIntPoint Cell = FIntPoint(INDEX_NONE, INDEX_NONE);
+
+    // Fraction of the ray travelled, 1 if it reached its end
+    float Time = 1.0f;
+
+    // Sum of the value field over the cells the ray saw, the start cell included
+    float VisibleValue = 0.0f;
+};
+
+/**
+ * Marches rays cell by cell with a DDA (Amanatides-Woo) walk, so a ray costs one step per crossed
+ * cell boundary and never touches physics. Sight-blocking edges always stop a ray, they stand on the
+ * floor the rays travel along. In 2D any blocking cell stops it too; in 2.5D a cell only stops it where
+ * the ray passes below the cell's height. The caster only reads the planes it was given, so any number
+ * of rays can be cast at once while the planes do not change.
+ */
+class GRID_API FGridRaycaster
+{
+public:
+    /**
+     * @param InBlocking Cells that block sight in 2D, usually the floor's occupancy; its size bounds every ray
+     * @param InEdges Walls and doors of the floor block sight, windows do not
+     */
+    FGridRaycaster(const FGridBitPlane& InBlocking, const FGridEdgeGrid& InEdges);
+
+    // Cast in 2.5D over the top of whatever stands on each cell relative to the grid plane, row-major, must outlive the caster
+    FORCEINLINE void SetHeights(const TArray<float>* InHeights) { Heights = InHeights; }
+
+    // Sum a per-cell value over the cells each ray sees, row-major, must outlive the caster
+    FORCEINLINE void SetValues(const TArray<float>* InValues) { Values = InValues; }
+
+    /**
+     * March a single ray. Its start and end cells never block, so rays can leave and reach occupied cells.
+     * @param Ray Segment to cast
+     * @param OutHit Where and why the ray stopped
+     * @return True if the ray reached its end
+     */
+    bool Cast(const FGridRay& Ray, FGridRayHit& OutHit) const;
+
+    /**
+     * Cast many rays on worker threads
+     * @param Rays Segments to cast
+     * @param OutHits One hit per ray, in the same order
+     */
+    void CastBatch(TConstArrayView<FGridRay> Rays, TArray<FGridRayHit>& OutHits) const;
+
+private:
+    // Rays cast by one task of a batch
+    static constexpr int32 RaysPerTask = 64;
+
+    const FGridBitPlane& Blocking;
+    const FGridEdgeGrid& Edges;
+
+    // Cell heights for 2.5D casts, nullptr for 2D
+    const TArray<float>* Heights = nullptr;
+
+    // Summed over visible cells, nullptr for none
+    const TArray<float>* Values = nullptr;
+};
@@ -0,0 +1,162 @@
+﻿// GridRoomIndex.h - Incremental room detection for a single grid floor
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EGridTypes.h"
+
+struct FGridBitPlane;
+class FGridEdgeGrid;
+
+/**
+ * Labels every free cell of a floor with the room it belongs to.
+ * Rooms are 4-connected regions of free cells that are not separated by an element on the
+ * edge between them. After the initial build the labels are only
+ * updated around changed cells: blocking cells splits the touched room, freeing cells merges
+ * the rooms around them into the largest neighbour, so the cost follows the size of the rooms
+ * involved instead of the size of the floor.
+ */
+class GRID_API FGridRoomIndex
+{
+public:
+    /**
+     * Label the whole floor from scratch
+     * @param Blocked Plane with a bit set for every cell that separates rooms
+     * @param Edges Walls, doors and windows of the floor
+     */
+    void Rebuild(const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges);
+
+    /**
+     * Grow the floor, keeping every room. Added cells are labelled like freed cells, joining the rooms
+     * they touch, and cells that stop being on the outer edge no longer count towards it.
+     * @param Offset Amount every existing cell moves by
+     * @param Blocked Blocking plane, already grown
+     * @param Edges Walls, doors and windows of the floor, already grown
+     */
+    void Expand(const FIntPoint& Offset, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges);
+
+    /**
+     * Update labels after cells became blocked. Blocked must already contain the new cells.
+     * @param Cells Cells that were blocked
+     * @param Blocked Updated blocking plane
+     * @param Edges Walls, doors and windows of the floor
+     */
+    void OnCellsBlocked(const TArray<FIntPoint>& Cells, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges);
+
+    /**
+     * Update labels after cells became free. Blocked must already have the cells cleared.
+     * @param Cells Cells that were freed
+     * @param Blocked Updated blocking plane
+     * @param Edges Walls, doors and windows of the floor
+     */
+    void OnCellsFreed(const TArray<FIntPoint>& Cells, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges);
+
+    /**
+     * Update labels after an element was placed on a previously open edge
+     * @param Cell Cell on one side of the edge
+     * @param Side Side of the cell the edge lies on
+     * @param Blocked Blocking plane
+     * @param Edges Updated edge grid
+     */
+    void OnEdgeClosed(const FIntPoint& Cell, EGridDirection Side, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges);
+
+    /**
+     * Update labels after the element on an edge was removed
+     * @param Cell Cell on one side of the edge
+     * @param Side Side of the cell the edge lies on
+     * @param Blocked Blocking plane
+     * @param Edges Updated edge grid
+     */
+    void OnEdgeOpened(const FIntPoint& Cell, EGridDirection Side, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges);
+
+    /**
+     * Get the room a cell belongs to
+     * @param Cell Grid position
+     * @return Room id or INDEX_NONE if the cell is blocked or out of bounds
+     */
+    int32 GetRoomId(const FIntPoint& Cell) const;
+
+    /**
+     * Get the summary of a room
+     * @param RoomId Room to query
+     * @param OutInfo Output room summary
+     * @return True if the room exists
+     */
+    bool GetRoomInfo(int32 RoomId, FGridRoomInfo& OutInfo) const;
+
+    // Rooms created, resized or removed since the last call to ResetChangedRooms
+    const TArray<int32>& GetChangedRooms() const { return ChangedRooms; }
+
+    // Clear the list of changed rooms
+    void ResetChangedRooms() { ChangedRooms.Reset(); }
+
+private:
+    // Bookkeeping for a single room
+    struct FRoomRecord
+    {
+        int32 CellCount = 0;
+        int32 BorderCellCount = 0;
+        bool bInUse = false;
+    };
+
+    // Get a free room id
+    int32 AllocateRoom();
+
+    // Return a room id to the free list
+    void ReleaseRoom(int32 RoomId);
+
+    // Flag a room as changed
+    void MarkRoomChanged(int32 RoomId);
+
+    // Start a new visit pass over the scratch stamps
+    void BeginVisit();
+
+    // Check and set the visit stamp of a cell
+    FORCEINLINE bool IsVisited(int32 Index) const { return VisitStamps[Index] == CurrentStamp; }
+    FORCEINLINE void MarkVisited(int32 Index) { VisitStamps[Index] = CurrentStamp; }
+
+    // True if the cell lies on the outer edge of the floor
+    FORCEINLINE bool IsBorderCell(int32 Index) const
+    {
+        const int32 X = Index % SizeX;
+        const int32 Y = Index / SizeX;
+        return X == 0 || Y == 0 || X == SizeX - 1 || Y == SizeY - 1;
+    }
+
+    // Get the neighbour in a direction if a room can extend into it
+    bool GetLinkedNeighbour(int32 Index, int32 Direction, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges, int32& OutNeighbour) const;
+
+    // Flood a fresh room from an unlabelled free cell
+    void FloodNewRoom(int32 SeedIndex, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges);
+
+    // Split a room that lost cells, starting from the free cells around the change
+    void SplitRoom(int32 RoomId, const TArray<int32>& Seeds, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges);
+
+    // Relabel all cells of a room into another one and release it
+    void AbsorbRoom(int32 TargetRoom, int32 RoomId, int32 SeedIndex, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges);
+
+    // Label a freed cell and merge the rooms around it
+    void MergeAround(int32 SeedIndex, const FGridBitPlane& Blocked, const FGridEdgeGrid& Edges);
+
+    // Floor dimensions
+    int32 SizeX = 0;
+    int32 SizeY = 0;
+
+    // Room id per cell (INDEX_NONE for blocked cells)
+    TArray<int32> Labels;
+
+    // Room records indexed by room id
+    TArray<FRoomRecord> Rooms;
+
+    // Room ids available for reuse
+    TArray<int32> FreeRoomIds;
+
+    // Rooms touched since the last reset
+    TArray<int32> ChangedRooms;
+
+    // Scratch visit stamps, avoids clearing a visited array for every flood
+    TArray<uint32> VisitStamps;
+    uint32 CurrentStamp = 0;
+
+    // Scratch owner of each visited cell while splitting
+    TArray<int32> VisitOwners;
+};
@@ -0,0 +1,130 @@
+﻿// GridStamp.h - Captured multi-building layouts for copy and paste
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EGridTypes.h"
+#include "GridBitPlane.h"
+#include "GridStamp.generated.h"
+
+class UBuildingObjectAsset;
+
+/**
+ * One building of a stamp, relative to the stamp origin
+ */
+USTRUCT(BlueprintType)
+struct GRID_API FBuildingStampEntry
+{
+    GENERATED_BODY()
+
+    // Asset the building was placed from
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stamp")
+    UBuildingObjectAsset* BuildingAsset = nullptr;
+
+    // Grid origin of the building relative to the stamp origin
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stamp")
+    FIntPoint Offset = FIntPoint::ZeroValue;
+
+    // Rotation of the building in quarters (0-3)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stamp")
+    int32 Rotation = 0;
+
+    // Floor of the building above the floor the stamp is placed on
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stamp")
+    int32 FloorOffset = 0;
+};
+
+/**
+ * Buildings captured from a region of the grid, placed again as a whole.
+ * Entries are sorted by floor so lower floors are always placed first.
+ */
+USTRUCT(BlueprintType)
+struct GRID_API FBuildingStamp
+{
+    GENERATED_BODY()
+
+    // Buildings of the stamp
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stamp")
+    TArray<FBuildingStampEntry> Entries;
+
+    // Size of the captured region in cells
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stamp")
+    FIntPoint Size = FIntPoint::ZeroValue;
+
+    // Number of floors the stamp spans
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stamp")
+    int32 NumFloors = 0;
+
+    // True if the stamp holds no buildings
+    bool IsEmpty() const { return Entries.Num() == 0; }
+};
+
+/**
+ * A stamp rasterized for all four rotations, so previewing it under the cursor only moves masks.
+ * Every rotation holds a combined footprint mask per floor for the occupancy test, the part of it
+ * that is not standing on the stamp's own floor below for the support test, and a mask per entry
+ * for zoning. Masks are positioned with MoveTo, which only shifts their Min.
+ */
+struct GRID_API FCompiledBuildingStamp
+{
+    // A stamp entry turned with the stamp
+    struct FRotatedEntry
+    {
+        // Index into the source stamp's entries
+        int32 EntryIndex = INDEX_NONE;
+
+        // Building origin relative to the stamp origin and building rotation
+        FIntPoint Offset = FIntPoint::ZeroValue;
+        int32 Rotation = 0;
+
+        // Footprint of the building
+        FGridFootprintMask Mask;
+    };
+
+    // All cells of one floor of a rotated stamp
+    struct FRotatedFloor
+    {
+        // Every footprint cell on the floor
+        FGridFootprintMask Mask;
+
+        // Footprint cells that need support from the grid, i.e. not above the stamp's floor below
+        FGridFootprintMask SupportMask;
+
+        // Footprint cells relative to the stamp origin, for previews
+        TArray<FIntPoint> Cells;
+
+        // Building type of each footprint cell relative to the stamp origin, for adjacency checks
+        TMap<FIntPoint, EBuildingType> CellTypes;
+    };
+
+    // One of the four rotations
+    struct FRotation
+    {
+        TArray<FRotatedEntry> Entries;
+        TArray<FRotatedFloor> Floors;
+
+        // Grid position the masks are currently moved to
+        FIntPoint Origin = FIntPoint::ZeroValue;
+
+        // True if turning made two footprints of the stamp overlap, e.g. non-square default footprints
+        bool bOverlaps = false;
+    };
+
+    // Rasterize a stamp for every rotation
+    void Compile(const FBuildingStamp& InStamp);
+
+    // Move the masks of a rotation so the stamp origin lies on a grid position
+    void MoveTo(int32 Rotation, const FIntPoint& Origin);
+
+    // Rotated data, Rotation is taken modulo 4
+    FORCEINLINE const FRotation& GetRotation(int32 Rotation) const { return Rotations[Rotation & 3]; }
+
+    // The stamp this was compiled from
+    FORCEINLINE const FBuildingStamp& GetStamp() const { return Stamp; }
+
+    // True if there is nothing to place
+    FORCEINLINE bool IsEmpty() const { return Stamp.IsEmpty(); }
+
+private:
+    FBuildingStamp Stamp;
+    FRotation Rotations[4];
+};
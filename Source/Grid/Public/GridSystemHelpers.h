@@ -2,7 +2,7 @@
 #pragma once
 
 // Include all grid system headers
-#include "GridTypes.h"
+#include "EGridTypes.h"
 #include "BuildingGridManager.h"
 #include "BuildingObjectAsset.h"
 #include "BuildingObject.h"
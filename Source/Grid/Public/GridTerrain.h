@@ -0,0 +1,112 @@
+﻿// GridTerrain.h - Ground height and slope under the grid, sampled once from the level
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridBitPlane.h"
+
+/**
+ * Ground under every cell of the ground floor, relative to the grid plane.
+ * Heights are kept in whole centimetres (int16, about +-327 m around the grid) and slopes in
+ * whole degrees rounded up (uint8), so a large site costs three bytes per cell.
+ * Placement limits are answered by suitability planes: for a window size and a pair of limits,
+ * one bit per window position tells whether the window is flat enough. A plane is built with
+ * sliding-window minimum and maximum passes, a constant amortized cost per cell whatever the
+ * window size, and kept until the terrain changes.
+ */
+class GRID_API FGridTerrain
+{
+public:
+    /**
+     * Sample the ground under every cell
+     * @param InSizeX Number of cells in X direction
+     * @param InSizeY Number of cells in Y direction
+     * @param InCellSize Size of a cell in world units, the run of the slopes
+     * @param SampleHeight Ground height of a cell relative to the grid plane
+     */
+    void Init(int32 InSizeX, int32 InSizeY, float InCellSize, TFunctionRef<float(int32 X, int32 Y)> SampleHeight);
+
+    /**
+     * Grow the terrain, keeping every sample; only the added cells are sampled
+     * @param NewSizeX Number of cells in X direction
+     * @param NewSizeY Number of cells in Y direction
+     * @param Offset Amount every existing cell moves by
+     * @param SampleHeight Ground height of a cell of the grown grid relative to the grid plane
+     */
+    void Expand(int32 NewSizeX, int32 NewSizeY, const FIntPoint& Offset, TFunctionRef<float(int32 X, int32 Y)> SampleHeight);
+
+    // Forget every sample, the grid is flat again
+    void Reset();
+
+    // True if the ground was sampled
+    FORCEINLINE bool IsSampled() const { return Heights.Num() > 0; }
+
+    // Ground height of a cell in world units relative to the grid plane, 0 outside the terrain
+    FORCEINLINE float GetHeight(int32 X, int32 Y) const
+    {
+        return IsValidCell(X, Y) ? static_cast<float>(Heights[Y * SizeX + X]) : 0.0f;
+    }
+
+    // Ground slope of a cell in degrees, 0 outside the terrain
+    FORCEINLINE float GetSlope(int32 X, int32 Y) const
+    {
+        return IsValidCell(X, Y) ? static_cast<float>(Slopes[Y * SizeX + X]) : 0.0f;
+    }
+
+    /**
+     * Get the window positions where the ground is flat enough. The plane is cached until the terrain changes.
+     * @param WindowSize Size of the window in cells
+     * @param MaxSlope Steepest slope allowed in any cell of the window in degrees, 0 for any
+     * @param MaxHeightDelta Largest height difference allowed between cells of the window, 0 for any
+     * @return Plane with a bit set at the minimum corner of every window inside the terrain that meets both limits
+     */
+    const FGridBitPlane& GetSuitablePlane(const FIntPoint& WindowSize, float MaxSlope, float MaxHeightDelta) const;
+
+    FORCEINLINE int32 GetSizeX() const { return SizeX; }
+    FORCEINLINE int32 GetSizeY() const { return SizeY; }
+
+private:
+    // Suitability plane for one window size and pair of limits
+    struct FSuitablePlane
+    {
+        FIntPoint WindowSize;
+        int32 MaxSlope = 0;
+        int32 MaxHeightDelta = 0;
+        FGridBitPlane Plane;
+    };
+
+    // Number of suitability planes kept, one per footprint size and limits in use
+    static constexpr int32 MaxSuitablePlanes = 16;
+
+    FORCEINLINE bool IsValidCell(int32 X, int32 Y) const
+    {
+        return X >= 0 && X < SizeX && Y >= 0 && Y < SizeY;
+    }
+
+    // Limits in the stored units, rounded towards stricter; MAX_int32 when unlimited
+    static int32 QuantizeSlopeLimit(float MaxSlope);
+    static int32 QuantizeHeightLimit(float MaxHeightDelta);
+
+    // Store the sampled height of a cell
+    void StoreHeight(int32 X, int32 Y, float Height);
+
+    // Recompute the slope of every cell in a rectangle from its neighbours' heights
+    void UpdateSlopes(const FIntRect& Rect);
+
+    // Number of cells in X dimension
+    int32 SizeX = 0;
+
+    // Number of cells in Y dimension
+    int32 SizeY = 0;
+
+    // Horizontal distance between neighbouring samples
+    float CellSize = 100.0f;
+
+    // Ground height per cell in centimetres, row-major
+    TArray<int16> Heights;
+
+    // Ground slope per cell in degrees, row-major
+    TArray<uint8> Slopes;
+
+    // Recently used suitability planes, oldest first
+    mutable TArray<FSuitablePlane> SuitablePlanes;
+};
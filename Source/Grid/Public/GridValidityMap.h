@@ -0,0 +1,106 @@
+﻿// GridValidityMap.h - Placement validity of every origin, built on background tasks
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Task.h"
+#include "GridBitPlane.h"
+
+class UBuildingObjectAsset;
+
+/**
+ * Copy of everything needed to decide where a footprint fits on one floor.
+ * Owns its planes, so a validity map can be built from it on any thread while the grid changes.
+ */
+struct GRID_API FGridValiditySnapshot
+{
+    // Footprint cells relative to the building origin
+    FGridFootprintMask Footprint;
+
+    // Occupied cells of the floor
+    FGridBitPlane Occupancy;
+
+    // Occupied cells of the floor below, only used if bNeedsSupport
+    FGridBitPlane Support;
+    bool bNeedsSupport = false;
+
+    // Cells in one of the building's allowed zones, only used if bZoned
+    FGridBitPlane AllowedZones;
+    bool bZoned = false;
+
+    // Positions of the footprint bounds' minimum corner where the ground is flat enough, only used if bTerrainLimited
+    FGridBitPlane SuitableTerrain;
+    bool bTerrainLimited = false;
+
+    /**
+     * Test the footprint at every origin of the floor
+     * @return Plane with a bit set for every origin where the footprint is in bounds, free, supported, zoned and on suitable ground
+     */
+    FGridBitPlane Build() const;
+};
+
+/**
+ * Identifies a validity map; maps of older grid versions are never returned
+ */
+struct FGridValidityKey
+{
+    TWeakObjectPtr<const UBuildingObjectAsset> Asset;
+    int32 Rotation = 0;
+    int32 FloorLevel = 0;
+    uint32 Version = 0;
+
+    bool operator==(const FGridValidityKey& Other) const
+    {
+        return Asset == Other.Asset && Rotation == Other.Rotation && FloorLevel == Other.FloorLevel && Version == Other.Version;
+    }
+};
+
+/**
+ * Small least-recently-used cache of validity maps.
+ * Requested maps are built on background tasks; lookups never wait for a task, they simply miss
+ * until it has finished. Entries of an older grid version are evicted first.
+ */
+class GRID_API FGridValidityCache
+{
+public:
+    explicit FGridValidityCache(int32 InCapacity = 12)
+        : Capacity(FMath::Max(1, InCapacity))
+    {
+    }
+
+    /**
+     * Get a finished validity map and mark it as recently used
+     * @param Key Map to look up
+     * @return The map, or nullptr if it was not requested or is still being built
+     */
+    const FGridBitPlane* Find(const FGridValidityKey& Key);
+
+    // True if the map is finished or being built
+    bool Contains(const FGridValidityKey& Key) const;
+
+    /**
+     * Start building a map unless it is cached already, evicting the least useful entry if full
+     * @param Key Map to build
+     * @param Snapshot Inputs of the map, moved into the task
+     */
+    void Request(const FGridValidityKey& Key, FGridValiditySnapshot&& Snapshot);
+
+    // Drop every entry; running tasks finish on their own and their results are discarded
+    void Reset();
+
+    // Number of cached maps, finished or not
+    FORCEINLINE int32 Num() const { return Entries.Num(); }
+
+private:
+    struct FEntry
+    {
+        FGridValidityKey Key;
+        UE::Tasks::TTask<FGridBitPlane> Task;
+        uint64 LastUse = 0;
+    };
+
+    TArray<FEntry> Entries;
+    int32 Capacity;
+
+    // Incremented on every lookup and request, orders entries by recency
+    uint64 UseCounter = 0;
+};
@@ -0,0 +1,121 @@
+﻿// GridZoneLayer.h - Zone painting and queries for a single grid floor
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EGridTypes.h"
+#include "GridBitPlane.h"
+
+/**
+ * Horizontal run of cells sharing the same zone
+ */
+struct FGridZoneRun
+{
+    // First column of the run
+    int32 StartX = 0;
+
+    // Number of cells in the run
+    int32 Length = 0;
+
+    // Zone of every cell in the run
+    EGridZone Zone = EGridZone::None;
+};
+
+/**
+ * Zone of every cell of a floor, kept in three equivalent forms:
+ * a byte per cell for point lookups, one bit plane per zone for footprint tests, and a
+ * run-length list per row for painting and for iterating all cells of a zone.
+ * Painting always happens as row spans, which are spliced into the run lists.
+ */
+class GRID_API FGridZoneLayer
+{
+public:
+    // Number of zone values, including unzoned
+    static constexpr int32 NumZones = static_cast<int32>(EGridZone::Count);
+
+    /**
+     * Resize the layer for a floor and mark every cell unzoned
+     * @param InSizeX Number of cells in X direction
+     * @param InSizeY Number of cells in Y direction
+     */
+    void Init(int32 InSizeX, int32 InSizeY);
+
+    /**
+     * Grow the layer, keeping every zone; added cells are unzoned
+     * @param NewSizeX Number of cells in X direction
+     * @param NewSizeY Number of cells in Y direction
+     * @param Offset Amount every existing cell moves by
+     */
+    void Expand(int32 NewSizeX, int32 NewSizeY, const FIntPoint& Offset);
+
+    /**
+     * Paint a rectangle of cells
+     * @param Rect Cells to paint (Min inclusive, Max exclusive), clipped to the floor
+     * @param Zone Zone to assign
+     */
+    void PaintRect(const FIntRect& Rect, EGridZone Zone);
+
+    /**
+     * Paint a filled circle of cells
+     * @param Center Center cell of the brush
+     * @param Radius Brush radius in cells
+     * @param Zone Zone to assign
+     */
+    void PaintBrush(const FIntPoint& Center, int32 Radius, EGridZone Zone);
+
+    // Zone of a single cell, None outside the floor
+    FORCEINLINE EGridZone GetZone(int32 X, int32 Y) const
+    {
+        if (X < 0 || X >= SizeX || Y < 0 || Y >= SizeY)
+        {
+            return EGridZone::None;
+        }
+
+        return static_cast<EGridZone>(Zones[Y * SizeX + X]);
+    }
+
+    /**
+     * Check that every footprint cell lies in one of the allowed zones
+     * @param Mask Footprint to test
+     * @param AllowedZoneBits Bit mask of allowed zones, indexed by EGridZone
+     * @return True if the footprint is fully inside the allowed zones
+     */
+    bool IsFootprintInZones(const FGridFootprintMask& Mask, int32 AllowedZoneBits) const;
+
+    /**
+     * Visit every run of cells in a zone
+     * @param Zone Zone to iterate
+     * @param Visitor Called with the row, first column and length of each run
+     */
+    void ForEachRun(EGridZone Zone, TFunctionRef<void(int32 Y, int32 StartX, int32 Length)> Visitor) const;
+
+    // Number of cells in a zone
+    int32 CountCells(EGridZone Zone) const;
+
+    // Union of the bit planes of the allowed zones, e.g. for testing footprints away from the layer
+    void GetAllowedPlane(int32 AllowedZoneBits, FGridBitPlane& OutPlane) const;
+
+    // Bit plane of the cells in a zone
+    FORCEINLINE const FGridBitPlane& GetZonePlane(EGridZone Zone) const { return ZonePlanes[static_cast<int32>(Zone)]; }
+
+private:
+    // Assign a zone to the columns [StartX, EndX) of a row
+    void PaintRowSpan(int32 Y, int32 StartX, int32 EndX, EGridZone Zone);
+
+    // Number of cells in X dimension
+    int32 SizeX = 0;
+
+    // Number of cells in Y dimension
+    int32 SizeY = 0;
+
+    // Zone per cell, row-major
+    TArray<uint8> Zones;
+
+    // One bit plane per zone
+    FGridBitPlane ZonePlanes[NumZones];
+
+    // Sorted, non-overlapping runs covering each row completely
+    TArray<TArray<FGridZoneRun>> RowRuns;
+
+    // Number of cells per zone
+    int32 CellCounts[NumZones] = {};
+};
@@ -0,0 +1,318 @@
+﻿// AgentLODSubsystem.cpp - Implementation of the agent simulation tiers
+#include "AgentLODSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/PlayerController.h"
+#include "Algo/BinarySearch.h"
+#include "TopDownCameraController.h"
+
+void UAgentLODSubsystem::Deinitialize()
+{
+    // Agents keep working without the subsystem
+    for (int32 AgentId = 0; AgentId < Agents.Num(); AgentId++)
+    {
+        if (AActor* Actor = Agents[AgentId].Actor.Get())
+        {
+            Actor->SetActorHiddenInGame(false);
+            SetAgentTicking(Agents[AgentId], true);
+        }
+    }
+
+    Agents.Reset();
+    FreeAgentIds.Reset();
+    Arrivals.Reset();
+
+    Super::Deinitialize();
+}
+
+void UAgentLODSubsystem::Tick(float DeltaTime)
+{
+    const double Now = GetWorld()->GetTimeSeconds();
+
+    if (Now >= NextTierUpdateTime)
+    {
+        UpdateTiers(Now);
+        NextTierUpdateTime = Now + TierUpdateInterval;
+    }
+
+    // Full agents steer themselves and statistical ones cost nothing until they are seen or arrive,
+    // so only the reduced tier is moved here
+    for (FLODAgent& Agent : Agents)
+    {
+        if (!Agent.IsMoving() || Agent.Tier != EAgentLODTier::Reduced || Now < Agent.NextMoveTime)
+        {
+            continue;
+        }
+
+        Agent.NextMoveTime = FMath::Max(Agent.NextMoveTime + ReducedUpdateInterval, Now);
+        PlaceOnPath(Agent, Now);
+    }
+
+    DispatchArrivals(Now);
+}
+
+TStatId UAgentLODSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UAgentLODSubsystem, STATGROUP_Tickables);
+}
+
+bool UAgentLODSubsystem::RegisterAgent(AActor* Agent)
+{
+    if (!Agent || Agents.ContainsByPredicate([Agent](const FLODAgent& Entry) { return Entry.Actor.Get() == Agent; }))
+    {
+        return false;
+    }
+
+    int32 AgentId;
+    if (FreeAgentIds.Num() > 0)
+    {
+        AgentId = FreeAgentIds.Pop(EAllowShrinking::No);
+    }
+    else
+    {
+        AgentId = Agents.AddDefaulted();
+    }
+
+    Agents[AgentId].Actor = Agent;
+    TierCounts[static_cast<int32>(EAgentLODTier::Full)]++;
+    return true;
+}
+
+bool UAgentLODSubsystem::UnregisterAgent(AActor* Agent)
+{
+    const int32 AgentId = Agents.IndexOfByPredicate([Agent](const FLODAgent& Entry) { return Entry.Actor.Get() == Agent; });
+    if (!Agent || AgentId == INDEX_NONE)
+    {
+        return false;
+    }
+
+    Agent->SetActorHiddenInGame(false);
+    ReleaseAgent(AgentId);
+    return true;
+}
+
+float UAgentLODSubsystem::MoveAgentAlongPath(AActor* Agent, const TArray<FVector>& Path, float Speed)
+{
+    const int32 AgentId = Agent ? Agents.IndexOfByPredicate([Agent](const FLODAgent& Entry) { return Entry.Actor.Get() == Agent; }) : INDEX_NONE;
+    if (AgentId == INDEX_NONE)
+    {
+        return -1.0f;
+    }
+
+    const double Now = GetWorld()->GetTimeSeconds();
+    FLODAgent& Entry = Agents[AgentId];
+    Entry.Walk++;
+    Entry.Path.Reset();
+    Entry.PathDistances.Reset();
+
+    if (Path.Num() < 2 || Speed <= 0.0f)
+    {
+        return 0.0f;
+    }
+
+    // Distances are cached once so every tier finds its point on the path with a binary search
+    Entry.Path = Path;
+    Entry.PathDistances.Reserve(Path.Num());
+    Entry.PathDistances.Add(0.0f);
+    for (int32 Index = 1; Index < Path.Num(); Index++)
+    {
+        Entry.PathDistances.Add(Entry.PathDistances.Last() + FVector::Dist(Path[Index - 1], Path[Index]));
+    }
+
+    Entry.StartTime = Now;
+    Entry.Speed = Speed;
+    Entry.NextMoveTime = Now;
+
+    FArrival Arrival;
+    Arrival.Time = Entry.GetArrivalTime();
+    Arrival.AgentId = AgentId;
+    Arrival.Walk = Entry.Walk;
+    Arrivals.HeapPush(Arrival, FArrivalOrder());
+
+    return static_cast<float>(Arrival.Time - Now);
+}
+
+EAgentLODTier UAgentLODSubsystem::GetAgentTier(AActor* Agent) const
+{
+    const FLODAgent* Entry = Agents.FindByPredicate([Agent](const FLODAgent& Candidate) { return Agent && Candidate.Actor.Get() == Agent; });
+    return Entry ? Entry->Tier : EAgentLODTier::Statistical;
+}
+
+void UAgentLODSubsystem::UpdateTiers(double Now)
+{
+    const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+    const ATopDownCameraController* Camera = PlayerController ? Cast<ATopDownCameraController>(PlayerController->GetPawn()) : nullptr;
+
+    const FVector Focus = Camera ? Camera->GetViewFocus() : FVector::ZeroVector;
+    const float VisibleRadiusSquared = Camera ? FMath::Square(Camera->GetVisibleGroundRadius() + ViewMargin) : 0.0f;
+    const float FullRadiusSquared = FMath::Square(FullTierDistance);
+
+    for (int32 AgentId = 0; AgentId < Agents.Num(); AgentId++)
+    {
+        FLODAgent& Agent = Agents[AgentId];
+        const AActor* Actor = Agent.Actor.Get();
+        if (!Actor)
+        {
+            if (!Agent.Actor.IsExplicitlyNull())
+            {
+                ReleaseAgent(AgentId);
+            }
+            continue;
+        }
+
+        // Without a top-down camera there is no view to save work on
+        if (!Camera)
+        {
+            SetTier(AgentId, EAgentLODTier::Full, Now);
+            continue;
+        }
+
+        // Hidden agents are not where their actor is, so use their point on the path
+        FVector Location = Actor->GetActorLocation();
+        if (Agent.IsMoving())
+        {
+            FVector Direction;
+            GetPathPoint(Agent, Now, Location, Direction);
+        }
+
+        const float DistanceSquared = FVector::DistSquaredXY(Location, Focus);
+        if (DistanceSquared > VisibleRadiusSquared)
+        {
+            SetTier(AgentId, EAgentLODTier::Statistical, Now);
+        }
+        else
+        {
+            SetTier(AgentId, DistanceSquared <= FullRadiusSquared ? EAgentLODTier::Full : EAgentLODTier::Reduced, Now);
+        }
+    }
+}
+
+void UAgentLODSubsystem::SetTier(int32 AgentId, EAgentLODTier Tier, double Now)
+{
+    FLODAgent& Agent = Agents[AgentId];
+    if (Agent.Tier == Tier)
+    {
+        return;
+    }
+
+    AActor* Actor = Agent.Actor.Get();
+    const bool bWasHidden = Agent.Tier == EAgentLODTier::Statistical;
+
+    TierCounts[static_cast<int32>(Agent.Tier)]--;
+    TierCounts[static_cast<int32>(Tier)]++;
+    Agent.Tier = Tier;
+
+    Actor->SetActorHiddenInGame(Tier == EAgentLODTier::Statistical);
+    SetAgentTicking(Agent, Tier == EAgentLODTier::Full);
+
+    // Coming back into view, jump to where the walk has got to in the meantime
+    if (bWasHidden && Agent.IsMoving())
+    {
+        PlaceOnPath(Agent, Now);
+    }
+    Agent.NextMoveTime = Now + ReducedUpdateInterval;
+
+    OnAgentTierChanged.Broadcast(Actor, Tier);
+}
+
+void UAgentLODSubsystem::SetAgentTicking(FLODAgent& Agent, bool bTicking)
+{
+    AActor* Actor = Agent.Actor.Get();
+    if (!Actor)
+    {
+        Agent.PausedComponents.Reset();
+        return;
+    }
+
+    Actor->SetActorTickEnabled(bTicking);
+
+    // Movement, meshes and AI tick on their own, so they are paused with the actor. Only the ones that
+    // were ticking are remembered, components that were off stay off when the agent comes back.
+    if (bTicking)
+    {
+        for (const TWeakObjectPtr<UActorComponent>& Component : Agent.PausedComponents)
+        {
+            if (UActorComponent* PausedComponent = Component.Get())
+            {
+                PausedComponent->SetComponentTickEnabled(true);
+            }
+        }
+        Agent.PausedComponents.Reset();
+    }
+    else if (Agent.PausedComponents.Num() == 0)
+    {
+        Actor->ForEachComponent(false, [&Agent](UActorComponent* Component)
+        {
+            if (Component->IsComponentTickEnabled())
+            {
+                Component->SetComponentTickEnabled(false);
+                Agent.PausedComponents.Add(Component);
+            }
+        });
+    }
+}
+
+void UAgentLODSubsystem::PlaceOnPath(const FLODAgent& Agent, double Now) const
+{
+    AActor* Actor = Agent.Actor.Get();
+    if (!Actor)
+    {
+        return;
+    }
+
+    FVector Location, Direction;
+    GetPathPoint(Agent, Now, Location, Direction);
+    const FRotator Rotation = Direction.IsNearlyZero() ? Actor->GetActorRotation() : Direction.Rotation();
+
+    // Every placement is a jump, the full tier moves smoothly under its own steering
+    Actor->SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+}
+
+void UAgentLODSubsystem::GetPathPoint(const FLODAgent& Agent, double Time, FVector& OutLocation, FVector& OutDirection) const
+{
+    const float Distance = FMath::Clamp(static_cast<float>(Time - Agent.StartTime) * Agent.Speed, 0.0f, Agent.PathDistances.Last());
+    const int32 Segment = FMath::Clamp(Algo::UpperBound(Agent.PathDistances, Distance), 1, Agent.Path.Num() - 1);
+    const float SegmentLength = Agent.PathDistances[Segment] - Agent.PathDistances[Segment - 1];
+    const float Alpha = SegmentLength > 0.0f ? (Distance - Agent.PathDistances[Segment - 1]) / SegmentLength : 1.0f;
+
+    OutLocation = FMath::Lerp(Agent.Path[Segment - 1], Agent.Path[Segment], Alpha);
+    OutDirection = (Agent.Path[Segment] - Agent.Path[Segment - 1]).GetSafeNormal2D();
+}
+
+void UAgentLODSubsystem::ReleaseAgent(int32 AgentId)
+{
+    // A live actor gets back everything its tier paused
+    SetAgentTicking(Agents[AgentId], true);
+
+    // The walk counter survives so pending arrivals of this agent never match the next one
+    const uint32 Walk = Agents[AgentId].Walk;
+    TierCounts[static_cast<int32>(Agents[AgentId].Tier)]--;
+    Agents[AgentId] = FLODAgent();
+    Agents[AgentId].Walk = Walk + 1;
+    FreeAgentIds.Add(AgentId);
+}
+
+void UAgentLODSubsystem::DispatchArrivals(double Now)
+{
+    while (Arrivals.Num() > 0 && Arrivals.HeapTop().Time <= Now)
+    {
+        FArrival Arrival;
+        Arrivals.HeapPop(Arrival, FArrivalOrder(), EAllowShrinking::No);
+
+        FLODAgent& Agent = Agents[Arrival.AgentId];
+        if (Agent.Walk != Arrival.Walk || !Agent.IsMoving())
+        {
+            continue;
+        }
+
+        // Full agents walk in by themselves, the other tiers end the walk at the last point
+        if (Agent.Tier != EAgentLODTier::Full)
+        {
+            PlaceOnPath(Agent, Arrival.Time);
+        }
+        Agent.Path.Reset();
+        Agent.PathDistances.Reset();
+
+        OnAgentArrived.Broadcast(Agent.Actor.Get());
+    }
+}
@@ -0,0 +1,145 @@
+﻿// AppointmentBook.cpp - Implementation of the appointment slot bitmap
+#include "AppointmentBook.h"
+
+void FAppointmentBook::Init(int32 InNumLanes, int32 WindowSlots, int64 StartSlot)
+{
+    NumLanes = FMath::Max(1, InNumLanes);
+    BaseSlot = StartSlot & ~static_cast<int64>(63);
+
+    // One extra word absorbs the alignment of the window start
+    WordsPerLane = FMath::DivideAndRoundUp(FMath::Max(1, WindowSlots), 64) + 1;
+    Words.Reset();
+    Words.SetNumZeroed(NumLanes * WordsPerLane);
+}
+
+void FAppointmentBook::AdvanceTo(int64 Slot)
+{
+    const int64 PassedWords = (Slot - BaseSlot) >> 6;
+    if (PassedWords <= 0)
+    {
+        return;
+    }
+
+    const int32 DroppedWords = static_cast<int32>(FMath::Min<int64>(PassedWords, WordsPerLane));
+    const int32 KeptWords = WordsPerLane - DroppedWords;
+    for (int32 Lane = 0; Lane < NumLanes; Lane++)
+    {
+        uint64* LaneWords = Words.GetData() + Lane * WordsPerLane;
+        FMemory::Memmove(LaneWords, LaneWords + DroppedWords, KeptWords * sizeof(uint64));
+        FMemory::Memzero(LaneWords + KeptWords, DroppedWords * sizeof(uint64));
+    }
+
+    BaseSlot += PassedWords * 64;
+}
+
+bool FAppointmentBook::IsFree(int32 Lane, int64 Start, int32 Length) const
+{
+    if (Lane < 0 || Lane >= NumLanes || Length <= 0 || Length > MaxLength)
+    {
+        return false;
+    }
+
+    const uint64 Mask = Length == 64 ? ~0ull : (1ull << Length) - 1;
+    return (GetBookedBits(Lane, Start) & Mask) == 0;
+}
+
+int64 FAppointmentBook::FindEarliest(int64 From, int32 Length, int32& OutLane) const
+{
+    OutLane = INDEX_NONE;
+    if (Length <= 0 || Length > MaxLength)
+    {
+        return INDEX_NONE;
+    }
+
+    // Later lanes only need to beat the best start found so far
+    int64 Best = GetWindowEnd();
+    for (int32 Lane = 0; Lane < NumLanes; Lane++)
+    {
+        const int64 Start = FindEarliestOnLane(Lane, From, Length, Best);
+        if (Start != INDEX_NONE)
+        {
+            Best = Start;
+            OutLane = Lane;
+        }
+    }
+
+    return OutLane != INDEX_NONE ? Best : INDEX_NONE;
+}
+
+void FAppointmentBook::SetBooked(int32 Lane, int64 Start, int32 Length, bool bBooked)
+{
+    if (Lane < 0 || Lane >= NumLanes)
+    {
+        return;
+    }
+
+    // Clip to the window
+    const int64 First = FMath::Max(Start, BaseSlot) - BaseSlot;
+    const int64 End = FMath::Min(Start + Length, GetWindowEnd()) - BaseSlot;
+
+    uint64* LaneWords = Words.GetData() + Lane * WordsPerLane;
+    for (int64 Offset = First; Offset < End; )
+    {
+        const int32 Bit = static_cast<int32>(Offset & 63);
+        const int32 Count = static_cast<int32>(FMath::Min<int64>(64 - Bit, End - Offset));
+        const uint64 Mask = (Count == 64 ? ~0ull : ((1ull << Count) - 1)) << Bit;
+
+        if (bBooked)
+        {
+            LaneWords[Offset >> 6] |= Mask;
+        }
+        else
+        {
+            LaneWords[Offset >> 6] &= ~Mask;
+        }
+        Offset += Count;
+    }
+}
+
+uint64 FAppointmentBook::GetBookedBits(int32 Lane, int64 Slot) const
+{
+    const uint64* LaneWords = Words.GetData() + Lane * WordsPerLane;
+    auto WordAt = [LaneWords, this](int64 WordIndex) -> uint64
+    {
+        return (WordIndex >= 0 && WordIndex < WordsPerLane) ? LaneWords[WordIndex] : ~0ull;
+    };
+
+    // Arithmetic shift keeps slots before the window in the word to the left
+    const int64 Offset = Slot - BaseSlot;
+    const int64 WordIndex = Offset >> 6;
+    const int32 Shift = static_cast<int32>(Offset & 63);
+    if (Shift == 0)
+    {
+        return WordAt(WordIndex);
+    }
+
+    return (WordAt(WordIndex) >> Shift) | (WordAt(WordIndex + 1) << (64 - Shift));
+}
+
+int64 FAppointmentBook::FindEarliestOnLane(int32 Lane, int64 From, int32 Length, int64 Limit) const
+{
+    From = FMath::Max(From, BaseSlot);
+    const int64 LastStart = FMath::Min(GetWindowEnd() - Length, Limit - 1);
+
+    for (int64 Position = From; Position <= LastStart; Position += 64)
+    {
+        // Bit i survives if the slots Position + i ... Position + i + Length - 1 are all free
+        uint64 Starts = ~0ull;
+        for (int32 Step = 0; Step < Length && Starts; Step++)
+        {
+            Starts &= ~GetBookedBits(Lane, Position + Step);
+        }
+
+        if (LastStart - Position < 63)
+        {
+            Starts &= (1ull << (LastStart - Position + 1)) - 1;
+        }
+
+        if (Starts)
+        {
+            return Position + static_cast<int64>(FMath::CountTrailingZeros64(Starts));
+        }
+    }
+
+    return INDEX_NONE;
+}
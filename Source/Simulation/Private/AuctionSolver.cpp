@@ -0,0 +1,268 @@
+﻿// AuctionSolver.cpp - Implementation of the auction assignment solver
+#include "AuctionSolver.h"
+
+void FAuctionSolver::Reset(int32 NumObjects)
+{
+    ArcStarts.Reset();
+    ArcStarts.Add(0);
+    ArcObjects.Reset();
+    ArcBenefits.Reset();
+    AssignedArcs.Reset();
+
+    Prices.SetNumZeroed(NumObjects);
+    Owners.Init(INDEX_NONE, NumObjects);
+}
+
+int32 FAuctionSolver::AddPerson()
+{
+    ArcStarts.Add(ArcObjects.Num());
+    AssignedArcs.Add(INDEX_NONE);
+    return NumPersons() - 1;
+}
+
+void FAuctionSolver::AddArc(int32 Object, int64 Benefit)
+{
+    check(NumPersons() > 0 && Prices.IsValidIndex(Object));
+
+    ArcObjects.Add(Object);
+    ArcBenefits.Add(Benefit);
+    ArcStarts.Last() = ArcObjects.Num();
+}
+
+void FAuctionSolver::SetPrice(int32 Object, int64 Price)
+{
+    Prices[Object] = FMath::Max<int64>(0, Price);
+}
+
+void FAuctionSolver::SetInitialAssignment(int32 Person, int32 Object)
+{
+    // Only arcs that exist can be kept
+    for (int32 Arc = ArcStarts[Person]; Arc < ArcStarts[Person + 1]; Arc++)
+    {
+        if (ArcObjects[Arc] == Object && Owners[Object] == INDEX_NONE)
+        {
+            AssignArc(Person, Arc);
+            return;
+        }
+    }
+}
+
+int32 FAuctionSolver::Solve(int64 StartEpsilon)
+{
+    // Incoming arcs per object for the reverse auction
+    ArcPersons.SetNumUninitialized(ArcObjects.Num());
+    ObjectArcStarts.Init(0, NumObjects() + 1);
+    for (int32 Person = 0; Person < NumPersons(); Person++)
+    {
+        for (int32 Arc = ArcStarts[Person]; Arc < ArcStarts[Person + 1]; Arc++)
+        {
+            ArcPersons[Arc] = Person;
+            ObjectArcStarts[ArcObjects[Arc] + 1]++;
+        }
+    }
+    for (int32 Object = 0; Object < NumObjects(); Object++)
+    {
+        ObjectArcStarts[Object + 1] += ObjectArcStarts[Object];
+    }
+    ObjectArcs.SetNumUninitialized(ArcObjects.Num());
+    {
+        TArray<int32> Fill(ObjectArcStarts);
+        for (int32 Arc = 0; Arc < ArcObjects.Num(); Arc++)
+        {
+            ObjectArcs[Fill[ArcObjects[Arc]]++] = Arc;
+        }
+    }
+
+    // Each phase tightens the bid increment, starting from the previous phase's prices
+    int32 NumBids = 0;
+    for (int64 Epsilon = FMath::Max<int64>(1, StartEpsilon); ; Epsilon /= 4)
+    {
+        Epsilon = FMath::Max<int64>(1, Epsilon);
+
+        QueueUnsettledPersons(Epsilon);
+        NumBids += RunForwardAuction(Epsilon);
+        NumBids += RunReverseAuction(Epsilon);
+
+        if (Epsilon == 1)
+        {
+            break;
+        }
+    }
+
+    return NumBids;
+}
+
+int64 FAuctionSolver::GetTotalBenefit() const
+{
+    int64 Total = 0;
+    for (int32 Arc : AssignedArcs)
+    {
+        Total += Arc != INDEX_NONE ? ArcBenefits[Arc] : 0;
+    }
+
+    return Total;
+}
+
+void FAuctionSolver::FindBestArcs(int32 Person, int32& OutBestArc, int64& OutBest, int64& OutSecond) const
+{
+    OutBestArc = INDEX_NONE;
+    OutBest = MIN_int64;
+    OutSecond = MIN_int64;
+
+    for (int32 Arc = ArcStarts[Person]; Arc < ArcStarts[Person + 1]; Arc++)
+    {
+        const int64 Value = ArcBenefits[Arc] - Prices[ArcObjects[Arc]];
+        if (Value > OutBest)
+        {
+            OutSecond = OutBest;
+            OutBest = Value;
+            OutBestArc = Arc;
+        }
+        else if (Value > OutSecond)
+        {
+            OutSecond = Value;
+        }
+    }
+}
+
+int64 FAuctionSolver::GetProfit(int32 Person) const
+{
+    const int32 Arc = AssignedArcs[Person];
+    return Arc != INDEX_NONE ? ArcBenefits[Arc] - Prices[ArcObjects[Arc]] : 0;
+}
+
+void FAuctionSolver::AssignArc(int32 Person, int32 Arc)
+{
+    if (AssignedArcs[Person] != INDEX_NONE)
+    {
+        Owners[ArcObjects[AssignedArcs[Person]]] = INDEX_NONE;
+    }
+
+    const int32 Object = ArcObjects[Arc];
+    if (Owners[Object] != INDEX_NONE)
+    {
+        AssignedArcs[Owners[Object]] = INDEX_NONE;
+    }
+
+    AssignedArcs[Person] = Arc;
+    Owners[Object] = Person;
+}
+
+void FAuctionSolver::QueueUnsettledPersons(int64 Epsilon)
+{
+    UnassignedPersons.Reset();
+
+    for (int32 Person = 0; Person < NumPersons(); Person++)
+    {
+        int32 BestArc;
+        int64 Best, Second;
+        FindBestArcs(Person, BestArc, Best, Second);
+
+        // Staying unassigned is always an option worth nothing
+        if (GetProfit(Person) >= FMath::Max<int64>(Best, 0) - Epsilon)
+        {
+            continue;
+        }
+
+        if (AssignedArcs[Person] != INDEX_NONE)
+        {
+            Owners[ArcObjects[AssignedArcs[Person]]] = INDEX_NONE;
+            AssignedArcs[Person] = INDEX_NONE;
+        }
+        UnassignedPersons.Add(Person);
+    }
+}
+
+int32 FAuctionSolver::RunForwardAuction(int64 Epsilon)
+{
+    int32 NumBids = 0;
+
+    while (UnassignedPersons.Num() > 0)
+    {
+        const int32 Person = UnassignedPersons.Pop(EAllowShrinking::No);
+
+        int32 BestArc;
+        int64 Best, Second;
+        FindBestArcs(Person, BestArc, Best, Second);
+
+        // Nothing is worth its price, the person stays unassigned
+        if (BestArc == INDEX_NONE || Best <= 0)
+        {
+            continue;
+        }
+
+        // Raise the price until the object is only just the person's best choice
+        const int32 Object = ArcObjects[BestArc];
+        const int32 PreviousOwner = Owners[Object];
+        Prices[Object] += Best - FMath::Max<int64>(Second, 0) + Epsilon;
+        AssignArc(Person, BestArc);
+        NumBids++;
+
+        if (PreviousOwner != INDEX_NONE)
+        {
+            UnassignedPersons.Add(PreviousOwner);
+        }
+    }
+
+    return NumBids;
+}
+
+int32 FAuctionSolver::RunReverseAuction(int64 Epsilon)
+{
+    UnassignedObjects.Reset();
+    for (int32 Object = 0; Object < NumObjects(); Object++)
+    {
+        if (Owners[Object] == INDEX_NONE && Prices[Object] > 0)
+        {
+            UnassignedObjects.Add(Object);
+        }
+    }
+
+    // Persons only ever move to a better deal here, so nobody becomes unassigned
+    int32 NumBids = 0;
+    while (UnassignedObjects.Num() > 0)
+    {
+        const int32 Object = UnassignedObjects.Pop(EAllowShrinking::No);
+
+        int32 BestArc = INDEX_NONE;
+        int64 Best = MIN_int64;
+        int64 Second = MIN_int64;
+        for (int32 Index = ObjectArcStarts[Object]; Index < ObjectArcStarts[Object + 1]; Index++)
+        {
+            const int32 Arc = ObjectArcs[Index];
+            const int64 Value = ArcBenefits[Arc] - GetProfit(ArcPersons[Arc]);
+            if (Value > Best)
+            {
+                Second = Best;
+                Best = Value;
+                BestArc = Arc;
+            }
+            else if (Value > Second)
+            {
+                Second = Value;
+            }
+        }
+
+        // Nobody would gain from the object even for free
+        if (BestArc == INDEX_NONE || Best <= 0)
+        {
+            Prices[Object] = 0;
+            continue;
+        }
+
+        // Lower the price until the object is only just the best person's best choice
+        Prices[Object] = Second > Epsilon ? Second - Epsilon : 0;
+
+        const int32 Person = ArcPersons[BestArc];
+        const int32 PreviousArc = AssignedArcs[Person];
+        AssignArc(Person, BestArc);
+        NumBids++;
+
+        if (PreviousArc != INDEX_NONE && Prices[ArcObjects[PreviousArc]] > 0)
+        {
+            UnassignedObjects.Add(ArcObjects[PreviousArc]);
+        }
+    }
+
+    return NumBids;
+}
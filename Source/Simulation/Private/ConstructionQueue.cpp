@@ -0,0 +1,299 @@
+﻿// ConstructionQueue.cpp - Implementation of the construction queue
+#include "ConstructionQueue.h"
+
+void FConstructionQueue::Reset()
+{
+    SiteSlots.Reset();
+    SiteIds.Reset();
+    SiteCells.Reset();
+    SiteFloors.Reset();
+    SiteWorkTotal.Reset();
+    SiteWorkLeft.Reset();
+    SitePriorities.Reset();
+    SiteMaxBuilders.Reset();
+    SiteNumBuilders.Reset();
+    SiteSequence.Reset();
+    NextSequence = 0;
+
+    BuilderCells.Reset();
+    BuilderFloors.Reset();
+    BuilderSites.Reset();
+    BuilderTravelLeft.Reset();
+    BuilderActive.Reset();
+    NumActiveBuilders = 0;
+}
+
+void FConstructionQueue::AddSite(int32 SiteId, const FIntPoint& Cell, int32 FloorLevel, float WorkHours, int32 MaxBuilders, int32 Priority)
+{
+    if (SiteId < 0)
+    {
+        return;
+    }
+
+    if (SiteId >= SiteSlots.Num())
+    {
+        const int32 OldNum = SiteSlots.Num();
+        SiteSlots.SetNum(SiteId + 1);
+        for (int32 Index = OldNum; Index < SiteSlots.Num(); Index++)
+        {
+            SiteSlots[Index] = INDEX_NONE;
+        }
+    }
+
+    RemoveSite(SiteId);
+
+    SiteSlots[SiteId] = SiteIds.Add(SiteId);
+    SiteCells.Add(Cell);
+    SiteFloors.Add(FloorLevel);
+    SiteWorkTotal.Add(FMath::Max(WorkHours, KINDA_SMALL_NUMBER));
+    SiteWorkLeft.Add(FMath::Max(WorkHours, KINDA_SMALL_NUMBER));
+    SitePriorities.Add(Priority);
+    SiteMaxBuilders.Add(FMath::Max(1, MaxBuilders));
+    SiteNumBuilders.Add(0);
+    SiteSequence.Add(NextSequence++);
+}
+
+void FConstructionQueue::RemoveSite(int32 SiteId)
+{
+    if (IsQueued(SiteId))
+    {
+        RemoveSiteAt(SiteSlots[SiteId]);
+    }
+}
+
+bool FConstructionQueue::SetPriority(int32 SiteId, int32 Priority)
+{
+    if (!IsQueued(SiteId))
+    {
+        return false;
+    }
+
+    SitePriorities[SiteSlots[SiteId]] = Priority;
+    return true;
+}
+
+bool FConstructionQueue::MoveSite(int32 SiteId, const FIntPoint& Cell, int32 FloorLevel)
+{
+    if (!IsQueued(SiteId))
+    {
+        return false;
+    }
+
+    SiteCells[SiteSlots[SiteId]] = Cell;
+    SiteFloors[SiteSlots[SiteId]] = FloorLevel;
+    return true;
+}
+
+void FConstructionQueue::ShiftCells(const FIntPoint& Offset)
+{
+    for (FIntPoint& Cell : SiteCells)
+    {
+        Cell += Offset;
+    }
+
+    for (FIntPoint& Cell : BuilderCells)
+    {
+        Cell += Offset;
+    }
+}
+
+int32 FConstructionQueue::AddBuilder(const FIntPoint& Cell, int32 FloorLevel)
+{
+    int32 BuilderId = BuilderActive.Find(false);
+    if (BuilderId == INDEX_NONE)
+    {
+        BuilderId = BuilderActive.Add(true);
+        BuilderCells.AddDefaulted();
+        BuilderFloors.AddDefaulted();
+        BuilderSites.AddDefaulted();
+        BuilderTravelLeft.AddDefaulted();
+    }
+
+    BuilderActive[BuilderId] = true;
+    NumActiveBuilders++;
+    BuilderCells[BuilderId] = Cell;
+    BuilderFloors[BuilderId] = FloorLevel;
+    BuilderSites[BuilderId] = INDEX_NONE;
+    BuilderTravelLeft[BuilderId] = 0.0f;
+    return BuilderId;
+}
+
+void FConstructionQueue::RemoveBuilder(int32 BuilderId)
+{
+    if (!BuilderActive.IsValidIndex(BuilderId) || !BuilderActive[BuilderId])
+    {
+        return;
+    }
+
+    if (IsQueued(BuilderSites[BuilderId]))
+    {
+        SiteNumBuilders[SiteSlots[BuilderSites[BuilderId]]]--;
+    }
+
+    BuilderActive[BuilderId] = false;
+    BuilderSites[BuilderId] = INDEX_NONE;
+    NumActiveBuilders--;
+}
+
+void FConstructionQueue::Advance(float Hours, float WalkHoursPerCell, float WalkHoursPerFloor, TArray<int32>& OutCompleted)
+{
+    OutCompleted.Reset();
+    if (Hours <= 0.0f || SiteIds.Num() == 0)
+    {
+        return;
+    }
+
+    DispatchBuilders(WalkHoursPerCell, WalkHoursPerFloor);
+
+    // Builders spend the span walking first, the rest of it counts as work on their site
+    SiteWorkDone.Reset();
+    SiteWorkDone.SetNumZeroed(SiteIds.Num());
+    for (int32 BuilderId = 0; BuilderId < BuilderSites.Num(); BuilderId++)
+    {
+        if (!BuilderActive[BuilderId] || BuilderSites[BuilderId] == INDEX_NONE)
+        {
+            continue;
+        }
+
+        const float WorkHours = Hours - BuilderTravelLeft[BuilderId];
+        BuilderTravelLeft[BuilderId] = FMath::Max(0.0f, -WorkHours);
+        if (WorkHours > 0.0f)
+        {
+            SiteWorkDone[SiteSlots[BuilderSites[BuilderId]]] += WorkHours;
+        }
+    }
+
+    // Walk backwards so removing a finished site does not move unvisited ones
+    for (int32 Slot = SiteIds.Num() - 1; Slot >= 0; Slot--)
+    {
+        SiteWorkLeft[Slot] -= SiteWorkDone[Slot];
+        if (SiteWorkLeft[Slot] <= 0.0f)
+        {
+            OutCompleted.Add(SiteIds[Slot]);
+            RemoveSiteAt(Slot);
+        }
+    }
+}
+
+void FConstructionQueue::CompleteAll(TArray<int32>& OutCompleted)
+{
+    OutCompleted.Reset();
+    for (int32 Slot = SiteIds.Num() - 1; Slot >= 0; Slot--)
+    {
+        OutCompleted.Add(SiteIds[Slot]);
+        RemoveSiteAt(Slot);
+    }
+}
+
+float FConstructionQueue::GetProgress(int32 SiteId) const
+{
+    if (!IsQueued(SiteId))
+    {
+        return 1.0f;
+    }
+
+    const int32 Slot = SiteSlots[SiteId];
+    return FMath::Clamp(1.0f - SiteWorkLeft[Slot] / SiteWorkTotal[Slot], 0.0f, 1.0f);
+}
+
+int32 FConstructionQueue::GetNumAssignedBuilders(int32 SiteId) const
+{
+    return IsQueued(SiteId) ? SiteNumBuilders[SiteSlots[SiteId]] : 0;
+}
+
+void FConstructionQueue::RemoveSiteAt(int32 Slot)
+{
+    const int32 SiteId = SiteIds[Slot];
+
+    // Builders stay at the site until they are dispatched again
+    for (int32 BuilderId = 0; BuilderId < BuilderSites.Num(); BuilderId++)
+    {
+        if (BuilderSites[BuilderId] == SiteId)
+        {
+            BuilderSites[BuilderId] = INDEX_NONE;
+            BuilderTravelLeft[BuilderId] = 0.0f;
+        }
+    }
+
+    SiteSlots[SiteId] = INDEX_NONE;
+    if (Slot != SiteIds.Num() - 1)
+    {
+        SiteSlots[SiteIds.Last()] = Slot;
+    }
+
+    SiteIds.RemoveAtSwap(Slot, 1, EAllowShrinking::No);
+    SiteCells.RemoveAtSwap(Slot, 1, EAllowShrinking::No);
+    SiteFloors.RemoveAtSwap(Slot, 1, EAllowShrinking::No);
+    SiteWorkTotal.RemoveAtSwap(Slot, 1, EAllowShrinking::No);
+    SiteWorkLeft.RemoveAtSwap(Slot, 1, EAllowShrinking::No);
+    SitePriorities.RemoveAtSwap(Slot, 1, EAllowShrinking::No);
+    SiteMaxBuilders.RemoveAtSwap(Slot, 1, EAllowShrinking::No);
+    SiteNumBuilders.RemoveAtSwap(Slot, 1, EAllowShrinking::No);
+    SiteSequence.RemoveAtSwap(Slot, 1, EAllowShrinking::No);
+}
+
+void FConstructionQueue::DispatchBuilders(float WalkHoursPerCell, float WalkHoursPerFloor)
+{
+    TArray<int32, TInlineAllocator<16>> IdleBuilders;
+    for (int32 BuilderId = 0; BuilderId < BuilderSites.Num(); BuilderId++)
+    {
+        if (BuilderActive[BuilderId] && BuilderSites[BuilderId] == INDEX_NONE)
+        {
+            IdleBuilders.Add(BuilderId);
+        }
+    }
+
+    if (IdleBuilders.Num() == 0)
+    {
+        return;
+    }
+
+    // Highest priority first, then the oldest site
+    TArray<int32, TInlineAllocator<16>> Order;
+    for (int32 Slot = 0; Slot < SiteIds.Num(); Slot++)
+    {
+        if (SiteNumBuilders[Slot] < SiteMaxBuilders[Slot])
+        {
+            Order.Add(Slot);
+        }
+    }
+    Order.Sort([this](int32 A, int32 B)
+    {
+        return SitePriorities[A] != SitePriorities[B] ? SitePriorities[A] > SitePriorities[B] : SiteSequence[A] < SiteSequence[B];
+    });
+
+    for (int32 Slot : Order)
+    {
+        // Fill the site with the nearest idle builders
+        while (SiteNumBuilders[Slot] < SiteMaxBuilders[Slot] && IdleBuilders.Num() > 0)
+        {
+            int32 BestIndex = 0;
+            float BestHours = MAX_flt;
+            for (int32 Index = 0; Index < IdleBuilders.Num(); Index++)
+            {
+                const int32 BuilderId = IdleBuilders[Index];
+                const int32 Cells = FMath::Abs(BuilderCells[BuilderId].X - SiteCells[Slot].X) + FMath::Abs(BuilderCells[BuilderId].Y - SiteCells[Slot].Y);
+                const float WalkHours = Cells * WalkHoursPerCell + FMath::Abs(BuilderFloors[BuilderId] - SiteFloors[Slot]) * WalkHoursPerFloor;
+                if (WalkHours < BestHours)
+                {
+                    BestHours = WalkHours;
+                    BestIndex = Index;
+                }
+            }
+
+            const int32 BuilderId = IdleBuilders[BestIndex];
+            IdleBuilders.RemoveAtSwap(BestIndex, 1, EAllowShrinking::No);
+
+            BuilderSites[BuilderId] = SiteIds[Slot];
+            BuilderTravelLeft[BuilderId] = BestHours;
+            BuilderCells[BuilderId] = SiteCells[Slot];
+            BuilderFloors[BuilderId] = SiteFloors[Slot];
+            SiteNumBuilders[Slot]++;
+        }
+
+        if (IdleBuilders.Num() == 0)
+        {
+            break;
+        }
+    }
+}
@@ -0,0 +1,68 @@
+﻿// DemandForecaster.cpp - Implementation of the demand forecaster
+#include "DemandForecaster.h"
+
+void FDemandForecaster::Reset(float InLevelSmoothing, float InTrendSmoothing, float InSeasonSmoothing)
+{
+    AllSeries.Reset();
+    LevelSmoothing = FMath::Clamp(InLevelSmoothing, 0.0f, 1.0f);
+    TrendSmoothing = FMath::Clamp(InTrendSmoothing, 0.0f, 1.0f);
+    SeasonSmoothing = FMath::Clamp(InSeasonSmoothing, 0.0f, 1.0f);
+}
+
+int32 FDemandForecaster::AddSeries(int32 FirstDay)
+{
+    FSeries& Series = AllSeries.AddDefaulted_GetRef();
+    Series.FirstPhase = ((FirstDay % SeasonLength) + SeasonLength) % SeasonLength;
+    return AllSeries.Num() - 1;
+}
+
+void FDemandForecaster::Observe(int32 SeriesIndex, float Value)
+{
+    if (!AllSeries.IsValidIndex(SeriesIndex))
+    {
+        return;
+    }
+
+    FSeries& Series = AllSeries[SeriesIndex];
+    const int32 Phase = (Series.FirstPhase + Series.Observations) % SeasonLength;
+    Series.Observations++;
+
+    // The first week seeds the level with its mean and each weekday with its difference to it
+    if (Series.Observations <= SeasonLength)
+    {
+        Series.Seasonal[Phase] = Value;
+        Series.FirstSeasonSum += Value;
+        if (Series.Observations == SeasonLength)
+        {
+            Series.Level = Series.FirstSeasonSum / SeasonLength;
+            for (float& Offset : Series.Seasonal)
+            {
+                Offset -= Series.Level;
+            }
+        }
+        return;
+    }
+
+    const float PreviousLevel = Series.Level;
+    Series.Level = LevelSmoothing * (Value - Series.Seasonal[Phase]) + (1.0f - LevelSmoothing) * (Series.Level + Series.Trend);
+    Series.Trend = TrendSmoothing * (Series.Level - PreviousLevel) + (1.0f - TrendSmoothing) * Series.Trend;
+    Series.Seasonal[Phase] = SeasonSmoothing * (Value - Series.Level) + (1.0f - SeasonSmoothing) * Series.Seasonal[Phase];
+}
+
+float FDemandForecaster::Forecast(int32 SeriesIndex, int32 DaysAhead) const
+{
+    if (!AllSeries.IsValidIndex(SeriesIndex) || AllSeries[SeriesIndex].Observations == 0)
+    {
+        return 0.0f;
+    }
+
+    const FSeries& Series = AllSeries[SeriesIndex];
+    if (Series.Observations < SeasonLength)
+    {
+        return Series.FirstSeasonSum / Series.Observations;
+    }
+
+    const int32 Ahead = FMath::Max(1, DaysAhead);
+    const int32 Phase = (Series.FirstPhase + Series.Observations + Ahead - 1) % SeasonLength;
+    return FMath::Max(0.0f, Series.Level + Ahead * Series.Trend + Series.Seasonal[Phase]);
+}
@@ -0,0 +1,23 @@
+﻿// EconomyLedger.cpp - Implementation of the economy ledger
+#include "EconomyLedger.h"
+
+void FEconomyLedger::Reset(int32 StartingFunds, int32 InMaxHistoryDays)
+{
+    Today = FEconomyDayRecord();
+    History.Reset();
+    MaxHistoryDays = FMath::Max(1, InMaxHistoryDays);
+    Balance = StartingFunds;
+}
+
+void FEconomyLedger::CloseDay(int32 NextDay)
+{
+    // Long games keep a bounded history, the metric rings hold the long-term view
+    if (History.Num() >= MaxHistoryDays)
+    {
+        History.RemoveAt(0, History.Num() - MaxHistoryDays + 1, EAllowShrinking::No);
+    }
+    History.Add(Today);
+
+    Today = FEconomyDayRecord();
+    Today.Day = NextDay;
+}
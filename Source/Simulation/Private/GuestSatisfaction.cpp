@@ -0,0 +1,176 @@
+﻿// GuestSatisfaction.cpp - Implementation of the guest satisfaction records
+#include "GuestSatisfaction.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+    // Records reduced by one task
+    constexpr int32 RecordsPerChunk = 2048;
+
+    // Sums over the records of one chunk
+    struct FSatisfactionSums
+    {
+        double Satisfaction = 0.0;
+        double WaitSeconds = 0.0;
+        double WalkSeconds = 0.0;
+        double Ambience = 0.0;
+        double Quality = 0.0;
+        int32 Visits = 0;
+        int32 Departed = 0;
+        int32 Unhappy = 0;
+    };
+}
+
+void FGuestSatisfaction::Reset(int32 InMaxHistoryDays)
+{
+    GuestIds.Reset();
+    Departed.Reset();
+    WaitSeconds.Reset();
+    WalkSeconds.Reset();
+    AmbienceSums.Reset();
+    QualitySums.Reset();
+    Visits.Reset();
+    AbandonedQueues.Reset();
+
+    DepartedScoreSum = 0.0;
+    DepartedToday = 0;
+    History.Reset();
+    MaxHistoryDays = FMath::Max(1, InMaxHistoryDays);
+}
+
+int32 FGuestSatisfaction::AddGuest(int32 GuestId)
+{
+    Departed.Add(false);
+    WaitSeconds.Add(0);
+    WalkSeconds.Add(0);
+    AmbienceSums.Add(0.0f);
+    QualitySums.Add(0.0f);
+    Visits.Add(0);
+    AbandonedQueues.Add(0);
+    return GuestIds.Add(GuestId);
+}
+
+void FGuestSatisfaction::MarkDeparted(int32 Record, const FGuestSatisfactionWeights& Weights)
+{
+    if (Departed[Record])
+    {
+        return;
+    }
+
+    Departed[Record] = true;
+    DepartedScoreSum += GetSatisfaction(Record, Weights);
+    DepartedToday++;
+}
+
+float FGuestSatisfaction::GetSatisfaction(int32 Record, const FGuestSatisfactionWeights& Weights) const
+{
+    float Satisfaction = Weights.Base;
+    Satisfaction -= WaitSeconds[Record] / 60.0f * Weights.PerWaitMinute;
+    Satisfaction -= WalkSeconds[Record] / 60.0f * Weights.PerWalkMinute;
+    Satisfaction -= AbandonedQueues[Record] * Weights.PerAbandonedQueue;
+
+    // Buildings count by their average, so a long stay is not better or worse by itself
+    if (Visits[Record] > 0)
+    {
+        Satisfaction += AmbienceSums[Record] / Visits[Record] * Weights.PerAmbience;
+        Satisfaction += (QualitySums[Record] / Visits[Record] - 75.0f) * Weights.PerQualityPoint;
+    }
+
+    return FMath::Clamp(Satisfaction, 0.0f, 100.0f);
+}
+
+const FGuestSatisfactionReport& FGuestSatisfaction::CloseDay(int32 Day, const FGuestSatisfactionWeights& Weights, TFunctionRef<void(int32 GuestId, int32 NewRecord)> OnRecordMoved)
+{
+    const int32 NumChunks = FMath::DivideAndRoundUp(NumRecords(), RecordsPerChunk);
+    TArray<FSatisfactionSums, TInlineAllocator<16>> ChunkSums;
+    ChunkSums.SetNum(NumChunks);
+
+    // Every chunk writes only its own sums, they are combined in order so the result is the same on every run
+    ParallelFor(NumChunks, [this, &Weights, &ChunkSums](int32 Chunk)
+    {
+        FSatisfactionSums& Sums = ChunkSums[Chunk];
+        const int32 End = FMath::Min((Chunk + 1) * RecordsPerChunk, NumRecords());
+        for (int32 Record = Chunk * RecordsPerChunk; Record < End; Record++)
+        {
+            const float Satisfaction = GetSatisfaction(Record, Weights);
+            Sums.Satisfaction += Satisfaction;
+            Sums.WaitSeconds += WaitSeconds[Record];
+            Sums.WalkSeconds += WalkSeconds[Record];
+            Sums.Ambience += AmbienceSums[Record];
+            Sums.Quality += QualitySums[Record];
+            Sums.Visits += Visits[Record];
+            Sums.Departed += Departed[Record] ? 1 : 0;
+            Sums.Unhappy += Satisfaction < Weights.UnhappyBelow ? 1 : 0;
+        }
+    });
+
+    FSatisfactionSums Total;
+    for (const FSatisfactionSums& Sums : ChunkSums)
+    {
+        Total.Satisfaction += Sums.Satisfaction;
+        Total.WaitSeconds += Sums.WaitSeconds;
+        Total.WalkSeconds += Sums.WalkSeconds;
+        Total.Ambience += Sums.Ambience;
+        Total.Quality += Sums.Quality;
+        Total.Visits += Sums.Visits;
+        Total.Departed += Sums.Departed;
+        Total.Unhappy += Sums.Unhappy;
+    }
+
+    // Only the most recent days are kept, the metric rings hold the long-term view
+    if (History.Num() >= MaxHistoryDays)
+    {
+        History.RemoveAt(0, History.Num() - MaxHistoryDays + 1, EAllowShrinking::No);
+    }
+    FGuestSatisfactionReport& Report = History.AddDefaulted_GetRef();
+    Report.Day = Day;
+    Report.Guests = NumRecords();
+    Report.DepartedGuests = Total.Departed;
+    Report.UnhappyGuests = Total.Unhappy;
+    if (Report.Guests > 0)
+    {
+        Report.AverageSatisfaction = static_cast<float>(Total.Satisfaction / Report.Guests);
+        Report.AverageWaitMinutes = static_cast<float>(Total.WaitSeconds / 60.0 / Report.Guests);
+        Report.AverageWalkMinutes = static_cast<float>(Total.WalkSeconds / 60.0 / Report.Guests);
+    }
+    if (Total.Visits > 0)
+    {
+        Report.AverageAmbience = static_cast<float>(Total.Ambience / Total.Visits);
+        Report.AverageQuality = static_cast<float>(Total.Quality / Total.Visits);
+    }
+
+    // Guests still in the resort keep their records, moved to the front
+    int32 NumKept = 0;
+    for (int32 Record = 0; Record < NumRecords(); Record++)
+    {
+        if (Departed[Record])
+        {
+            continue;
+        }
+
+        GuestIds[NumKept] = GuestIds[Record];
+        Departed[NumKept] = false;
+        WaitSeconds[NumKept] = WaitSeconds[Record];
+        WalkSeconds[NumKept] = WalkSeconds[Record];
+        AmbienceSums[NumKept] = AmbienceSums[Record];
+        QualitySums[NumKept] = QualitySums[Record];
+        Visits[NumKept] = Visits[Record];
+        AbandonedQueues[NumKept] = AbandonedQueues[Record];
+        OnRecordMoved(GuestIds[NumKept], NumKept);
+        NumKept++;
+    }
+
+    GuestIds.SetNum(NumKept, EAllowShrinking::No);
+    Departed.SetNum(NumKept, EAllowShrinking::No);
+    WaitSeconds.SetNum(NumKept, EAllowShrinking::No);
+    WalkSeconds.SetNum(NumKept, EAllowShrinking::No);
+    AmbienceSums.SetNum(NumKept, EAllowShrinking::No);
+    QualitySums.SetNum(NumKept, EAllowShrinking::No);
+    Visits.SetNum(NumKept, EAllowShrinking::No);
+    AbandonedQueues.SetNum(NumKept, EAllowShrinking::No);
+
+    DepartedScoreSum = 0.0;
+    DepartedToday = 0;
+
+    return Report;
+}
@@ -0,0 +1,367 @@
+﻿// MassAgentProcessors.cpp - Implementation of the guest and staff processors
+#include "MassAgentProcessors.h"
+#include "MassAgentFragments.h"
+#include "MassAgentSubsystem.h"
+#include "MassExecutionContext.h"
+#include "MassCommandBuffer.h"
+#include "MassEntityManager.h"
+#include "Engine/World.h"
+
+namespace
+{
+    // Snapshot entry of a building that still exists, nullptr if it was removed
+    const FAgentBuildingInfo* FindBuildingInfo(const TArray<FAgentBuildingInfo>& Buildings, const FBuildingHandle& Handle)
+    {
+        return Handle.IsValid() && Buildings.IsValidIndex(Handle.Index) && Buildings[Handle.Index].Handle == Handle ? &Buildings[Handle.Index] : nullptr;
+    }
+
+    // Open building for a treatment or a meal that is quickest to walk to and get into
+    const FAgentBuildingInfo* ChooseBuilding(const TArray<FAgentBuildingInfo>& Buildings, const FVector& From, float Speed, bool bTreatment)
+    {
+        const FAgentBuildingInfo* Best = nullptr;
+        float BestSeconds = MAX_flt;
+        for (const FAgentBuildingInfo& Building : Buildings)
+        {
+            if (!Building.bOpen || (bTreatment ? !Building.bOffersTreatment : !Building.bServesFood))
+            {
+                continue;
+            }
+
+            // A full building costs about one visit of waiting
+            const float Seconds = FVector::Dist(From, Building.Location) / FMath::Max(Speed, 1.0f) + (Building.FreePlaces > 0 ? 0.0f : Building.VisitSeconds);
+            if (Seconds < BestSeconds)
+            {
+                BestSeconds = Seconds;
+                Best = &Building;
+            }
+        }
+        return Best;
+    }
+
+    // Cross off the wish a building served or the guest gave up on
+    void DropWish(FAgentScheduleFragment& Schedule, const FAgentBuildingInfo& Building)
+    {
+        if (Building.bOffersTreatment && Schedule.TreatmentsLeft > 0)
+        {
+            Schedule.TreatmentsLeft--;
+        }
+        else
+        {
+            Schedule.bHasEaten = true;
+        }
+    }
+
+    // Queue a request to let the agent into its building; it starts its visit once the building takes it
+    void RequestEnter(FMassExecutionContext& Context, UMassAgentSubsystem* Agents, const FMassEntityHandle& Entity, const FAgentBuildingInfo& Building, bool bStaff)
+    {
+        Context.Defer().PushCommand<FMassDeferredSetCommand>([Agents, Entity, Handle = Building.Handle, VisitSeconds = Building.VisitSeconds, bStaff](FMassEntityManager& Manager)
+        {
+            FAgentScheduleFragment* Schedule = Manager.IsEntityValid(Entity) ? Manager.GetFragmentDataPtr<FAgentScheduleFragment>(Entity) : nullptr;
+            if (!Schedule)
+            {
+                return;
+            }
+
+            Schedule->bRequestPending = false;
+            if (Agents->EnterBuilding(Entity, Handle, bStaff))
+            {
+                Schedule->Task = EAgentTask::Visiting;
+                Schedule->TimeLeft = VisitSeconds;
+            }
+        });
+    }
+
+    // Send an agent to the entrance
+    void StartLeaving(FAgentScheduleFragment& Schedule, FAgentDestinationFragment& Destination, const FVector& Entrance)
+    {
+        Destination.Building = FBuildingHandle();
+        Destination.Location = Entrance;
+        Schedule.Task = EAgentTask::Leaving;
+    }
+}
+
+UAgentMovementProcessor::UAgentMovementProcessor()
+    : EntityQuery(*this)
+{
+    // Run by UMassAgentSubsystem, which owns the simulation time of the agents
+    bAutoRegisterWithProcessingPhases = false;
+    ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::All);
+}
+
+void UAgentMovementProcessor::ConfigureQueries()
+{
+    EntityQuery.AddRequirement<FAgentPositionFragment>(EMassFragmentAccess::ReadWrite);
+    EntityQuery.AddRequirement<FAgentDestinationFragment>(EMassFragmentAccess::ReadOnly);
+    EntityQuery.AddRequirement<FAgentScheduleFragment>(EMassFragmentAccess::ReadWrite);
+    EntityQuery.AddRequirement<FAgentSatisfactionFragment>(EMassFragmentAccess::ReadWrite, EMassFragmentPresence::Optional);
+}
+
+void UAgentMovementProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+    const UMassAgentSubsystem* Agents = UWorld::GetSubsystem<UMassAgentSubsystem>(EntityManager.GetWorld());
+    if (!Agents)
+    {
+        return;
+    }
+
+    const float MaxWaitSeconds = Agents->MaxWaitSeconds;
+    EntityQuery.ParallelForEachEntityChunk(EntityManager, Context, [MaxWaitSeconds](FMassExecutionContext& Context)
+    {
+        const float DeltaSeconds = Context.GetDeltaTimeSeconds();
+        const TArrayView<FAgentPositionFragment> Positions = Context.GetMutableFragmentView<FAgentPositionFragment>();
+        const TConstArrayView<FAgentDestinationFragment> Destinations = Context.GetFragmentView<FAgentDestinationFragment>();
+        const TArrayView<FAgentScheduleFragment> Schedules = Context.GetMutableFragmentView<FAgentScheduleFragment>();
+        const TArrayView<FAgentSatisfactionFragment> Satisfactions = Context.GetMutableFragmentView<FAgentSatisfactionFragment>();
+
+        for (int32 EntityIndex = 0; EntityIndex < Context.GetNumEntities(); EntityIndex++)
+        {
+            FAgentScheduleFragment& Schedule = Schedules[EntityIndex];
+            if (Schedule.Task != EAgentTask::Walking && Schedule.Task != EAgentTask::Leaving)
+            {
+                continue;
+            }
+
+            FAgentPositionFragment& Position = Positions[EntityIndex];
+            const FVector ToDestination = Destinations[EntityIndex].Location - Position.Location;
+            const float Distance = ToDestination.Size();
+            const float Step = Position.Speed * DeltaSeconds;
+
+            float WalkSeconds = DeltaSeconds;
+            if (Step < Distance)
+            {
+                Position.Location += ToDestination * (Step / Distance);
+            }
+            else
+            {
+                // Arrived during this step; only the part of it spent walking counts
+                Position.Location = Destinations[EntityIndex].Location;
+                WalkSeconds = Position.Speed > 0.0f ? Distance / Position.Speed : 0.0f;
+
+                if (Schedule.Task == EAgentTask::Walking)
+                {
+                    Schedule.Task = EAgentTask::Waiting;
+                    Schedule.TimeLeft = MaxWaitSeconds;
+                }
+                else
+                {
+                    Schedule.Task = EAgentTask::Done;
+                }
+            }
+
+            // Staff have no satisfaction
+            if (Satisfactions.Num() > 0)
+            {
+                Satisfactions[EntityIndex].WalkSeconds += WalkSeconds;
+            }
+        }
+    });
+}
+
+UAgentDecisionProcessor::UAgentDecisionProcessor()
+    : GuestQuery(*this)
+    , StaffQuery(*this)
+{
+    // Run by UMassAgentSubsystem, after the movement processor
+    bAutoRegisterWithProcessingPhases = false;
+    ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::All);
+}
+
+void UAgentDecisionProcessor::ConfigureQueries()
+{
+    GuestQuery.AddRequirement<FAgentPositionFragment>(EMassFragmentAccess::ReadOnly);
+    GuestQuery.AddRequirement<FAgentDestinationFragment>(EMassFragmentAccess::ReadWrite);
+    GuestQuery.AddRequirement<FAgentScheduleFragment>(EMassFragmentAccess::ReadWrite);
+    GuestQuery.AddRequirement<FAgentSatisfactionFragment>(EMassFragmentAccess::ReadWrite);
+    GuestQuery.AddTagRequirement<FAgentGuestTag>(EMassFragmentPresence::All);
+
+    StaffQuery.AddRequirement<FAgentDestinationFragment>(EMassFragmentAccess::ReadWrite);
+    StaffQuery.AddRequirement<FAgentScheduleFragment>(EMassFragmentAccess::ReadWrite);
+    StaffQuery.AddTagRequirement<FAgentStaffTag>(EMassFragmentPresence::All);
+}
+
+void UAgentDecisionProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+    UMassAgentSubsystem* Agents = UWorld::GetSubsystem<UMassAgentSubsystem>(EntityManager.GetWorld());
+    if (!Agents)
+    {
+        return;
+    }
+
+    // Every chunk reads the same snapshot; buildings only change on the game thread, between steps
+    const TArray<FAgentBuildingInfo>& Buildings = Agents->GetBuildingSnapshot();
+    const FVector Entrance = Agents->GetEntranceLocation();
+    const FGuestSatisfactionWeights Weights = Agents->SatisfactionWeights;
+
+    GuestQuery.ParallelForEachEntityChunk(EntityManager, Context, [Agents, &Buildings, &Entrance, &Weights](FMassExecutionContext& Context)
+    {
+        const float DeltaSeconds = Context.GetDeltaTimeSeconds();
+        const TConstArrayView<FAgentPositionFragment> Positions = Context.GetFragmentView<FAgentPositionFragment>();
+        const TArrayView<FAgentDestinationFragment> Destinations = Context.GetMutableFragmentView<FAgentDestinationFragment>();
+        const TArrayView<FAgentScheduleFragment> Schedules = Context.GetMutableFragmentView<FAgentScheduleFragment>();
+        const TArrayView<FAgentSatisfactionFragment> Satisfactions = Context.GetMutableFragmentView<FAgentSatisfactionFragment>();
+
+        for (int32 EntityIndex = 0; EntityIndex < Context.GetNumEntities(); EntityIndex++)
+        {
+            FAgentDestinationFragment& Destination = Destinations[EntityIndex];
+            FAgentScheduleFragment& Schedule = Schedules[EntityIndex];
+            FAgentSatisfactionFragment& Satisfaction = Satisfactions[EntityIndex];
+            const FMassEntityHandle Entity = Context.GetEntity(EntityIndex);
+
+            switch (Schedule.Task)
+            {
+            case EAgentTask::Deciding:
+            {
+                // Treatments first, then a meal; wishes no open building can serve are dropped
+                const FAgentPositionFragment& Position = Positions[EntityIndex];
+                const FAgentBuildingInfo* Best = nullptr;
+                if (Schedule.TreatmentsLeft > 0)
+                {
+                    Best = ChooseBuilding(Buildings, Position.Location, Position.Speed, true);
+                    Schedule.TreatmentsLeft = Best ? Schedule.TreatmentsLeft : 0;
+                }
+                if (!Best && !Schedule.bHasEaten)
+                {
+                    Best = ChooseBuilding(Buildings, Position.Location, Position.Speed, false);
+                    Schedule.bHasEaten = !Best;
+                }
+
+                if (Best)
+                {
+                    Destination.Building = Best->Handle;
+                    Destination.Location = Best->Location;
+                    Schedule.Task = EAgentTask::Walking;
+                }
+                else
+                {
+                    StartLeaving(Schedule, Destination, Entrance);
+                }
+                break;
+            }
+
+            case EAgentTask::Waiting:
+            {
+                const FAgentBuildingInfo* Building = FindBuildingInfo(Buildings, Destination.Building);
+                if (Schedule.bRequestPending)
+                {
+                    break;
+                }
+
+                // The building closed while the guest was on the way, choose another one
+                if (!Building || !Building->bOpen)
+                {
+                    Schedule.Task = EAgentTask::Deciding;
+                    break;
+                }
+
+                Satisfaction.WaitSeconds += DeltaSeconds;
+                Schedule.TimeLeft -= DeltaSeconds;
+                if (Schedule.TimeLeft <= 0.0f)
+                {
+                    Satisfaction.AbandonedQueues++;
+                    DropWish(Schedule, *Building);
+                    Schedule.Task = EAgentTask::Deciding;
+                }
+                else if (Building->FreePlaces > 0)
+                {
+                    Schedule.bRequestPending = true;
+                    RequestEnter(Context, Agents, Entity, *Building, false);
+                }
+                break;
+            }
+
+            case EAgentTask::Visiting:
+            {
+                // A removed building ends the visit early
+                const FAgentBuildingInfo* Building = FindBuildingInfo(Buildings, Destination.Building);
+                Schedule.TimeLeft -= DeltaSeconds;
+                if (Building && Schedule.TimeLeft > 0.0f)
+                {
+                    break;
+                }
+
+                Context.Defer().PushCommand<FMassDeferredSetCommand>([Agents, Entity, Handle = Destination.Building](FMassEntityManager&)
+                {
+                    Agents->LeaveBuilding(Entity, Handle, false);
+                });
+
+                if (Building)
+                {
+                    Satisfaction.AmbienceSum += Building->Ambience;
+                    Satisfaction.QualitySum += Building->Quality;
+                    Satisfaction.Visits++;
+                    DropWish(Schedule, *Building);
+                }
+                Schedule.Task = EAgentTask::Deciding;
+                break;
+            }
+
+            case EAgentTask::Done:
+            {
+                Context.Defer().PushCommand<FMassDeferredSetCommand>([Agents, Score = Satisfaction.GetSatisfaction(Weights)](FMassEntityManager&)
+                {
+                    Agents->OnGuestDeparted(Score);
+                });
+                Context.Defer().DestroyEntity(Entity);
+                break;
+            }
+
+            default:
+                break;
+            }
+        }
+    });
+
+    StaffQuery.ParallelForEachEntityChunk(EntityManager, Context, [Agents, &Buildings, &Entrance](FMassExecutionContext& Context)
+    {
+        const float DeltaSeconds = Context.GetDeltaTimeSeconds();
+        const TArrayView<FAgentDestinationFragment> Destinations = Context.GetMutableFragmentView<FAgentDestinationFragment>();
+        const TArrayView<FAgentScheduleFragment> Schedules = Context.GetMutableFragmentView<FAgentScheduleFragment>();
+
+        for (int32 EntityIndex = 0; EntityIndex < Context.GetNumEntities(); EntityIndex++)
+        {
+            FAgentDestinationFragment& Destination = Destinations[EntityIndex];
+            FAgentScheduleFragment& Schedule = Schedules[EntityIndex];
+            if (Schedule.Task == EAgentTask::Leaving || Schedule.bRequestPending)
+            {
+                continue;
+            }
+
+            if (Schedule.Task == EAgentTask::Done)
+            {
+                Context.Defer().PushCommand<FMassDeferredSetCommand>([Agents](FMassEntityManager&)
+                {
+                    Agents->OnStaffDeparted();
+                });
+                Context.Defer().DestroyEntity(Context.GetEntity(EntityIndex));
+                continue;
+            }
+
+            // Staff go home when their shift is over or their building was removed
+            const FAgentBuildingInfo* Building = FindBuildingInfo(Buildings, Destination.Building);
+            Schedule.ShiftLeft -= DeltaSeconds;
+            if (!Building || Schedule.ShiftLeft <= 0.0f)
+            {
+                if (Schedule.Task == EAgentTask::Visiting)
+                {
+                    Context.Defer().PushCommand<FMassDeferredSetCommand>([Agents, Entity = Context.GetEntity(EntityIndex), Handle = Destination.Building](FMassEntityManager&)
+                    {
+                        Agents->LeaveBuilding(Entity, Handle, true);
+                    });
+                }
+                StartLeaving(Schedule, Destination, Entrance);
+                continue;
+            }
+
+            if (Schedule.Task == EAgentTask::Deciding)
+            {
+                Destination.Location = Building->Location;
+                Schedule.Task = EAgentTask::Walking;
+            }
+            else if (Schedule.Task == EAgentTask::Waiting)
+            {
+                Schedule.bRequestPending = true;
+                RequestEnter(Context, Agents, Context.GetEntity(EntityIndex), *Building, true);
+            }
+        }
+    });
+}
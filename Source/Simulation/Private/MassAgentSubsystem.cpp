@@ -0,0 +1,249 @@
+﻿// MassAgentSubsystem.cpp - Implementation of the entity guests and staff
+#include "MassAgentSubsystem.h"
+#include "MassAgentFragments.h"
+#include "MassAgentProcessors.h"
+#include "MassEntitySubsystem.h"
+#include "MassEntityManager.h"
+#include "MassExecutor.h"
+#include "SimulationClockSubsystem.h"
+#include "StaffSchedulingSubsystem.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "BuildingGridManager.h"
+#include "BuildingObject.h"
+#include "BuildingObjectAsset.h"
+
+void UMassAgentSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    Collection.InitializeDependency<UMassEntitySubsystem>();
+
+    if (USimulationClockSubsystem* Clock = Collection.InitializeDependency<USimulationClockSubsystem>())
+    {
+        Clock->OnSimulationStep.AddUObject(this, &UMassAgentSubsystem::HandleSimulationStep);
+    }
+}
+
+void UMassAgentSubsystem::Deinitialize()
+{
+    if (USimulationClockSubsystem* Clock = GetWorld()->GetSubsystem<USimulationClockSubsystem>())
+    {
+        Clock->OnSimulationStep.RemoveAll(this);
+    }
+
+    // Entities go with the world's entity manager
+    Pipeline.Reset();
+    Processors.Reset();
+    EntityManager.Reset();
+    GridManager = nullptr;
+    BuildingSnapshot.Reset();
+
+    Super::Deinitialize();
+}
+
+void UMassAgentSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+    Super::OnWorldBeginPlay(InWorld);
+
+    // Use the first grid in the level unless one was set explicitly
+    if (!GridManager)
+    {
+        for (TActorIterator<ABuildingGridManager> It(&InWorld); It; ++It)
+        {
+            SetGridManager(*It);
+            break;
+        }
+    }
+
+    UMassEntitySubsystem* EntitySubsystem = InWorld.GetSubsystem<UMassEntitySubsystem>();
+    if (!EntitySubsystem)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("MassAgentSubsystem: No entity subsystem, agents are disabled"));
+        return;
+    }
+
+    EntityManager = EntitySubsystem->GetMutableEntityManager().AsShared();
+
+    GuestArchetype = EntityManager->CreateArchetype({
+        FAgentPositionFragment::StaticStruct(),
+        FAgentDestinationFragment::StaticStruct(),
+        FAgentScheduleFragment::StaticStruct(),
+        FAgentSatisfactionFragment::StaticStruct(),
+        FAgentGuestTag::StaticStruct() });
+
+    StaffArchetype = EntityManager->CreateArchetype({
+        FAgentPositionFragment::StaticStruct(),
+        FAgentDestinationFragment::StaticStruct(),
+        FAgentScheduleFragment::StaticStruct(),
+        FAgentStaffTag::StaticStruct() });
+
+    // Agents move first, so arrivals are decided on in the same step
+    Processors.Add(NewObject<UAgentMovementProcessor>(this));
+    Processors.Add(NewObject<UAgentDecisionProcessor>(this));
+    for (UMassProcessor* Processor : Processors)
+    {
+        Pipeline.AppendProcessor(*Processor);
+    }
+    Pipeline.Initialize(*this);
+}
+
+void UMassAgentSubsystem::HandleSimulationStep(int32 Seconds)
+{
+    if (!EntityManager.IsValid() || NumGuests + NumStaff == 0)
+    {
+        return;
+    }
+
+    UpdateBuildingSnapshot();
+
+    // Deferred building registrations and destructions are flushed at the end of the run
+    FMassProcessingContext ProcessingContext(*EntityManager, static_cast<float>(Seconds));
+    UE::Mass::Executor::Run(Pipeline, ProcessingContext);
+}
+
+void UMassAgentSubsystem::SetGridManager(ABuildingGridManager* InGridManager)
+{
+    GridManager = InGridManager;
+    EntranceLocation = GridManager ? GridManager->GridToWorld(GridManager->GetEntranceCell()) : FVector::ZeroVector;
+}
+
+int32 UMassAgentSubsystem::SpawnGuests(int32 Count, int32 NumTreatments)
+{
+    TArray<FMassEntityHandle> Entities;
+    CreateAgents(GuestArchetype, Count, Entities);
+
+    for (const FMassEntityHandle& Entity : Entities)
+    {
+        EntityManager->GetFragmentDataChecked<FAgentScheduleFragment>(Entity).TreatmentsLeft = FMath::Max(0, NumTreatments);
+    }
+
+    NumGuests += Entities.Num();
+    return Entities.Num();
+}
+
+int32 UMassAgentSubsystem::SpawnStaff(FBuildingHandle Building, int32 Count)
+{
+    if (!GridManager || !GridManager->GetBuilding(Building))
+    {
+        return 0;
+    }
+
+    // Staff work one shift of the staff schedule, as long as the staff actors it assigns
+    const UStaffSchedulingSubsystem* Scheduling = GetWorld()->GetSubsystem<UStaffSchedulingSubsystem>();
+    const float ShiftSeconds = Scheduling ? static_cast<float>(Scheduling->GetShiftLengthSeconds()) : 8.0f * 3600.0f;
+
+    TArray<FMassEntityHandle> Entities;
+    CreateAgents(StaffArchetype, Count, Entities);
+
+    for (const FMassEntityHandle& Entity : Entities)
+    {
+        EntityManager->GetFragmentDataChecked<FAgentDestinationFragment>(Entity).Building = Building;
+        EntityManager->GetFragmentDataChecked<FAgentScheduleFragment>(Entity).ShiftLeft = ShiftSeconds;
+    }
+
+    NumStaff += Entities.Num();
+    return Entities.Num();
+}
+
+bool UMassAgentSubsystem::EnterBuilding(const FMassEntityHandle& Agent, const FBuildingHandle& Building, bool bStaff) const
+{
+    ABuildingObject* BuildingActor = GridManager ? GridManager->GetBuilding(Building) : nullptr;
+    if (!BuildingActor)
+    {
+        return false;
+    }
+
+    const FAgentHandle Handle(Agent.Index, Agent.SerialNumber);
+    return bStaff ? BuildingActor->AssignAgentStaff(Handle) : BuildingActor->RegisterAgentGuest(Handle);
+}
+
+void UMassAgentSubsystem::LeaveBuilding(const FMassEntityHandle& Agent, const FBuildingHandle& Building, bool bStaff) const
+{
+    ABuildingObject* BuildingActor = GridManager ? GridManager->GetBuilding(Building) : nullptr;
+    if (!BuildingActor)
+    {
+        return;
+    }
+
+    const FAgentHandle Handle(Agent.Index, Agent.SerialNumber);
+    if (bStaff)
+    {
+        BuildingActor->RemoveAgentStaff(Handle);
+    }
+    else
+    {
+        BuildingActor->RemoveAgentGuest(Handle);
+    }
+}
+
+void UMassAgentSubsystem::OnGuestDeparted(float Satisfaction)
+{
+    NumGuests--;
+    DepartedGuests++;
+    DepartedSatisfactionSum += Satisfaction;
+}
+
+void UMassAgentSubsystem::UpdateBuildingSnapshot()
+{
+    for (FAgentBuildingInfo& Info : BuildingSnapshot)
+    {
+        Info = FAgentBuildingInfo();
+    }
+
+    if (!GridManager)
+    {
+        return;
+    }
+
+    for (const FBuildingHandle& Handle : GridManager->GetBuildingHandles())
+    {
+        const ABuildingObject* Building = GridManager->GetBuilding(Handle);
+        if (!Building)
+        {
+            continue;
+        }
+
+        if (Handle.Index >= BuildingSnapshot.Num())
+        {
+            BuildingSnapshot.SetNum(Handle.Index + 1);
+        }
+
+        FIntPoint Cell;
+        int32 FloorLevel, Rotation;
+        Building->GetGridProperties(Cell, FloorLevel, Rotation);
+
+        const UBuildingObjectAsset* Asset = Building->GetBuildingAsset();
+        const EBuildingType Type = Building->GetBuildingType();
+
+        FAgentBuildingInfo& Info = BuildingSnapshot[Handle.Index];
+        Info.Handle = Handle;
+        Info.Location = Building->GetActorLocation();
+        Info.VisitSeconds = (Asset ? Asset->VisitDurationMinutes : 60) * 60.0f;
+        Info.Quality = Building->GetEfficiency();
+        Info.Ambience = GridManager->GetInfluenceAt(Cell, EGridInfluenceChannel::Appeal, FloorLevel)
+            + GridManager->GetInfluenceAt(Cell, EGridInfluenceChannel::Tranquility, FloorLevel)
+            - GridManager->GetInfluenceAt(Cell, EGridInfluenceChannel::Noise, FloorLevel);
+        Info.FreePlaces = FMath::Max(0, (Asset ? Asset->MaxGuests : 1) - Building->GetNumGuests());
+        Info.bOffersTreatment = Asset && Asset->SupportedTreatments.Num() > 0;
+        Info.bServesFood = Type == EBuildingType::Restaurant || Type == EBuildingType::JuiceBar;
+        Info.bOpen = !Building->IsUnderConstruction() && Building->IsOperational();
+    }
+}
+
+void UMassAgentSubsystem::CreateAgents(const FMassArchetypeHandle& Archetype, int32 Count, TArray<FMassEntityHandle>& OutEntities)
+{
+    if (!EntityManager.IsValid() || !Archetype.IsValid() || Count <= 0)
+    {
+        return;
+    }
+
+    EntityManager->BatchCreateEntities(Archetype, Count, OutEntities);
+
+    for (const FMassEntityHandle& Entity : OutEntities)
+    {
+        FAgentPositionFragment& Position = EntityManager->GetFragmentDataChecked<FAgentPositionFragment>(Entity);
+        Position.Location = EntranceLocation;
+        Position.Speed = WalkSpeed;
+    }
+}
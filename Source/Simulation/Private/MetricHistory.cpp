@@ -0,0 +1,74 @@
+﻿// MetricHistory.cpp - Implementation of the metric history
+#include "MetricHistory.h"
+
+void FMetricHistory::Reset(int32 InNumMetrics, int32 NumHours, int32 NumDays, int32 NumWeeks)
+{
+    MetricCount = FMath::Max(0, InNumMetrics);
+
+    const int32 Capacities[3] = { NumHours, NumDays, NumWeeks };
+    for (int32 LevelIndex = 0; LevelIndex < 3; LevelIndex++)
+    {
+        FLevel& Level = Levels[LevelIndex];
+        Level.Capacity = FMath::Max(1, Capacities[LevelIndex]);
+        Level.Samples.Reset();
+        Level.Samples.SetNum(Level.Capacity * MetricCount);
+        Level.Head = 0;
+        Level.Num = 0;
+        Level.Open.Reset();
+        Level.Open.SetNum(MetricCount);
+        Level.OpenPeriods = 0;
+    }
+}
+
+void FMetricHistory::CloseHour()
+{
+    CloseLevel(0);
+
+    if (Levels[1].OpenPeriods == HoursPerDay)
+    {
+        CloseLevel(1);
+
+        if (Levels[2].OpenPeriods == DaysPerWeek)
+        {
+            CloseLevel(2);
+        }
+    }
+}
+
+FMetricSeriesView FMetricHistory::GetSeries(int32 Metric, EMetricResolution Resolution) const
+{
+    if (Metric < 0 || Metric >= MetricCount)
+    {
+        return FMetricSeriesView();
+    }
+
+    const FLevel& Level = Levels[static_cast<int32>(Resolution)];
+    const int32 First = Level.Num < Level.Capacity ? 0 : Level.Head;
+    return FMetricSeriesView(Level.Samples.GetData() + Metric * Level.Capacity, Level.Capacity, First, Level.Num);
+}
+
+void FMetricHistory::CloseLevel(int32 LevelIndex)
+{
+    FLevel& Level = Levels[LevelIndex];
+    FLevel* Next = LevelIndex + 1 < 3 ? &Levels[LevelIndex + 1] : nullptr;
+
+    for (int32 Metric = 0; Metric < MetricCount; Metric++)
+    {
+        FMetricSample& Open = Level.Open[Metric];
+        Level.Samples[Metric * Level.Capacity + Level.Head] = Open;
+        if (Next)
+        {
+            Next->Open[Metric].Merge(Open);
+        }
+        Open = FMetricSample();
+    }
+
+    Level.Head = Level.Head + 1 < Level.Capacity ? Level.Head + 1 : 0;
+    Level.Num = FMath::Min(Level.Num + 1, Level.Capacity);
+    Level.OpenPeriods = 0;
+
+    if (Next)
+    {
+        Next->OpenPeriods++;
+    }
+}
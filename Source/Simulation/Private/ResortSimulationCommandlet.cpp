@@ -0,0 +1,68 @@
+﻿// ResortSimulationCommandlet.cpp - Implementation of the headless simulation commandlet
+#include "ResortSimulationCommandlet.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Misc/Parse.h"
+#include "UObject/Package.h"
+#include "ResortSimulationSubsystem.h"
+
+UResortSimulationCommandlet::UResortSimulationCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UResortSimulationCommandlet::Main(const FString& Params)
+{
+    FString MapName;
+    int32 Days = 30;
+    FParse::Value(*Params, TEXT("Map="), MapName);
+    FParse::Value(*Params, TEXT("Days="), Days);
+
+    if (MapName.IsEmpty())
+    {
+        UE_LOG(LogTemp, Error, TEXT("Usage: -run=ResortSimulation -Map=<map package> [-Days=<days>]"));
+        return 1;
+    }
+
+    UPackage* MapPackage = LoadPackage(nullptr, *MapName, LOAD_None);
+    UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+    if (!World)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Could not load map %s"), *MapName);
+        return 1;
+    }
+
+    // Bring the level up as a game world, without audio or physics
+    World->AddToRoot();
+    World->WorldType = EWorldType::Game;
+
+    FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+    WorldContext.SetCurrentWorld(World);
+
+    World->InitWorld(UWorld::InitializationValues()
+        .AllowAudioPlayback(false)
+        .CreatePhysicsScene(false)
+        .CreateNavigation(false)
+        .CreateAISystem(false)
+        .ShouldSimulatePhysics(false));
+    World->InitializeActorsForPlay(FURL());
+    World->BeginPlay();
+
+    int32 Result = 1;
+    if (UResortSimulationSubsystem* Simulation = World->GetSubsystem<UResortSimulationSubsystem>())
+    {
+        const FFastForwardReport Report = Simulation->RunFastForward(Days);
+        UE_LOG(LogTemp, Display, TEXT("Simulated %.0f days in %.3f s (%.1f days/s), %lld events, balance %lld"),
+            Report.SimulatedDays, Report.WallSeconds, Report.DaysPerSecond, Report.DispatchedEvents, Simulation->GetBalance());
+        Result = 0;
+    }
+
+    GEngine->DestroyWorldContext(World);
+    World->DestroyWorld(false);
+    World->RemoveFromRoot();
+
+    return Result;
+}
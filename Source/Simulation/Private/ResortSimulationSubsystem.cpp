@@ -0,0 +1,1153 @@
+﻿// ResortSimulationSubsystem.cpp - Implementation of the resort simulation
+#include "ResortSimulationSubsystem.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Engine/GameViewportClient.h"
+#include "HAL/PlatformTime.h"
+#include "BuildingGridManager.h"
+#include "BuildingObject.h"
+#include "BuildingObjectAsset.h"
+#include "StaffSchedulingSubsystem.h"
+#include "SimulationClockSubsystem.h"
+
+void UResortSimulationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    if (USimulationClockSubsystem* Clock = Collection.InitializeDependency<USimulationClockSubsystem>())
+    {
+        Clock->OnSimulationStep.AddUObject(this, &UResortSimulationSubsystem::HandleSimulationStep);
+    }
+
+    // The first day starts immediately, every day schedules the next one
+    EventWheel.Reset(0);
+    TreatmentScheduler.Reset(AppointmentWindowSlots, 0);
+    EventWheel.Schedule(0, FSimEvent(static_cast<uint8>(EEventType::DayStart), INDEX_NONE, 0));
+}
+
+void UResortSimulationSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+    Super::OnWorldBeginPlay(InWorld);
+
+    // Use the first grid in the level unless one was set explicitly
+    if (!GridManager)
+    {
+        for (TActorIterator<ABuildingGridManager> It(&InWorld); It; ++It)
+        {
+            SetGridManager(*It);
+            break;
+        }
+    }
+}
+
+void UResortSimulationSubsystem::Deinitialize()
+{
+    if (GridManager)
+    {
+        GridManager->OnBuildingPlaced.RemoveDynamic(this, &UResortSimulationSubsystem::HandleBuildingPlaced);
+        GridManager->OnBuildingRemoved.RemoveDynamic(this, &UResortSimulationSubsystem::HandleBuildingRemoved);
+        GridManager->OnBuildingMoved.RemoveDynamic(this, &UResortSimulationSubsystem::HandleBuildingMoved);
+        GridManager->OnGridExpanded.RemoveDynamic(this, &UResortSimulationSubsystem::HandleGridExpanded);
+        GridManager = nullptr;
+    }
+
+    if (USimulationClockSubsystem* Clock = GetWorld()->GetSubsystem<USimulationClockSubsystem>())
+    {
+        Clock->OnSimulationStep.RemoveAll(this);
+    }
+
+    Super::Deinitialize();
+}
+
+void UResortSimulationSubsystem::Tick(float DeltaTime)
+{
+    // Regular time comes from the clock's steps
+    if (IsFastForwarding())
+    {
+        TickFastForward();
+    }
+}
+
+TStatId UResortSimulationSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UResortSimulationSubsystem, STATGROUP_Tickables);
+}
+
+void UResortSimulationSubsystem::SetGridManager(ABuildingGridManager* InGridManager)
+{
+    if (GridManager == InGridManager)
+    {
+        return;
+    }
+
+    if (GridManager)
+    {
+        GridManager->OnBuildingPlaced.RemoveDynamic(this, &UResortSimulationSubsystem::HandleBuildingPlaced);
+        GridManager->OnBuildingRemoved.RemoveDynamic(this, &UResortSimulationSubsystem::HandleBuildingRemoved);
+        GridManager->OnBuildingMoved.RemoveDynamic(this, &UResortSimulationSubsystem::HandleBuildingMoved);
+        GridManager->OnGridExpanded.RemoveDynamic(this, &UResortSimulationSubsystem::HandleGridExpanded);
+
+        // Guests of the old grid cannot reach the new one's buildings
+        for (int32 BuildingIndex = 0; BuildingIndex < Buildings.Num(); BuildingIndex++)
+        {
+            if (Buildings[BuildingIndex].Handle.IsValid())
+            {
+                HandleBuildingRemoved(Buildings[BuildingIndex].Handle, Buildings[BuildingIndex].Building.Get());
+            }
+        }
+    }
+
+    GridManager = InGridManager;
+
+    if (GridManager)
+    {
+        GridManager->OnBuildingPlaced.AddDynamic(this, &UResortSimulationSubsystem::HandleBuildingPlaced);
+        GridManager->OnBuildingRemoved.AddDynamic(this, &UResortSimulationSubsystem::HandleBuildingRemoved);
+        GridManager->OnBuildingMoved.AddDynamic(this, &UResortSimulationSubsystem::HandleBuildingMoved);
+        GridManager->OnGridExpanded.AddDynamic(this, &UResortSimulationSubsystem::HandleGridExpanded);
+
+        for (const FBuildingHandle& Handle : GridManager->GetBuildingHandles())
+        {
+            HandleBuildingPlaced(Handle, GridManager->GetBuilding(Handle));
+        }
+    }
+}
+
+int32 UResortSimulationSubsystem::ScheduleGuestArrival(int64 DelaySeconds, int32 NumTreatments)
+{
+    return ScheduleGroupArrival(DelaySeconds, 1, NumTreatments);
+}
+
+int32 UResortSimulationSubsystem::ScheduleGroupArrival(int64 DelaySeconds, int32 GroupSize, int32 NumTreatments)
+{
+    // Members are linked in order, only the first one gets the arrival event
+    int32 FirstGuestId = INDEX_NONE;
+    int32 PreviousGuestId = INDEX_NONE;
+    for (int32 Member = 0; Member < FMath::Max(1, GroupSize); Member++)
+    {
+        int32 GuestId;
+        if (FreeGuestIds.Num() > 0)
+        {
+            GuestId = FreeGuestIds.Pop(EAllowShrinking::No);
+            Guests[GuestId] = FSimGuest();
+        }
+        else
+        {
+            GuestId = Guests.AddDefaulted();
+        }
+
+        FSimGuest& Guest = Guests[GuestId];
+        Guest.Activity = EGuestActivity::Arriving;
+        Guest.TreatmentsLeft = FMath::Max(0, NumTreatments);
+
+        if (PreviousGuestId != INDEX_NONE)
+        {
+            Guests[PreviousGuestId].NextInGroup = GuestId;
+        }
+        else
+        {
+            FirstGuestId = GuestId;
+        }
+        PreviousGuestId = GuestId;
+    }
+
+    Guests[FirstGuestId].PendingEvent = EventWheel.Schedule(EventWheel.GetNow() + FMath::Max<int64>(0, DelaySeconds), FSimEvent(static_cast<uint8>(EEventType::Arrive), FirstGuestId));
+
+    return FirstGuestId;
+}
+
+int32 UResortSimulationSubsystem::AdvanceSimulation(int64 Seconds)
+{
+    if (Seconds <= 0)
+    {
+        return 0;
+    }
+
+    const int32 NumDispatched = EventWheel.Advance(EventWheel.GetNow() + Seconds, [this](int64 Time, const FSimEvent& Event)
+    {
+        DispatchEvent(Time, Event);
+    });
+
+    Stats.DispatchedEvents += NumDispatched;
+    return NumDispatched;
+}
+
+FFastForwardReport UResortSimulationSubsystem::RunFastForward(int32 Days)
+{
+    return FastForwardTo(EventWheel.GetNow() + FMath::Max(0, Days) * SecondsPerDay);
+}
+
+void UResortSimulationSubsystem::StartFastForward(int32 Days, float BudgetMilliseconds)
+{
+    if (Days <= 0 || IsFastForwarding())
+    {
+        return;
+    }
+
+    FastForward.TargetTime = EventWheel.GetNow() + Days * SecondsPerDay;
+    FastForward.StartTime = EventWheel.GetNow();
+    FastForward.StartEvents = Stats.DispatchedEvents;
+    FastForward.StartWallTime = FPlatformTime::Seconds();
+    FastForward.BudgetMilliseconds = FMath::Max(1.0f, BudgetMilliseconds);
+
+    // Nothing needs to be drawn while days fly by
+    if (UGameViewportClient* Viewport = GetWorld()->GetGameViewport())
+    {
+        FastForward.bRenderingWasDisabled = Viewport->bDisableWorldRendering;
+        Viewport->bDisableWorldRendering = true;
+    }
+}
+
+FFastForwardReport UResortSimulationSubsystem::SkipToMorning()
+{
+    int64 Morning = GetCurrentDay() * SecondsPerDay + OpeningHour * 3600;
+    if (Morning <= EventWheel.GetNow())
+    {
+        Morning += SecondsPerDay;
+    }
+
+    return FastForwardTo(Morning);
+}
+
+EGuestActivity UResortSimulationSubsystem::GetGuestActivity(int32 GuestId) const
+{
+    return Guests.IsValidIndex(GuestId) ? Guests[GuestId].Activity : EGuestActivity::None;
+}
+
+float UResortSimulationSubsystem::GetGuestSatisfaction(int32 GuestId) const
+{
+    if (!Guests.IsValidIndex(GuestId) || Guests[GuestId].SatisfactionRecord == INDEX_NONE)
+    {
+        return 0.0f;
+    }
+
+    return Satisfaction.GetSatisfaction(Guests[GuestId].SatisfactionRecord, SatisfactionWeights);
+}
+
+bool UResortSimulationSubsystem::GetGuestAppointment(int32 GuestId, FTreatmentAppointment& OutAppointment) const
+{
+    if (!Guests.IsValidIndex(GuestId) || !Guests[GuestId].Appointment.IsValid())
+    {
+        return false;
+    }
+
+    OutAppointment = MakeAppointment(Guests[GuestId].Appointment);
+    return true;
+}
+
+bool UResortSimulationSubsystem::FindEarliestAppointment(FName Treatment, FTreatmentAppointment& OutAppointment)
+{
+    const FIntPoint Entrance = GridManager ? GridManager->GetEntranceCell() : FIntPoint::ZeroValue;
+    const FTreatmentBooking Booking = TreatmentScheduler.FindBest(Treatment, AdvanceAppointmentsToNow(), [this, &Entrance](int32 BuildingIndex)
+    {
+        return GetTravelSlots(Entrance, 0, BuildingIndex);
+    });
+
+    if (!Booking.IsValid())
+    {
+        return false;
+    }
+
+    OutAppointment = MakeAppointment(Booking);
+    return true;
+}
+
+bool UResortSimulationSubsystem::RegisterBuilder(AActor* Builder)
+{
+    if (!Builder || Builders.Contains(Builder))
+    {
+        return false;
+    }
+
+    const FIntPoint Entrance = GridManager ? GridManager->GetEntranceCell() : FIntPoint::ZeroValue;
+    const int32 BuilderId = ConstructionQueue.AddBuilder(Entrance, 0);
+    if (BuilderId >= Builders.Num())
+    {
+        Builders.SetNum(BuilderId + 1);
+    }
+    Builders[BuilderId] = Builder;
+
+    return true;
+}
+
+bool UResortSimulationSubsystem::UnregisterBuilder(AActor* Builder)
+{
+    const int32 BuilderId = Builder ? Builders.IndexOfByKey(Builder) : INDEX_NONE;
+    if (BuilderId == INDEX_NONE)
+    {
+        return false;
+    }
+
+    ConstructionQueue.RemoveBuilder(BuilderId);
+    Builders[BuilderId].Reset();
+    return true;
+}
+
+bool UResortSimulationSubsystem::SetConstructionPriority(FBuildingHandle Building, int32 Priority)
+{
+    return FindBuilding(Building) && ConstructionQueue.SetPriority(Building.Index, Priority);
+}
+
+void UResortSimulationSubsystem::DispatchEvent(int64 Time, const FSimEvent& Event)
+{
+    if (static_cast<EEventType>(Event.Type) == EEventType::DayStart)
+    {
+        OnDayStart(Event.Data);
+        return;
+    }
+
+    if (static_cast<EEventType>(Event.Type) == EEventType::ShiftStart)
+    {
+        // Every run of a shift ends at its own time, even when that is after the next midnight
+        if (UStaffSchedulingSubsystem* Staffing = GetWorld()->GetSubsystem<UStaffSchedulingSubsystem>())
+        {
+            const int32 ShiftRun = Staffing->ApplyShift(Event.Data);
+            EventWheel.Schedule(Time + Staffing->GetShiftLengthSeconds(), FSimEvent(static_cast<uint8>(EEventType::ShiftEnd), INDEX_NONE, ShiftRun));
+        }
+        return;
+    }
+
+    if (static_cast<EEventType>(Event.Type) == EEventType::ShiftEnd)
+    {
+        if (UStaffSchedulingSubsystem* Staffing = GetWorld()->GetSubsystem<UStaffSchedulingSubsystem>())
+        {
+            Staffing->EndShift(Event.Data);
+        }
+        return;
+    }
+
+    if (static_cast<EEventType>(Event.Type) == EEventType::ConstructionTick)
+    {
+        OnConstructionTick();
+        return;
+    }
+
+    if (static_cast<EEventType>(Event.Type) == EEventType::MetricsHour)
+    {
+        OnMetricsHour();
+        return;
+    }
+
+    if (!Guests.IsValidIndex(Event.Subject))
+    {
+        return;
+    }
+
+    switch (static_cast<EEventType>(Event.Type))
+    {
+        case EEventType::Arrive:
+            OnGuestArrive(Event.Subject);
+            break;
+        case EEventType::ReachBuilding:
+            OnGuestReachBuilding(Event.Subject);
+            break;
+        case EEventType::VisitEnd:
+            OnGuestVisitEnd(Event.Subject);
+            break;
+        case EEventType::QueueTimeout:
+            OnGuestQueueTimeout(Event.Subject);
+            break;
+        case EEventType::Leave:
+            OnGuestLeave(Event.Subject);
+            break;
+        default:
+            break;
+    }
+}
+
+void UResortSimulationSubsystem::OnDayStart(int32 Day)
+{
+    if (Day == 0)
+    {
+        ArrivalStream.Initialize(RandomSeed);
+        Ledger.Reset(StartingFunds);
+        Satisfaction.Reset();
+
+        Metrics.Reset(static_cast<int32>(EResortMetric::Count));
+        MetricsHour = 0;
+        OnMetricsHour();
+
+        Forecaster.Reset(ForecastLevelSmoothing, ForecastTrendSmoothing, ForecastSeasonSmoothing);
+        ArrivalSeries = Forecaster.AddSeries(0);
+        TreatmentWishSeries = Forecaster.AddSeries(0);
+        TreatmentSeries.Reset();
+        TodayTreatmentWishes = 0;
+        TodayTreatmentLoad.Reset();
+    }
+    else
+    {
+        Ledger.CloseDay(Day);
+        ObserveDemand(Day - 1);
+
+        const FGuestSatisfactionReport& Report = Satisfaction.CloseDay(Day - 1, SatisfactionWeights, [this](int32 GuestId, int32 NewRecord)
+        {
+            Guests[GuestId].SatisfactionRecord = NewRecord;
+        });
+        UE_LOG(LogTemp, Verbose, TEXT("Day %d satisfaction: %.1f average over %d guests, %d unhappy"),
+            Report.Day, Report.AverageSatisfaction, Report.Guests, Report.UnhappyGuests);
+    }
+
+    // Plan the day's staff; each shift starts at its hour of the day and ends on its own event
+    const int64 DayStartTime = Day * SecondsPerDay;
+    if (UStaffSchedulingSubsystem* Staffing = GetWorld()->GetSubsystem<UStaffSchedulingSubsystem>())
+    {
+        Staffing->SolveDay();
+        for (int32 Shift = 0; Shift < Staffing->GetNumShifts(); Shift++)
+        {
+            EventWheel.Schedule(DayStartTime + Staffing->GetShiftStartSeconds(Shift), FSimEvent(static_cast<uint8>(EEventType::ShiftStart), INDEX_NONE, Shift));
+        }
+    }
+
+    // Daily building update and running costs
+    for (FSimBuilding& Building : Buildings)
+    {
+        if (ABuildingObject* BuildingActor = Building.Building.Get())
+        {
+            BuildingActor->OnDailyUpdate();
+
+            const int32 MaintenanceCost = BuildingActor->CalculateMaintenanceCost();
+            Ledger.AddCost(MaintenanceCost);
+            RecordMetric(EResortMetric::Costs, MaintenanceCost);
+        }
+    }
+
+    // Spread the day's arrivals over the opening hours, in groups
+    const int32 FirstArrival = OpeningHour * 3600;
+    const int32 LastArrival = FMath::Max(FirstArrival, ClosingHour * 3600 - 1);
+    for (int32 Remaining = DailyGuestArrivals; Remaining > 0; )
+    {
+        const int32 GroupSize = ArrivalStream.RandRange(1, FMath::Min(FMath::Max(1, MaxGroupSize), Remaining));
+        const int64 ArrivalTime = DayStartTime + ArrivalStream.RandRange(FirstArrival, LastArrival);
+        ScheduleGroupArrival(ArrivalTime - EventWheel.GetNow(), GroupSize, ArrivalStream.RandRange(1, FMath::Max(1, MaxTreatmentsPerGuest)));
+        Remaining -= GroupSize;
+    }
+
+    EventWheel.Schedule(DayStartTime + SecondsPerDay, FSimEvent(static_cast<uint8>(EEventType::DayStart), INDEX_NONE, Day + 1));
+
+    OnDayStarted.Broadcast(Day);
+}
+
+void UResortSimulationSubsystem::OnConstructionTick()
+{
+    bConstructionTickPending = false;
+
+    // Builders whose actors are gone stop working
+    for (int32 BuilderId = 0; BuilderId < Builders.Num(); BuilderId++)
+    {
+        if (!Builders[BuilderId].IsValid())
+        {
+            ConstructionQueue.RemoveBuilder(BuilderId);
+        }
+    }
+
+    // Without builders nobody would ever finish the sites, so they open right away
+    if (ConstructionQueue.NumBuilders() == 0)
+    {
+        ConstructionQueue.CompleteAll(CompletedSites);
+    }
+    else
+    {
+        ConstructionQueue.Advance(ConstructionTickMinutes / 60.0f, WalkSecondsPerCell / 3600.0f, WalkSecondsPerFloor / 3600.0f, CompletedSites);
+    }
+
+    for (int32 BuildingIndex : CompletedSites)
+    {
+        if (ABuildingObject* BuildingActor = Buildings[BuildingIndex].Building.Get())
+        {
+            BuildingActor->CompleteConstruction();
+            UE_LOG(LogTemp, Verbose, TEXT("Construction of %s completed on day %d"), *BuildingActor->GetName(), GetCurrentDay());
+        }
+    }
+
+    // Only the sites still queued have progress to report
+    if (ConstructionQueue.NumSites() > 0)
+    {
+        for (FSimBuilding& Building : Buildings)
+        {
+            ABuildingObject* BuildingActor = Building.Building.Get();
+            if (BuildingActor && ConstructionQueue.IsQueued(Building.Handle.Index))
+            {
+                BuildingActor->SetConstructionProgress(ConstructionQueue.GetProgress(Building.Handle.Index));
+            }
+        }
+    }
+
+    ScheduleConstructionTick();
+}
+
+void UResortSimulationSubsystem::ScheduleConstructionTick()
+{
+    if (bConstructionTickPending || ConstructionQueue.NumSites() == 0)
+    {
+        return;
+    }
+
+    EventWheel.Schedule(EventWheel.GetNow() + FMath::Max(1, ConstructionTickMinutes) * 60, FSimEvent(static_cast<uint8>(EEventType::ConstructionTick), INDEX_NONE));
+    bConstructionTickPending = true;
+}
+
+void UResortSimulationSubsystem::OnMetricsHour()
+{
+    int32 GuestsInBuildings = 0;
+    int32 Capacity = 0;
+    for (const FSimBuilding& Building : Buildings)
+    {
+        if (const ABuildingObject* BuildingActor = Building.Building.Get())
+        {
+            GuestsInBuildings += BuildingActor->GetNumGuests();
+            Capacity += Building.Capacity;
+        }
+    }
+
+    // Levels are sampled at the start of every hour
+    RecordMetric(EResortMetric::Balance, static_cast<float>(Ledger.GetBalance()));
+    RecordMetric(EResortMetric::Guests, Stats.ActiveGuests);
+    RecordMetric(EResortMetric::Occupancy, Capacity > 0 ? static_cast<float>(GuestsInBuildings) / Capacity : 0.0f);
+
+    EventWheel.Schedule((MetricsHour + 1) * 3600, FSimEvent(static_cast<uint8>(EEventType::MetricsHour), INDEX_NONE));
+}
+
+void UResortSimulationSubsystem::RecordMetric(EResortMetric Metric, float Value)
+{
+    // Nothing is recorded before the first day
+    if (Metrics.NumMetrics() == 0)
+    {
+        return;
+    }
+
+    // Hours close lazily, so events at the turn of an hour land in the right one whatever their order
+    for (const int64 Hour = EventWheel.GetNow() / 3600; MetricsHour < Hour; MetricsHour++)
+    {
+        Metrics.CloseHour();
+    }
+
+    Metrics.AddSample(static_cast<int32>(Metric), Value);
+}
+
+void UResortSimulationSubsystem::GetMetricHistory(EResortMetric Metric, EMetricResolution Resolution, TArray<float>& OutValues) const
+{
+    const FMetricSeriesView Series = Metrics.GetSeries(static_cast<int32>(Metric), Resolution);
+    const bool bTotals = Metric == EResortMetric::Revenue || Metric == EResortMetric::Costs;
+
+    OutValues.Reset(Series.Num());
+    for (int32 Index = 0; Index < Series.Num(); Index++)
+    {
+        OutValues.Add(bTotals ? Series[Index].Sum : Series[Index].GetAverage());
+    }
+}
+
+float UResortSimulationSubsystem::ForecastTreatmentDemand(FName Treatment, int32 DaysAhead) const
+{
+    if (Treatment.IsNone())
+    {
+        return Forecaster.Forecast(TreatmentWishSeries, DaysAhead);
+    }
+
+    const int32* Series = TreatmentSeries.Find(Treatment);
+    return Series ? Forecaster.Forecast(*Series, DaysAhead) : 0.0f;
+}
+
+void UResortSimulationSubsystem::RecordTreatmentLoad(const FSimBuilding& Building)
+{
+    const ABuildingObject* BuildingActor = Building.Building.Get();
+    const UBuildingObjectAsset* Asset = BuildingActor ? BuildingActor->GetBuildingAsset() : nullptr;
+    if (!Asset || Asset->SupportedTreatments.Num() == 0)
+    {
+        return;
+    }
+
+    // A series starts on the day its treatment is first given
+    const float Share = 1.0f / Asset->SupportedTreatments.Num();
+    for (const FName& Treatment : Asset->SupportedTreatments)
+    {
+        int32* Series = TreatmentSeries.Find(Treatment);
+        if (!Series)
+        {
+            Series = &TreatmentSeries.Add(Treatment, Forecaster.AddSeries(GetCurrentDay()));
+        }
+
+        if (*Series >= TodayTreatmentLoad.Num())
+        {
+            TodayTreatmentLoad.SetNumZeroed(*Series + 1);
+        }
+        TodayTreatmentLoad[*Series] += Share;
+    }
+}
+
+void UResortSimulationSubsystem::ObserveDemand(int32 ClosedDay)
+{
+    Forecaster.Observe(ArrivalSeries, Ledger.GetHistory().Last().Guests);
+    Forecaster.Observe(TreatmentWishSeries, TodayTreatmentWishes);
+
+    // Every treatment series gets a value each day, zero if nobody had it
+    for (const TPair<FName, int32>& Series : TreatmentSeries)
+    {
+        Forecaster.Observe(Series.Value, TodayTreatmentLoad.IsValidIndex(Series.Value) ? TodayTreatmentLoad[Series.Value] : 0.0f);
+    }
+
+    TodayTreatmentWishes = 0;
+    TodayTreatmentLoad.Reset();
+
+    UE_LOG(LogTemp, Verbose, TEXT("Day %d demand: %d arrivals, forecast %.1f for tomorrow"),
+        ClosedDay, Ledger.GetHistory().Last().Guests, Forecaster.Forecast(ArrivalSeries));
+}
+
+FFastForwardReport UResortSimulationSubsystem::FastForwardTo(int64 TargetTime)
+{
+    const int64 StartTime = EventWheel.GetNow();
+    const int64 StartEvents = Stats.DispatchedEvents;
+    const double StartWallTime = FPlatformTime::Seconds();
+
+    AdvanceSimulation(TargetTime - StartTime);
+
+    return MakeFastForwardReport(StartTime, StartEvents, StartWallTime);
+}
+
+void UResortSimulationSubsystem::TickFastForward()
+{
+    const double EndWallTime = FPlatformTime::Seconds() + FastForward.BudgetMilliseconds * 0.001;
+
+    // Advance a simulated hour at a time so the budget is checked regularly
+    while (EventWheel.GetNow() < FastForward.TargetTime && FPlatformTime::Seconds() < EndWallTime)
+    {
+        AdvanceSimulation(FMath::Min<int64>(3600, FastForward.TargetTime - EventWheel.GetNow()));
+    }
+
+    if (EventWheel.GetNow() < FastForward.TargetTime)
+    {
+        return;
+    }
+
+    const FFastForwardReport Report = MakeFastForwardReport(FastForward.StartTime, FastForward.StartEvents, FastForward.StartWallTime);
+
+    if (UGameViewportClient* Viewport = GetWorld()->GetGameViewport())
+    {
+        Viewport->bDisableWorldRendering = FastForward.bRenderingWasDisabled;
+    }
+    FastForward = FFastForwardState();
+
+    OnFastForwardFinished.Broadcast(Report);
+}
+
+void UResortSimulationSubsystem::HandleSimulationStep(int32 Seconds)
+{
+    // A fast-forward advances the wheel itself
+    if (!IsFastForwarding())
+    {
+        AdvanceSimulation(Seconds);
+    }
+}
+
+FFastForwardReport UResortSimulationSubsystem::MakeFastForwardReport(int64 StartTime, int64 StartEvents, double StartWallTime) const
+{
+    FFastForwardReport Report;
+    Report.SimulatedDays = static_cast<float>(EventWheel.GetNow() - StartTime) / SecondsPerDay;
+    Report.WallSeconds = static_cast<float>(FPlatformTime::Seconds() - StartWallTime);
+    Report.DaysPerSecond = Report.WallSeconds > 0.0f ? Report.SimulatedDays / Report.WallSeconds : 0.0f;
+    Report.DispatchedEvents = Stats.DispatchedEvents - StartEvents;
+
+    UE_LOG(LogTemp, Log, TEXT("Fast-forwarded %.2f days in %.3f s: %.1f simulated days per second, %lld events"),
+        Report.SimulatedDays, Report.WallSeconds, Report.DaysPerSecond, Report.DispatchedEvents);
+
+    return Report;
+}
+
+void UResortSimulationSubsystem::OnGuestArrive(int32 GuestId)
+{
+    const FIntPoint Entrance = GridManager ? GridManager->GetEntranceCell() : FIntPoint::ZeroValue;
+
+    TArray<int32, TInlineAllocator<8>> Members;
+    int32 NumWantingTreatment = 0;
+    for (int32 MemberId = GuestId; MemberId != INDEX_NONE; )
+    {
+        FSimGuest& Member = Guests[MemberId];
+        Member.PendingEvent.Reset();
+        Member.Cell = Entrance;
+        Member.FloorLevel = 0;
+        Member.SatisfactionRecord = Satisfaction.AddGuest(MemberId);
+
+        Members.Add(MemberId);
+        NumWantingTreatment += Member.TreatmentsLeft > 0 ? 1 : 0;
+        TodayTreatmentWishes += Member.TreatmentsLeft;
+        MemberId = Member.NextInGroup;
+        Member.NextInGroup = INDEX_NONE;
+
+        Stats.ArrivedGuests++;
+        Stats.ActiveGuests++;
+        Ledger.AddGuest();
+    }
+
+    // The group books its first treatments in one batch; members nothing is left for skip treatments
+    if (NumWantingTreatment > 0)
+    {
+        TreatmentScheduler.BookGroup(NAME_None, AdvanceAppointmentsToNow(), NumWantingTreatment, [this, &Entrance](int32 BuildingIndex)
+        {
+            return GetTravelSlots(Entrance, 0, BuildingIndex);
+        }, GroupBookings);
+
+        int32 BookingIndex = 0;
+        for (int32 MemberId : Members)
+        {
+            FSimGuest& Member = Guests[MemberId];
+            if (Member.TreatmentsLeft > 0)
+            {
+                Member.Appointment = GroupBookings[BookingIndex++];
+                if (!Member.Appointment.IsValid())
+                {
+                    Member.TreatmentsLeft = 0;
+                }
+            }
+        }
+    }
+
+    for (int32 MemberId : Members)
+    {
+        ChooseNextActivity(MemberId);
+    }
+}
+
+void UResortSimulationSubsystem::OnGuestReachBuilding(int32 GuestId)
+{
+    FSimGuest& Guest = Guests[GuestId];
+    Guest.PendingEvent.Reset();
+
+    FSimBuilding* Building = FindBuilding(Guest.Building);
+    ABuildingObject* BuildingActor = Building ? Building->Building.Get() : nullptr;
+    if (!BuildingActor)
+    {
+        // The building went away without a removal event; forget it so nobody else is sent there
+        if (Building)
+        {
+            Guest.Cell = Building->Cell;
+            Guest.FloorLevel = Building->FloorLevel;
+            HandleBuildingRemoved(Guest.Building, nullptr);
+            return;
+        }
+
+        CancelAppointment(Guest);
+        ChooseNextActivity(GuestId);
+        return;
+    }
+
+    Guest.Cell = Building->Cell;
+    Guest.FloorLevel = Building->FloorLevel;
+
+    // Walk straight in if there is room and nobody is waiting or the guest has an appointment,
+    // otherwise join the queue
+    if ((Building->Queue.Num() == 0 || Guest.Appointment.IsValid()) && BuildingActor->RegisterSimulatedGuest(GuestId))
+    {
+        StartVisit(GuestId, *Building);
+        return;
+    }
+
+    Guest.Activity = EGuestActivity::Queued;
+    Guest.QueuedSince = EventWheel.GetNow();
+    Guest.TimeoutEvent = EventWheel.Schedule(EventWheel.GetNow() + MaxQueueWaitMinutes * 60, FSimEvent(static_cast<uint8>(EEventType::QueueTimeout), GuestId));
+    Building->Queue.Add(GuestId);
+}
+
+void UResortSimulationSubsystem::OnGuestVisitEnd(int32 GuestId)
+{
+    FSimGuest& Guest = Guests[GuestId];
+    Guest.PendingEvent.Reset();
+
+    if (Guest.Activity == EGuestActivity::InTreatment)
+    {
+        Guest.TreatmentsLeft--;
+        Stats.CompletedTreatments++;
+        CancelAppointment(Guest);
+    }
+    else
+    {
+        Guest.bHasEaten = true;
+        Stats.CompletedMeals++;
+    }
+
+    // Pay, free the place and let the next guest in
+    if (FSimBuilding* Building = FindBuilding(Guest.Building))
+    {
+        Ledger.AddRevenue(Building->Revenue);
+        RecordMetric(EResortMetric::Revenue, Building->Revenue);
+        if (ABuildingObject* BuildingActor = Building->Building.Get())
+        {
+            BuildingActor->RemoveSimulatedGuest(GuestId);
+        }
+        AdmitQueuedGuests(*Building);
+    }
+
+    ChooseNextActivity(GuestId);
+}
+
+void UResortSimulationSubsystem::OnGuestQueueTimeout(int32 GuestId)
+{
+    FSimGuest& Guest = Guests[GuestId];
+    Guest.TimeoutEvent.Reset();
+    CancelAppointment(Guest);
+
+    if (FSimBuilding* Building = FindBuilding(Guest.Building))
+    {
+        Building->Queue.Remove(GuestId);
+    }
+
+    Satisfaction.AddWait(Guest.SatisfactionRecord, EventWheel.GetNow() - Guest.QueuedSince);
+    Satisfaction.AddAbandonedQueue(Guest.SatisfactionRecord);
+
+    // Give up on whatever the guest was waiting for
+    if (Guest.TreatmentsLeft > 0)
+    {
+        Guest.TreatmentsLeft--;
+    }
+    else
+    {
+        Guest.bHasEaten = true;
+    }
+    Stats.AbandonedQueues++;
+
+    ChooseNextActivity(GuestId);
+}
+
+void UResortSimulationSubsystem::OnGuestLeave(int32 GuestId)
+{
+    Satisfaction.MarkDeparted(Guests[GuestId].SatisfactionRecord, SatisfactionWeights);
+    Guests[GuestId] = FSimGuest();
+    FreeGuestIds.Add(GuestId);
+
+    Stats.ActiveGuests--;
+    Stats.DepartedGuests++;
+}
+
+void UResortSimulationSubsystem::ChooseNextActivity(int32 GuestId)
+{
+    FSimGuest& Guest = Guests[GuestId];
+    Guest.Building = FBuildingHandle();
+
+    // An appointment at a building whose actor is gone cannot be kept
+    if (Guest.Appointment.IsValid() && !Buildings[Guest.Appointment.BuildingIndex].Building.IsValid())
+    {
+        CancelAppointment(Guest);
+    }
+
+    // Treatments first, then a meal; wishes no open building can serve are dropped
+    if (Guest.TreatmentsLeft > 0 && (Guest.Appointment.IsValid() || BookTreatment(GuestId)))
+    {
+        const FSimBuilding& Building = Buildings[Guest.Appointment.BuildingIndex];
+        const int64 WalkSeconds = GetWalkSeconds(Guest.Cell, Guest.FloorLevel, Building.Cell, Building.FloorLevel);
+
+        // Guests with time to spare arrive when the appointment starts
+        Satisfaction.AddWalk(Guest.SatisfactionRecord, WalkSeconds);
+        Guest.Activity = EGuestActivity::Walking;
+        Guest.Building = Building.Handle;
+        Guest.PendingEvent = EventWheel.Schedule(
+            FMath::Max(EventWheel.GetNow() + WalkSeconds, Guest.Appointment.StartSlot * SecondsPerSlot),
+            FSimEvent(static_cast<uint8>(EEventType::ReachBuilding), GuestId));
+        return;
+    }
+    Guest.TreatmentsLeft = 0;
+
+    int32 BuildingIndex = INDEX_NONE;
+    if (!Guest.bHasEaten)
+    {
+        BuildingIndex = FindBestBuilding(Guest, FoodBuildings);
+        if (BuildingIndex == INDEX_NONE)
+        {
+            Guest.bHasEaten = true;
+        }
+    }
+
+    if (BuildingIndex != INDEX_NONE)
+    {
+        const FSimBuilding& Building = Buildings[BuildingIndex];
+        const int64 WalkSeconds = GetWalkSeconds(Guest.Cell, Guest.FloorLevel, Building.Cell, Building.FloorLevel);
+        Satisfaction.AddWalk(Guest.SatisfactionRecord, WalkSeconds);
+        Guest.Activity = EGuestActivity::Walking;
+        Guest.Building = Building.Handle;
+        Guest.PendingEvent = EventWheel.Schedule(EventWheel.GetNow() + WalkSeconds, FSimEvent(static_cast<uint8>(EEventType::ReachBuilding), GuestId));
+        return;
+    }
+
+    // Nothing left to do, walk back to the entrance
+    const FIntPoint Entrance = GridManager ? GridManager->GetEntranceCell() : FIntPoint::ZeroValue;
+    const int64 WalkSeconds = GetWalkSeconds(Guest.Cell, Guest.FloorLevel, Entrance, 0);
+    Satisfaction.AddWalk(Guest.SatisfactionRecord, WalkSeconds);
+    Guest.Activity = EGuestActivity::Leaving;
+    Guest.PendingEvent = EventWheel.Schedule(EventWheel.GetNow() + WalkSeconds, FSimEvent(static_cast<uint8>(EEventType::Leave), GuestId));
+}
+
+bool UResortSimulationSubsystem::BookTreatment(int32 GuestId)
+{
+    FSimGuest& Guest = Guests[GuestId];
+    Guest.Appointment = TreatmentScheduler.FindBest(NAME_None, AdvanceAppointmentsToNow(), [this, &Guest](int32 BuildingIndex)
+    {
+        return GetTravelSlots(Guest.Cell, Guest.FloorLevel, BuildingIndex);
+    });
+
+    if (!Guest.Appointment.IsValid() || !TreatmentScheduler.Book(Guest.Appointment))
+    {
+        Guest.Appointment = FTreatmentBooking();
+        return false;
+    }
+
+    return true;
+}
+
+void UResortSimulationSubsystem::CancelAppointment(FSimGuest& Guest)
+{
+    if (Guest.Appointment.IsValid())
+    {
+        AdvanceAppointmentsToNow();
+        TreatmentScheduler.Cancel(Guest.Appointment);
+        Guest.Appointment = FTreatmentBooking();
+    }
+}
+
+int64 UResortSimulationSubsystem::GetTravelSlots(const FIntPoint& Cell, int32 FloorLevel, int32 BuildingIndex) const
+{
+    // Stale records, whose actor went away without a removal event, are never booked
+    const FSimBuilding& Building = Buildings[BuildingIndex];
+    const ABuildingObject* BuildingActor = Building.Building.Get();
+    if (!Building.Handle.IsValid() || !BuildingActor || !BuildingActor->IsOperational())
+    {
+        return INDEX_NONE;
+    }
+
+    const int64 WalkSeconds = GetWalkSeconds(Cell, FloorLevel, Building.Cell, Building.FloorLevel);
+    return (WalkSeconds + SecondsPerSlot - 1) / SecondsPerSlot;
+}
+
+int64 UResortSimulationSubsystem::AdvanceAppointmentsToNow()
+{
+    // Slots that have started can no longer be booked
+    TreatmentScheduler.AdvanceTo(EventWheel.GetNow() / SecondsPerSlot);
+    return (EventWheel.GetNow() + SecondsPerSlot - 1) / SecondsPerSlot;
+}
+
+FTreatmentAppointment UResortSimulationSubsystem::MakeAppointment(const FTreatmentBooking& Booking) const
+{
+    FTreatmentAppointment Appointment;
+    Appointment.Building = Buildings.IsValidIndex(Booking.BuildingIndex) ? Buildings[Booking.BuildingIndex].Handle : FBuildingHandle();
+    Appointment.StartTime = Booking.StartSlot * SecondsPerSlot;
+    Appointment.EndTime = Booking.GetEndSlot() * SecondsPerSlot;
+    Appointment.Place = Booking.Lane;
+    return Appointment;
+}
+
+int32 UResortSimulationSubsystem::FindBestBuilding(const FSimGuest& Guest, const TArray<int32>& Candidates) const
+{
+    int32 BestIndex = INDEX_NONE;
+    int64 BestCost = MAX_int64;
+
+    for (int32 BuildingIndex : Candidates)
+    {
+        // Stale records, whose actor went away without a removal event, are skipped
+        const FSimBuilding& Building = Buildings[BuildingIndex];
+        const ABuildingObject* BuildingActor = Building.Building.Get();
+        if (!Building.Handle.IsValid() || !BuildingActor || !BuildingActor->IsOperational())
+        {
+            continue;
+        }
+
+        // Expected wait assumes the places free up evenly
+        const int32 Waiting = Building.Queue.Num() + FMath::Max(0, BuildingActor->GetNumGuests() - Building.Capacity + 1);
+        const int64 WaitSeconds = Waiting * Building.VisitSeconds / Building.Capacity;
+        const int64 Cost = GetWalkSeconds(Guest.Cell, Guest.FloorLevel, Building.Cell, Building.FloorLevel) + WaitSeconds;
+
+        if (Cost < BestCost)
+        {
+            BestCost = Cost;
+            BestIndex = BuildingIndex;
+        }
+    }
+
+    return BestIndex;
+}
+
+void UResortSimulationSubsystem::StartVisit(int32 GuestId, FSimBuilding& Building)
+{
+    FSimGuest& Guest = Guests[GuestId];
+    Guest.Activity = Guest.TreatmentsLeft > 0 && Building.bOffersTreatment ? EGuestActivity::InTreatment : EGuestActivity::Eating;
+    if (Guest.Activity == EGuestActivity::InTreatment)
+    {
+        RecordTreatmentLoad(Building);
+    }
+
+    const ABuildingObject* BuildingActor = Building.Building.Get();
+    Satisfaction.AddVisit(Guest.SatisfactionRecord, GetAmbience(Building), BuildingActor ? BuildingActor->GetEfficiency() : 0.0f);
+    Guest.PendingEvent = EventWheel.Schedule(EventWheel.GetNow() + Building.VisitSeconds, FSimEvent(static_cast<uint8>(EEventType::VisitEnd), GuestId));
+}
+
+void UResortSimulationSubsystem::AdmitQueuedGuests(FSimBuilding& Building)
+{
+    ABuildingObject* BuildingActor = Building.Building.Get();
+    if (!BuildingActor)
+    {
+        return;
+    }
+
+    int32 NumAdmitted = 0;
+    while (NumAdmitted < Building.Queue.Num() && BuildingActor->RegisterSimulatedGuest(Building.Queue[NumAdmitted]))
+    {
+        const int32 GuestId = Building.Queue[NumAdmitted];
+        EventWheel.Cancel(Guests[GuestId].TimeoutEvent);
+        Guests[GuestId].TimeoutEvent.Reset();
+        Satisfaction.AddWait(Guests[GuestId].SatisfactionRecord, EventWheel.GetNow() - Guests[GuestId].QueuedSince);
+        StartVisit(GuestId, Building);
+        NumAdmitted++;
+    }
+
+    Building.Queue.RemoveAt(0, NumAdmitted, EAllowShrinking::No);
+}
+
+float UResortSimulationSubsystem::GetAmbience(const FSimBuilding& Building) const
+{
+    if (!GridManager)
+    {
+        return 0.0f;
+    }
+
+    return GridManager->GetInfluenceAt(Building.Cell, EGridInfluenceChannel::Appeal, Building.FloorLevel)
+        + GridManager->GetInfluenceAt(Building.Cell, EGridInfluenceChannel::Tranquility, Building.FloorLevel)
+        - GridManager->GetInfluenceAt(Building.Cell, EGridInfluenceChannel::Noise, Building.FloorLevel);
+}
+
+int64 UResortSimulationSubsystem::GetWalkSeconds(const FIntPoint& From, int32 FromFloor, const FIntPoint& To, int32 ToFloor) const
+{
+    const int32 Cells = FMath::Abs(To.X - From.X) + FMath::Abs(To.Y - From.Y);
+    const int32 Floors = FMath::Abs(ToFloor - FromFloor);
+    return FMath::CeilToInt(Cells * WalkSecondsPerCell + Floors * WalkSecondsPerFloor);
+}
+
+UResortSimulationSubsystem::FSimBuilding* UResortSimulationSubsystem::FindBuilding(const FBuildingHandle& Handle)
+{
+    if (!Buildings.IsValidIndex(Handle.Index) || Buildings[Handle.Index].Handle != Handle)
+    {
+        return nullptr;
+    }
+
+    return &Buildings[Handle.Index];
+}
+
+void UResortSimulationSubsystem::HandleBuildingPlaced(FBuildingHandle Handle, ABuildingObject* Building)
+{
+    if (!Handle.IsValid() || !Building)
+    {
+        return;
+    }
+
+    if (Handle.Index >= Buildings.Num())
+    {
+        Buildings.SetNum(Handle.Index + 1);
+    }
+
+    FSimBuilding& Record = Buildings[Handle.Index];
+    Record = FSimBuilding();
+    Record.Handle = Handle;
+    Record.Building = Building;
+
+    int32 Rotation;
+    Building->GetGridProperties(Record.Cell, Record.FloorLevel, Rotation);
+
+    const EBuildingType Type = Building->GetBuildingType();
+    const UBuildingObjectAsset* Asset = Building->GetBuildingAsset();
+    Record.VisitSeconds = (Asset ? Asset->VisitDurationMinutes : 60) * 60;
+    Record.Capacity = FMath::Max(1, Asset ? Asset->MaxGuests : 1);
+    Record.Revenue = Asset ? Asset->BaseRevenue : 0;
+    Record.bOffersTreatment = Asset && Asset->SupportedTreatments.Num() > 0;
+    Record.bServesFood = Type == EBuildingType::Restaurant || Type == EBuildingType::JuiceBar;
+    Record.AppointmentSlots = FMath::Clamp(static_cast<int32>((Record.VisitSeconds + SecondsPerSlot - 1) / SecondsPerSlot), 1, FAppointmentBook::MaxLength);
+
+    if (Record.bOffersTreatment)
+    {
+        AdvanceAppointmentsToNow();
+        TreatmentScheduler.AddBuilding(Handle.Index, Record.Capacity, Record.AppointmentSlots, Asset->SupportedTreatments);
+    }
+    if (Record.bServesFood)
+    {
+        FoodBuildings.Add(Handle.Index);
+    }
+
+    // The building opens once its construction is done, guests skip it until then
+    if (Building->IsUnderConstruction())
+    {
+        if (!Asset || Asset->ConstructionHours <= 0.0f || ConstructionQueue.NumBuilders() == 0)
+        {
+            Building->CompleteConstruction();
+        }
+        else
+        {
+            ConstructionQueue.AddSite(Handle.Index, Record.Cell, Record.FloorLevel, Asset->ConstructionHours, Asset->MaxBuilders);
+            ScheduleConstructionTick();
+        }
+    }
+}
+
+void UResortSimulationSubsystem::HandleBuildingMoved(FBuildingHandle Handle, ABuildingObject* Building)
+{
+    FSimBuilding* Record = FindBuilding(Handle);
+    if (!Record || !Building)
+    {
+        return;
+    }
+
+    // Guests already walking keep their arrival time, later walks start from the new cell
+    int32 Rotation;
+    Building->GetGridProperties(Record->Cell, Record->FloorLevel, Rotation);
+    ConstructionQueue.MoveSite(Handle.Index, Record->Cell, Record->FloorLevel);
+}
+
+void UResortSimulationSubsystem::HandleGridExpanded(FIntPoint CellOffset)
+{
+    if (CellOffset == FIntPoint::ZeroValue)
+    {
+        return;
+    }
+
+    // Land added before the first column or row renumbers every cell; walk times stay the same
+    for (FSimGuest& Guest : Guests)
+    {
+        Guest.Cell += CellOffset;
+    }
+
+    for (FSimBuilding& Record : Buildings)
+    {
+        Record.Cell += CellOffset;
+    }
+
+    ConstructionQueue.ShiftCells(CellOffset);
+}
+
+void UResortSimulationSubsystem::HandleBuildingRemoved(FBuildingHandle Handle, ABuildingObject* Building)
+{
+    FSimBuilding* Record = FindBuilding(Handle);
+    if (!Record)
+    {
+        return;
+    }
+
+    TreatmentScheduler.RemoveBuilding(Handle.Index);
+    ConstructionQueue.RemoveSite(Handle.Index);
+    FoodBuildings.RemoveSingleSwap(Handle.Index, EAllowShrinking::No);
+    *Record = FSimBuilding();
+
+    // Removals are rare, so a scan over the guests is cheaper than tracking visitors per building
+    for (int32 GuestId = 0; GuestId < Guests.Num(); GuestId++)
+    {
+        FSimGuest& Guest = Guests[GuestId];
+        if (Guest.Building != Handle || Guest.Activity == EGuestActivity::Leaving)
+        {
+            continue;
+        }
+
+        EventWheel.Cancel(Guest.PendingEvent);
+        EventWheel.Cancel(Guest.TimeoutEvent);
+        Guest.PendingEvent.Reset();
+        Guest.TimeoutEvent.Reset();
+        Guest.Appointment = FTreatmentBooking();
+
+        if (Building)
+        {
+            Building->RemoveSimulatedGuest(GuestId);
+        }
+
+        ChooseNextActivity(GuestId);
+    }
+}
@@ -0,0 +1,282 @@
+﻿// SimTimingWheel.cpp - Implementation of the simulation timing wheel
+#include "SimTimingWheel.h"
+
+FSimTimingWheel::FSimTimingWheel()
+{
+    Reset(0);
+}
+
+void FSimTimingWheel::Reset(int64 StartTime)
+{
+    // Keep the node generations so ids from before the reset stay invalid
+    FreeNodes.Reset();
+    for (int32 NodeIndex = Nodes.Num() - 1; NodeIndex >= 0; NodeIndex--)
+    {
+        if (Nodes[NodeIndex].Bucket != INDEX_NONE)
+        {
+            Nodes[NodeIndex].Bucket = INDEX_NONE;
+            Nodes[NodeIndex].Generation++;
+        }
+        FreeNodes.Add(NodeIndex);
+    }
+
+    for (int32 Bucket = 0; Bucket < NumBuckets; Bucket++)
+    {
+        Heads[Bucket] = INDEX_NONE;
+        Tails[Bucket] = INDEX_NONE;
+    }
+
+    for (int32 Level = 0; Level < NumLevels; Level++)
+    {
+        Occupied[Level] = 0;
+    }
+
+    Now = StartTime;
+    NumPending = 0;
+}
+
+FSimEventId FSimTimingWheel::Schedule(int64 Time, const FSimEvent& Event)
+{
+    int32 NodeIndex;
+    if (FreeNodes.Num() > 0)
+    {
+        NodeIndex = FreeNodes.Pop(EAllowShrinking::No);
+    }
+    else
+    {
+        NodeIndex = Nodes.AddDefaulted();
+    }
+
+    FNode& Node = Nodes[NodeIndex];
+    Node.Time = FMath::Max(Time, Now);
+    Node.Event = Event;
+    Link(NodeIndex);
+    NumPending++;
+
+    FSimEventId Id;
+    Id.Index = NodeIndex;
+    Id.Generation = Node.Generation;
+    return Id;
+}
+
+bool FSimTimingWheel::Cancel(const FSimEventId& Id)
+{
+    if (!IsScheduled(Id))
+    {
+        return false;
+    }
+
+    Unlink(Id.Index);
+    FreeNode(Id.Index);
+    return true;
+}
+
+bool FSimTimingWheel::IsScheduled(const FSimEventId& Id) const
+{
+    return Nodes.IsValidIndex(Id.Index)
+        && Nodes[Id.Index].Generation == Id.Generation
+        && Nodes[Id.Index].Bucket != INDEX_NONE;
+}
+
+int32 FSimTimingWheel::Advance(int64 Target, TFunctionRef<void(int64 Time, const FSimEvent& Event)> Handler)
+{
+    int32 NumDispatched = 0;
+
+    while (NumPending > 0)
+    {
+        // Level 0 slots hold exact times within the current block of 64 seconds
+        const uint64 DueSlots = Occupied[0] & (~0ull << (Now & (NumSlots - 1)));
+        if (DueSlots)
+        {
+            const int32 Slot = static_cast<int32>(FMath::CountTrailingZeros64(DueSlots));
+            const int64 Time = (Now & ~static_cast<int64>(NumSlots - 1)) | Slot;
+            if (Time > Target)
+            {
+                break;
+            }
+
+            // Handlers may append to this slot, so pop until it is empty
+            Now = Time;
+            while (Heads[Slot] != INDEX_NONE)
+            {
+                const int32 NodeIndex = Heads[Slot];
+                const FSimEvent Event = Nodes[NodeIndex].Event;
+                Unlink(NodeIndex);
+                FreeNode(NodeIndex);
+
+                Handler(Now, Event);
+                NumDispatched++;
+            }
+            continue;
+        }
+
+        // Otherwise move to the start of the next occupied slot on the lowest non-empty level
+        // and spread its events over the levels below
+        int64 NextSlotStart = MAX_int64;
+        int32 NextBucket = INDEX_NONE;
+        for (int32 Level = 1; Level < NumLevels; Level++)
+        {
+            const int32 Shift = Level * SlotBits;
+            const int32 NowSlot = static_cast<int32>((Now >> Shift) & (NumSlots - 1));
+            const uint64 PendingSlots = NowSlot + 1 < NumSlots ? Occupied[Level] & (~0ull << (NowSlot + 1)) : 0;
+            if (PendingSlots)
+            {
+                const int32 Slot = static_cast<int32>(FMath::CountTrailingZeros64(PendingSlots));
+                NextSlotStart = ((Now >> (Shift + SlotBits)) << (Shift + SlotBits)) | (static_cast<int64>(Slot) << Shift);
+                NextBucket = Level * NumSlots + Slot;
+                break;
+            }
+        }
+
+        if (NextBucket == INDEX_NONE && Heads[OverflowBucket] != INDEX_NONE)
+        {
+            const int32 TopShift = NumLevels * SlotBits;
+            NextSlotStart = (GetEarliestTime(OverflowBucket) >> TopShift) << TopShift;
+            NextBucket = OverflowBucket;
+        }
+
+        if (NextBucket == INDEX_NONE || NextSlotStart > Target)
+        {
+            break;
+        }
+
+        Now = NextSlotStart;
+        Cascade(NextBucket);
+    }
+
+    Now = FMath::Max(Now, Target);
+    return NumDispatched;
+}
+
+int64 FSimTimingWheel::GetNextEventTime() const
+{
+    const uint64 DueSlots = Occupied[0] & (~0ull << (Now & (NumSlots - 1)));
+    if (DueSlots)
+    {
+        return (Now & ~static_cast<int64>(NumSlots - 1)) | static_cast<int64>(FMath::CountTrailingZeros64(DueSlots));
+    }
+
+    for (int32 Level = 1; Level < NumLevels; Level++)
+    {
+        if (Occupied[Level])
+        {
+            // Occupied slots all lie ahead of the current one on the level
+            const int32 NowSlot = static_cast<int32>((Now >> (Level * SlotBits)) & (NumSlots - 1));
+            const uint64 PendingSlots = NowSlot + 1 < NumSlots ? Occupied[Level] & (~0ull << (NowSlot + 1)) : 0;
+            if (PendingSlots)
+            {
+                return GetEarliestTime(Level * NumSlots + static_cast<int32>(FMath::CountTrailingZeros64(PendingSlots)));
+            }
+        }
+    }
+
+    return GetEarliestTime(OverflowBucket);
+}
+
+int32 FSimTimingWheel::GetBucket(int64 Time) const
+{
+    // The level is set by the highest group of bits where the event time differs from now
+    const uint64 Difference = static_cast<uint64>(Time ^ Now);
+    const int32 Level = Difference ? (63 - static_cast<int32>(FMath::CountLeadingZeros64(Difference))) / SlotBits : 0;
+    if (Level >= NumLevels)
+    {
+        return OverflowBucket;
+    }
+
+    return Level * NumSlots + static_cast<int32>((Time >> (Level * SlotBits)) & (NumSlots - 1));
+}
+
+void FSimTimingWheel::Link(int32 NodeIndex)
+{
+    FNode& Node = Nodes[NodeIndex];
+    const int32 Bucket = GetBucket(Node.Time);
+
+    Node.Bucket = Bucket;
+    Node.Prev = Tails[Bucket];
+    Node.Next = INDEX_NONE;
+
+    if (Tails[Bucket] != INDEX_NONE)
+    {
+        Nodes[Tails[Bucket]].Next = NodeIndex;
+    }
+    else
+    {
+        Heads[Bucket] = NodeIndex;
+        if (Bucket != OverflowBucket)
+        {
+            Occupied[Bucket / NumSlots] |= 1ull << (Bucket % NumSlots);
+        }
+    }
+    Tails[Bucket] = NodeIndex;
+}
+
+void FSimTimingWheel::Unlink(int32 NodeIndex)
+{
+    FNode& Node = Nodes[NodeIndex];
+    const int32 Bucket = Node.Bucket;
+
+    if (Node.Prev != INDEX_NONE)
+    {
+        Nodes[Node.Prev].Next = Node.Next;
+    }
+    else
+    {
+        Heads[Bucket] = Node.Next;
+    }
+
+    if (Node.Next != INDEX_NONE)
+    {
+        Nodes[Node.Next].Prev = Node.Prev;
+    }
+    else
+    {
+        Tails[Bucket] = Node.Prev;
+    }
+
+    if (Heads[Bucket] == INDEX_NONE && Bucket != OverflowBucket)
+    {
+        Occupied[Bucket / NumSlots] &= ~(1ull << (Bucket % NumSlots));
+    }
+
+    Node.Prev = INDEX_NONE;
+    Node.Next = INDEX_NONE;
+}
+
+void FSimTimingWheel::FreeNode(int32 NodeIndex)
+{
+    Nodes[NodeIndex].Bucket = INDEX_NONE;
+    Nodes[NodeIndex].Generation++;
+    FreeNodes.Add(NodeIndex);
+    NumPending--;
+}
+
+void FSimTimingWheel::Cascade(int32 Bucket)
+{
+    int32 NodeIndex = Heads[Bucket];
+
+    Heads[Bucket] = INDEX_NONE;
+    Tails[Bucket] = INDEX_NONE;
+    if (Bucket != OverflowBucket)
+    {
+        Occupied[Bucket / NumSlots] &= ~(1ull << (Bucket % NumSlots));
+    }
+
+    // Re-linking in list order keeps events of equal time in scheduling order
+    while (NodeIndex != INDEX_NONE)
+    {
+        const int32 Next = Nodes[NodeIndex].Next;
+        Link(NodeIndex);
+        NodeIndex = Next;
+    }
+}
+
+int64 FSimTimingWheel::GetEarliestTime(int32 Bucket) const
+{
+    int64 Earliest = MAX_int64;
+    for (int32 NodeIndex = Heads[Bucket]; NodeIndex != INDEX_NONE; NodeIndex = Nodes[NodeIndex].Next)
+    {
+        Earliest = FMath::Min(Earliest, Nodes[NodeIndex].Time);
+    }
+
+    return Earliest;
+}
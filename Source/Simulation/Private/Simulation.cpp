@@ -0,0 +1,17 @@
+﻿#include "Simulation.h"
+
+#define LOCTEXT_NAMESPACE "FSimulationModule"
+
+void FSimulationModule::StartupModule()
+{
+    
+}
+
+void FSimulationModule::ShutdownModule()
+{
+    
+}
+
+#undef LOCTEXT_NAMESPACE
+    
+IMPLEMENT_MODULE(FSimulationModule, Simulation)
@@ -0,0 +1,79 @@
+﻿// SimulationClockSubsystem.cpp - Implementation of the fixed-step simulation clock
+#include "SimulationClockSubsystem.h"
+
+void USimulationClockSubsystem::Tick(float DeltaTime)
+{
+    const int32 Multiplier = GetSpeedMultiplier(Speed);
+    if (Multiplier == 0)
+    {
+        return;
+    }
+
+    PendingSteps += static_cast<double>(DeltaTime) * StepsPerSecond * Multiplier;
+
+    // Whole steps beyond the backlog are dropped, the fraction of a step is kept
+    const double Excess = FMath::FloorToDouble(PendingSteps - FMath::Max(MaxBacklogSteps, MaxStepsPerFrame));
+    if (Excess > 0.0)
+    {
+        PendingSteps -= Excess;
+        DroppedSteps += static_cast<int64>(Excess);
+    }
+
+    const int32 NumSteps = FMath::Min(FMath::FloorToInt32(PendingSteps), MaxStepsPerFrame);
+    PendingSteps -= NumSteps;
+    RunSteps(NumSteps);
+}
+
+TStatId USimulationClockSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(USimulationClockSubsystem, STATGROUP_Tickables);
+}
+
+void USimulationClockSubsystem::SetSpeed(ESimulationSpeed NewSpeed)
+{
+    if (Speed == NewSpeed)
+    {
+        return;
+    }
+
+    if (NewSpeed == ESimulationSpeed::Paused)
+    {
+        SpeedBeforePause = Speed;
+    }
+
+    // Time that has not been run yet belongs to the old speed
+    PendingSteps = FMath::Frac(PendingSteps);
+
+    Speed = NewSpeed;
+    OnSpeedChanged.Broadcast(Speed);
+}
+
+void USimulationClockSubsystem::TogglePause()
+{
+    SetSpeed(Speed == ESimulationSpeed::Paused ? SpeedBeforePause : ESimulationSpeed::Paused);
+}
+
+void USimulationClockSubsystem::RunSteps(int32 NumSteps)
+{
+    for (int32 Step = 0; Step < NumSteps; Step++)
+    {
+        StepCount++;
+        SimulatedSeconds += SecondsPerStep;
+        OnSimulationStep.Broadcast(SecondsPerStep);
+    }
+}
+
+int32 USimulationClockSubsystem::GetSpeedMultiplier(ESimulationSpeed InSpeed)
+{
+    switch (InSpeed)
+    {
+    case ESimulationSpeed::Normal:
+        return 1;
+    case ESimulationSpeed::Fast:
+        return 3;
+    case ESimulationSpeed::Fastest:
+        return 10;
+    default:
+        return 0;
+    }
+}
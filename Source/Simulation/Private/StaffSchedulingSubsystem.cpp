@@ -0,0 +1,347 @@
+﻿// StaffSchedulingSubsystem.cpp - Implementation of the staff scheduling service
+#include "StaffSchedulingSubsystem.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/PlatformTime.h"
+#include "BuildingGridManager.h"
+#include "BuildingObject.h"
+#include "BuildingObjectAsset.h"
+
+void UStaffSchedulingSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+    Super::OnWorldBeginPlay(InWorld);
+
+    // Use the first grid in the level unless one was set explicitly
+    if (!GridManager)
+    {
+        for (TActorIterator<ABuildingGridManager> It(&InWorld); It; ++It)
+        {
+            SetGridManager(*It);
+            break;
+        }
+    }
+}
+
+void UStaffSchedulingSubsystem::Deinitialize()
+{
+    if (GridManager)
+    {
+        GridManager->OnGridExpanded.RemoveDynamic(this, &UStaffSchedulingSubsystem::HandleGridExpanded);
+    }
+    GridManager = nullptr;
+    AppliedStaff.Reset();
+
+    Super::Deinitialize();
+}
+
+void UStaffSchedulingSubsystem::SetGridManager(ABuildingGridManager* InGridManager)
+{
+    if (GridManager == InGridManager)
+    {
+        return;
+    }
+
+    // Places at the old grid's buildings mean nothing on the new one
+    ClearAppliedShift();
+    for (FStaffRecord& Record : Roster)
+    {
+        Record.bHasSeat = false;
+    }
+    SeatPrices.Reset();
+
+    if (GridManager)
+    {
+        GridManager->OnGridExpanded.RemoveDynamic(this, &UStaffSchedulingSubsystem::HandleGridExpanded);
+    }
+
+    GridManager = InGridManager;
+
+    if (GridManager)
+    {
+        GridManager->OnGridExpanded.AddDynamic(this, &UStaffSchedulingSubsystem::HandleGridExpanded);
+    }
+}
+
+void UStaffSchedulingSubsystem::HandleGridExpanded(FIntPoint CellOffset)
+{
+    for (FStaffRecord& Record : Roster)
+    {
+        Record.HomeCell += CellOffset;
+    }
+}
+
+bool UStaffSchedulingSubsystem::RegisterStaffMember(AActor* StaffMember, FName StaffType, FIntPoint HomeCell, int32 HomeFloor)
+{
+    if (!StaffMember || StaffType.IsNone())
+    {
+        return false;
+    }
+
+    FStaffRecord* Record = Roster.FindByPredicate([StaffMember](const FStaffRecord& Entry) { return Entry.Actor.Get() == StaffMember; });
+    if (!Record)
+    {
+        Record = &Roster.AddDefaulted_GetRef();
+        Record->Actor = StaffMember;
+    }
+
+    Record->StaffType = StaffType;
+    Record->HomeCell = HomeCell;
+    Record->HomeFloor = HomeFloor;
+    return true;
+}
+
+bool UStaffSchedulingSubsystem::UnregisterStaffMember(AActor* StaffMember)
+{
+    const int32 Index = Roster.IndexOfByPredicate([StaffMember](const FStaffRecord& Entry) { return Entry.Actor.Get() == StaffMember; });
+    if (Index == INDEX_NONE)
+    {
+        return false;
+    }
+
+    RemoveAppliedStaff(StaffMember);
+    Roster.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+    return true;
+}
+
+FStaffScheduleReport UStaffSchedulingSubsystem::SolveDay()
+{
+    const double StartWallTime = FPlatformTime::Seconds();
+
+    Roster.RemoveAllSwap([](const FStaffRecord& Record) { return !Record.Actor.IsValid(); });
+
+    // Places of every shift at every building that needs staff, each worth an equal share of the
+    // building's efficiency in hundredths of a point
+    TArray<FStaffSeat> Seats;
+    TArray<int64> SeatValues;
+    TArray<FIntPoint> SeatCells;
+    TArray<int32> SeatFloors;
+    TMap<FName, TArray<int32>> SeatsByType;
+
+    const int32 ClampedShifts = GetNumShifts();
+    if (GridManager)
+    {
+        for (const FBuildingHandle& Handle : GridManager->GetBuildingHandles())
+        {
+            const ABuildingObject* Building = GridManager->GetBuilding(Handle);
+            const UBuildingObjectAsset* Asset = Building ? Building->GetBuildingAsset() : nullptr;
+            if (!Asset || Asset->RequiredStaffTypes.Num() == 0)
+            {
+                continue;
+            }
+
+            FIntPoint Cell;
+            int32 FloorLevel, Rotation;
+            Building->GetGridProperties(Cell, FloorLevel, Rotation);
+
+            for (int32 Shift = 0; Shift < ClampedShifts; Shift++)
+            {
+                for (const TPair<FName, int32>& Requirement : Asset->RequiredStaffTypes)
+                {
+                    for (int32 Index = 0; Index < Requirement.Value; Index++)
+                    {
+                        FStaffSeat& Seat = Seats.AddDefaulted_GetRef();
+                        Seat.Building = Handle;
+                        Seat.StaffType = Requirement.Key;
+                        Seat.Shift = Shift;
+                        Seat.Index = Index;
+
+                        SeatValues.Add(10000 / (Requirement.Value * Asset->RequiredStaffTypes.Num()));
+                        SeatCells.Add(Cell);
+                        SeatFloors.Add(FloorLevel);
+                        SeatsByType.FindOrAdd(Requirement.Key).Add(Seats.Num() - 1);
+                    }
+                }
+            }
+        }
+    }
+
+    // Benefits are scaled so that the smallest bid increment still gives the optimal assignment
+    const int64 Scale = Roster.Num() + 1;
+    Solver.Reset(Seats.Num());
+
+    int64 MaxBenefit = 0;
+    for (const FStaffRecord& Record : Roster)
+    {
+        Solver.AddPerson();
+
+        if (const TArray<int32>* TypeSeats = SeatsByType.Find(Record.StaffType))
+        {
+            for (int32 SeatIndex : *TypeSeats)
+            {
+                const int64 Benefit = SeatValues[SeatIndex] - GetTravelCost(Record, SeatCells[SeatIndex], SeatFloors[SeatIndex]);
+                if (Benefit > 0)
+                {
+                    Solver.AddArc(SeatIndex, Benefit * Scale);
+                    MaxBenefit = FMath::Max(MaxBenefit, Benefit * Scale);
+                }
+            }
+        }
+    }
+
+    // Start from yesterday's prices and places where the seats still exist
+    TMap<FStaffSeat, int32> SeatIndices;
+    SeatIndices.Reserve(Seats.Num());
+    for (int32 SeatIndex = 0; SeatIndex < Seats.Num(); SeatIndex++)
+    {
+        SeatIndices.Add(Seats[SeatIndex], SeatIndex);
+        if (const int64* Price = SeatPrices.Find(Seats[SeatIndex]))
+        {
+            Solver.SetPrice(SeatIndex, *Price * Scale / PriceScale);
+        }
+    }
+
+    const bool bWarmStart = SeatPrices.Num() > 0;
+    for (int32 Person = 0; Person < Roster.Num(); Person++)
+    {
+        const int32* SeatIndex = Roster[Person].bHasSeat ? SeatIndices.Find(Roster[Person].Seat) : nullptr;
+        if (SeatIndex)
+        {
+            Solver.SetInitialAssignment(Person, *SeatIndex);
+        }
+    }
+
+    FStaffScheduleReport Report;
+    Report.bWarmStarted = bWarmStart;
+    Report.Bids = Solver.Solve(bWarmStart ? Scale : MaxBenefit / 4);
+    Report.Seats = Seats.Num();
+
+    // Read back the places and keep the prices for tomorrow
+    int64 FilledValue = 0;
+    int64 TravelCost = 0;
+    for (int32 Person = 0; Person < Roster.Num(); Person++)
+    {
+        FStaffRecord& Record = Roster[Person];
+        const int32 SeatIndex = Solver.GetAssignment(Person);
+        Record.bHasSeat = SeatIndex != INDEX_NONE;
+        if (!Record.bHasSeat)
+        {
+            Report.IdleStaff++;
+            continue;
+        }
+
+        Record.Seat = Seats[SeatIndex];
+        FilledValue += SeatValues[SeatIndex];
+        TravelCost += GetTravelCost(Record, SeatCells[SeatIndex], SeatFloors[SeatIndex]);
+        Report.FilledSeats++;
+    }
+
+    SeatPrices.Reset();
+    for (int32 SeatIndex = 0; SeatIndex < Seats.Num(); SeatIndex++)
+    {
+        SeatPrices.Add(Seats[SeatIndex], Solver.GetPrice(SeatIndex));
+    }
+    PriceScale = Scale;
+
+    Report.PlannedEfficiency = FilledValue / (100.0f * ClampedShifts);
+    Report.TravelCost = TravelCost / (100.0f * ClampedShifts);
+    Report.SolveMilliseconds = static_cast<float>((FPlatformTime::Seconds() - StartWallTime) * 1000.0);
+    LastReport = Report;
+
+    UE_LOG(LogTemp, Verbose, TEXT("Staff schedule: %d of %d places filled by %d staff, %d idle, %d bids%s in %.2f ms"),
+        Report.FilledSeats, Report.Seats, Roster.Num(), Report.IdleStaff, Report.Bids,
+        Report.bWarmStarted ? TEXT(" (warm start)") : TEXT(""), Report.SolveMilliseconds);
+
+    return Report;
+}
+
+int32 UStaffSchedulingSubsystem::ApplyShift(int32 Shift)
+{
+    const int32 ShiftRun = NextShiftRun++;
+    if (!GridManager)
+    {
+        return ShiftRun;
+    }
+
+    for (const FStaffRecord& Record : Roster)
+    {
+        if (!Record.bHasSeat || Record.Seat.Shift != Shift)
+        {
+            continue;
+        }
+
+        // Someone still finishing a shift that ran late moves straight on to this one
+        AActor* StaffMember = Record.Actor.Get();
+        RemoveAppliedStaff(StaffMember);
+
+        ABuildingObject* Building = GridManager->GetBuilding(Record.Seat.Building);
+        if (StaffMember && Building && Building->AssignStaffMember(StaffMember))
+        {
+            FAppliedStaff& Applied = AppliedStaff.AddDefaulted_GetRef();
+            Applied.Building = Building;
+            Applied.StaffMember = StaffMember;
+            Applied.ShiftRun = ShiftRun;
+        }
+    }
+
+    return ShiftRun;
+}
+
+void UStaffSchedulingSubsystem::EndShift(int32 ShiftRun)
+{
+    for (int32 AppliedIndex = AppliedStaff.Num() - 1; AppliedIndex >= 0; AppliedIndex--)
+    {
+        const FAppliedStaff& Applied = AppliedStaff[AppliedIndex];
+        if (Applied.ShiftRun != ShiftRun)
+        {
+            continue;
+        }
+
+        ABuildingObject* Building = Applied.Building.Get();
+        AActor* StaffMember = Applied.StaffMember.Get();
+        if (Building && StaffMember)
+        {
+            Building->RemoveStaffMember(StaffMember);
+        }
+        AppliedStaff.RemoveAtSwap(AppliedIndex, 1, EAllowShrinking::No);
+    }
+}
+
+bool UStaffSchedulingSubsystem::GetStaffAssignment(AActor* StaffMember, FBuildingHandle& OutBuilding, int32& OutShift) const
+{
+    const FStaffRecord* Record = Roster.FindByPredicate([StaffMember](const FStaffRecord& Entry) { return Entry.Actor.Get() == StaffMember; });
+    if (!Record || !Record->bHasSeat)
+    {
+        return false;
+    }
+
+    OutBuilding = Record->Seat.Building;
+    OutShift = Record->Seat.Shift;
+    return true;
+}
+
+int64 UStaffSchedulingSubsystem::GetTravelCost(const FStaffRecord& Record, const FIntPoint& Cell, int32 FloorLevel) const
+{
+    const int32 Cells = FMath::Abs(Cell.X - Record.HomeCell.X) + FMath::Abs(Cell.Y - Record.HomeCell.Y);
+    const int32 Floors = FMath::Abs(FloorLevel - Record.HomeFloor);
+    return FMath::RoundToInt((Cells * TravelCostPerCell + Floors * TravelCostPerFloor) * 100.0f);
+}
+
+void UStaffSchedulingSubsystem::ClearAppliedShift()
+{
+    for (const FAppliedStaff& Applied : AppliedStaff)
+    {
+        ABuildingObject* Building = Applied.Building.Get();
+        AActor* StaffMember = Applied.StaffMember.Get();
+        if (Building && StaffMember)
+        {
+            Building->RemoveStaffMember(StaffMember);
+        }
+    }
+
+    AppliedStaff.Reset();
+}
+
+void UStaffSchedulingSubsystem::RemoveAppliedStaff(AActor* StaffMember)
+{
+    for (int32 AppliedIndex = AppliedStaff.Num() - 1; AppliedIndex >= 0; AppliedIndex--)
+    {
+        if (AppliedStaff[AppliedIndex].StaffMember.Get() == StaffMember)
+        {
+            if (ABuildingObject* Building = AppliedStaff[AppliedIndex].Building.Get())
+            {
+                Building->RemoveStaffMember(StaffMember);
+            }
+            AppliedStaff.RemoveAtSwap(AppliedIndex, 1, EAllowShrinking::No);
+        }
+    }
+}
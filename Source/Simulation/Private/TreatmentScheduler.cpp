@@ -0,0 +1,280 @@
+﻿// TreatmentScheduler.cpp - Implementation of the treatment appointment scheduler
+#include "TreatmentScheduler.h"
+
+template <typename FunctionType>
+void FTreatmentScheduler::ForEachHeap(const FBuildingBook& Building, FunctionType Function)
+{
+    Function(Heaps.FindOrAdd(NAME_None), NAME_None);
+    for (const FName& Treatment : Building.Treatments)
+    {
+        Function(Heaps.FindOrAdd(Treatment), Treatment);
+    }
+}
+
+void FTreatmentScheduler::Reset(int32 InWindowSlots, int64 InNowSlot)
+{
+    Books.Reset();
+    Heaps.Reset();
+    Reinsert.Reset();
+    WindowSlots = FMath::Max(1, InWindowSlots);
+    NowSlot = InNowSlot;
+}
+
+void FTreatmentScheduler::AddBuilding(int32 BuildingIndex, int32 NumLanes, int32 DurationSlots, const TArray<FName>& Treatments)
+{
+    if (BuildingIndex < 0)
+    {
+        return;
+    }
+
+    if (BuildingIndex >= Books.Num())
+    {
+        Books.SetNum(BuildingIndex + 1);
+    }
+
+    RemoveBuilding(BuildingIndex);
+
+    FBuildingBook& Building = Books[BuildingIndex];
+    Building.Book.Init(NumLanes, WindowSlots, NowSlot);
+    Building.Treatments.Reset();
+    for (const FName& Treatment : Treatments)
+    {
+        if (!Treatment.IsNone())
+        {
+            Building.Treatments.AddUnique(Treatment);
+        }
+    }
+    Building.DurationSlots = FMath::Clamp(DurationSlots, 1, FAppointmentBook::MaxLength);
+    Building.Bound = NowSlot;
+    Building.bActive = true;
+
+    ForEachHeap(Building, [this, BuildingIndex](FCandidateHeap& Heap, FName Treatment)
+    {
+        Heap.NumBuildings++;
+        PushEntry(Heap, BuildingIndex, Treatment);
+    });
+}
+
+void FTreatmentScheduler::RemoveBuilding(int32 BuildingIndex)
+{
+    if (!Books.IsValidIndex(BuildingIndex) || !Books[BuildingIndex].bActive)
+    {
+        return;
+    }
+
+    // Entries left in the heaps no longer match the generation and are dropped when popped
+    FBuildingBook& Building = Books[BuildingIndex];
+    ForEachHeap(Building, [](FCandidateHeap& Heap, FName Treatment)
+    {
+        Heap.NumBuildings--;
+    });
+
+    Building.bActive = false;
+    Building.Generation++;
+}
+
+void FTreatmentScheduler::AdvanceTo(int64 InNowSlot)
+{
+    if (InNowSlot <= NowSlot)
+    {
+        return;
+    }
+
+    NowSlot = InNowSlot;
+
+    // Windows move in whole words, so most calls leave the books alone
+    for (FBuildingBook& Building : Books)
+    {
+        if (Building.bActive && NowSlot - Building.Book.GetWindowStart() >= 64)
+        {
+            Building.Book.AdvanceTo(NowSlot);
+        }
+    }
+}
+
+FTreatmentBooking FTreatmentScheduler::FindBest(FName Treatment, int64 FromSlot, TFunctionRef<int64(int32 BuildingIndex)> GetTravelSlots)
+{
+    FTreatmentBooking Best;
+
+    FCandidateHeap* Heap = Heaps.Find(Treatment);
+    if (!Heap)
+    {
+        return Best;
+    }
+
+    FromSlot = FMath::Max(FromSlot, NowSlot);
+    int64 BestEnd = MAX_int64;
+
+    // Keys never exceed the finish of a building's earliest appointment, so once the top key
+    // reaches the best finish no remaining building can improve on it
+    Reinsert.Reset();
+    while (Heap->Entries.Num() > 0 && Heap->Entries.HeapTop().Key < BestEnd)
+    {
+        FHeapEntry Entry;
+        Heap->Entries.HeapPop(Entry, FHeapOrder(), EAllowShrinking::No);
+        if (!IsCurrent(Entry))
+        {
+            continue;
+        }
+
+        FBuildingBook& Building = Books[Entry.BuildingIndex];
+
+        // Tighten the bound; if it moved the building goes back in with its new key
+        int32 Lane;
+        const int64 FirstFree = Building.Book.FindEarliest(FMath::Max(Building.Bound, NowSlot), Building.DurationSlots, Lane);
+        const int64 Bound = FirstFree != INDEX_NONE ? FirstFree : Building.Book.GetWindowEnd() - Building.DurationSlots + 1;
+        if (Bound != Building.Bound)
+        {
+            SetBound(Entry.BuildingIndex, Bound);
+            continue;
+        }
+
+        Reinsert.Add(Entry);
+
+        const int64 TravelSlots = GetTravelSlots(Entry.BuildingIndex);
+        if (FirstFree == INDEX_NONE || TravelSlots < 0)
+        {
+            continue;
+        }
+
+        const int64 Start = Building.Book.FindEarliest(FMath::Max(FirstFree, FromSlot + TravelSlots), Building.DurationSlots, Lane);
+        if (Start != INDEX_NONE && Start + Building.DurationSlots < BestEnd)
+        {
+            BestEnd = Start + Building.DurationSlots;
+            Best.BuildingIndex = Entry.BuildingIndex;
+            Best.Lane = Lane;
+            Best.StartSlot = Start;
+            Best.Length = Building.DurationSlots;
+            Best.Generation = Building.Generation;
+        }
+    }
+
+    for (const FHeapEntry& Entry : Reinsert)
+    {
+        Heap->Entries.HeapPush(Entry, FHeapOrder());
+    }
+
+    return Best;
+}
+
+bool FTreatmentScheduler::Book(const FTreatmentBooking& Booking)
+{
+    if (!Books.IsValidIndex(Booking.BuildingIndex))
+    {
+        return false;
+    }
+
+    // Booking only pushes the first free slot later, so the bound stays valid
+    FBuildingBook& Building = Books[Booking.BuildingIndex];
+    if (!Building.bActive || Building.Generation != Booking.Generation || Booking.StartSlot < NowSlot
+        || !Building.Book.IsFree(Booking.Lane, Booking.StartSlot, Booking.Length))
+    {
+        return false;
+    }
+
+    Building.Book.SetBooked(Booking.Lane, Booking.StartSlot, Booking.Length, true);
+    return true;
+}
+
+void FTreatmentScheduler::Cancel(const FTreatmentBooking& Booking)
+{
+    if (!Books.IsValidIndex(Booking.BuildingIndex))
+    {
+        return;
+    }
+
+    FBuildingBook& Building = Books[Booking.BuildingIndex];
+    if (!Building.bActive || Building.Generation != Booking.Generation || Booking.GetEndSlot() <= NowSlot)
+    {
+        return;
+    }
+
+    const int64 Start = FMath::Max(Booking.StartSlot, NowSlot);
+    Building.Book.SetBooked(Booking.Lane, Start, static_cast<int32>(Booking.GetEndSlot() - Start), false);
+
+    // A run through the freed slots may start up to a duration before them
+    const int64 Bound = FMath::Max(NowSlot, Start - Building.DurationSlots + 1);
+    if (Bound < Building.Bound)
+    {
+        SetBound(Booking.BuildingIndex, Bound);
+    }
+}
+
+int32 FTreatmentScheduler::BookGroup(FName Treatment, int64 FromSlot, int32 GroupSize, TFunctionRef<int64(int32 BuildingIndex)> GetTravelSlots, TArray<FTreatmentBooking>& OutBookings)
+{
+    OutBookings.Reset(GroupSize);
+
+    int32 NumBooked = 0;
+    for (int32 Member = 0; Member < GroupSize; Member++)
+    {
+        const FTreatmentBooking Booking = FindBest(Treatment, FromSlot, GetTravelSlots);
+        if (Booking.IsValid() && Book(Booking))
+        {
+            OutBookings.Add(Booking);
+            NumBooked++;
+        }
+        else
+        {
+            // Nothing is left for this member, so nothing is left for the rest either
+            OutBookings.SetNum(GroupSize);
+            break;
+        }
+    }
+
+    return NumBooked;
+}
+
+const FAppointmentBook* FTreatmentScheduler::GetBook(int32 BuildingIndex) const
+{
+    return Books.IsValidIndex(BuildingIndex) && Books[BuildingIndex].bActive ? &Books[BuildingIndex].Book : nullptr;
+}
+
+FTreatmentScheduler::FHeapEntry FTreatmentScheduler::MakeEntry(int32 BuildingIndex, const FBuildingBook& Building)
+{
+    FHeapEntry Entry;
+    Entry.Key = Building.Bound + Building.DurationSlots;
+    Entry.BuildingIndex = BuildingIndex;
+    Entry.Generation = Building.Generation;
+    return Entry;
+}
+
+bool FTreatmentScheduler::IsCurrent(const FHeapEntry& Entry) const
+{
+    const FBuildingBook& Building = Books[Entry.BuildingIndex];
+    return Building.bActive
+        && Building.Generation == Entry.Generation
+        && Building.Bound + Building.DurationSlots == Entry.Key;
+}
+
+void FTreatmentScheduler::SetBound(int32 BuildingIndex, int64 Bound)
+{
+    FBuildingBook& Building = Books[BuildingIndex];
+    Building.Bound = Bound;
+
+    ForEachHeap(Building, [this, BuildingIndex](FCandidateHeap& Heap, FName Treatment)
+    {
+        PushEntry(Heap, BuildingIndex, Treatment);
+    });
+}
+
+void FTreatmentScheduler::PushEntry(FCandidateHeap& Heap, int32 BuildingIndex, FName Treatment)
+{
+    Heap.Entries.HeapPush(MakeEntry(BuildingIndex, Books[BuildingIndex]), FHeapOrder());
+
+    // Every bound change leaves a stale entry behind; rebuild once they outnumber the live ones
+    if (Heap.Entries.Num() <= 2 * Heap.NumBuildings + 32)
+    {
+        return;
+    }
+
+    Heap.Entries.Reset();
+    for (int32 Index = 0; Index < Books.Num(); Index++)
+    {
+        const FBuildingBook& Building = Books[Index];
+        if (Building.bActive && (Treatment.IsNone() || Building.Treatments.Contains(Treatment)))
+        {
+            Heap.Entries.Add(MakeEntry(Index, Building));
+        }
+    }
+    Heap.Entries.Heapify(FHeapOrder());
+}
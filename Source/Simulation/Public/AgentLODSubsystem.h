@@ -0,0 +1,180 @@
+﻿// AgentLODSubsystem.h - Camera-driven simulation detail for guest and staff actors
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SimulationTypes.h"
+#include "AgentLODSubsystem.generated.h"
+
+// Broadcast when an agent has reached the end of its path, at the same time in every tier
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAgentArrived, AActor*, Agent);
+
+// Broadcast when an agent moves to another tier, e.g. to pause or resume its own steering
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnAgentTierChanged, AActor*, Agent, EAgentLODTier, Tier);
+
+/**
+ * Moves registered guest and staff actors along their paths with as much detail as the camera needs.
+ * An agent's position on its path is a function of the time it started and its speed, so every
+ * tier agrees on where it is and when it arrives:
+ * - Full: near the view focus; the actor ticks and steers itself, only its arrival time is tracked.
+ * - Reduced: visible but further away; the actor does not tick and is moved a few times a second.
+ * - Statistical: off-screen; the actor is hidden and not moved at all. It is placed at its current
+ *   point on the cached path when it becomes visible again.
+ * Tiers are assigned from the view of the player's TopDownCameraController a few times a second.
+ * Arrivals are kept in a heap by time and fire regardless of tier.
+ */
+UCLASS()
+class SIMULATION_API UAgentLODSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    // Distance from the view focus within which visible agents get the full tier
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Agent LOD", meta = (ClampMin = "0"))
+    float FullTierDistance = 2000.0f;
+
+    // Extra distance beyond the visible ground that still counts as on-screen
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Agent LOD", meta = (ClampMin = "0"))
+    float ViewMargin = 500.0f;
+
+    // Seconds between two moves of an agent in the reduced tier
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Agent LOD", meta = (ClampMin = "0.02"))
+    float ReducedUpdateInterval = 0.2f;
+
+    // Seconds between two tier assignments
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Agent LOD", meta = (ClampMin = "0"))
+    float TierUpdateInterval = 0.25f;
+
+    // Called when an agent reaches the end of its path
+    UPROPERTY(BlueprintAssignable, Category = "Agent LOD")
+    FOnAgentArrived OnAgentArrived;
+
+    // Called when an agent changes tier
+    UPROPERTY(BlueprintAssignable, Category = "Agent LOD")
+    FOnAgentTierChanged OnAgentTierChanged;
+
+    // UWorldSubsystem interface
+    virtual void Deinitialize() override;
+
+    // FTickableGameObject interface
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    /**
+     * Add a guest or staff actor; it starts standing where it is, in the full tier
+     * @param Agent The agent actor
+     * @return True if the agent was added
+     */
+    UFUNCTION(BlueprintCallable, Category = "Agent LOD")
+    bool RegisterAgent(AActor* Agent);
+
+    /**
+     * Remove an agent and give it back its tick and visibility
+     * @param Agent The agent actor
+     * @return True if the agent was registered
+     */
+    UFUNCTION(BlueprintCallable, Category = "Agent LOD")
+    bool UnregisterAgent(AActor* Agent);
+
+    /**
+     * Send an agent along a path, starting now
+     * @param Agent The agent actor
+     * @param Path World positions to pass through, the first one is the start
+     * @param Speed Walking speed in units per second
+     * @return Seconds until the agent arrives, negative if the agent is not registered
+     */
+    UFUNCTION(BlueprintCallable, Category = "Agent LOD")
+    float MoveAgentAlongPath(AActor* Agent, const TArray<FVector>& Path, float Speed);
+
+    /**
+     * Get the tier an agent is simulated in
+     * @param Agent The agent actor
+     * @return Current tier, Statistical for unknown agents
+     */
+    UFUNCTION(BlueprintCallable, Category = "Agent LOD")
+    EAgentLODTier GetAgentTier(AActor* Agent) const;
+
+    /**
+     * Get the number of agents in a tier
+     * @param Tier The tier
+     * @return Number of registered agents in the tier
+     */
+    UFUNCTION(BlueprintCallable, Category = "Agent LOD")
+    int32 GetNumAgentsInTier(EAgentLODTier Tier) const { return TierCounts[static_cast<int32>(Tier)]; }
+
+private:
+    // A registered agent and the path it follows
+    struct FLODAgent
+    {
+        TWeakObjectPtr<AActor> Actor;
+        EAgentLODTier Tier = EAgentLODTier::Full;
+
+        // Path points and the distance along the path at each of them
+        TArray<FVector> Path;
+        TArray<float> PathDistances;
+
+        // World time the walk started and its speed
+        double StartTime = 0.0;
+        float Speed = 0.0f;
+
+        // Counts walks, so arrivals of an earlier walk are ignored
+        uint32 Walk = 0;
+
+        // Next world time a reduced-tier agent is moved
+        double NextMoveTime = 0.0;
+
+        // Components that were ticking when the agent left the full tier, resumed when it comes back
+        TArray<TWeakObjectPtr<UActorComponent>> PausedComponents;
+
+        bool IsMoving() const { return Path.Num() > 1; }
+        double GetArrivalTime() const { return StartTime + PathDistances.Last() / Speed; }
+    };
+
+    // Arrival of an agent at the end of a walk
+    struct FArrival
+    {
+        double Time = 0.0;
+        int32 AgentId = INDEX_NONE;
+        uint32 Walk = 0;
+    };
+
+    // Earliest arrival first
+    struct FArrivalOrder
+    {
+        bool operator()(const FArrival& A, const FArrival& B) const { return A.Time < B.Time; }
+    };
+
+    // Assign every agent its tier from the camera's view
+    void UpdateTiers(double Now);
+
+    // Switch an agent to a tier, adjusting its tick and visibility
+    void SetTier(int32 AgentId, EAgentLODTier Tier, double Now);
+
+    // Pause or resume the ticks of an agent's actor and of its components that were ticking
+    void SetAgentTicking(FLODAgent& Agent, bool bTicking);
+
+    // Place an agent at its point on the path for a time
+    void PlaceOnPath(const FLODAgent& Agent, double Now) const;
+
+    // Point on a moving agent's path and the direction of its segment at a time
+    void GetPathPoint(const FLODAgent& Agent, double Time, FVector& OutLocation, FVector& OutDirection) const;
+
+    // Free an agent's id
+    void ReleaseAgent(int32 AgentId);
+
+    // Fire the arrivals that are due
+    void DispatchArrivals(double Now);
+
+    // Agents by id, ids are reused after an agent is removed
+    TArray<FLODAgent> Agents;
+    TArray<int32> FreeAgentIds;
+
+    // Pending arrivals
+    TArray<FArrival> Arrivals;
+
+    // Registered agents per tier
+    int32 TierCounts[3] = { 0, 0, 0 };
+
+    // World time of the next tier assignment
+    double NextTierUpdateTime = 0.0;
+};
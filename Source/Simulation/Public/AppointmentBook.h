@@ -0,0 +1,86 @@
+﻿// AppointmentBook.h - Slot bitmap of the bookings of a single building
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Bookings of one building over a rolling window of fixed-length time slots.
+ * Every place in the building (lane) keeps one bit per slot, packed into 64-bit words, so a
+ * conflict check or an earliest-free-run search over a day touches only a couple of words.
+ * The window start is kept word aligned, moving it forward drops whole words.
+ */
+class SIMULATION_API FAppointmentBook
+{
+public:
+    // Longest appointment in slots
+    static constexpr int32 MaxLength = 64;
+
+    /**
+     * Clear the book
+     * @param InNumLanes Number of appointments that can run at the same time
+     * @param WindowSlots Number of slots ahead of the start that can be booked
+     * @param StartSlot First slot of the window
+     */
+    void Init(int32 InNumLanes, int32 WindowSlots, int64 StartSlot);
+
+    /**
+     * Move the window forward, forgetting bookings that ended before it
+     * @param Slot New first slot of interest
+     */
+    void AdvanceTo(int64 Slot);
+
+    /**
+     * Check that a lane is free for a span of slots
+     * @param Lane Lane to test
+     * @param Start First slot
+     * @param Length Number of slots
+     * @return True if every slot is inside the window and unbooked
+     */
+    bool IsFree(int32 Lane, int64 Start, int32 Length) const;
+
+    /**
+     * Find the earliest start of a free run on any lane
+     * @param From Earliest acceptable start
+     * @param Length Number of consecutive free slots needed
+     * @param OutLane Lane of the run
+     * @return First slot of the run, INDEX_NONE if the window has no such run
+     */
+    int64 FindEarliest(int64 From, int32 Length, int32& OutLane) const;
+
+    /**
+     * Book or release a span of slots on a lane
+     * @param Lane Lane to change
+     * @param Start First slot
+     * @param Length Number of slots
+     * @param bBooked True to book, false to release
+     */
+    void SetBooked(int32 Lane, int64 Start, int32 Length, bool bBooked);
+
+    // First slot covered by the window
+    FORCEINLINE int64 GetWindowStart() const { return BaseSlot; }
+
+    // First slot past the window
+    FORCEINLINE int64 GetWindowEnd() const { return BaseSlot + static_cast<int64>(WordsPerLane) * 64; }
+
+    // Number of lanes
+    FORCEINLINE int32 GetNumLanes() const { return NumLanes; }
+
+private:
+    // Booked bits of the 64 slots starting at Slot; slots outside the window read as booked
+    uint64 GetBookedBits(int32 Lane, int64 Slot) const;
+
+    // Earliest start of a free run on one lane, INDEX_NONE if there is none before Limit
+    int64 FindEarliestOnLane(int32 Lane, int64 From, int32 Length, int64 Limit) const;
+
+    // Slot of bit 0 of the first word
+    int64 BaseSlot = 0;
+
+    // Number of lanes
+    int32 NumLanes = 0;
+
+    // Number of 64-bit words per lane
+    int32 WordsPerLane = 0;
+
+    // Booked slots, lane-major
+    TArray<uint64> Words;
+};
@@ -0,0 +1,119 @@
+﻿// AuctionSolver.h - Sparse assignment solver based on the auction algorithm
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Assigns persons to objects, at most one each, maximizing the total benefit of the chosen arcs.
+ * Persons may stay unassigned at zero benefit, so arcs with negative benefit are never worth adding.
+ * Persons bid for their best object and raise its price by how much they prefer it over the next
+ * best; objects left without a person bid back for persons by lowering their price, which keeps
+ * leftover objects free of charge as optimality requires. With epsilon scaling the number of bids
+ * stays close to linear in practice. Prices and assignments survive between solves, so a problem
+ * that changed a little since the last solve starts close to its equilibrium and needs few bids.
+ * The result is optimal if every benefit is a multiple of GetBenefitScale().
+ */
+class SIMULATION_API FAuctionSolver
+{
+public:
+    /**
+     * Start a new problem; prices and the previous assignment are kept until overwritten
+     * @param NumObjects Number of objects
+     */
+    void Reset(int32 NumObjects);
+
+    /**
+     * Add a person, arcs added next belong to it
+     * @return Index of the person
+     */
+    int32 AddPerson();
+
+    /**
+     * Add an arc from the last added person
+     * @param Object Object the person can be assigned to
+     * @param Benefit Value of the assignment
+     */
+    void AddArc(int32 Object, int64 Benefit);
+
+    /**
+     * Set the price of an object, e.g. from an earlier solve of a similar problem
+     * @param Object Object index
+     * @param Price Price, not negative
+     */
+    void SetPrice(int32 Object, int64 Price);
+
+    /**
+     * Suggest an assignment to start from; it is kept only if it is still close to optimal
+     * @param Person Person index
+     * @param Object Object index, INDEX_NONE for unassigned
+     */
+    void SetInitialAssignment(int32 Person, int32 Object);
+
+    /**
+     * Solve the problem
+     * @param StartEpsilon Bid increment of the first scaling phase; small values suit warm starts
+     * @return Number of bids made
+     */
+    int32 Solve(int64 StartEpsilon);
+
+    // Object assigned to a person, INDEX_NONE if unassigned
+    FORCEINLINE int32 GetAssignment(int32 Person) const { return AssignedArcs[Person] != INDEX_NONE ? ArcObjects[AssignedArcs[Person]] : INDEX_NONE; }
+
+    // Person assigned to an object, INDEX_NONE if unassigned
+    FORCEINLINE int32 GetOwner(int32 Object) const { return Owners[Object]; }
+
+    // Price of an object after solving
+    FORCEINLINE int64 GetPrice(int32 Object) const { return Prices[Object]; }
+
+    // Factor benefits need to be a multiple of for the result to be optimal
+    FORCEINLINE int64 GetBenefitScale() const { return NumPersons() + 1; }
+
+    // Number of persons and objects
+    FORCEINLINE int32 NumPersons() const { return ArcStarts.Num() - 1; }
+    FORCEINLINE int32 NumObjects() const { return Prices.Num(); }
+
+    // Total benefit of the current assignment
+    int64 GetTotalBenefit() const;
+
+private:
+    // Best and second best net value of a person's arcs, not counting staying unassigned
+    void FindBestArcs(int32 Person, int32& OutBestArc, int64& OutBest, int64& OutSecond) const;
+
+    // Net value of what a person has now, zero when unassigned
+    int64 GetProfit(int32 Person) const;
+
+    // Assign a person along an arc, releasing whatever either side had before
+    void AssignArc(int32 Person, int32 Arc);
+
+    // Release persons that are no longer within Epsilon of their best choice and queue them
+    void QueueUnsettledPersons(int64 Epsilon);
+
+    // Persons bid until each is assigned or prefers to stay unassigned
+    int32 RunForwardAuction(int64 Epsilon);
+
+    // Unassigned objects with a price bid for persons until each is assigned or free
+    int32 RunReverseAuction(int64 Epsilon);
+
+    // Arcs of person i are ArcStarts[i] to ArcStarts[i + 1]
+    TArray<int32> ArcStarts;
+    TArray<int32> ArcObjects;
+    TArray<int64> ArcBenefits;
+
+    // Current object prices
+    TArray<int64> Prices;
+
+    // Arcs into each object, by arc index, built on solve
+    TArray<int32> ObjectArcStarts;
+    TArray<int32> ObjectArcs;
+
+    // Person of each arc
+    TArray<int32> ArcPersons;
+
+    // Assigned arc per person and person per object
+    TArray<int32> AssignedArcs;
+    TArray<int32> Owners;
+
+    // Persons and objects waiting to bid
+    TArray<int32> UnassignedPersons;
+    TArray<int32> UnassignedObjects;
+};
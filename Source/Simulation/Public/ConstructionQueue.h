@@ -0,0 +1,138 @@
+﻿// ConstructionQueue.h - Construction sites and the builders working on them
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Buildings under construction and the builders that put work into them.
+ * Sites and builders are kept as parallel arrays and the whole queue is advanced in one batch per
+ * simulation tick: idle builders are dispatched to the sites with the highest priority, nearest
+ * builder first, walk there and then add their working time to the site until it is done.
+ */
+class SIMULATION_API FConstructionQueue
+{
+public:
+    /**
+     * Remove all sites and builders
+     */
+    void Reset();
+
+    /**
+     * Queue a building for construction
+     * @param SiteId Id of the site, e.g. the building's handle index
+     * @param Cell Cell builders walk to
+     * @param FloorLevel Floor of the cell
+     * @param WorkHours Builder-hours of work needed
+     * @param MaxBuilders Most builders that can work on the site at once
+     * @param Priority Sites with a higher priority get builders first
+     */
+    void AddSite(int32 SiteId, const FIntPoint& Cell, int32 FloorLevel, float WorkHours, int32 MaxBuilders, int32 Priority = 0);
+
+    /**
+     * Drop a site, its builders become idle where they are
+     * @param SiteId Id of the site
+     */
+    void RemoveSite(int32 SiteId);
+
+    /**
+     * Change the priority of a queued site; builders already working there stay
+     * @param SiteId Id of the site
+     * @param Priority New priority
+     * @return True if the site is queued
+     */
+    bool SetPriority(int32 SiteId, int32 Priority);
+
+    /**
+     * Move a queued site, e.g. after its building was relocated; its work and builders stay
+     * @param SiteId Id of the site
+     * @param Cell New cell builders walk to
+     * @param FloorLevel Floor of the cell
+     * @return True if the site is queued
+     */
+    bool MoveSite(int32 SiteId, const FIntPoint& Cell, int32 FloorLevel);
+
+    /**
+     * Move every site and builder by the same number of cells, e.g. after the grid grew at its start
+     * @param Offset Cells to add to every position
+     */
+    void ShiftCells(const FIntPoint& Offset);
+
+    /**
+     * Add a builder
+     * @param Cell Cell the builder starts at
+     * @param FloorLevel Floor of the cell
+     * @return Id of the builder
+     */
+    int32 AddBuilder(const FIntPoint& Cell, int32 FloorLevel);
+
+    /**
+     * Remove a builder, leaving its site to the others
+     * @param BuilderId Id returned by AddBuilder
+     */
+    void RemoveBuilder(int32 BuilderId);
+
+    /**
+     * Dispatch idle builders and let all builders work for a span of time
+     * @param Hours Simulated hours that pass
+     * @param WalkHoursPerCell Hours a builder needs to walk one cell
+     * @param WalkHoursPerFloor Hours a builder needs to change floors
+     * @param OutCompleted Ids of the sites finished during the span
+     */
+    void Advance(float Hours, float WalkHoursPerCell, float WalkHoursPerFloor, TArray<int32>& OutCompleted);
+
+    /**
+     * Finish every queued site at once, e.g. when nobody is left to build them
+     * @param OutCompleted Ids of the sites that were queued
+     */
+    void CompleteAll(TArray<int32>& OutCompleted);
+
+    // True if the site is still being built
+    bool IsQueued(int32 SiteId) const { return SiteSlots.IsValidIndex(SiteId) && SiteSlots[SiteId] != INDEX_NONE; }
+
+    // Share of a site's work that is done, 0-1, 1 for unknown sites
+    float GetProgress(int32 SiteId) const;
+
+    // Number of builders working on or walking to a site
+    int32 GetNumAssignedBuilders(int32 SiteId) const;
+
+    // Number of queued sites
+    FORCEINLINE int32 NumSites() const { return SiteIds.Num(); }
+
+    // Number of builders that were added and not removed
+    FORCEINLINE int32 NumBuilders() const { return NumActiveBuilders; }
+
+private:
+    // Remove a site by dense index, freeing its builders
+    void RemoveSiteAt(int32 Slot);
+
+    // Send idle builders to the sites that need them most
+    void DispatchBuilders(float WalkHoursPerCell, float WalkHoursPerFloor);
+
+    // Dense index per site id, INDEX_NONE if not queued
+    TArray<int32> SiteSlots;
+
+    // Sites, dense and in no particular order
+    TArray<int32> SiteIds;
+    TArray<FIntPoint> SiteCells;
+    TArray<int32> SiteFloors;
+    TArray<float> SiteWorkTotal;
+    TArray<float> SiteWorkLeft;
+    TArray<int32> SitePriorities;
+    TArray<int32> SiteMaxBuilders;
+    TArray<int32> SiteNumBuilders;
+
+    // Order sites were queued in, ties in priority go to the older site
+    TArray<int64> SiteSequence;
+    int64 NextSequence = 0;
+
+    // Builders by id; a removed builder keeps its entry, marked inactive
+    TArray<FIntPoint> BuilderCells;
+    TArray<int32> BuilderFloors;
+    TArray<int32> BuilderSites;
+    TArray<float> BuilderTravelLeft;
+    TArray<bool> BuilderActive;
+    int32 NumActiveBuilders = 0;
+
+    // Work added to each site during the current advance, by dense index
+    TArray<float> SiteWorkDone;
+};
@@ -0,0 +1,74 @@
+﻿// DemandForecaster.h - Seasonal exponential smoothing of daily demand
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Forecasts daily series such as guest arrivals with additive Holt-Winters smoothing over a
+ * weekly season. Each series keeps a level, a trend and one offset per weekday; a day's value
+ * updates them in constant time and a forecast is a sum of three numbers, so the whole model
+ * costs well under a microsecond per series per day.
+ * Series start on any day and stay aligned to the weekday of their first value. Until a series
+ * has seen a full week it forecasts the mean of what it has seen.
+ */
+class SIMULATION_API FDemandForecaster
+{
+public:
+    // Days in a season
+    static constexpr int32 SeasonLength = 7;
+
+    /**
+     * Remove all series and set the smoothing factors
+     * @param InLevelSmoothing Weight of a new value in the level, 0-1
+     * @param InTrendSmoothing Weight of a new level change in the trend, 0-1
+     * @param InSeasonSmoothing Weight of a new value in its weekday's offset, 0-1
+     */
+    void Reset(float InLevelSmoothing = 0.3f, float InTrendSmoothing = 0.05f, float InSeasonSmoothing = 0.2f);
+
+    /**
+     * Add a series
+     * @param FirstDay Day of its first value
+     * @return Index of the series
+     */
+    int32 AddSeries(int32 FirstDay);
+
+    /**
+     * Feed the value of the next day of a series
+     * @param Series Index of the series
+     * @param Value Value of the day
+     */
+    void Observe(int32 Series, float Value);
+
+    /**
+     * Forecast a series
+     * @param Series Index of the series
+     * @param DaysAhead 1 for the day after the last value
+     * @return Forecast value, never negative; 0 for series without values
+     */
+    float Forecast(int32 Series, int32 DaysAhead = 1) const;
+
+    // Number of series
+    FORCEINLINE int32 NumSeries() const { return AllSeries.Num(); }
+
+private:
+    // Smoothing state of one series
+    struct FSeries
+    {
+        float Level = 0.0f;
+        float Trend = 0.0f;
+        float Seasonal[SeasonLength] = {};
+
+        // Sum of the values of the first week, which seed level and offsets
+        float FirstSeasonSum = 0.0f;
+
+        // Weekday of the first value, and values seen
+        int32 FirstPhase = 0;
+        int32 Observations = 0;
+    };
+
+    TArray<FSeries> AllSeries;
+
+    float LevelSmoothing = 0.3f;
+    float TrendSmoothing = 0.05f;
+    float SeasonSmoothing = 0.2f;
+};
@@ -0,0 +1,55 @@
+﻿// EconomyLedger.h - Running account of the resort's income and expenses
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SimulationTypes.h"
+
+/**
+ * Books revenue and costs into the current day and keeps the most recent closed days.
+ * Booking is a couple of additions so it can be called from every simulation event.
+ */
+class SIMULATION_API FEconomyLedger
+{
+public:
+    /**
+     * Clear the history and start over
+     * @param StartingFunds Balance before the first day
+     * @param InMaxHistoryDays Closed days kept, older ones are dropped
+     */
+    void Reset(int32 StartingFunds, int32 InMaxHistoryDays = 90);
+
+    // Book income into the current day
+    FORCEINLINE void AddRevenue(int32 Amount) { Today.Revenue += Amount; Balance += Amount; }
+
+    // Book an expense into the current day
+    FORCEINLINE void AddCost(int32 Amount) { Today.Costs += Amount; Balance -= Amount; }
+
+    // Count an arriving guest for the current day
+    FORCEINLINE void AddGuest() { Today.Guests++; }
+
+    /**
+     * Close the current day and open the next one
+     * @param NextDay Index of the day being opened
+     */
+    void CloseDay(int32 NextDay);
+
+    // Current balance including the open day
+    FORCEINLINE int64 GetBalance() const { return Balance; }
+
+    // The day being booked
+    FORCEINLINE const FEconomyDayRecord& GetToday() const { return Today; }
+
+    // Most recent closed days, oldest first
+    FORCEINLINE const TArray<FEconomyDayRecord>& GetHistory() const { return History; }
+
+private:
+    // Day being booked
+    FEconomyDayRecord Today;
+
+    // Most recent closed days
+    TArray<FEconomyDayRecord> History;
+    int32 MaxHistoryDays = 90;
+
+    // Money available
+    int64 Balance = 0;
+};
@@ -0,0 +1,104 @@
+﻿// GuestSatisfaction.h - Per-guest satisfaction and its daily aggregation
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SimulationTypes.h"
+
+/**
+ * Satisfaction records of the guests of the current day.
+ * Each record sums up what happened to a guest (queue waits, walks, the ambience and efficiency
+ * of the visited buildings) as the simulation events occur, so a guest's satisfaction can be read
+ * at any time without looking at anything else. At the end of the day all records are reduced to
+ * a day report in parallel chunks; records of guests that left are dropped, the others carry over.
+ * Departures also feed running totals so the current day's average can be shown without a scan.
+ */
+class SIMULATION_API FGuestSatisfaction
+{
+public:
+    /**
+     * Remove all records and the history
+     * @param InMaxHistoryDays Closed days kept, older reports are dropped
+     */
+    void Reset(int32 InMaxHistoryDays = 90);
+
+    /**
+     * Start the record of an arriving guest
+     * @param GuestId Guest id in the simulation
+     * @return Index of the record, valid until the day is closed
+     */
+    int32 AddGuest(int32 GuestId);
+
+    // Count simulated seconds a guest waited in a queue
+    FORCEINLINE void AddWait(int32 Record, int64 Seconds) { WaitSeconds[Record] += Seconds; }
+
+    // Count simulated seconds a guest walked
+    FORCEINLINE void AddWalk(int32 Record, int64 Seconds) { WalkSeconds[Record] += Seconds; }
+
+    // Count a visit to a building with the ambience and efficiency in percent it had
+    FORCEINLINE void AddVisit(int32 Record, float Ambience, float Quality)
+    {
+        AmbienceSums[Record] += Ambience;
+        QualitySums[Record] += Quality;
+        Visits[Record]++;
+    }
+
+    // Count a queue a guest gave up on
+    FORCEINLINE void AddAbandonedQueue(int32 Record) { AbandonedQueues[Record]++; }
+
+    /**
+     * Finish the record of a leaving guest and add it to the running totals of the day
+     * @param Record Record of the guest
+     * @param Weights Weights of the satisfaction parts
+     */
+    void MarkDeparted(int32 Record, const FGuestSatisfactionWeights& Weights);
+
+    /**
+     * Compute the satisfaction of a guest
+     * @param Record Record of the guest
+     * @param Weights Weights of the satisfaction parts
+     * @return Satisfaction, 0-100
+     */
+    float GetSatisfaction(int32 Record, const FGuestSatisfactionWeights& Weights) const;
+
+    /**
+     * Reduce all records of the day into a report, drop the departed guests and keep the others
+     * @param Day Index of the day being closed
+     * @param Weights Weights of the satisfaction parts
+     * @param OnRecordMoved Called with the guest id and new record index of each guest that stays
+     * @return Report of the closed day, also added to the history
+     */
+    const FGuestSatisfactionReport& CloseDay(int32 Day, const FGuestSatisfactionWeights& Weights, TFunctionRef<void(int32 GuestId, int32 NewRecord)> OnRecordMoved);
+
+    // Average satisfaction of the guests that left today so far, 0 if nobody has
+    FORCEINLINE float GetDepartedAverage() const { return DepartedToday > 0 ? static_cast<float>(DepartedScoreSum / DepartedToday) : 0.0f; }
+
+    // Number of guests that left today so far
+    FORCEINLINE int32 GetDepartedToday() const { return DepartedToday; }
+
+    // Most recent closed days, oldest first
+    FORCEINLINE const TArray<FGuestSatisfactionReport>& GetHistory() const { return History; }
+
+    // Number of records of the current day
+    FORCEINLINE int32 NumRecords() const { return GuestIds.Num(); }
+
+private:
+    // Guest and state of each record
+    TArray<int32> GuestIds;
+    TArray<bool> Departed;
+
+    // Contributions per record, summed as events happen
+    TArray<int64> WaitSeconds;
+    TArray<int64> WalkSeconds;
+    TArray<float> AmbienceSums;
+    TArray<float> QualitySums;
+    TArray<int32> Visits;
+    TArray<int32> AbandonedQueues;
+
+    // Running totals of the guests that left today
+    double DepartedScoreSum = 0.0;
+    int32 DepartedToday = 0;
+
+    // Most recent closed days
+    TArray<FGuestSatisfactionReport> History;
+    int32 MaxHistoryDays = 90;
+};
@@ -0,0 +1,143 @@
+﻿// MassAgentFragments.h - MassEntity fragments of guest and staff agents
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "EGridTypes.h"
+#include "SimulationTypes.h"
+#include "MassAgentFragments.generated.h"
+
+/**
+ * What an agent is doing; the movement and decision processors move agents between these
+ */
+enum class EAgentTask : uint8
+{
+    // Needs a new destination
+    Deciding,
+
+    // Walking to the destination
+    Walking,
+
+    // At the destination, waiting to be let in
+    Waiting,
+
+    // Using the destination building, or working there for staff
+    Visiting,
+
+    // Walking to the entrance to leave
+    Leaving,
+
+    // Left, waiting to be destroyed
+    Done
+};
+
+/**
+ * Where an agent is
+ */
+USTRUCT()
+struct SIMULATION_API FAgentPositionFragment : public FMassFragment
+{
+    GENERATED_BODY()
+
+    // World position
+    FVector Location = FVector::ZeroVector;
+
+    // Walking speed in units per simulated second
+    float Speed = 150.0f;
+};
+
+/**
+ * Where an agent is going
+ */
+USTRUCT()
+struct SIMULATION_API FAgentDestinationFragment : public FMassFragment
+{
+    GENERATED_BODY()
+
+    // Building the agent is walking to or using, invalid when walking to the entrance
+    FBuildingHandle Building;
+
+    // World position of the destination
+    FVector Location = FVector::ZeroVector;
+};
+
+/**
+ * Parts of a guest's satisfaction, summed up as things happen; weighed like FGuestSatisfaction records
+ */
+USTRUCT()
+struct SIMULATION_API FAgentSatisfactionFragment : public FMassFragment
+{
+    GENERATED_BODY()
+
+    // Simulated seconds spent waiting and walking
+    float WaitSeconds = 0.0f;
+    float WalkSeconds = 0.0f;
+
+    // Ambience and efficiency of the visited buildings, summed over the visits
+    float AmbienceSum = 0.0f;
+    float QualitySum = 0.0f;
+    int32 Visits = 0;
+
+    // Waits the guest gave up on
+    int32 AbandonedQueues = 0;
+
+    // Satisfaction 0-100 from the parts
+    float GetSatisfaction(const FGuestSatisfactionWeights& Weights) const
+    {
+        float Satisfaction = Weights.Base;
+        Satisfaction -= WaitSeconds / 60.0f * Weights.PerWaitMinute;
+        Satisfaction -= WalkSeconds / 60.0f * Weights.PerWalkMinute;
+        Satisfaction -= AbandonedQueues * Weights.PerAbandonedQueue;
+        if (Visits > 0)
+        {
+            Satisfaction += AmbienceSum / Visits * Weights.PerAmbience;
+            Satisfaction += (QualitySum / Visits - 75.0f) * Weights.PerQualityPoint;
+        }
+        return FMath::Clamp(Satisfaction, 0.0f, 100.0f);
+    }
+};
+
+/**
+ * What an agent is doing and what it still wants to do
+ */
+USTRUCT()
+struct SIMULATION_API FAgentScheduleFragment : public FMassFragment
+{
+    GENERATED_BODY()
+
+    // Current task
+    EAgentTask Task = EAgentTask::Deciding;
+
+    // Simulated seconds left of the current visit or wait
+    float TimeLeft = 0.0f;
+
+    // Simulated seconds a staff member works before going home
+    float ShiftLeft = 0.0f;
+
+    // Treatments a guest still wants
+    int32 TreatmentsLeft = 0;
+
+    // True once a guest has eaten
+    bool bHasEaten = false;
+
+    // True while a building registration requested for this agent has not been answered
+    bool bRequestPending = false;
+};
+
+/**
+ * Marks guest agents
+ */
+USTRUCT()
+struct SIMULATION_API FAgentGuestTag : public FMassTag
+{
+    GENERATED_BODY()
+};
+
+/**
+ * Marks staff agents; their destination is the building they work at
+ */
+USTRUCT()
+struct SIMULATION_API FAgentStaffTag : public FMassTag
+{
+    GENERATED_BODY()
+};
@@ -0,0 +1,56 @@
+﻿// MassAgentProcessors.h - Processors that move guest and staff entities and decide what they do
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassProcessor.h"
+#include "MassEntityQuery.h"
+#include "MassAgentProcessors.generated.h"
+
+/**
+ * Moves walking and leaving agents towards their destination. An agent that reaches a building
+ * starts waiting to be let in; one that reaches the entrance while leaving is done.
+ * Runs from UMassAgentSubsystem's pipeline, not from the processing phases.
+ */
+UCLASS()
+class SIMULATION_API UAgentMovementProcessor : public UMassProcessor
+{
+    GENERATED_BODY()
+
+public:
+    UAgentMovementProcessor();
+
+protected:
+    virtual void ConfigureQueries() override;
+    virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+    // Guests and staff
+    FMassEntityQuery EntityQuery;
+};
+
+/**
+ * Chooses destinations and runs the waits and visits of agents.
+ * Guests go for their treatments, then a meal, then leave, each time choosing the open building
+ * that is quickest to reach and use. Staff walk to the building they work at and stay there.
+ * Entering and leaving buildings is deferred to the game thread, and agents that are done are
+ * destroyed there as well.
+ */
+UCLASS()
+class SIMULATION_API UAgentDecisionProcessor : public UMassProcessor
+{
+    GENERATED_BODY()
+
+public:
+    UAgentDecisionProcessor();
+
+protected:
+    virtual void ConfigureQueries() override;
+    virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+    // Guests
+    FMassEntityQuery GuestQuery;
+
+    // Staff
+    FMassEntityQuery StaffQuery;
+};
@@ -0,0 +1,187 @@
+﻿// MassAgentSubsystem.h - Guests and staff as MassEntity entities
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MassEntityTypes.h"
+#include "MassProcessingTypes.h"
+#include "EGridTypes.h"
+#include "SimulationTypes.h"
+#include "MassAgentSubsystem.generated.h"
+
+class ABuildingGridManager;
+class ABuildingObject;
+class UMassProcessor;
+struct FMassEntityManager;
+
+/**
+ * What the agent processors know about a building during one step
+ */
+struct FAgentBuildingInfo
+{
+    FBuildingHandle Handle;
+    FVector Location = FVector::ZeroVector;
+    float VisitSeconds = 0.0f;
+    float Quality = 0.0f;
+    float Ambience = 0.0f;
+    int32 FreePlaces = 0;
+    bool bOffersTreatment = false;
+    bool bServesFood = false;
+    bool bOpen = false;
+};
+
+/**
+ * Simulates large numbers of guests and staff as MassEntity entities instead of actors.
+ * Each agent is a set of fragments (position, destination, satisfaction and schedule) and a
+ * movement and a decision processor update all of them in parallel chunks on every step of
+ * USimulationClockSubsystem, reading a snapshot of the buildings taken at the start of the step.
+ * Agents enter and leave buildings through ABuildingObject's agent registration, keyed by
+ * FAgentHandle. Processors cannot touch actors from worker threads, so they queue these
+ * registrations as deferred commands that run on the game thread once the chunks are done.
+ */
+UCLASS()
+class SIMULATION_API UMassAgentSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    // Walking speed of new agents in units per simulated second
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Agents", meta = (ClampMin = "1"))
+    float WalkSpeed = 150.0f;
+
+    // Simulated seconds a guest waits to be let into a building before giving up
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Agents", meta = (ClampMin = "0"))
+    float MaxWaitSeconds = 45.0f * 60.0f;
+
+    // Weights of waiting, walking and building quality in guest satisfaction
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Agents")
+    FGuestSatisfactionWeights SatisfactionWeights;
+
+    // USubsystem interface
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    // UWorldSubsystem interface
+    virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+    /**
+     * Set the grid whose buildings agents visit; found automatically on begin play
+     * @param InGridManager Grid manager of the resort
+     */
+    UFUNCTION(BlueprintCallable, Category = "Agents")
+    void SetGridManager(ABuildingGridManager* InGridManager);
+
+    /**
+     * Create guests at the entrance
+     * @param Count Number of guests
+     * @param NumTreatments Treatments each guest wants before eating and leaving
+     * @return Number of guests created
+     */
+    UFUNCTION(BlueprintCallable, Category = "Agents")
+    int32 SpawnGuests(int32 Count, int32 NumTreatments = 1);
+
+    /**
+     * Create staff at the entrance that walk to a building, work there for one shift of
+     * UStaffSchedulingSubsystem and then go home
+     * @param Building Building the staff work at
+     * @param Count Number of staff
+     * @return Number of staff created
+     */
+    UFUNCTION(BlueprintCallable, Category = "Agents")
+    int32 SpawnStaff(FBuildingHandle Building, int32 Count);
+
+    /**
+     * Get the number of guest entities
+     * @return Guests in the resort
+     */
+    UFUNCTION(BlueprintCallable, Category = "Agents")
+    int32 GetNumGuests() const { return NumGuests; }
+
+    /**
+     * Get the number of staff entities
+     * @return Staff in the resort
+     */
+    UFUNCTION(BlueprintCallable, Category = "Agents")
+    int32 GetNumStaff() const { return NumStaff; }
+
+    /**
+     * Get the average satisfaction of the guests that have left
+     * @return Satisfaction 0-100, 0 if nobody has left yet
+     */
+    UFUNCTION(BlueprintCallable, Category = "Agents")
+    float GetDepartedSatisfaction() const { return DepartedGuests > 0 ? static_cast<float>(DepartedSatisfactionSum / DepartedGuests) : 0.0f; }
+
+    // Buildings by handle index as of the start of the step, read by the processors
+    const TArray<FAgentBuildingInfo>& GetBuildingSnapshot() const { return BuildingSnapshot; }
+
+    // World position of the entrance
+    FVector GetEntranceLocation() const { return EntranceLocation; }
+
+    /**
+     * Let an agent into its destination building, called on the game thread by deferred commands
+     * @param Agent The agent
+     * @param Building Building to enter
+     * @param bStaff True to assign the agent as staff, false to register it as a guest
+     * @return True if the building took the agent
+     */
+    bool EnterBuilding(const FMassEntityHandle& Agent, const FBuildingHandle& Building, bool bStaff) const;
+
+    /**
+     * Take an agent out of a building, called on the game thread by deferred commands
+     * @param Agent The agent
+     * @param Building Building to leave
+     * @param bStaff True if the agent works there
+     */
+    void LeaveBuilding(const FMassEntityHandle& Agent, const FBuildingHandle& Building, bool bStaff) const;
+
+    /**
+     * Count a guest that has left, called on the game thread by deferred commands
+     * @param Satisfaction Final satisfaction of the guest
+     */
+    void OnGuestDeparted(float Satisfaction);
+
+    // Count a staff member that has left, called on the game thread by deferred commands
+    void OnStaffDeparted() { NumStaff--; }
+
+private:
+    // Run the processors for one step of the simulation clock
+    void HandleSimulationStep(int32 Seconds);
+
+    // Refresh the building snapshot for this step
+    void UpdateBuildingSnapshot();
+
+    // Create agents of an archetype at the entrance
+    void CreateAgents(const FMassArchetypeHandle& Archetype, int32 Count, TArray<FMassEntityHandle>& OutEntities);
+
+    // Entity manager of the world, set on begin play
+    TSharedPtr<FMassEntityManager> EntityManager;
+
+    // Grid the agents walk on
+    UPROPERTY()
+    ABuildingGridManager* GridManager = nullptr;
+
+    // Movement and decision processors, run in this order every step
+    UPROPERTY()
+    TArray<UMassProcessor*> Processors;
+
+    // Pipeline built from the processors
+    FMassRuntimePipeline Pipeline;
+
+    // Archetypes of guests and staff
+    FMassArchetypeHandle GuestArchetype;
+    FMassArchetypeHandle StaffArchetype;
+
+    // Buildings by handle index as of the start of the step
+    TArray<FAgentBuildingInfo> BuildingSnapshot;
+
+    // World position of the entrance
+    FVector EntranceLocation = FVector::ZeroVector;
+
+    // Agent counts, changed on the game thread only
+    int32 NumGuests = 0;
+    int32 NumStaff = 0;
+
+    // Guests that have left and the sum of their final satisfaction
+    int32 DepartedGuests = 0;
+    double DepartedSatisfactionSum = 0.0;
+};
@@ -0,0 +1,137 @@
+﻿// MetricHistory.h - Bounded multi-resolution history of simulation metrics
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SimulationTypes.h"
+
+/**
+ * Samples of a metric within one period
+ */
+struct SIMULATION_API FMetricSample
+{
+    float Sum = 0.0f;
+    float Min = MAX_flt;
+    float Max = -MAX_flt;
+    int32 Count = 0;
+
+    FORCEINLINE void Add(float Value)
+    {
+        Sum += Value;
+        Min = FMath::Min(Min, Value);
+        Max = FMath::Max(Max, Value);
+        Count++;
+    }
+
+    FORCEINLINE void Merge(const FMetricSample& Other)
+    {
+        Sum += Other.Sum;
+        Min = FMath::Min(Min, Other.Min);
+        Max = FMath::Max(Max, Other.Max);
+        Count += Other.Count;
+    }
+
+    // Mean of the samples, 0 without samples
+    FORCEINLINE float GetAverage() const { return Count > 0 ? Sum / Count : 0.0f; }
+};
+
+/**
+ * Closed periods of one metric in one resolution, oldest first, read in place from the ring
+ */
+class FMetricSeriesView
+{
+public:
+    FMetricSeriesView() = default;
+
+    FMetricSeriesView(const FMetricSample* InData, int32 InCapacity, int32 InFirst, int32 InNum)
+        : Data(InData)
+        , Capacity(InCapacity)
+        , First(InFirst)
+        , Count(InNum)
+    {}
+
+    FORCEINLINE int32 Num() const { return Count; }
+
+    FORCEINLINE const FMetricSample& operator[](int32 Index) const
+    {
+        check(Index >= 0 && Index < Count);
+        const int32 Slot = First + Index;
+        return Data[Slot < Capacity ? Slot : Slot - Capacity];
+    }
+
+private:
+    const FMetricSample* Data = nullptr;
+    int32 Capacity = 0;
+    int32 First = 0;
+    int32 Count = 0;
+};
+
+/**
+ * History of a fixed set of metrics in hours, days and weeks.
+ * Samples go into the open hour. Closing an hour stores it in the hourly ring and adds it to the
+ * open day; the 24th hour closes the day the same way into the open week, and the 7th day closes
+ * the week. Every resolution keeps a fixed number of periods and overwrites the oldest, so memory
+ * stays the same however long the game runs: by default a day of hours, a season of days and five
+ * years of weeks.
+ * Rings are stored metric by metric and all metrics close together, so one head per resolution
+ * serves every metric.
+ */
+class SIMULATION_API FMetricHistory
+{
+public:
+    static constexpr int32 HoursPerDay = 24;
+    static constexpr int32 DaysPerWeek = 7;
+
+    /**
+     * Clear the history and size the rings
+     * @param InNumMetrics Number of metrics
+     * @param NumHours Hours kept
+     * @param NumDays Days kept
+     * @param NumWeeks Weeks kept
+     */
+    void Reset(int32 InNumMetrics, int32 NumHours = HoursPerDay, int32 NumDays = 90, int32 NumWeeks = 260);
+
+    // Add a sample to the open hour
+    FORCEINLINE void AddSample(int32 Metric, float Value) { Levels[0].Open[Metric].Add(Value); }
+
+    /**
+     * Close the open hour, and the day and week when they are complete
+     */
+    void CloseHour();
+
+    /**
+     * Get the closed periods of a metric
+     * @param Metric Index of the metric
+     * @param Resolution Period length
+     * @return Periods oldest first, valid until the next CloseHour or Reset
+     */
+    FMetricSeriesView GetSeries(int32 Metric, EMetricResolution Resolution) const;
+
+    // Samples of a metric in the period still open at a resolution, e.g. today so far
+    FORCEINLINE const FMetricSample& GetOpen(int32 Metric, EMetricResolution Resolution) const { return Levels[static_cast<int32>(Resolution)].Open[Metric]; }
+
+    // Number of metrics
+    FORCEINLINE int32 NumMetrics() const { return MetricCount; }
+
+private:
+    // Ring of closed periods and the open period of one resolution
+    struct FLevel
+    {
+        // Closed periods, Capacity per metric
+        TArray<FMetricSample> Samples;
+        int32 Capacity = 0;
+
+        // Slot the next closed period goes to, and closed periods stored
+        int32 Head = 0;
+        int32 Num = 0;
+
+        // Open period per metric and the periods of the level below it holds
+        TArray<FMetricSample> Open;
+        int32 OpenPeriods = 0;
+    };
+
+    // Store the open period of a level in its ring and add it to the next level's open period
+    void CloseLevel(int32 LevelIndex);
+
+    FLevel Levels[3];
+    int32 MetricCount = 0;
+};
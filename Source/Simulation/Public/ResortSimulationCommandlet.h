@@ -0,0 +1,22 @@
+﻿// ResortSimulationCommandlet.h - Headless fast-forward of the resort simulation
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ResortSimulationCommandlet.generated.h"
+
+/**
+ * Loads a map without rendering and fast-forwards its resort simulation.
+ * Usage: -run=ResortSimulation -Map=/Game/Maps/Resort -Days=30
+ */
+UCLASS()
+class SIMULATION_API UResortSimulationCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UResortSimulationCommandlet();
+
+    // UCommandlet interface
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,586 @@
+﻿// ResortSimulationSubsystem.h - Discrete-event simulation of the resort
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EGridTypes.h"
+#include "SimTimingWheel.h"
+#include "SimulationTypes.h"
+#include "EconomyLedger.h"
+#include "TreatmentScheduler.h"
+#include "ConstructionQueue.h"
+#include "GuestSatisfaction.h"
+#include "MetricHistory.h"
+#include "DemandForecaster.h"
+#include "ResortSimulationSubsystem.generated.h"
+
+class ABuildingGridManager;
+class ABuildingObject;
+
+// Broadcast when a new simulated day begins
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSimulationDayStarted, int32, Day);
+
+// Broadcast when an in-game fast-forward has finished
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnFastForwardFinished, const FFastForwardReport&, Report);
+
+/**
+ * Simulates guests arriving, keeping treatment appointments, eating and leaving.
+ * Every guest action is an event on a timing wheel keyed by simulated seconds, so a guest costs
+ * nothing between its events. Guests occupy buildings through ABuildingObject's simulated guest
+ * registration and share capacity with actor-based guests.
+ * Treatments are booked ahead in slots of 15 minutes: a guest is given the appointment that
+ * finishes first across all treatment buildings and walks there to arrive on time. Groups book
+ * together on arrival. Restaurants and juice bars are walk-in with a queue.
+ * The start of each day is an event as well: it has the staff scheduled, runs the buildings'
+ * daily update, books their running costs and schedules the day's arrivals and shift changes.
+ * Every event also adds to the guest's satisfaction record, which is reduced into a report at the
+ * end of each day.
+ * Placed buildings are queued for construction; while any site is queued a construction tick
+ * advances all builders and sites as one batch and opens the buildings that are finished.
+ * Time advances in the fixed steps of USimulationClockSubsystem, so a run does not depend on the
+ * frame rate or the game speed. Nothing depends on rendering either, so the whole simulation can be
+ * fast-forwarded by advancing the wheel in a loop.
+ */
+UCLASS()
+class SIMULATION_API UResortSimulationSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    // Simulated seconds a guest needs to walk one grid cell
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+    float WalkSecondsPerCell = 2.0f;
+
+    // Simulated seconds a guest needs to change floors
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+    float WalkSecondsPerFloor = 30.0f;
+
+    // Simulated minutes a guest waits in a queue before giving up
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+    int32 MaxQueueWaitMinutes = 45;
+
+    // Guests arriving per day
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Schedule")
+    int32 DailyGuestArrivals = 40;
+
+    // Hour of the day the first guests arrive
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Schedule", meta = (ClampMin = "0", ClampMax = "23"))
+    int32 OpeningHour = 8;
+
+    // Hour of the day the last guests arrive
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Schedule", meta = (ClampMin = "0", ClampMax = "24"))
+    int32 ClosingHour = 20;
+
+    // Largest group of guests arriving together
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Schedule", meta = (ClampMin = "1"))
+    int32 MaxGroupSize = 4;
+
+    // Most treatments a single guest asks for
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Schedule", meta = (ClampMin = "1"))
+    int32 MaxTreatmentsPerGuest = 3;
+
+    // Seed of the arrival generator, equal seeds give equal runs
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Schedule")
+    int32 RandomSeed = 1337;
+
+    // Simulated minutes between two construction ticks
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Construction", meta = (ClampMin = "1"))
+    int32 ConstructionTickMinutes = 15;
+
+    // Weights of waiting, walking, ambience and building quality in guest satisfaction
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Satisfaction")
+    FGuestSatisfactionWeights SatisfactionWeights;
+
+    // Balance before the first day
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Economy")
+    int32 StartingFunds = 10000;
+
+    // Weight of a new day in the forecast level, 0-1
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Forecast", meta = (ClampMin = "0", ClampMax = "1"))
+    float ForecastLevelSmoothing = 0.3f;
+
+    // Weight of a new day in the forecast trend, 0-1
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Forecast", meta = (ClampMin = "0", ClampMax = "1"))
+    float ForecastTrendSmoothing = 0.05f;
+
+    // Weight of a new day in its weekday's forecast offset, 0-1
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Forecast", meta = (ClampMin = "0", ClampMax = "1"))
+    float ForecastSeasonSmoothing = 0.2f;
+
+    // Called at the start of every simulated day
+    UPROPERTY(BlueprintAssignable, Category = "Schedule")
+    FOnSimulationDayStarted OnDayStarted;
+
+    // Called when StartFastForward has reached its target
+    UPROPERTY(BlueprintAssignable, Category = "Simulation")
+    FOnFastForwardFinished OnFastForwardFinished;
+
+    // Simulated seconds per day
+    static constexpr int64 SecondsPerDay = 24 * 60 * 60;
+
+    // Simulated seconds per appointment slot
+    static constexpr int64 SecondsPerSlot = 15 * 60;
+
+    // Appointment slots that can be booked ahead, two days
+    static constexpr int32 AppointmentWindowSlots = 2 * SecondsPerDay / SecondsPerSlot;
+
+    // USubsystem interface
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+    // UWorldSubsystem interface
+    virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+    virtual void Deinitialize() override;
+
+    // FTickableGameObject interface
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    /**
+     * Set the grid whose buildings guests visit; found automatically on begin play
+     * @param InGridManager Grid manager of the resort
+     */
+    UFUNCTION(BlueprintCallable, Category = "Simulation")
+    void SetGridManager(ABuildingGridManager* InGridManager);
+
+    /**
+     * Schedule a guest to arrive at the entrance
+     * @param DelaySeconds Simulated seconds from now until the guest arrives
+     * @param NumTreatments Number of treatments the guest wants before eating and leaving
+     * @return Id of the guest
+     */
+    UFUNCTION(BlueprintCallable, Category = "Simulation")
+    int32 ScheduleGuestArrival(int64 DelaySeconds, int32 NumTreatments = 1);
+
+    /**
+     * Schedule a group of guests to arrive at the entrance together and book their first treatments as one batch
+     * @param DelaySeconds Simulated seconds from now until the group arrives
+     * @param GroupSize Number of guests in the group
+     * @param NumTreatments Number of treatments each guest wants before eating and leaving
+     * @return Id of the first guest of the group
+     */
+    UFUNCTION(BlueprintCallable, Category = "Simulation")
+    int32 ScheduleGroupArrival(int64 DelaySeconds, int32 GroupSize, int32 NumTreatments = 1);
+
+    /**
+     * Dispatch all events due within a span of simulated time
+     * @param Seconds Simulated seconds to advance
+     * @return Number of dispatched events
+     */
+    UFUNCTION(BlueprintCallable, Category = "Simulation")
+    int32 AdvanceSimulation(int64 Seconds);
+
+    /**
+     * Get the current simulated time
+     * @return Simulated seconds since the simulation started
+     */
+    UFUNCTION(BlueprintCallable, Category = "Simulation")
+    int64 GetSimulationTime() const { return EventWheel.GetNow(); }
+
+    /**
+     * Get the current simulated day
+     * @return Days since the simulation started
+     */
+    UFUNCTION(BlueprintCallable, Category = "Schedule")
+    int32 GetCurrentDay() const { return static_cast<int32>(EventWheel.GetNow() / SecondsPerDay); }
+
+    /**
+     * Simulate whole days as fast as possible, blocking until done
+     * @param Days Number of days to simulate
+     * @return Throughput of the run
+     */
+    UFUNCTION(BlueprintCallable, Category = "Simulation")
+    FFastForwardReport RunFastForward(int32 Days);
+
+    /**
+     * Simulate days across frames with world rendering switched off; OnFastForwardFinished reports the result
+     * @param Days Number of days to simulate
+     * @param BudgetMilliseconds Real time spent simulating per frame
+     */
+    UFUNCTION(BlueprintCallable, Category = "Simulation")
+    void StartFastForward(int32 Days, float BudgetMilliseconds = 30.0f);
+
+    /**
+     * Check if an in-game fast-forward is running
+     * @return True while StartFastForward has not reached its target
+     */
+    UFUNCTION(BlueprintCallable, Category = "Simulation")
+    bool IsFastForwarding() const { return FastForward.TargetTime != INDEX_NONE; }
+
+    /**
+     * Simulate up to the next opening hour, blocking until done
+     * @return Throughput of the run
+     */
+    UFUNCTION(BlueprintCallable, Category = "Simulation")
+    FFastForwardReport SkipToMorning();
+
+    /**
+     * Get the current balance
+     * @return Money available
+     */
+    UFUNCTION(BlueprintCallable, Category = "Economy")
+    int64 GetBalance() const { return Ledger.GetBalance(); }
+
+    /**
+     * Get the income and expenses of the most recent closed days
+     * @return Day records, oldest first
+     */
+    UFUNCTION(BlueprintCallable, Category = "Economy")
+    TArray<FEconomyDayRecord> GetEconomyHistory() const { return Ledger.GetHistory(); }
+
+    // Income and expenses booked by the simulation
+    const FEconomyLedger& GetLedger() const { return Ledger; }
+
+    /**
+     * Get the closed periods of a metric for a graph; revenue and costs are totals per period, the
+     * others averages of hourly samples
+     * @param Metric The metric
+     * @param Resolution Period length
+     * @param OutValues Values oldest first
+     */
+    UFUNCTION(BlueprintCallable, Category = "Economy")
+    void GetMetricHistory(EResortMetric Metric, EMetricResolution Resolution, TArray<float>& OutValues) const;
+
+    // Closed periods of a metric, read in place; valid until the simulation advances
+    FMetricSeriesView GetMetricSeries(EResortMetric Metric, EMetricResolution Resolution) const { return Metrics.GetSeries(static_cast<int32>(Metric), Resolution); }
+
+    /**
+     * Get what a guest is doing
+     * @param GuestId Guest id
+     * @return Current activity, None for unknown guests
+     */
+    UFUNCTION(BlueprintCallable, Category = "Simulation")
+    EGuestActivity GetGuestActivity(int32 GuestId) const;
+
+    /**
+     * Get the treatment appointment a guest is walking to or attending
+     * @param GuestId Guest id
+     * @param OutAppointment The appointment
+     * @return True if the guest has an appointment
+     */
+    UFUNCTION(BlueprintCallable, Category = "Schedule")
+    bool GetGuestAppointment(int32 GuestId, FTreatmentAppointment& OutAppointment) const;
+
+    /**
+     * Find the appointment a guest at the entrance could get right now, without booking it
+     * @param Treatment Treatment wanted, None for any
+     * @param OutAppointment The appointment
+     * @return True if a building has room within the booking window
+     */
+    UFUNCTION(BlueprintCallable, Category = "Schedule")
+    bool FindEarliestAppointment(FName Treatment, FTreatmentAppointment& OutAppointment);
+
+    /**
+     * Add a builder that works on queued construction sites, starting at the entrance
+     * @param Builder The builder actor
+     * @return True if the builder was added
+     */
+    UFUNCTION(BlueprintCallable, Category = "Construction")
+    bool RegisterBuilder(AActor* Builder);
+
+    /**
+     * Remove a builder, leaving its site to the others
+     * @param Builder The builder actor
+     * @return True if the builder was registered
+     */
+    UFUNCTION(BlueprintCallable, Category = "Construction")
+    bool UnregisterBuilder(AActor* Builder);
+
+    /**
+     * Change the priority of a building under construction
+     * @param Building Handle of the building
+     * @param Priority Sites with a higher priority get builders first
+     * @return True if the building is under construction
+     */
+    UFUNCTION(BlueprintCallable, Category = "Construction")
+    bool SetConstructionPriority(FBuildingHandle Building, int32 Priority);
+
+    /**
+     * Get the construction progress of a building
+     * @param Building Handle of the building
+     * @return Share of the work that is done (0-1), 1 if the building is not under construction
+     */
+    UFUNCTION(BlueprintCallable, Category = "Construction")
+    float GetConstructionProgress(FBuildingHandle Building) const { return ConstructionQueue.GetProgress(Building.Index); }
+
+    /**
+     * Get the current satisfaction of a guest in the resort
+     * @param GuestId Guest id
+     * @return Satisfaction 0-100, 0 for unknown guests
+     */
+    UFUNCTION(BlueprintCallable, Category = "Satisfaction")
+    float GetGuestSatisfaction(int32 GuestId) const;
+
+    /**
+     * Get the average satisfaction of the guests that left today so far
+     * @return Satisfaction 0-100, 0 if nobody has left yet
+     */
+    UFUNCTION(BlueprintCallable, Category = "Satisfaction")
+    float GetTodaySatisfaction() const { return Satisfaction.GetDepartedAverage(); }
+
+    /**
+     * Get the satisfaction reports of the most recent closed days
+     * @return Day reports, oldest first
+     */
+    UFUNCTION(BlueprintCallable, Category = "Satisfaction")
+    TArray<FGuestSatisfactionReport> GetSatisfactionHistory() const { return Satisfaction.GetHistory(); }
+
+    /**
+     * Forecast the number of guests arriving on a coming day
+     * @param DaysAhead 1 for tomorrow
+     * @return Expected arrivals
+     */
+    UFUNCTION(BlueprintCallable, Category = "Forecast")
+    float ForecastGuestArrivals(int32 DaysAhead = 1) const { return Forecaster.Forecast(ArrivalSeries, DaysAhead); }
+
+    /**
+     * Forecast the treatment demand of a coming day
+     * @param Treatment Treatment type, or None for the treatments guests ask for in total
+     * @param DaysAhead 1 for tomorrow
+     * @return Expected treatments; a visit to a building offering several types counts for each in equal parts
+     */
+    UFUNCTION(BlueprintCallable, Category = "Forecast")
+    float ForecastTreatmentDemand(FName Treatment, int32 DaysAhead = 1) const;
+
+    /**
+     * Get the running totals of the simulation
+     * @return Simulation statistics
+     */
+    UFUNCTION(BlueprintCallable, Category = "Simulation")
+    const FGuestSimulationStats& GetStats() const { return Stats; }
+
+private:
+    // Kinds of events on the wheel, the subject is a guest id for guest events
+    enum class EEventType : uint8
+    {
+        Arrive,
+        ReachBuilding,
+        VisitEnd,
+        QueueTimeout,
+        Leave,
+        DayStart,
+        ShiftStart,
+        ShiftEnd,
+        ConstructionTick,
+        MetricsHour
+    };
+
+    // State of a simulated guest
+    struct FSimGuest
+    {
+        EGuestActivity Activity = EGuestActivity::None;
+
+        // Building the guest is walking to, waiting at or using
+        FBuildingHandle Building;
+
+        // Where the guest currently is
+        FIntPoint Cell = FIntPoint::ZeroValue;
+        int32 FloorLevel = 0;
+
+        // Treatments still wanted
+        int32 TreatmentsLeft = 0;
+
+        // Booked treatment, if any
+        FTreatmentBooking Appointment;
+
+        // Next guest of the same group until the group has arrived
+        int32 NextInGroup = INDEX_NONE;
+
+        // True once the guest has eaten
+        bool bHasEaten = false;
+
+        // Satisfaction record of the guest
+        int32 SatisfactionRecord = INDEX_NONE;
+
+        // Simulated time the guest joined its current queue
+        int64 QueuedSince = 0;
+
+        // Event that ends the current activity
+        FSimEventId PendingEvent;
+
+        // Queue timeout while waiting
+        FSimEventId TimeoutEvent;
+    };
+
+    // Simulation view of a placed building
+    struct FSimBuilding
+    {
+        FBuildingHandle Handle;
+        TWeakObjectPtr<ABuildingObject> Building;
+        FIntPoint Cell = FIntPoint::ZeroValue;
+        int32 FloorLevel = 0;
+        int64 VisitSeconds = 0;
+        int32 AppointmentSlots = 1;
+        int32 Capacity = 1;
+        int32 Revenue = 0;
+        bool bOffersTreatment = false;
+        bool bServesFood = false;
+
+        // Guests waiting for a free place, in arrival order
+        TArray<int32> Queue;
+    };
+
+    // Route a dispatched event to its handler
+    void DispatchEvent(int64 Time, const FSimEvent& Event);
+
+    // Daily update of buildings and economy, and scheduling of the day's arrivals
+    void OnDayStart(int32 Day);
+
+    // Advance all construction sites by one tick and open the finished buildings
+    void OnConstructionTick();
+
+    // Schedule the next construction tick unless one is pending or nothing is being built
+    void ScheduleConstructionTick();
+
+    // Sample the hourly metrics and schedule the next hour
+    void OnMetricsHour();
+
+    // Add a sample to a metric, closing the hours that have passed first
+    void RecordMetric(EResortMetric Metric, float Value);
+
+    // Count a treatment visit towards the demand of the building's treatment types
+    void RecordTreatmentLoad(const FSimBuilding& Building);
+
+    // Feed the closed day's demand to the forecaster
+    void ObserveDemand(int32 ClosedDay);
+
+    // Advance the simulation to a time and measure the throughput
+    FFastForwardReport FastForwardTo(int64 TargetTime);
+
+    // Advance an in-game fast-forward by one frame's budget
+    void TickFastForward();
+
+    // Advance by one step of the simulation clock
+    void HandleSimulationStep(int32 Seconds);
+
+    // Throughput since the given starting point, logged
+    FFastForwardReport MakeFastForwardReport(int64 StartTime, int64 StartEvents, double StartWallTime) const;
+
+    // Event handlers
+    void OnGuestArrive(int32 GuestId);
+    void OnGuestReachBuilding(int32 GuestId);
+    void OnGuestVisitEnd(int32 GuestId);
+    void OnGuestQueueTimeout(int32 GuestId);
+    void OnGuestLeave(int32 GuestId);
+
+    // Send a guest to its next treatment, a meal or the exit
+    void ChooseNextActivity(int32 GuestId);
+
+    // Book the treatment that finishes first for a guest at its current position
+    bool BookTreatment(int32 GuestId);
+
+    // Release the unused slots of a guest's appointment
+    void CancelAppointment(FSimGuest& Guest);
+
+    // Whole slots a guest needs to walk to a treatment building, negative if the building is closed
+    int64 GetTravelSlots(const FIntPoint& Cell, int32 FloorLevel, int32 BuildingIndex) const;
+
+    // Bring the appointment books up to the current time, returning the first slot that can still be booked
+    int64 AdvanceAppointmentsToNow();
+
+    // Blueprint view of a booking
+    FTreatmentAppointment MakeAppointment(const FTreatmentBooking& Booking) const;
+
+    // Cheapest walk-in building for a guest by walking time plus expected wait, INDEX_NONE if none is open
+    int32 FindBestBuilding(const FSimGuest& Guest, const TArray<int32>& Candidates) const;
+
+    // Start using a building the guest was admitted to
+    void StartVisit(int32 GuestId, FSimBuilding& Building);
+
+    // Admit queued guests while the building has room
+    void AdmitQueuedGuests(FSimBuilding& Building);
+
+    // Ambience at a building, appeal plus tranquility minus noise
+    float GetAmbience(const FSimBuilding& Building) const;
+
+    // Simulated seconds to walk between two cells
+    int64 GetWalkSeconds(const FIntPoint& From, int32 FromFloor, const FIntPoint& To, int32 ToFloor) const;
+
+    // Simulation record of a handle, nullptr if unknown or stale
+    FSimBuilding* FindBuilding(const FBuildingHandle& Handle);
+
+    // Building registry callbacks
+    UFUNCTION()
+    void HandleBuildingPlaced(FBuildingHandle Handle, ABuildingObject* Building);
+
+    UFUNCTION()
+    void HandleBuildingRemoved(FBuildingHandle Handle, ABuildingObject* Building);
+
+    UFUNCTION()
+    void HandleBuildingMoved(FBuildingHandle Handle, ABuildingObject* Building);
+
+    UFUNCTION()
+    void HandleGridExpanded(FIntPoint CellOffset);
+
+    // Grid the simulated guests walk on
+    UPROPERTY()
+    ABuildingGridManager* GridManager = nullptr;
+
+    // Pending guest events
+    FSimTimingWheel EventWheel;
+
+    // Guests by id, ids are reused after a guest leaves
+    TArray<FSimGuest> Guests;
+    TArray<int32> FreeGuestIds;
+
+    // Buildings by handle index
+    TArray<FSimBuilding> Buildings;
+
+    // Handle indices of buildings serving food
+    TArray<int32> FoodBuildings;
+
+    // Appointment books of the treatment buildings
+    FTreatmentScheduler TreatmentScheduler;
+
+    // Bookings of the group being processed
+    TArray<FTreatmentBooking> GroupBookings;
+
+    // Buildings under construction by handle index, and their builders
+    FConstructionQueue ConstructionQueue;
+
+    // Builder actors by builder id, empty entries are free
+    TArray<TWeakObjectPtr<AActor>> Builders;
+
+    // Sites finished during the last construction tick
+    TArray<int32> CompletedSites;
+
+    // True while a construction tick is on the wheel
+    bool bConstructionTickPending = false;
+
+    // Satisfaction records of today's guests and the daily reports
+    FGuestSatisfaction Satisfaction;
+
+    // Arrival times and treatment wishes
+    FRandomStream ArrivalStream;
+
+    // Income and expenses
+    FEconomyLedger Ledger;
+
+    // Revenue, costs, balance and occupancy in hours, days and weeks, and the hour open in it
+    FMetricHistory Metrics;
+    int64 MetricsHour = 0;
+
+    // Daily demand forecasts: arrivals, treatment wishes and the load per treatment type
+    FDemandForecaster Forecaster;
+    int32 ArrivalSeries = INDEX_NONE;
+    int32 TreatmentWishSeries = INDEX_NONE;
+    TMap<FName, int32> TreatmentSeries;
+
+    // Today's treatment wishes and load per forecaster series
+    int32 TodayTreatmentWishes = 0;
+    TArray<float> TodayTreatmentLoad;
+
+    // Progress of an in-game fast-forward
+    struct FFastForwardState
+    {
+        int64 TargetTime = INDEX_NONE;
+        int64 StartTime = 0;
+        int64 StartEvents = 0;
+        double StartWallTime = 0.0;
+        float BudgetMilliseconds = 0.0f;
+        bool bRenderingWasDisabled = false;
+    };
+    FFastForwardState FastForward;
+
+    // Running totals
+    FGuestSimulationStats Stats;
+};
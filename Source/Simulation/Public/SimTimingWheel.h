@@ -0,0 +1,150 @@
+﻿// SimTimingWheel.h - Hierarchical timing wheel for discrete simulation events
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Event dispatched by the simulation at a scheduled time
+ */
+struct FSimEvent
+{
+    // Event kind, interpreted by the owner of the wheel
+    uint8 Type = 0;
+
+    // Object the event applies to, e.g. a guest id
+    int32 Subject = INDEX_NONE;
+
+    // Extra event data
+    int32 Data = 0;
+
+    FSimEvent()
+    {}
+
+    FSimEvent(uint8 InType, int32 InSubject, int32 InData = 0)
+        : Type(InType)
+        , Subject(InSubject)
+        , Data(InData)
+    {}
+};
+
+/**
+ * Reference to a scheduled event, used to cancel it
+ */
+struct FSimEventId
+{
+    int32 Index = INDEX_NONE;
+    uint32 Generation = 0;
+
+    bool IsValid() const { return Index != INDEX_NONE; }
+    void Reset() { Index = INDEX_NONE; }
+};
+
+/**
+ * Event queue keyed by simulated time in whole seconds.
+ * Four levels of 64 slots each cover about 194 days ahead of the current time; later events wait
+ * in an overflow list. Scheduling and cancelling are O(1), and advancing jumps directly from one
+ * occupied slot to the next, so idle time costs nothing no matter how many events are pending.
+ * Events due at the same time are dispatched in the order they were scheduled.
+ */
+class SIMULATION_API FSimTimingWheel
+{
+public:
+    static constexpr int32 NumLevels = 4;
+    static constexpr int32 SlotBits = 6;
+    static constexpr int32 NumSlots = 1 << SlotBits;
+
+    FSimTimingWheel();
+
+    /**
+     * Remove all events and restart the clock
+     * @param StartTime Simulated time to restart at
+     */
+    void Reset(int64 StartTime = 0);
+
+    /**
+     * Schedule an event
+     * @param Time Simulated time to dispatch at, times in the past are dispatched at the current time
+     * @param Event Event to dispatch
+     * @return Id that can be used to cancel the event
+     */
+    FSimEventId Schedule(int64 Time, const FSimEvent& Event);
+
+    /**
+     * Cancel a scheduled event
+     * @param Id Id returned by Schedule
+     * @return True if the event was still pending
+     */
+    bool Cancel(const FSimEventId& Id);
+
+    // True if the event has neither been dispatched nor cancelled
+    bool IsScheduled(const FSimEventId& Id) const;
+
+    /**
+     * Dispatch every event due up to a time, in time order, and move the clock there.
+     * The handler may schedule and cancel events, including events due at the current time.
+     * @param Target Simulated time to advance to
+     * @param Handler Called with the dispatch time and the event
+     * @return Number of dispatched events
+     */
+    int32 Advance(int64 Target, TFunctionRef<void(int64 Time, const FSimEvent& Event)> Handler);
+
+    // Time of the earliest pending event, MAX_int64 when empty
+    int64 GetNextEventTime() const;
+
+    // Current simulated time
+    FORCEINLINE int64 GetNow() const { return Now; }
+
+    // Number of pending events
+    FORCEINLINE int32 Num() const { return NumPending; }
+
+private:
+    static constexpr int32 OverflowBucket = NumLevels * NumSlots;
+    static constexpr int32 NumBuckets = OverflowBucket + 1;
+
+    struct FNode
+    {
+        int64 Time = 0;
+        FSimEvent Event;
+        int32 Prev = INDEX_NONE;
+        int32 Next = INDEX_NONE;
+        int32 Bucket = INDEX_NONE;
+        uint32 Generation = 0;
+    };
+
+    // Bucket an event due at Time belongs in relative to the current time
+    int32 GetBucket(int64 Time) const;
+
+    // Append a node to the tail of its bucket
+    void Link(int32 NodeIndex);
+
+    // Remove a node from its bucket
+    void Unlink(int32 NodeIndex);
+
+    // Release a node, invalidating ids that refer to it
+    void FreeNode(int32 NodeIndex);
+
+    // Re-insert the events of a bucket relative to the current time
+    void Cascade(int32 Bucket);
+
+    // Earliest time among the events of a bucket
+    int64 GetEarliestTime(int32 Bucket) const;
+
+    // Event storage, linked into buckets
+    TArray<FNode> Nodes;
+
+    // Unused entries of Nodes
+    TArray<int32> FreeNodes;
+
+    // First and last node of each bucket
+    int32 Heads[NumBuckets];
+    int32 Tails[NumBuckets];
+
+    // One bit per non-empty slot on each level
+    uint64 Occupied[NumLevels];
+
+    // Current simulated time
+    int64 Now = 0;
+
+    // Number of pending events
+    int32 NumPending = 0;
+};
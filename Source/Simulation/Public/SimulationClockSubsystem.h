@@ -0,0 +1,131 @@
+﻿// SimulationClockSubsystem.h - Fixed-step simulation clock with game speeds
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SimulationTypes.h"
+#include "SimulationClockSubsystem.generated.h"
+
+// Broadcast once per fixed step with the simulated seconds the step covers
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnSimulationStep, int32 /*SimulatedSeconds*/);
+
+// Broadcast when the game speed changes
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSimulationSpeedChanged, ESimulationSpeed, Speed);
+
+/**
+ * Turns real time into fixed simulation steps.
+ * Real time is accumulated in units of steps, scaled by the game speed, and every whole step is
+ * broadcast as the same number of simulated seconds. Simulations that advance only on these steps
+ * give the same results at any frame rate and any speed.
+ * At most MaxStepsPerFrame steps run per frame; what is left stays in the accumulator for the next
+ * frames, up to MaxBacklogSteps. Time beyond that is dropped rather than caught up, so a slow frame
+ * at 10x cannot make the following frames slower still.
+ */
+UCLASS()
+class SIMULATION_API USimulationClockSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    // Fixed steps per real second at 1x
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Clock", meta = (ClampMin = "1"))
+    int32 StepsPerSecond = 20;
+
+    // Simulated seconds covered by one step; 20 steps of 3 seconds make a simulated minute per real second
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Clock", meta = (ClampMin = "1"))
+    int32 SecondsPerStep = 3;
+
+    // Most steps run in one frame
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Clock", meta = (ClampMin = "1"))
+    int32 MaxStepsPerFrame = 12;
+
+    // Most steps kept for later frames; older time is dropped
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Clock", meta = (ClampMin = "0"))
+    int32 MaxBacklogSteps = 60;
+
+    // Called for every step, in order
+    FOnSimulationStep OnSimulationStep;
+
+    // Called when the speed changes
+    UPROPERTY(BlueprintAssignable, Category = "Clock")
+    FOnSimulationSpeedChanged OnSpeedChanged;
+
+    // FTickableGameObject interface
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    /**
+     * Change how fast simulated time runs
+     * @param NewSpeed The new speed
+     */
+    UFUNCTION(BlueprintCallable, Category = "Clock")
+    void SetSpeed(ESimulationSpeed NewSpeed);
+
+    /**
+     * Pause, or resume at the speed before the pause
+     */
+    UFUNCTION(BlueprintCallable, Category = "Clock")
+    void TogglePause();
+
+    /**
+     * Run steps right away, e.g. to step through a paused simulation
+     * @param NumSteps Number of steps
+     */
+    UFUNCTION(BlueprintCallable, Category = "Clock")
+    void RunSteps(int32 NumSteps);
+
+    /**
+     * Get the current speed
+     * @return Speed
+     */
+    UFUNCTION(BlueprintCallable, Category = "Clock")
+    ESimulationSpeed GetSpeed() const { return Speed; }
+
+    /**
+     * Get the number of steps run so far
+     * @return Steps
+     */
+    UFUNCTION(BlueprintCallable, Category = "Clock")
+    int64 GetStepCount() const { return StepCount; }
+
+    /**
+     * Get the simulated seconds the steps so far have covered
+     * @return Simulated seconds
+     */
+    UFUNCTION(BlueprintCallable, Category = "Clock")
+    int64 GetSimulatedSeconds() const { return SimulatedSeconds; }
+
+    /**
+     * Get how far real time is into the next step, to interpolate between two steps when drawing
+     * @return Fraction of a step 0-1
+     */
+    UFUNCTION(BlueprintCallable, Category = "Clock")
+    float GetStepAlpha() const { return static_cast<float>(FMath::Min(PendingSteps, 1.0)); }
+
+    /**
+     * Get the number of steps dropped because the backlog was full
+     * @return Dropped steps
+     */
+    UFUNCTION(BlueprintCallable, Category = "Clock")
+    int64 GetDroppedSteps() const { return DroppedSteps; }
+
+    // Real-time multiplier of a speed
+    static int32 GetSpeedMultiplier(ESimulationSpeed InSpeed);
+
+private:
+    // Current speed
+    ESimulationSpeed Speed = ESimulationSpeed::Normal;
+
+    // Speed to resume at after a pause
+    ESimulationSpeed SpeedBeforePause = ESimulationSpeed::Normal;
+
+    // Real time not yet run, in steps
+    double PendingSteps = 0.0;
+
+    // Steps run and the simulated seconds they covered
+    int64 StepCount = 0;
+    int64 SimulatedSeconds = 0;
+
+    // Steps dropped because the backlog was full
+    int64 DroppedSteps = 0;
+};
@@ -0,0 +1,304 @@
+﻿// SimulationTypes.h - Type definitions for the resort simulation
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EGridTypes.h"
+#include "SimulationTypes.generated.h"
+
+/**
+ * What a simulated guest is currently doing
+ */
+UENUM(BlueprintType)
+enum class EGuestActivity : uint8
+{
+    None         UMETA(DisplayName = "None"),
+    Arriving     UMETA(DisplayName = "Arriving"),
+    Walking      UMETA(DisplayName = "Walking"),
+    Queued       UMETA(DisplayName = "Queued"),
+    InTreatment  UMETA(DisplayName = "In Treatment"),
+    Eating       UMETA(DisplayName = "Eating"),
+    Leaving      UMETA(DisplayName = "Leaving")
+};
+
+/**
+ * How closely an agent actor is simulated, from the camera's point of view
+ */
+UENUM(BlueprintType)
+enum class EAgentLODTier : uint8
+{
+    Full         UMETA(DisplayName = "Full"),
+    Reduced      UMETA(DisplayName = "Reduced"),
+    Statistical  UMETA(DisplayName = "Statistical")
+};
+
+/**
+ * How fast simulated time runs compared to real time
+ */
+UENUM(BlueprintType)
+enum class ESimulationSpeed : uint8
+{
+    Paused   UMETA(DisplayName = "Paused"),
+    Normal   UMETA(DisplayName = "1x"),
+    Fast     UMETA(DisplayName = "3x"),
+    Fastest  UMETA(DisplayName = "10x")
+};
+
+/**
+ * Quantities of the resort recorded over time for graphs
+ */
+UENUM(BlueprintType)
+enum class EResortMetric : uint8
+{
+    Revenue    UMETA(DisplayName = "Revenue"),
+    Costs      UMETA(DisplayName = "Costs"),
+    Balance    UMETA(DisplayName = "Balance"),
+    Guests     UMETA(DisplayName = "Guests"),
+    Occupancy  UMETA(DisplayName = "Occupancy"),
+    Count      UMETA(Hidden)
+};
+
+/**
+ * Length of the periods a metric history is kept in
+ */
+UENUM(BlueprintType)
+enum class EMetricResolution : uint8
+{
+    Hour  UMETA(DisplayName = "Hour"),
+    Day   UMETA(DisplayName = "Day"),
+    Week  UMETA(DisplayName = "Week")
+};
+
+/**
+ * Running totals of the guest simulation
+ */
+USTRUCT(BlueprintType)
+struct SIMULATION_API FGuestSimulationStats
+{
+    GENERATED_BODY()
+
+    // Guests currently in the resort
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Simulation")
+    int32 ActiveGuests = 0;
+
+    // Guests that arrived since the simulation started
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Simulation")
+    int32 ArrivedGuests = 0;
+
+    // Guests that left since the simulation started
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Simulation")
+    int32 DepartedGuests = 0;
+
+    // Treatments finished by guests
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Simulation")
+    int32 CompletedTreatments = 0;
+
+    // Meals finished by guests
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Simulation")
+    int32 CompletedMeals = 0;
+
+    // Guests that gave up waiting in a queue
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Simulation")
+    int32 AbandonedQueues = 0;
+
+    // Events dispatched by the timing wheel
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Simulation")
+    int64 DispatchedEvents = 0;
+};
+
+/**
+ * Income and expenses of one simulated day
+ */
+USTRUCT(BlueprintType)
+struct SIMULATION_API FEconomyDayRecord
+{
+    GENERATED_BODY()
+
+    // Day index since the simulation started
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Economy")
+    int32 Day = 0;
+
+    // Money earned from guest visits
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Economy")
+    int32 Revenue = 0;
+
+    // Money spent on maintenance and other running costs
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Economy")
+    int32 Costs = 0;
+
+    // Guests that arrived during the day
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Economy")
+    int32 Guests = 0;
+};
+
+/**
+ * Throughput of a fast-forward run
+ */
+USTRUCT(BlueprintType)
+struct SIMULATION_API FFastForwardReport
+{
+    GENERATED_BODY()
+
+    // Simulated days covered by the run
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Simulation")
+    float SimulatedDays = 0.0f;
+
+    // Real time the run took in seconds
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Simulation")
+    float WallSeconds = 0.0f;
+
+    // Simulated days per real second
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Simulation")
+    float DaysPerSecond = 0.0f;
+
+    // Events dispatched during the run
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Simulation")
+    int64 DispatchedEvents = 0;
+};
+
+/**
+ * Treatment appointment booked by a simulated guest
+ */
+USTRUCT(BlueprintType)
+struct SIMULATION_API FTreatmentAppointment
+{
+    GENERATED_BODY()
+
+    // Building the appointment is in
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Schedule")
+    FBuildingHandle Building;
+
+    // Simulated time the appointment starts
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Schedule")
+    int64 StartTime = 0;
+
+    // Simulated time the booked slots end
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Schedule")
+    int64 EndTime = 0;
+
+    // Place within the building
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Schedule")
+    int32 Place = INDEX_NONE;
+};
+
+/**
+ * Outcome of a daily staff scheduling solve
+ */
+USTRUCT(BlueprintType)
+struct SIMULATION_API FStaffScheduleReport
+{
+    GENERATED_BODY()
+
+    // Staff places over all buildings and shifts
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Staff")
+    int32 Seats = 0;
+
+    // Places given to a staff member
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Staff")
+    int32 FilledSeats = 0;
+
+    // Staff members without a shift
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Staff")
+    int32 IdleStaff = 0;
+
+    // Sum over buildings of the staffed share of their requirements in percent, averaged over the shifts
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Staff")
+    float PlannedEfficiency = 0.0f;
+
+    // Efficiency points lost to commuting, averaged over the shifts
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Staff")
+    float TravelCost = 0.0f;
+
+    // Bids the solver needed
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Staff")
+    int32 Bids = 0;
+
+    // True if the solve started from the previous day's prices
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Staff")
+    bool bWarmStarted = false;
+
+    // Real time the solve took in milliseconds
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Staff")
+    float SolveMilliseconds = 0.0f;
+};
+
+/**
+ * How much each part of a guest's visit adds to or takes from its satisfaction
+ */
+USTRUCT(BlueprintType)
+struct SIMULATION_API FGuestSatisfactionWeights
+{
+    GENERATED_BODY()
+
+    // Satisfaction of a guest before anything happened, 0-100
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Satisfaction", meta = (ClampMin = "0", ClampMax = "100"))
+    float Base = 70.0f;
+
+    // Points lost per simulated minute spent in a queue
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Satisfaction", meta = (ClampMin = "0"))
+    float PerWaitMinute = 0.5f;
+
+    // Points lost per simulated minute spent walking
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Satisfaction", meta = (ClampMin = "0"))
+    float PerWalkMinute = 0.2f;
+
+    // Points per unit of ambience (appeal plus tranquility minus noise) at the visited buildings, on average
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Satisfaction")
+    float PerAmbience = 5.0f;
+
+    // Points per efficiency point the visited buildings ran above or below 75 percent, on average
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Satisfaction")
+    float PerQualityPoint = 0.4f;
+
+    // Points lost for every queue the guest gave up on
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Satisfaction", meta = (ClampMin = "0"))
+    float PerAbandonedQueue = 15.0f;
+
+    // Guests below this satisfaction count as unhappy
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Satisfaction", meta = (ClampMin = "0", ClampMax = "100"))
+    float UnhappyBelow = 40.0f;
+};
+
+/**
+ * Satisfaction of the guests of one simulated day
+ */
+USTRUCT(BlueprintType)
+struct SIMULATION_API FGuestSatisfactionReport
+{
+    GENERATED_BODY()
+
+    // Day index since the simulation started
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Satisfaction")
+    int32 Day = 0;
+
+    // Guests that were in the resort during the day
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Satisfaction")
+    int32 Guests = 0;
+
+    // Of those, guests that had left by the end of the day
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Satisfaction")
+    int32 DepartedGuests = 0;
+
+    // Average satisfaction, 0-100
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Satisfaction")
+    float AverageSatisfaction = 0.0f;
+
+    // Guests below the unhappy threshold
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Satisfaction")
+    int32 UnhappyGuests = 0;
+
+    // Average simulated minutes a guest spent in queues
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Satisfaction")
+    float AverageWaitMinutes = 0.0f;
+
+    // Average simulated minutes a guest spent walking
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Satisfaction")
+    float AverageWalkMinutes = 0.0f;
+
+    // Average ambience at the visited buildings
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Satisfaction")
+    float AverageAmbience = 0.0f;
+
+    // Average efficiency of the visited buildings in percent
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Satisfaction")
+    float AverageQuality = 0.0f;
+};
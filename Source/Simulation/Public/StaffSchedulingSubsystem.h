@@ -0,0 +1,207 @@
+﻿// StaffSchedulingSubsystem.h - Daily assignment of staff to buildings and shifts
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EGridTypes.h"
+#include "AuctionSolver.h"
+#include "SimulationTypes.h"
+#include "StaffSchedulingSubsystem.generated.h"
+
+class ABuildingGridManager;
+class ABuildingObject;
+
+/**
+ * Assigns registered staff members to buildings and shifts once per day.
+ * Every building needs its RequiredStaffTypes in each shift and every staff member works at most
+ * one shift. Each place is worth its share of the building's efficiency, minus the staff
+ * member's commute, and the total is maximized by an auction solver. The solver starts from the
+ * previous day's prices and assignment, so a day with few changes is solved in a few bids.
+ * Assignments of a shift are applied through ABuildingObject::AssignStaffMember when it starts and
+ * taken back when it ends. Start times wrap at midnight, so a late shift runs into the next day.
+ */
+UCLASS()
+class SIMULATION_API UStaffSchedulingSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    // Shifts per day, only as many as fit into a day are used
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Staff", meta = (ClampMin = "1", ClampMax = "4"))
+    int32 NumShifts = 2;
+
+    // Hour of the day the first shift starts
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Staff", meta = (ClampMin = "0", ClampMax = "23"))
+    int32 FirstShiftHour = 6;
+
+    // Length of a shift in hours
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Staff", meta = (ClampMin = "1", ClampMax = "24"))
+    int32 ShiftLengthHours = 8;
+
+    // Efficiency points a staff member's commute costs per grid cell
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Staff", meta = (ClampMin = "0"))
+    float TravelCostPerCell = 0.25f;
+
+    // Efficiency points a staff member's commute costs per floor
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Staff", meta = (ClampMin = "0"))
+    float TravelCostPerFloor = 2.0f;
+
+    // UWorldSubsystem interface
+    virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+    virtual void Deinitialize() override;
+
+    /**
+     * Set the grid whose buildings are staffed; found automatically on begin play
+     * @param InGridManager Grid manager of the resort
+     */
+    UFUNCTION(BlueprintCallable, Category = "Staff")
+    void SetGridManager(ABuildingGridManager* InGridManager);
+
+    /**
+     * Add a staff member to the roster, scheduled from the next solve on
+     * @param StaffMember The staff actor
+     * @param StaffType Type matched against the buildings' RequiredStaffTypes
+     * @param HomeCell Cell the staff member commutes from, e.g. a staff room
+     * @param HomeFloor Floor of the home cell
+     * @return True if the staff member was added or updated
+     */
+    UFUNCTION(BlueprintCallable, Category = "Staff")
+    bool RegisterStaffMember(AActor* StaffMember, FName StaffType, FIntPoint HomeCell, int32 HomeFloor = 0);
+
+    /**
+     * Remove a staff member from the roster and from the building it works at
+     * @param StaffMember The staff actor
+     * @return True if the staff member was on the roster
+     */
+    UFUNCTION(BlueprintCallable, Category = "Staff")
+    bool UnregisterStaffMember(AActor* StaffMember);
+
+    /**
+     * Assign the roster to buildings and shifts for the day. Staff already at work stay until their
+     * shift ends; every shift of the day starts through ApplyShift at its start time
+     * @return Outcome of the solve
+     */
+    UFUNCTION(BlueprintCallable, Category = "Staff")
+    FStaffScheduleReport SolveDay();
+
+    /**
+     * Put the staff of a shift to work at their buildings
+     * @param Shift Shift index
+     * @return Id of this run of the shift, passed to EndShift when it is over
+     */
+    UFUNCTION(BlueprintCallable, Category = "Staff")
+    int32 ApplyShift(int32 Shift);
+
+    /**
+     * Take the staff of a shift run off their buildings
+     * @param ShiftRun Id returned by ApplyShift
+     */
+    UFUNCTION(BlueprintCallable, Category = "Staff")
+    void EndShift(int32 ShiftRun);
+
+    /**
+     * Get where and when a staff member works today
+     * @param StaffMember The staff actor
+     * @param OutBuilding Building the staff member works at
+     * @param OutShift Shift the staff member works
+     * @return True if the staff member has a shift today
+     */
+    UFUNCTION(BlueprintCallable, Category = "Staff")
+    bool GetStaffAssignment(AActor* StaffMember, FBuildingHandle& OutBuilding, int32& OutShift) const;
+
+    /**
+     * Get the outcome of the last solve
+     * @return Report of the last SolveDay
+     */
+    UFUNCTION(BlueprintCallable, Category = "Staff")
+    FStaffScheduleReport GetLastReport() const { return LastReport; }
+
+    // Length of a shift in hours, clamped to a day
+    int32 GetShiftLengthHours() const { return FMath::Clamp(ShiftLengthHours, 1, 24); }
+
+    // Shifts per day, NumShifts clamped so the shifts do not overlap within a day
+    int32 GetNumShifts() const { return FMath::Clamp(NumShifts, 1, FMath::Min(4, 24 / GetShiftLengthHours())); }
+
+    // Simulated seconds after the start of a day at which a shift starts, wrapped at midnight
+    int64 GetShiftStartSeconds(int32 Shift) const { return static_cast<int64>((FMath::Clamp(FirstShiftHour, 0, 23) + Shift * GetShiftLengthHours()) % 24) * 3600; }
+
+    // Simulated seconds a shift lasts
+    int64 GetShiftLengthSeconds() const { return static_cast<int64>(GetShiftLengthHours()) * 3600; }
+
+private:
+    // One place for one staff member of a type at a building during a shift
+    struct FStaffSeat
+    {
+        FBuildingHandle Building;
+        FName StaffType;
+        int32 Shift = 0;
+        int32 Index = 0;
+
+        bool operator==(const FStaffSeat& Other) const
+        {
+            return Building == Other.Building && StaffType == Other.StaffType && Shift == Other.Shift && Index == Other.Index;
+        }
+
+        friend uint32 GetTypeHash(const FStaffSeat& Seat)
+        {
+            return HashCombine(HashCombine(GetTypeHash(Seat.Building), GetTypeHash(Seat.StaffType)), Seat.Shift * 64 + Seat.Index);
+        }
+    };
+
+    // Roster entry
+    struct FStaffRecord
+    {
+        TWeakObjectPtr<AActor> Actor;
+        FName StaffType;
+        FIntPoint HomeCell = FIntPoint::ZeroValue;
+        int32 HomeFloor = 0;
+
+        // Today's place, if any
+        FStaffSeat Seat;
+        bool bHasSeat = false;
+    };
+
+    // Commute cost of a staff member to a building in hundredths of an efficiency point
+    int64 GetTravelCost(const FStaffRecord& Record, const FIntPoint& Cell, int32 FloorLevel) const;
+
+    // Take every staff member this subsystem put to work off their buildings
+    void ClearAppliedShift();
+
+    // Take one staff member off the building this subsystem put them in
+    void RemoveAppliedStaff(AActor* StaffMember);
+
+    // Renumber home cells after the grid grew at its start
+    UFUNCTION()
+    void HandleGridExpanded(FIntPoint CellOffset);
+
+    // Grid whose buildings are staffed
+    UPROPERTY()
+    ABuildingGridManager* GridManager = nullptr;
+
+    // Staff members that can be scheduled
+    TArray<FStaffRecord> Roster;
+
+    // Assignment solver, reused between days
+    FAuctionSolver Solver;
+
+    // Final seat prices of the last solve and the benefit scale they are in
+    TMap<FStaffSeat, int64> SeatPrices;
+    int64 PriceScale = 1;
+
+    // A staff member this subsystem put into a building and the shift run they work in
+    struct FAppliedStaff
+    {
+        TWeakObjectPtr<ABuildingObject> Building;
+        TWeakObjectPtr<AActor> StaffMember;
+        int32 ShiftRun = INDEX_NONE;
+    };
+
+    // Staff at work in the shifts running now
+    TArray<FAppliedStaff> AppliedStaff;
+
+    // Id of the next shift run
+    int32 NextShiftRun = 0;
+
+    // Outcome of the last solve
+    FStaffScheduleReport LastReport;
+};
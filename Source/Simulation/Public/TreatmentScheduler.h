@@ -0,0 +1,170 @@
+﻿// TreatmentScheduler.h - Appointment booking across all treatment buildings
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AppointmentBook.h"
+
+/**
+ * A booked or proposed appointment
+ */
+struct FTreatmentBooking
+{
+    // Building the appointment is in, by handle index
+    int32 BuildingIndex = INDEX_NONE;
+
+    // Place within the building
+    int32 Lane = INDEX_NONE;
+
+    // First slot and number of slots
+    int64 StartSlot = INDEX_NONE;
+    int32 Length = 0;
+
+    // Registration of the building the booking was made against
+    uint32 Generation = 0;
+
+    bool IsValid() const { return BuildingIndex != INDEX_NONE; }
+    int64 GetEndSlot() const { return StartSlot + Length; }
+};
+
+/**
+ * Appointment books of all treatment buildings and a best-first search across them.
+ * Every building keeps a lower bound on its first free slot. Candidate heaps, one per treatment
+ * plus one for any treatment, are ordered by the earliest finish that bound allows, so a search
+ * only opens the books of buildings that could still beat the best appointment found so far.
+ * Bounds are tightened lazily when a building is popped, so booking never touches a heap.
+ */
+class SIMULATION_API FTreatmentScheduler
+{
+public:
+    /**
+     * Remove all buildings and bookings
+     * @param InWindowSlots Number of slots ahead of now that can be booked
+     * @param InNowSlot Current slot
+     */
+    void Reset(int32 InWindowSlots, int64 InNowSlot);
+
+    /**
+     * Open an appointment book for a building, replacing any previous one at the index
+     * @param BuildingIndex Handle index of the building
+     * @param NumLanes Number of appointments that can run at the same time
+     * @param DurationSlots Length of one appointment in slots
+     * @param Treatments Treatments the building offers
+     */
+    void AddBuilding(int32 BuildingIndex, int32 NumLanes, int32 DurationSlots, const TArray<FName>& Treatments);
+
+    /**
+     * Close the appointment book of a building, invalidating its bookings
+     * @param BuildingIndex Handle index of the building
+     */
+    void RemoveBuilding(int32 BuildingIndex);
+
+    /**
+     * Move the current time forward; slots before it can no longer be booked
+     * @param InNowSlot Current slot
+     */
+    void AdvanceTo(int64 InNowSlot);
+
+    /**
+     * Find the appointment that finishes first across all buildings offering a treatment
+     * @param Treatment Treatment wanted, NAME_None for any
+     * @param FromSlot Slot the guest sets off
+     * @param GetTravelSlots Slots needed to reach a building, negative to skip the building
+     * @return Best appointment, invalid if no building has room within the window
+     */
+    FTreatmentBooking FindBest(FName Treatment, int64 FromSlot, TFunctionRef<int64(int32 BuildingIndex)> GetTravelSlots);
+
+    /**
+     * Book an appointment returned by FindBest
+     * @param Booking Appointment to book
+     * @return True if the slots were still free
+     */
+    bool Book(const FTreatmentBooking& Booking);
+
+    /**
+     * Release the slots of an appointment that have not started yet
+     * @param Booking Appointment to release
+     */
+    void Cancel(const FTreatmentBooking& Booking);
+
+    /**
+     * Book one appointment per member of a group, each the best left after the previous ones
+     * @param Treatment Treatment wanted, NAME_None for any
+     * @param FromSlot Slot the group sets off
+     * @param GroupSize Number of appointments
+     * @param GetTravelSlots Slots needed to reach a building, negative to skip the building
+     * @param OutBookings Booked appointments, invalid for members nothing was left for
+     * @return Number of appointments booked
+     */
+    int32 BookGroup(FName Treatment, int64 FromSlot, int32 GroupSize, TFunctionRef<int64(int32 BuildingIndex)> GetTravelSlots, TArray<FTreatmentBooking>& OutBookings);
+
+    // Appointment book of a building, nullptr if it has none
+    const FAppointmentBook* GetBook(int32 BuildingIndex) const;
+
+    // Current slot
+    FORCEINLINE int64 GetNowSlot() const { return NowSlot; }
+
+private:
+    struct FBuildingBook
+    {
+        FAppointmentBook Book;
+        TArray<FName> Treatments;
+
+        // No appointment can start before this slot
+        int64 Bound = 0;
+
+        int32 DurationSlots = 1;
+        uint32 Generation = 0;
+        bool bActive = false;
+    };
+
+    struct FHeapEntry
+    {
+        // Earliest finish the building's bound allows
+        int64 Key = 0;
+        int32 BuildingIndex = INDEX_NONE;
+        uint32 Generation = 0;
+    };
+
+    struct FHeapOrder
+    {
+        bool operator()(const FHeapEntry& A, const FHeapEntry& B) const
+        {
+            return A.Key != B.Key ? A.Key < B.Key : A.BuildingIndex < B.BuildingIndex;
+        }
+    };
+
+    // Entries of one candidate heap and the number of buildings it should hold
+    struct FCandidateHeap
+    {
+        TArray<FHeapEntry> Entries;
+        int32 NumBuildings = 0;
+    };
+
+    // Heap key of a building's current bound
+    static FHeapEntry MakeEntry(int32 BuildingIndex, const FBuildingBook& Building);
+
+    // True if an entry matches the current bound of an active building
+    bool IsCurrent(const FHeapEntry& Entry) const;
+
+    // Change the bound of a building and push its new key to all its heaps
+    void SetBound(int32 BuildingIndex, int64 Bound);
+
+    // Push a building's key to one heap, dropping stale entries when they pile up
+    void PushEntry(FCandidateHeap& Heap, int32 BuildingIndex, FName Treatment);
+
+    // Apply a function to the heaps a building is a candidate in
+    template <typename FunctionType>
+    void ForEachHeap(const FBuildingBook& Building, FunctionType Function);
+
+    // Books by building handle index
+    TArray<FBuildingBook> Books;
+
+    // Candidate heaps by treatment, NAME_None holds every building
+    TMap<FName, FCandidateHeap> Heaps;
+
+    // Exact entries popped during a search, pushed back at its end
+    TArray<FHeapEntry> Reinsert;
+
+    int32 WindowSlots = 0;
+    int64 NowSlot = 0;
+};
@@ -0,0 +1,27 @@
+﻿using UnrealBuildTool;
+
+public class Simulation : ModuleRules
+{
+    public Simulation(ReadOnlyTargetRules Target) : base(Target)
+    {
+        PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+        PublicDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "Core",
+                "CoreUObject",
+                "Engine",
+                "Grid",
+                "MassEntity"
+            }
+        );
+
+        PrivateDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "Core_Mechanics"
+            }
+        );
+    }
+}